@@ -9,11 +9,14 @@
  */
 #include <windows.h>
 #include <algorithm>
+#include <chrono>
 
 #include "SporeModLoader.hpp"
 #include "SporeModLoaderHelpers.hpp"
+#include "SporeModManagerHelpers/LoaderProfile.hpp"
 
 using namespace SporeModLoaderHelpers;
+namespace LoaderProfile = SporeModManagerHelpers::LoaderProfile;
 
 //
 // Local Variables
@@ -31,6 +34,8 @@ static std::vector<HMODULE> l_LoadedModLibs;
 
 bool SporeModLoader::Initialize()
 {
+    const auto startTime = std::chrono::steady_clock::now();
+
     try
     {
         Logger::Open();
@@ -56,11 +61,14 @@ bool SporeModLoader::Initialize()
         }
 
         Logger::AddMessage(L"SporeModLoader::Initialize() == 1");
+        LoaderProfile::AddEvent(LoaderProfile::EventType::Initialize, startTime, true);
+        Logger::Flush();
         return true;
     }
     catch (...)
     {
         Logger::AddMessage(L"SporeModLoader::Initialize() == 0");
+        LoaderProfile::AddEvent(LoaderProfile::EventType::Initialize, startTime, false);
         UI::ShowErrorMessage(L"SporeModLoader::Initialize() Failed!");
         return false;
     }
@@ -68,6 +76,8 @@ bool SporeModLoader::Initialize()
 
 bool SporeModLoader::LoadCoreLibs()
 {
+    const auto startTime = std::chrono::steady_clock::now();
+
     try
     {
         Logger::AddMessage(L"SporeModLoader::LoadCoreLibs()");
@@ -76,11 +86,13 @@ bool SporeModLoader::LoadCoreLibs()
             throw std::exception();
         }
         Logger::AddMessage(L"SporeModLoader::LoadCoreLibs() == 1");
+        LoaderProfile::AddEvent(LoaderProfile::EventType::LoadCoreLibs, startTime, true);
         return true;
     }
     catch (...)
     {
         Logger::AddMessage(L"SporeModLoader::LoadCoreLibs() == 0");
+        LoaderProfile::AddEvent(LoaderProfile::EventType::LoadCoreLibs, startTime, false);
         UI::ShowErrorMessage(L"SporeModLoader::LoadCoreLibs() Failed!");
         return false;
     }
@@ -88,6 +100,8 @@ bool SporeModLoader::LoadCoreLibs()
 
 bool SporeModLoader::LoadModLibs()
 {
+    const auto startTime = std::chrono::steady_clock::now();
+
     try
     {
         Logger::AddMessage(L"SporeModLoader::LoadModLibs()");
@@ -96,11 +110,15 @@ bool SporeModLoader::LoadModLibs()
             throw std::exception();
         }
         Logger::AddMessage(L"SporeModLoader::LoadModLibs() == 1");
+        LoaderProfile::AddEvent(LoaderProfile::EventType::LoadModLibs, startTime, true);
+        Logger::SaveProfile();
         return true;
     }
     catch (...)
     {
         Logger::AddMessage(L"SporeModLoader::LoadModLibs() == 0");
+        LoaderProfile::AddEvent(LoaderProfile::EventType::LoadModLibs, startTime, false);
+        Logger::SaveProfile();
         UI::ShowErrorMessage(L"SporeModLoader::LoadModLibs() Failed!");
         return false;
     }
@@ -108,6 +126,8 @@ bool SporeModLoader::LoadModLibs()
 
 bool SporeModLoader::UnloadCoreLibs(void)
 {
+    const auto startTime = std::chrono::steady_clock::now();
+
     try
     {
         // reverse the order of the core libraries,
@@ -121,11 +141,15 @@ bool SporeModLoader::UnloadCoreLibs(void)
             throw std::exception();
         }
         Logger::AddMessage(L"SporeModLoader::UnloadCoreLibs() == 1");
+        LoaderProfile::AddEvent(LoaderProfile::EventType::UnloadCoreLibs, startTime, true);
+        Logger::SaveProfile();
         return true;
     }
     catch (...)
     {
         Logger::AddMessage(L"SporeModLoader::UnloadCoreLibs() == 0");
+        LoaderProfile::AddEvent(LoaderProfile::EventType::UnloadCoreLibs, startTime, false);
+        Logger::SaveProfile();
         UI::ShowErrorMessage(L"SporeModLoader::UnloadCoreLibs() Failed!");
         return false;
     }
@@ -133,6 +157,8 @@ bool SporeModLoader::UnloadCoreLibs(void)
 
 bool SporeModLoader::UnloadModLibs(void)
 {
+    const auto startTime = std::chrono::steady_clock::now();
+
     try
     {
         Logger::AddMessage(L"SporeModLoader::UnloadModLibs()");
@@ -141,11 +167,13 @@ bool SporeModLoader::UnloadModLibs(void)
             throw std::exception();
         }
         Logger::AddMessage(L"SporeModLoader::UnloadModLibs() == 1");
+        LoaderProfile::AddEvent(LoaderProfile::EventType::UnloadModLibs, startTime, true);
         return true;
     }
     catch (...)
     {
         Logger::AddMessage(L"SporeModLoader::UnloadModLibs() == 0");
+        LoaderProfile::AddEvent(LoaderProfile::EventType::UnloadModLibs, startTime, false);
         UI::ShowErrorMessage(L"SporeModLoader::UnloadModLibs() Failed!");
         return false;
     }
@@ -11,16 +11,22 @@
 
 #include <fstream>
 #include <optional>
+#include <chrono>
 
 #include "SporeModLoaderHelpers.hpp"
+#include "SporeModManagerHelpers/LoadManifest.hpp"
+#include "SporeModManagerHelpers/LoaderProfile.hpp"
 
 using namespace SporeModLoaderHelpers;
+namespace LoadManifest = SporeModManagerHelpers::LoadManifest;
+namespace LoaderProfile = SporeModManagerHelpers::LoaderProfile;
 
 //
 // Local Variables
 //
 
-static std::wofstream l_LogFileStream;
+static std::wofstream        l_LogFileStream;
+static std::filesystem::path l_LogFilePath;
 
 //
 // Exported Functions
@@ -100,6 +106,7 @@ std::vector<std::filesystem::path> Path::GetModLibsPaths(void)
     std::vector<std::filesystem::path> modLibsPaths;
     std::filesystem::path modLibsPath;
     std::vector<std::wstring> excludePostfixes;
+    LoadManifest::Manifest manifest;
 
     modLibsPath = GetModLoaderPath();
     modLibsPath += "\\ModLibs";
@@ -120,19 +127,34 @@ std::vector<std::filesystem::path> Path::GetModLibsPaths(void)
         excludePostfixes.push_back(L"-steam_patched.dll");
     }
 
-    for (const auto& entry : std::filesystem::directory_iterator(modLibsPath))
+    // SporeModManager writes the load manifest after
+    // changing ModLibs, when ModLibs has been changed
+    // since then, we have to list the dlls ourselves
+    bool isCurrent = LoadManifest::Read(modLibsPath, manifest) &&
+                     LoadManifest::IsCurrent(modLibsPath, manifest);
+
+    std::wstring logMessage;
+    logMessage = L"LoadManifest::IsCurrent(\"";
+    logMessage += LoadManifest::GetManifestPath(modLibsPath).wstring();
+    logMessage += L"\") == ";
+    logMessage += std::to_wstring(isCurrent ? 1 : 0);
+    Logger::AddMessage(logMessage);
+
+    if (!isCurrent && !LoadManifest::Create(modLibsPath, manifest))
     {
-        // skip non-files & non-dlls
-        if (!entry.is_regular_file() ||
-            !entry.path().has_extension() ||
-            entry.path().extension() != ".dll")
-        {
-            continue;
-        }
+        std::wstring errorMessage;
+        errorMessage = L"LoadManifest::Create(\"";
+        errorMessage += modLibsPath.wstring();
+        errorMessage += L"\") Failed!";
+        UI::ShowErrorMessage(errorMessage);
+        throw std::exception();
+    }
 
+    for (const auto& file : manifest.Files)
+    {
         // ensure we have an allowed postfix
         bool skipLib = false;
-        std::wstring filename = entry.path().filename().wstring();
+        std::wstring filename = file.FileName.wstring();
         for (const auto& postfix : excludePostfixes)
         {
             // we have to support C++17 for MinGW
@@ -151,7 +173,7 @@ std::vector<std::filesystem::path> Path::GetModLibsPaths(void)
 
         if (!skipLib)
         {
-            modLibsPaths.push_back(entry.path());
+            modLibsPaths.push_back(modLibsPath / file.FileName);
         }
     }
 
@@ -179,6 +201,8 @@ void Logger::Open(void)
                 throw std::exception();
             }
         }
+
+        l_LogFilePath = logFilePath;
     }
     catch (...)
     {
@@ -191,11 +215,37 @@ void Logger::Open(void)
 
 void Logger::AddMessage(std::wstring message)
 {
-    l_LogFileStream << message << std::endl;
+    // messages are only written when the log
+    // is flushed, which is done after every phase
+    l_LogFileStream << message << L'\n';
+}
+
+void Logger::Flush(void)
+{
+    l_LogFileStream.flush();
+}
+
+void Logger::SaveProfile(void)
+{
+    std::filesystem::path profilePath = l_LogFilePath;
+    profilePath.replace_extension(".profile");
+
+    bool ret = LoaderProfile::Write(profilePath);
+
+    std::wstring logMessage;
+    logMessage = L"LoaderProfile::Write(\"";
+    logMessage += profilePath.wstring();
+    logMessage += L"\") == ";
+    logMessage += std::to_wstring(ret ? 1 : 0);
+    AddMessage(logMessage);
+    Flush();
 }
 
 void UI::ShowErrorMessage(std::wstring message)
 {
+    // the game is aborted after most errors,
+    // so ensure the log contains everything
+    Logger::Flush();
     MessageBoxW(nullptr, message.c_str(), L"SporeModLoader", MB_OK | MB_ICONERROR);
 }
 
@@ -203,9 +253,12 @@ bool Library::LoadAll(const std::vector<std::filesystem::path>& paths, std::vect
 {
     for (const auto& path : paths)
     {
-        // attempt to load library
+        // attempt to load library, which includes
+        // the time spent in DllMain of the library
+        const auto startTime = std::chrono::steady_clock::now();
         HMODULE hModule = LoadLibraryW(path.wstring().c_str());
         bool ret = hModule != nullptr;
+        LoaderProfile::AddEvent(LoaderProfile::EventType::LoadDll, startTime, ret, path.filename());
 
         std::wstring logMessage;
         logMessage = L"LoadLibraryW(\"";
@@ -239,8 +292,10 @@ bool Library::UnloadAll(const std::vector<HMODULE>& modules, const std::vector<s
         const auto& module = modules[i];
         const auto& path   = paths[i];
 
-        // attempt to load library
+        // attempt to unload library
+        const auto startTime = std::chrono::steady_clock::now();
         bool ret = FreeLibrary(module);
+        LoaderProfile::AddEvent(LoaderProfile::EventType::UnloadDll, startTime, ret, path.filename());
 
         std::wstring logMessage;
         logMessage = L"FreeLibrary(\"";
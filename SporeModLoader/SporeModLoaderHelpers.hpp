@@ -51,6 +51,16 @@ namespace SporeModLoaderHelpers
         ///     Adds message to the log file
         /// </summary>
         void AddMessage(std::wstring message);
+
+        /// <summary>
+        ///     Writes the added messages to the log file
+        /// </summary>
+        void Flush(void);
+
+        /// <summary>
+        ///     Writes the profile next to the log file and flushes it
+        /// </summary>
+        void SaveProfile(void);
     }
 
     namespace UI
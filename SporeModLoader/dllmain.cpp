@@ -8,12 +8,15 @@
  *  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include <windows.h>
+#include <chrono>
 #include "detours.h"
 
 #include "SporeModLoader.hpp"
 #include "SporeModLoaderHelpers.hpp"
+#include "SporeModManagerHelpers/LoaderProfile.hpp"
 
 using namespace SporeModLoaderHelpers;
+namespace LoaderProfile = SporeModManagerHelpers::LoaderProfile;
 
 //
 // Detoured Game Functions
@@ -23,12 +26,16 @@ typedef void (WINAPI* ptr_InitializeGeneralAllocator)(void);
 static void (WINAPI* InitializeGeneralAllocator_real)(void) = nullptr;
 static void WINAPI InitializeGeneralAllocator_detoured(void)
 {
+    const auto startTime = std::chrono::steady_clock::now();
+
     InitializeGeneralAllocator_real();
 
     static bool loaded = false;
 
     if (!loaded)
     {
+        LoaderProfile::AddEvent(LoaderProfile::EventType::InitializeAllocator, startTime, true);
+
         if (!SporeModLoader::LoadCoreLibs())
         {
             std::abort();
@@ -127,7 +134,9 @@ static void GetStartupInfoA_detoured(LPSTARTUPINFOA lpStartupInfo)
         // Thanks to @Zarklord for coming up with this method after
         // we discussed that this should be solved somehow instead
         // of making mods fix this by not using static variables
+        const auto startTime = std::chrono::steady_clock::now();
         attach_allocator_detours();
+        LoaderProfile::AddEvent(LoaderProfile::EventType::AttachAllocatorDetours, startTime, true);
 
         initialized = true;
     }
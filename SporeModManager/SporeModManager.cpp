@@ -9,37 +9,111 @@
  */
 #include <algorithm>
 #include <iostream>
+#include <chrono>
 #include <fstream>
+#include <unordered_map>
+#include <map>
 
+#include "SporeModManagerHelpers/Cache.hpp"
+#include "SporeModManagerHelpers/Dbpf.hpp"
+#include "SporeModManagerHelpers/DllImports.hpp"
 #include "SporeModManagerHelpers/Download.hpp"
+#include "SporeModManagerHelpers/Hash.hpp"
+#include "SporeModManagerHelpers/LoadManifest.hpp"
+#include "SporeModManagerHelpers/LoaderProfile.hpp"
+#include "SporeModManagerHelpers/ResourceIndex.hpp"
+#include "SporeModManagerHelpers/ResourceNames.hpp"
 #include "SporeModManagerHelpers/SporeMod.hpp"
 #include "SporeModManagerHelpers/String.hpp"
 #include "SporeModManagerHelpers/Path.hpp"
+#include "SporeModManagerHelpers/Thread.hpp"
 #include "SporeModManagerHelpers/Zip.hpp"
 #include "SporeModManagerHelpers/UI.hpp"
 #include "SporeModManager.hpp"
 
 using namespace SporeModManagerHelpers;
 
+//
+// Local Defines
+//
+
+#define SPOREMODMANAGER_MERGED_PACKAGE "SporeModManagerMerged.package"
+
 //
 // Local Variables
 //
 
 static bool                                          l_HasInstalledSporeMods = false;
 static std::vector<SporeMod::Xml::InstalledSporeMod> l_InstalledSporeMods;
-static bool                                          l_SaveInstalledSporeMods = true;
 static std::vector<SporeMod::Xml::SporeModInfo>      l_SporeModInfos;
 static std::vector<Zip::ZipFile>                     l_ZipFiles;
+static std::vector<SporeMod::Xml::InstalledSporeMod> l_PreviousSporeMods;
+static std::vector<std::string>                      l_RecoveredSporeMods;
+static std::vector<std::filesystem::path>            l_DownloadedFiles;
+static bool                                          l_KeepDownloadedFiles = false;
 
 //
 // Helper Functions
 //
 
+static bool recover_installedsporemodlist(void)
+{
+    std::vector<SporeMod::Xml::InstalledSporeMod> journalSporeMods;
+    int installedSporeModId;
+
+    // an install which was interrupted while moving its
+    // files into place isn't in the journal, so roll it
+    // back before anything else uses those directories
+    if (!SporeMod::RecoverInstallDirectories() ||
+        !SporeMod::Xml::GetInstalledModJournal(journalSporeMods))
+    {
+        return false;
+    }
+
+    if (journalSporeMods.empty())
+    {
+        return true;
+    }
+
+    // mods in the journal have been installed by
+    // an interrupted run, so add them to the list
+    std::cout << "-> Recovering " << journalSporeMods.size() << " mod(s) installed by an interrupted run" << std::endl;
+    for (const auto& journalSporeMod : journalSporeMods)
+    {
+        if (UI::GetVerboseMode())
+        {
+            std::cout << "--> Recovering " << journalSporeMod.Name << std::endl;
+        }
+
+        if (SporeMod::FindInstalledMod(journalSporeMod.UniqueName, installedSporeModId, l_InstalledSporeMods))
+        {
+            l_InstalledSporeMods[installedSporeModId] = journalSporeMod;
+        }
+        else
+        {
+            l_InstalledSporeMods.push_back(journalSporeMod);
+        }
+        l_RecoveredSporeMods.push_back(journalSporeMod.UniqueName);
+    }
+
+    // reload the list so the order matches
+    // the order of the saved list
+    if (!SporeMod::Xml::SaveInstalledModList(l_InstalledSporeMods) ||
+        !SporeMod::Xml::RemoveInstalledModJournal())
+    {
+        return false;
+    }
+
+    l_InstalledSporeMods.clear();
+    return SporeMod::Xml::GetInstalledModList(l_InstalledSporeMods);
+}
+
 static bool get_installedsporemodlist(void)
 {
     if (!l_HasInstalledSporeMods)
     {
-        if (!SporeMod::Xml::GetInstalledModList(l_InstalledSporeMods))
+        if (!SporeMod::Xml::GetInstalledModList(l_InstalledSporeMods) ||
+            !recover_installedsporemodlist())
         {
             std::cerr << "Error: failed to retrieve installed mod list!" << std::endl;
             return false;
@@ -49,16 +123,100 @@ static bool get_installedsporemodlist(void)
     return true;
 }
 
+static bool is_recovered_sporemod(const std::string& uniqueName)
+{
+    return std::find(l_RecoveredSporeMods.begin(), l_RecoveredSporeMods.end(), uniqueName) != l_RecoveredSporeMods.end();
+}
+
+static std::string get_duration_string(int64_t duration)
+{
+    char durationString[32];
+    std::snprintf(durationString, sizeof(durationString), "%.3f ms", static_cast<double>(duration) / 1000000.0);
+    return durationString;
+}
+
+static void update_load_manifest(void)
+{
+    const std::filesystem::path modLibsPath = Path::GetModLibsPath();
+    LoadManifest::Manifest manifest;
+
+    // SporeModLoader lists ModLibs itself when
+    // the manifest doesn't match it anymore, so
+    // failing to write it isn't an error
+    if (!LoadManifest::Create(modLibsPath, manifest) ||
+        !LoadManifest::Write(modLibsPath, manifest))
+    {
+        std::cerr << "Warning: failed to update load manifest " << LoadManifest::GetManifestPath(modLibsPath) << "!" << std::endl;
+    }
+}
+
 static bool save_installedsporemodlist(void)
 {
-    if (l_SaveInstalledSporeMods)
+    // the journal is only needed until the list has been saved
+    if (!SporeMod::Xml::SaveInstalledModList(l_InstalledSporeMods) ||
+        !SporeMod::Xml::RemoveInstalledModJournal())
     {
-        if (!SporeMod::Xml::SaveInstalledModList(l_InstalledSporeMods))
-        {
-            std::cerr << "Error: failed to save installed mod list!" << std::endl;
-            return false;
-        }
+        std::cerr << "Error: failed to save installed mod list!" << std::endl;
+        return false;
+    }
+
+    // the installed files of ModLibs only
+    // change before the list is saved
+    update_load_manifest();
+    return true;
+}
+
+static bool find_profile(const std::string& name, std::vector<SporeMod::Xml::Profile>& profiles, 
+                         std::vector<SporeMod::Xml::Profile>::iterator& profileIter)
+{
+    profileIter = std::find_if(profiles.begin(), profiles.end(), [name](const SporeMod::Xml::Profile& profile)
+    {
+        return profile.Name == name;
+    });
+
+    if (profileIter == profiles.end())
+    {
+        std::cerr << "Error: no profile found with the name " << name << "!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static std::string get_extension(const std::filesystem::path& path)
+{
+    // urls can contain a query or a checksum
+    if (Download::IsUrl(path.string()))
+    {
+        return String::Lowercase(Download::GetFileName(path.string()).extension().string());
+    }
+
+    return String::Lowercase(path.extension().string());
+}
+
+static bool get_download_path(const std::string& url, std::filesystem::path& downloadPath)
+{
+    std::error_code error;
+
+    downloadPath = std::filesystem::temp_directory_path(error);
+    if (error)
+    {
+        std::cerr << "Error: failed to retrieve temporary directory: " << error.message() << std::endl;
+        return false;
+    }
+
+    downloadPath = Path::Combine({ downloadPath, "SporeModManager" });
+    std::filesystem::create_directories(downloadPath, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to create directory " << downloadPath << ": " << error.message() << std::endl;
+        return false;
     }
+
+    // urls with the same file name can point to different
+    // files, so the url, which contains the checksum, is part of it
+    const std::string urlHash = Hash::Sha256(url.data(), url.size()).substr(0, 16);
+    downloadPath = Path::Combine({ downloadPath, urlHash + "-" + Download::GetFileName(url).string() });
     return true;
 }
 
@@ -66,10 +224,41 @@ static bool get_sporemodinfo(const std::filesystem::path& path, const std::strin
 {
     Zip::ZipFile zipFile = nullptr;
     std::vector<char> modInfoFileBuffer;
+    std::filesystem::path downloadPath;
 
     if (extension == ".sporemod")
     {
-        if (!Zip::OpenFile(zipFile, path))
+        if (Download::IsUrl(path.string()))
+        {
+            // urls with a checksum have to be downloaded
+            // completely in order to verify them, otherwise
+            // only read what we need using range requests
+            if (Download::HasChecksum(path.string()))
+            {
+                if (!get_download_path(path.string(), downloadPath) ||
+                    !Download::DownloadFile(path.string(), downloadPath))
+                {
+                    return false;
+                }
+
+                // the downloaded file is removed after
+                // the mod has been installed or has failed
+                if (std::find(l_DownloadedFiles.begin(), l_DownloadedFiles.end(), downloadPath) == l_DownloadedFiles.end())
+                {
+                    l_DownloadedFiles.push_back(downloadPath);
+                }
+
+                if (!Zip::OpenFile(zipFile, downloadPath))
+                {
+                    return false;
+                }
+            }
+            else if (!Zip::OpenUrl(zipFile, path.string()))
+            {
+                return false;
+            }
+        }
+        else if (!Zip::OpenFile(zipFile, path))
         {
             return false;
         }
@@ -77,7 +266,9 @@ static bool get_sporemodinfo(const std::filesystem::path& path, const std::strin
         sporeModInfo.HasModInfoXml = Zip::LocateFile(zipFile, "modinfo.xml");
         if (!sporeModInfo.HasModInfoXml)
         { // no modinfo.xml
-            sporeModInfo.UniqueName = path.stem().string();
+            sporeModInfo.UniqueName = Download::IsUrl(path.string()) ? 
+                                        Download::GetFileName(path.string()).stem().string() : 
+                                        path.stem().string();
             sporeModInfo.Name       = sporeModInfo.UniqueName;
         }
         else
@@ -115,18 +306,69 @@ static bool get_sporemodinfo(const std::filesystem::path& path, const std::strin
     return true;
 }
 
+static bool check_path(const std::filesystem::path& path, const std::string& extension)
+{
+    // remote files are only supported for sporemod files,
+    // because they're opened with range requests
+    if (Download::IsUrl(path.string()))
+    {
+        if (extension != ".sporemod")
+        {
+            std::cerr << "Error: " << path << " cannot be installed from an url, only sporemod files are supported!" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    if (!std::filesystem::is_regular_file(path))
+    {
+        std::cerr << "Error: " << path << " is not a regular file or doesn't exist!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
 static void reserve_list_items(size_t size)
 {
     l_SporeModInfos.reserve(size);
     l_ZipFiles.reserve(size);
 }
 
+static void remove_downloaded_files(void)
+{
+    for (const auto& downloadedFile : l_DownloadedFiles)
+    {
+        Download::RemoveDownloadedFile(downloadedFile);
+    }
+    l_DownloadedFiles.clear();
+}
+
 static void close_zipfiles(void)
 {
     for (const Zip::ZipFile& zipFile : l_ZipFiles)
     {
         Zip::CloseFile(zipFile);
     }
+
+    // files downloaded for an earlier target
+    // are used again for the next one
+    if (!l_KeepDownloadedFiles)
+    {
+        remove_downloaded_files();
+    }
+}
+
+static void reset_lists(void)
+{
+    // the zip files have already been closed
+    // by InstallMods() or UpdateMods()
+    l_HasInstalledSporeMods = false;
+    l_InstalledSporeMods.clear();
+    l_SporeModInfos.clear();
+    l_ZipFiles.clear();
+    l_PreviousSporeMods.clear();
+    l_RecoveredSporeMods.clear();
 }
 
 static void remove_duplicate_paths(std::vector<std::filesystem::path>& paths, bool update)
@@ -151,6 +393,183 @@ static void remove_duplicate_paths(std::vector<std::filesystem::path>& paths, bo
     paths = uniquePaths;
 }
 
+static bool update_resource_index(void)
+{
+    // only packages which haven't been indexed
+    // or which have changed are read again
+    for (const auto& installedSporeMod : l_InstalledSporeMods)
+    {
+        for (const auto& installedFile : installedSporeMod.InstalledFiles)
+        {
+            if (get_extension(installedFile.FileName) != ".package")
+            {
+                continue;
+            }
+
+            // files which have been removed by the user can't be indexed,
+            // 'check' already reports them, so ignore them here
+            ResourceIndex::UpdatePackage(installedFile.InstallLocation, installedFile.FileName,
+                                         SporeMod::GetInstalledFilePath(installedSporeMod, installedFile));
+        }
+    }
+
+    ResourceIndex::RemoveUnusedPackages(l_InstalledSporeMods);
+    return ResourceIndex::SaveIndex();
+}
+
+static bool find_package_path(SporeMod::InstallLocation installLocation, const std::filesystem::path& fileName, 
+                              std::filesystem::path& path)
+{
+    // a package shared by multiple enabled mods is the same file
+    for (const auto& installedSporeMod : l_InstalledSporeMods)
+    {
+        if (installedSporeMod.IsDisabled)
+        {
+            continue;
+        }
+
+        for (const auto& installedFile : installedSporeMod.InstalledFiles)
+        {
+            if (installedFile.InstallLocation == installLocation && installedFile.FileName == fileName)
+            {
+                path = SporeMod::GetInstalledFilePath(installedSporeMod, installedFile);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static bool is_merged_package(SporeMod::InstallLocation installLocation, const std::filesystem::path& fileName)
+{
+    for (const auto& installedSporeMod : l_InstalledSporeMods)
+    {
+        for (const auto& installedFile : installedSporeMod.InstalledFiles)
+        {
+            if (!installedSporeMod.IsDisabled && installedFile.IsMerged &&
+                installedFile.InstallLocation == installLocation && installedFile.FileName == fileName)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static bool build_merged_package(const SporeMod::Xml::MergedPackage& mergedPackage)
+{
+    const std::filesystem::path mergedPackagePath = Path::GetFullInstallPath(mergedPackage.InstallLocation, mergedPackage.FileName);
+    std::vector<std::filesystem::path> paths;
+    std::filesystem::path path;
+
+    for (const auto& sourceFileName : mergedPackage.SourceFileNames)
+    {
+        if (!find_package_path(mergedPackage.InstallLocation, sourceFileName, path))
+        {
+            std::cerr << "Error: no enabled mod found with " << sourceFileName << "!" << std::endl;
+            return false;
+        }
+        paths.push_back(path);
+    }
+
+    std::cout << "-> Merging " << paths.size() << " package(s) into " << mergedPackagePath << std::endl;
+    return Dbpf::MergePackages(paths, mergedPackagePath);
+}
+
+static bool update_merged_packages(void)
+{
+    std::vector<SporeMod::Xml::MergedPackage> mergedPackages;
+    std::vector<SporeMod::Xml::MergedPackage> updatedMergedPackages;
+    std::error_code error;
+    bool returnValue = true;
+
+    if (!SporeMod::Xml::GetMergedPackages(mergedPackages))
+    {
+        std::cerr << "Error: failed to retrieve merged packages!" << std::endl;
+        return false;
+    }
+
+    // only the merged packages of which sources have
+    // been uninstalled or restored have to be rebuilt
+    for (auto& mergedPackage : mergedPackages)
+    {
+        const size_t sourceCount = mergedPackage.SourceFileNames.size();
+        mergedPackage.SourceFileNames.erase(std::remove_if(mergedPackage.SourceFileNames.begin(), mergedPackage.SourceFileNames.end(),
+            [&](const std::filesystem::path& sourceFileName)
+            {
+                return !is_merged_package(mergedPackage.InstallLocation, sourceFileName);
+            }), mergedPackage.SourceFileNames.end());
+
+        if (mergedPackage.SourceFileNames.empty())
+        {
+            const std::filesystem::path mergedPackagePath = Path::GetFullInstallPath(mergedPackage.InstallLocation, mergedPackage.FileName);
+            std::cout << "-> Removing " << mergedPackagePath << std::endl;
+            std::filesystem::remove(mergedPackagePath, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to remove " << mergedPackagePath << ": " << error.message() << std::endl;
+                returnValue = false;
+                updatedMergedPackages.push_back(mergedPackage);
+            }
+            continue;
+        }
+
+        if (mergedPackage.SourceFileNames.size() != sourceCount && !build_merged_package(mergedPackage))
+        {
+            returnValue = false;
+        }
+
+        updatedMergedPackages.push_back(mergedPackage);
+    }
+
+    if (!SporeMod::Xml::SaveMergedPackages(updatedMergedPackages))
+    {
+        std::cerr << "Error: failed to save merged packages!" << std::endl;
+        return false;
+    }
+
+    return returnValue;
+}
+
+static bool unmerge_sporemods(const std::vector<const SporeMod::Xml::InstalledSporeMod*>& installedSporeMods)
+{
+    std::vector<SporeMod::Xml::SporeModFile> mergedFiles;
+
+    for (const auto& installedSporeMod : installedSporeMods)
+    {
+        for (const auto& installedFile : installedSporeMod->InstalledFiles)
+        {
+            if (installedFile.IsMerged)
+            {
+                mergedFiles.push_back(installedFile);
+            }
+        }
+    }
+
+    if (mergedFiles.empty())
+    {
+        return true;
+    }
+
+    // restoring a package restores it for
+    // every enabled mod which shares it
+    for (const auto& mergedFile : mergedFiles)
+    {
+        if (!is_merged_package(mergedFile.InstallLocation, mergedFile.FileName))
+        {
+            continue;
+        }
+        if (!SporeMod::SetPackageMerged(l_InstalledSporeMods, mergedFile, false))
+        {
+            return false;
+        }
+    }
+
+    return update_merged_packages();
+}
+
 //
 // Exported Functions
 //
@@ -168,7 +587,7 @@ bool SporeModManager::ListInstalledMods(void)
     {
         installedSporeMod = l_InstalledSporeMods[i];
 
-        std::cout << "[" << i << "] " << installedSporeMod.Name << std::endl;
+        std::cout << "[" << i << "] " << installedSporeMod.Name << (installedSporeMod.IsDisabled ? " (disabled)" : "") << std::endl;
         if (!installedSporeMod.Description.empty())
         {
             std::cout << "  " << String::Replace(installedSporeMod.Description, "\n", "\n  ") << std::endl;
@@ -178,47 +597,142 @@ bool SporeModManager::ListInstalledMods(void)
     return true;
 }
 
-bool SporeModManager::InstallMods(std::vector<std::filesystem::path>& paths, bool skipValidation, bool skipInstalled, bool skipConfiguration)
+bool SporeModManager::CheckInstalledMods(bool rehash, bool& hasChanges)
 {
-    std::vector<std::string> uniqueNames;
-    std::string              extension;
-    bool                     returnValue = true;
-    int                              installedSporeModId;
-    SporeMod::Xml::InstalledSporeMod installedSporeMod;
-    SporeMod::Xml::SporeModInfo      sporeModInfo;
+    std::vector<std::pair<const SporeMod::Xml::InstalledSporeMod*, const SporeMod::Xml::SporeModFile*>> installedFiles;
+    std::vector<SporeMod::FileState> fileStates;
+    size_t fileIndex     = 0;
+    size_t modifiedCount = 0;
+    size_t missingCount  = 0;
+    size_t unknownCount  = 0;
+    size_t unresolvedCount;
+
+    hasChanges = false;
 
     if (!get_installedsporemodlist())
     {
         return false;
     }
 
-    // do some basic validation before attempting
-    // to install the given mods
-    if (!skipValidation)
+    for (const auto& installedSporeMod : l_InstalledSporeMods)
     {
-        // remove duplicates
-        remove_duplicate_paths(paths, false);
+        for (const auto& installedFile : installedSporeMod.InstalledFiles)
+        {
+            installedFiles.push_back({ &installedSporeMod, &installedFile });
+        }
+    }
 
-        // reserve list items
-        reserve_list_items(paths.size());
+    // checking a file only reads that file,
+    // so we can check all of them in parallel
+    fileStates.resize(installedFiles.size());
+    Thread::ParallelFor(installedFiles.size(), [&](size_t index)
+    {
+        fileStates[index] = SporeMod::CheckInstalledFile(*installedFiles[index].first, *installedFiles[index].second, rehash);
+    });
 
-        for (size_t i = 0; i < paths.size(); i++)
+    for (size_t i = 0; i < l_InstalledSporeMods.size(); i++)
+    {
+        const SporeMod::Xml::InstalledSporeMod& installedSporeMod = l_InstalledSporeMods[i];
+        bool hasShownName = false;
+
+        for (const auto& installedFile : installedSporeMod.InstalledFiles)
         {
-            const std::filesystem::path& path = paths[i];
+            const SporeMod::FileState fileState = fileStates[fileIndex++];
+            const char* fileStateString;
 
-            if (!std::filesystem::is_regular_file(path))
+            switch (fileState)
             {
-                std::cerr << "Error: " << path << " is not a regular file or doesn't exist!" << std::endl;
-                close_zipfiles();
-                return false;
+            default:
+            case SporeMod::FileState::Unchanged:
+                continue;
+            case SporeMod::FileState::Modified:
+                fileStateString = "modified";
+                modifiedCount++;
+                break;
+            case SporeMod::FileState::Missing:
+                fileStateString = "missing";
+                missingCount++;
+                break;
+            case SporeMod::FileState::Unknown:
+                unknownCount++;
+                if (!UI::GetVerboseMode())
+                {
+                    continue;
+                }
+                fileStateString = "no fingerprint";
+                break;
             }
 
-            sporeModInfo = {};
-            extension = String::Lowercase(path.extension().string());
-            if (extension == ".sporemod" || extension == ".package")
+            if (!hasShownName)
             {
-                if (!get_sporemodinfo(path, extension, sporeModInfo))
-                {
+                std::cout << "[" << i << "] " << installedSporeMod.Name << std::endl;
+                hasShownName = true;
+            }
+
+            std::cout << "  " << fileStateString << ": " 
+                      << SporeMod::GetInstalledFilePath(installedSporeMod, installedFile).string() << std::endl;
+        }
+    }
+
+    // a DLL which can't be loaded makes Spore fail to start
+    DllImports::CheckInstalledImports(unresolvedCount);
+
+    std::cout << "-> Checked " << installedFiles.size() << " file(s) of " << l_InstalledSporeMods.size() << " mod(s), "
+              << modifiedCount << " modified, " << missingCount << " missing";
+    if (unknownCount > 0)
+    {
+        std::cout << ", " << unknownCount << " without fingerprint";
+    }
+    if (unresolvedCount > 0)
+    {
+        std::cout << ", " << unresolvedCount << " unresolved import(s)";
+    }
+    std::cout << std::endl;
+
+    hasChanges = modifiedCount > 0 || missingCount > 0 || unresolvedCount > 0;
+    return true;
+}
+
+bool SporeModManager::InstallMods(std::vector<std::filesystem::path>& paths, bool skipValidation, bool skipInstalled, bool skipConfiguration)
+{
+    std::vector<std::string> uniqueNames;
+    std::string              extension;
+    bool                     returnValue = true;
+    int                              installedSporeModId;
+    SporeMod::Xml::InstalledSporeMod installedSporeMod;
+    SporeMod::Xml::SporeModInfo      sporeModInfo;
+
+    if (!get_installedsporemodlist())
+    {
+        return false;
+    }
+
+    // do some basic validation before attempting
+    // to install the given mods
+    if (!skipValidation)
+    {
+        // remove duplicates
+        remove_duplicate_paths(paths, false);
+
+        // reserve list items
+        reserve_list_items(paths.size());
+
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            const std::filesystem::path& path = paths[i];
+
+            sporeModInfo = {};
+            extension = get_extension(path);
+            if (!check_path(path, extension))
+            {
+                close_zipfiles();
+                return false;
+            }
+
+            if (extension == ".sporemod" || extension == ".package")
+            {
+                if (!get_sporemodinfo(path, extension, sporeModInfo))
+                {
                     close_zipfiles();
                     return false;
                 }
@@ -231,8 +745,11 @@ bool SporeModManager::InstallMods(std::vector<std::filesystem::path>& paths, boo
             }
 
             // ensure the mod isn't already installed
+            // mods which were installed by an interrupted run
+            // are skipped, so a rerun continues where it stopped
             const bool hasInstalled = SporeMod::FindInstalledMod(sporeModInfo.UniqueName, installedSporeModId, l_InstalledSporeMods);
-            if (!skipInstalled && hasInstalled)
+            const bool hasRecovered = hasInstalled && is_recovered_sporemod(sporeModInfo.UniqueName);
+            if (!skipInstalled && hasInstalled && !hasRecovered)
             {
                 std::cerr << "Error: a mod with the same unique name (" << sporeModInfo.Name << ") has already been installed" << std::endl;
                 close_zipfiles();
@@ -244,12 +761,13 @@ bool SporeModManager::InstallMods(std::vector<std::filesystem::path>& paths, boo
             // with the same unique name or a mod with the same
             // unique name already being installed
             const bool hasUniqueName = std::find(uniqueNames.begin(), uniqueNames.end(), sporeModInfo.UniqueName) != uniqueNames.end();
-            const bool skipInstall   = skipInstalled && hasInstalled;
+            const bool skipInstall   = (skipInstalled || hasRecovered) && hasInstalled;
             if (hasUniqueName || skipInstall)
             {
                 std::cout << "Skipping " << path << (hasUniqueName ?
-                                " as it's already being installed!" :
-                                " as it's already installed!") << std::endl;
+                                " as it's already being installed!" : (hasRecovered ?
+                                " as it was installed by an interrupted run!" :
+                                " as it's already installed!")) << std::endl;
                 Zip::CloseFile(l_ZipFiles[i]);
                 paths.erase(paths.begin() + i);
                 l_ZipFiles.erase(l_ZipFiles.begin() + i);
@@ -264,12 +782,19 @@ bool SporeModManager::InstallMods(std::vector<std::filesystem::path>& paths, boo
     // configure given mods
     if (!skipConfiguration)
     {
+        // the resources of the given mods are
+        // compared against the index when configuring
+        if (!update_resource_index())
+        {
+            std::cerr << "Warning: failed to update resource index!" << std::endl;
+        }
+
         for (size_t i = 0; i < paths.size(); i++)
         {
             const std::filesystem::path& path = paths[i];
 
             installedSporeMod = {};
-            extension = String::Lowercase(path.extension().string());
+            extension = get_extension(path);
             if (extension == ".sporemod")
             {
                 if (!SporeMod::ConfigureSporeMod(l_ZipFiles[i], l_SporeModInfos[i], installedSporeMod, l_InstalledSporeMods))
@@ -295,27 +820,55 @@ bool SporeModManager::InstallMods(std::vector<std::filesystem::path>& paths, boo
     {
         const std::filesystem::path& path = paths[i];
         const size_t installedSporeModIndex = l_InstalledSporeMods.size() - paths.size() + i;
-        const SporeMod::Xml::InstalledSporeMod& installedSporeMod = l_InstalledSporeMods[installedSporeModIndex];
+        SporeMod::Xml::InstalledSporeMod& installedSporeMod = l_InstalledSporeMods[installedSporeModIndex];
+
+        // when updating, pass the previously installed mod
+        // along, so we can skip the files that haven't changed
+        const SporeMod::Xml::InstalledSporeMod* previousSporeMod = nullptr;
+        if (SporeMod::FindInstalledMod(installedSporeMod.UniqueName, installedSporeModId, l_PreviousSporeMods))
+        {
+            previousSporeMod = &l_PreviousSporeMods[installedSporeModId];
+        }
 
-        extension = String::Lowercase(path.extension().string());
+        extension = get_extension(path);
         if (extension == ".sporemod")
         {
-            if (!SporeMod::InstallSporeMod(l_ZipFiles[i], installedSporeMod))
+            if (!SporeMod::InstallSporeMod(l_ZipFiles[i], installedSporeMod, l_InstalledSporeMods, previousSporeMod))
             {
                 returnValue = false;
             }
         }
         else if (extension == ".package")
         {
-            if (!SporeMod::InstallPackage(path, installedSporeMod))
+            if (!SporeMod::InstallPackage(path, installedSporeMod, l_InstalledSporeMods, previousSporeMod))
             {
                 returnValue = false;
             }
         }
 
+        // record the mod in the journal, so an
+        // interrupted run doesn't lose track of it
+        if (returnValue && !SporeMod::Xml::AppendInstalledModJournal(installedSporeMod))
+        {
+            std::cerr << "Warning: failed to record " << installedSporeMod.Name << " in the journal!" << std::endl;
+        }
+
         if (!returnValue)
         {
-            l_InstalledSporeMods.erase(l_InstalledSporeMods.begin() + installedSporeModIndex, l_InstalledSporeMods.end());
+            // the files of mods which haven't been installed are
+            // left untouched, so keep the previous versions of them
+            for (size_t j = installedSporeModIndex; j < l_InstalledSporeMods.size(); j++)
+            {
+                if (SporeMod::FindInstalledMod(l_InstalledSporeMods[j].UniqueName, installedSporeModId, l_PreviousSporeMods))
+                {
+                    l_InstalledSporeMods[j] = l_PreviousSporeMods[installedSporeModId];
+                }
+                else
+                {
+                    l_InstalledSporeMods.erase(l_InstalledSporeMods.begin() + j);
+                    j -= 1;
+                }
+            }
             break;
         }
     }
@@ -326,6 +879,16 @@ bool SporeModManager::InstallMods(std::vector<std::filesystem::path>& paths, boo
         return false;
     }
 
+    if (!update_resource_index())
+    {
+        std::cerr << "Warning: failed to update resource index!" << std::endl;
+    }
+
+    if (!Cache::SaveStatistics())
+    {
+        std::cerr << "Warning: failed to save cache statistics!" << std::endl;
+    }
+
     close_zipfiles();
     return returnValue;
 }
@@ -356,14 +919,14 @@ bool SporeModManager::UpdateMods(std::vector<std::filesystem::path>& paths, bool
     {
         const std::filesystem::path& path = paths[i];
 
-        if (!std::filesystem::is_regular_file(path))
+        sporeModInfo = {};
+        extension = get_extension(path);
+        if (!check_path(path, extension))
         {
-            std::cerr << "Error: " << path << " is not a regular file or doesn't exist!" << std::endl;
+            close_zipfiles();
             return false;
         }
 
-        sporeModInfo = {};
-        extension = String::Lowercase(path.extension().string());
         if (extension == ".sporemod" || extension == ".package")
         {
             if (!get_sporemodinfo(path, extension, sporeModInfo))
@@ -392,6 +955,20 @@ bool SporeModManager::UpdateMods(std::vector<std::filesystem::path>& paths, bool
         }
         uniqueNames.push_back(sporeModInfo.UniqueName);
 
+        // mods which were updated by an interrupted
+        // run don't have to be updated again
+        if (is_recovered_sporemod(sporeModInfo.UniqueName))
+        {
+            std::cout << "Skipping " << path << " as it was " << 
+                         (requiresInstalled ? "updated" : "installed") << " by an interrupted run!" << std::endl;
+            Zip::CloseFile(l_ZipFiles[i]);
+            paths.erase(paths.begin() + i);
+            l_ZipFiles.erase(l_ZipFiles.begin() + i);
+            l_SporeModInfos.erase(l_SporeModInfos.begin() + i);
+            i -= 1;
+            continue;
+        }
+
         if (!SporeMod::FindInstalledMod(sporeModInfo.UniqueName, installedSporeModId, l_InstalledSporeMods))
         {
             if (requiresInstalled)
@@ -403,10 +980,23 @@ bool SporeModManager::UpdateMods(std::vector<std::filesystem::path>& paths, bool
         }
         else
         {
+            // the files of disabled mods aren't
+            // in the install locations
+            if (l_InstalledSporeMods[installedSporeModId].IsDisabled)
+            {
+                close_zipfiles();
+                std::cerr << "Error: " << l_InstalledSporeMods[installedSporeModId].Name << " is disabled, enable it before updating it!" << std::endl;
+                return false;
+            }
             installedSporeModIds.push_back(installedSporeModId);
         }
     }
 
+    if (!update_resource_index())
+    {
+        std::cerr << "Warning: failed to update resource index!" << std::endl;
+    }
+
     // configure mods before attempting
     // to updating the given mods
     for (size_t i = 0; i < paths.size(); i++)
@@ -414,7 +1004,7 @@ bool SporeModManager::UpdateMods(std::vector<std::filesystem::path>& paths, bool
         const std::filesystem::path& path = paths[i];
 
         installedSporeMod = {};
-        extension = String::Lowercase(path.extension().string());
+        extension = get_extension(path);
         if (extension == ".sporemod")
         {
             if (!SporeMod::ConfigureSporeMod(l_ZipFiles[i], l_SporeModInfos[i], installedSporeMod, l_InstalledSporeMods))
@@ -434,28 +1024,89 @@ bool SporeModManager::UpdateMods(std::vector<std::filesystem::path>& paths, bool
         l_InstalledSporeMods.push_back(installedSporeMod);
     }
 
-    // disable saving the installed mod list when uninstalling mods
-    l_SaveInstalledSporeMods = false;
-
-    // apply changes
-    if (!installedSporeModIds.empty() && !UninstallMods(installedSporeModIds))
+    // the packages of the updated mods are restored before
+    // they're replaced, this is only done after every mod
+    // has been configured, because configuring can fail
+    std::vector<const SporeMod::Xml::InstalledSporeMod*> updatedSporeMods;
+    for (const auto& id : installedSporeModIds)
     {
+        updatedSporeMods.push_back(&l_InstalledSporeMods[id]);
+    }
+    if (!unmerge_sporemods(updatedSporeMods))
+    {
+        // remove the configured mods again,
+        // so they aren't saved as installed
+        l_InstalledSporeMods.resize(l_InstalledSporeMods.size() - paths.size());
+        save_installedsporemodlist();
         close_zipfiles();
         return false;
     }
 
-    // save installed mod list when installing mods
-    l_SaveInstalledSporeMods = true;
+    // move the installed mods out of the list, InstallMods
+    // uses them to only install the files which have changed
+    // and to remove the files which aren't part of the mod anymore
+    std::sort(installedSporeModIds.rbegin(), installedSporeModIds.rend());
+    for (const auto& id : installedSporeModIds)
+    {
+        l_PreviousSporeMods.push_back(l_InstalledSporeMods[id]);
+        l_InstalledSporeMods.erase(l_InstalledSporeMods.begin() + id);
+    }
 
     return InstallMods(paths, true, false, true);
 }
 
+bool SporeModManager::InstallModsToTargets(const std::vector<std::filesystem::path>& paths, const std::vector<std::filesystem::path>& targets,
+                                           bool update, bool skipInstalled)
+{
+    std::vector<std::filesystem::path> targetPaths;
+    bool returnValue = true;
+
+    // the downloaded files are used for every target
+    l_KeepDownloadedFiles = true;
+
+    for (const auto& target : targets)
+    {
+        std::cout << "-> Installing to target " << target << std::endl;
+
+        // every target has its own configuration file,
+        // which contains the directories and installed mods
+        Path::SetConfigFilePath(target);
+        Path::SetDirectories({}, {}, {}, {});
+        reset_lists();
+
+        if (!Path::CheckIfPathsExist())
+        {
+            returnValue = false;
+            continue;
+        }
+
+        // files which have been extracted for an earlier
+        // target are copied from there instead of extracted again
+        targetPaths = paths;
+        if (update)
+        {
+            if (!UpdateMods(targetPaths, false))
+            {
+                returnValue = false;
+            }
+        }
+        else if (!InstallMods(targetPaths, false, skipInstalled))
+        {
+            returnValue = false;
+        }
+    }
+
+    l_KeepDownloadedFiles = false;
+    remove_downloaded_files();
+    reset_lists();
+    return returnValue;
+}
+
 bool SporeModManager::UninstallMods(const std::vector<int>& ids)
 {
-    std::vector<SporeMod::Xml::InstalledSporeMod> removedSporeMods;
-    SporeMod::Xml::InstalledSporeMod installedSporeMod;
-    std::filesystem::path fullInstallPath;
-    std::error_code error;
+    std::vector<const SporeMod::Xml::InstalledSporeMod*> removedSporeMods;
+    std::vector<bool> removeSporeMod;
+    size_t installedSporeModCount = 0;
 
     if (!get_installedsporemodlist())
     {
@@ -471,44 +1122,996 @@ bool SporeModManager::UninstallMods(const std::vector<int>& ids)
         }
     }
 
+    removeSporeMod.resize(l_InstalledSporeMods.size(), false);
     for (const auto& id : ids)
     {
-        installedSporeMod = l_InstalledSporeMods[id];
+        if (removeSporeMod[id])
+        {
+            continue;
+        }
 
-        std::cout << "-> Removing " << installedSporeMod.Name << std::endl;
+        std::cout << "-> Removing " << l_InstalledSporeMods[id].Name << std::endl;
+        removeSporeMod[id] = true;
+        removedSporeMods.push_back(&l_InstalledSporeMods[id]);
+    }
 
-        for (const auto& installedFile : installedSporeMod.InstalledFiles)
+    if (!SporeMod::UninstallSporeMods(removedSporeMods, l_InstalledSporeMods))
+    {
+        return false;
+    }
+
+    // remove the mods from the list in a single pass
+    for (size_t i = 0; i < l_InstalledSporeMods.size(); i++)
+    {
+        if (!removeSporeMod[i])
         {
-            fullInstallPath = Path::GetFullInstallPath(installedFile.InstallLocation, installedFile.FileName);
-            if (UI::GetVerboseMode())
-            {
-                std::cout << "--> Removing " << fullInstallPath << std::endl;
-            }
-            std::filesystem::remove(fullInstallPath, error);
-            if (error)
+            if (i != installedSporeModCount)
             {
-                std::cerr << "Error: failed to remove " << fullInstallPath << ": " << error.message() << std::endl;
-                return false;
+                l_InstalledSporeMods[installedSporeModCount] = std::move(l_InstalledSporeMods[i]);
             }
+            installedSporeModCount++;
+        }
+    }
+    l_InstalledSporeMods.resize(installedSporeModCount);
+
+    if (!save_installedsporemodlist())
+    {
+        return false;
+    }
+
+    // the merged packages don't contain
+    // the packages of the removed mods
+    if (!update_merged_packages())
+    {
+        return false;
+    }
+
+    if (!update_resource_index())
+    {
+        std::cerr << "Warning: failed to update resource index!" << std::endl;
+    }
+
+    return true;
+}
+
+bool SporeModManager::SetModsEnabled(const std::vector<int>& ids, bool enable)
+{
+    bool returnValue = true;
+
+    if (!get_installedsporemodlist())
+    {
+        return false;
+    }
+
+    for (const auto& id : ids)
+    {
+        if (id < 0 || (size_t)id >= l_InstalledSporeMods.size())
+        {
+            std::cerr << "Error: ID(s) must be valid!" << std::endl;
+            return false;
+        }
+    }
+
+    // the packages of disabled mods
+    // can't be in a merged package
+    if (!enable)
+    {
+        std::vector<const SporeMod::Xml::InstalledSporeMod*> disabledSporeMods;
+        for (const auto& id : ids)
+        {
+            disabledSporeMods.push_back(&l_InstalledSporeMods[id]);
         }
 
-        removedSporeMods.push_back(installedSporeMod);
+        if (!unmerge_sporemods(disabledSporeMods))
+        {
+            save_installedsporemodlist();
+            return false;
+        }
     }
 
-    for (const auto& removedSporeMod : removedSporeMods)
+    for (const auto& id : ids)
     {
-        auto installedSporeModIter = std::find(l_InstalledSporeMods.begin(), l_InstalledSporeMods.end(), removedSporeMod);
-        if (installedSporeModIter != l_InstalledSporeMods.end())
+        SporeMod::Xml::InstalledSporeMod& installedSporeMod = l_InstalledSporeMods[id];
+
+        if (installedSporeMod.IsDisabled != enable)
+        {
+            std::cout << "Skipping " << installedSporeMod.Name << " as it's already " << (enable ? "enabled" : "disabled") << "!" << std::endl;
+            continue;
+        }
+
+        std::cout << "-> " << (enable ? "Enabling " : "Disabling ") << installedSporeMod.Name << std::endl;
+        if (!SporeMod::SetSporeModEnabled(installedSporeMod, enable, l_InstalledSporeMods))
         {
-            l_InstalledSporeMods.erase(installedSporeModIter);
+            returnValue = false;
+            break;
         }
     }
 
+    // save the state of the mods
+    // which have been moved already
     if (!save_installedsporemodlist())
     {
         return false;
     }
 
+    return returnValue;
+}
+
+bool SporeModManager::ListProfiles(void)
+{
+    std::vector<SporeMod::Xml::Profile> profiles;
+    std::string activeProfile;
+
+    if (!SporeMod::Xml::GetProfiles(profiles, activeProfile))
+    {
+        std::cerr << "Error: failed to retrieve profiles!" << std::endl;
+        return false;
+    }
+
+    for (const auto& profile : profiles)
+    {
+        std::cout << (profile.Name == activeProfile ? "* " : "  ") << profile.Name 
+                  << " (" << profile.UniqueNames.size() << " mod(s))" << std::endl;
+    }
+
+    return true;
+}
+
+bool SporeModManager::SaveProfile(const std::string& name)
+{
+    std::vector<SporeMod::Xml::Profile> profiles;
+    std::vector<SporeMod::Xml::Profile>::iterator profileIter;
+    std::string activeProfile;
+    SporeMod::Xml::Profile profile;
+
+    if (!get_installedsporemodlist())
+    {
+        return false;
+    }
+
+    if (!SporeMod::Xml::GetProfiles(profiles, activeProfile))
+    {
+        std::cerr << "Error: failed to retrieve profiles!" << std::endl;
+        return false;
+    }
+
+    // a profile consists of the enabled mods,
+    // the installed mods keep the chosen components
+    profile.Name = name;
+    for (const auto& installedSporeMod : l_InstalledSporeMods)
+    {
+        if (!installedSporeMod.IsDisabled)
+        {
+            profile.UniqueNames.push_back(installedSporeMod.UniqueName);
+        }
+    }
+
+    profileIter = std::find_if(profiles.begin(), profiles.end(), [name](const SporeMod::Xml::Profile& profile)
+    {
+        return profile.Name == name;
+    });
+    if (profileIter != profiles.end())
+    {
+        *profileIter = profile;
+    }
+    else
+    {
+        profiles.push_back(profile);
+    }
+
+    if (!SporeMod::Xml::SaveProfiles(profiles, name))
+    {
+        std::cerr << "Error: failed to save profiles!" << std::endl;
+        return false;
+    }
+
+    std::cout << "-> Saved profile " << name << " with " << profile.UniqueNames.size() << " mod(s)" << std::endl;
+    return true;
+}
+
+bool SporeModManager::SwitchProfile(const std::string& name)
+{
+    std::vector<SporeMod::Xml::Profile> profiles;
+    std::vector<SporeMod::Xml::Profile>::iterator profileIter;
+    std::vector<SporeMod::Xml::InstalledSporeMod*> enabledSporeMods;
+    std::vector<SporeMod::Xml::InstalledSporeMod*> disabledSporeMods;
+    std::string activeProfile;
+    int  installedSporeModId;
+    bool returnValue = true;
+
+    if (!get_installedsporemodlist())
+    {
+        return false;
+    }
+
+    if (!SporeMod::Xml::GetProfiles(profiles, activeProfile))
+    {
+        std::cerr << "Error: failed to retrieve profiles!" << std::endl;
+        return false;
+    }
+
+    if (!find_profile(name, profiles, profileIter))
+    {
+        return false;
+    }
+
+    // ensure every mod of the profile is
+    // installed before changing anything
+    for (const auto& uniqueName : profileIter->UniqueNames)
+    {
+        if (!SporeMod::FindInstalledMod(uniqueName, installedSporeModId, l_InstalledSporeMods))
+        {
+            std::cerr << "Error: " << uniqueName << " from profile " << name << " isn't installed!" << std::endl;
+            return false;
+        }
+    }
+
+    // only the mods which differ from
+    // the profile have to be moved
+    for (auto& installedSporeMod : l_InstalledSporeMods)
+    {
+        const bool inProfile = std::find(profileIter->UniqueNames.begin(), profileIter->UniqueNames.end(), 
+                                         installedSporeMod.UniqueName) != profileIter->UniqueNames.end();
+        if (inProfile && installedSporeMod.IsDisabled)
+        {
+            enabledSporeMods.push_back(&installedSporeMod);
+        }
+        else if (!inProfile && !installedSporeMod.IsDisabled)
+        {
+            disabledSporeMods.push_back(&installedSporeMod);
+        }
+    }
+
+    std::cout << "-> Switching to profile " << name << ", enabling " << enabledSporeMods.size() 
+              << " and disabling " << disabledSporeMods.size() << " mod(s)" << std::endl;
+
+    if (!unmerge_sporemods({ disabledSporeMods.begin(), disabledSporeMods.end() }))
+    {
+        save_installedsporemodlist();
+        return false;
+    }
+
+    // disable mods first, so the files of
+    // the enabled mods don't conflict with them
+    for (const auto& installedSporeMod : disabledSporeMods)
+    {
+        std::cout << "-> Disabling " << installedSporeMod->Name << std::endl;
+        if (!SporeMod::SetSporeModEnabled(*installedSporeMod, false, l_InstalledSporeMods))
+        {
+            returnValue = false;
+            break;
+        }
+    }
+
+    for (size_t i = 0; returnValue && i < enabledSporeMods.size(); i++)
+    {
+        std::cout << "-> Enabling " << enabledSporeMods[i]->Name << std::endl;
+        if (!SporeMod::SetSporeModEnabled(*enabledSporeMods[i], true, l_InstalledSporeMods))
+        {
+            returnValue = false;
+        }
+    }
+
+    if (!save_installedsporemodlist())
+    {
+        return false;
+    }
+
+    // the active profile is only changed
+    // when all mods have been switched
+    if (returnValue && !SporeMod::Xml::SaveProfiles(profiles, name))
+    {
+        std::cerr << "Error: failed to save profiles!" << std::endl;
+        return false;
+    }
+
+    return returnValue;
+}
+
+bool SporeModManager::DeleteProfile(const std::string& name)
+{
+    std::vector<SporeMod::Xml::Profile> profiles;
+    std::vector<SporeMod::Xml::Profile>::iterator profileIter;
+    std::string activeProfile;
+
+    if (!SporeMod::Xml::GetProfiles(profiles, activeProfile))
+    {
+        std::cerr << "Error: failed to retrieve profiles!" << std::endl;
+        return false;
+    }
+
+    if (!find_profile(name, profiles, profileIter))
+    {
+        return false;
+    }
+
+    profiles.erase(profileIter);
+
+    if (!SporeMod::Xml::SaveProfiles(profiles, activeProfile == name ? "" : activeProfile))
+    {
+        std::cerr << "Error: failed to save profiles!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool SporeModManager::ShowCacheStatistics(void)
+{
+    Cache::CacheStatistics statistics;
+
+    if (Cache::GetCachePath().empty())
+    {
+        std::cerr << "Error: no cache path has been given!" << std::endl;
+        return false;
+    }
+
+    if (!Cache::GetStatistics(statistics))
+    {
+        return false;
+    }
+
+    const uint64_t lookups = statistics.Hits + statistics.Misses;
+    std::cout << "Entries: " << statistics.EntryCount << std::endl
+              << "Size:    " << statistics.Size << " / " << statistics.MaxSize << " bytes" << std::endl
+              << "Hits:    " << statistics.Hits << std::endl
+              << "Misses:  " << statistics.Misses << std::endl
+              << "Ratio:   " << (lookups == 0 ? 0 : (statistics.Hits * 100 / lookups)) << "%" << std::endl;
+    return true;
+}
+
+bool SporeModManager::ShowConflicts(void)
+{
+    struct indexed_package
+    {
+        SporeMod::InstallLocation InstallLocation;
+        std::filesystem::path     FileName;
+        std::string               Name;
+    };
+
+    std::vector<indexed_package>   indexedPackages;
+    std::vector<Dbpf::ResourceKey> resourceKeys;
+    std::unordered_map<Dbpf::ResourceKey, std::vector<size_t>, Dbpf::ResourceKeyHash> resourcePackages;
+    std::map<std::vector<size_t>, std::vector<Dbpf::ResourceKey>> conflicts;
+
+    if (!get_installedsporemodlist())
+    {
+        return false;
+    }
+
+    if (!update_resource_index())
+    {
+        std::cerr << "Warning: failed to update resource index!" << std::endl;
+    }
+
+    for (const auto& installedSporeMod : l_InstalledSporeMods)
+    {
+        // the game doesn't load disabled mods
+        if (installedSporeMod.IsDisabled)
+        {
+            continue;
+        }
+
+        for (const auto& installedFile : installedSporeMod.InstalledFiles)
+        {
+            // shared packages are only counted once
+            auto predicate = [installedFile](const indexed_package& indexedPackage)
+            {
+                return indexedPackage.InstallLocation == installedFile.InstallLocation &&
+                        indexedPackage.FileName == installedFile.FileName;
+            };
+            if (get_extension(installedFile.FileName) != ".package" ||
+                std::find_if(indexedPackages.begin(), indexedPackages.end(), predicate) != indexedPackages.end() ||
+                !ResourceIndex::GetResources(installedFile.InstallLocation, installedFile.FileName, resourceKeys))
+            {
+                continue;
+            }
+
+            indexedPackages.push_back({ installedFile.InstallLocation, installedFile.FileName, installedSporeMod.Name });
+            for (const auto& resourceKey : resourceKeys)
+            {
+                std::vector<size_t>& packageIds = resourcePackages[resourceKey];
+                if (packageIds.empty() || packageIds.back() != indexedPackages.size() - 1)
+                {
+                    packageIds.push_back(indexedPackages.size() - 1);
+                }
+            }
+        }
+    }
+
+    // group the resources by the packages
+    // which contain them, so every set of
+    // conflicting packages is shown once
+    for (const auto& resourcePackage : resourcePackages)
+    {
+        if (resourcePackage.second.size() > 1)
+        {
+            conflicts[resourcePackage.second].push_back(resourcePackage.first);
+        }
+    }
+
+    if (conflicts.empty())
+    {
+        std::cout << "No conflicting resources found" << std::endl;
+        return true;
+    }
+
+    for (auto& conflict : conflicts)
+    {
+        std::cout << "-> " << conflict.second.size() << " resource(s) are in ";
+        for (size_t i = 0; i < conflict.first.size(); i++)
+        {
+            const indexed_package& indexedPackage = indexedPackages[conflict.first[i]];
+            if (i > 0)
+            {
+                std::cout << (i == conflict.first.size() - 1 ? " and " : ", ");
+            }
+            std::cout << indexedPackage.FileName << " (" << indexedPackage.Name << ")";
+        }
+        std::cout << std::endl;
+
+        if (UI::GetVerboseMode())
+        {
+            std::sort(conflict.second.begin(), conflict.second.end());
+            for (const auto& resourceKey : conflict.second)
+            {
+                std::cout << "--> " << ResourceNames::GetKeyString(resourceKey) << std::endl;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool SporeModManager::MergePackages(const std::vector<int>& ids)
+{
+    std::vector<SporeMod::Xml::MergedPackage> mergedPackages;
+    std::vector<SporeMod::Xml::MergedPackage> previousMergedPackages;
+    std::vector<SporeMod::Xml::SporeModFile>  mergedFiles;
+    std::vector<SporeMod::Xml::SporeModFile>  restoredFiles;
+    std::error_code error;
+    bool returnValue = true;
+
+    if (!get_installedsporemodlist())
+    {
+        return false;
+    }
+
+    for (const auto& id : ids)
+    {
+        if (id < 0 || (size_t)id >= l_InstalledSporeMods.size())
+        {
+            std::cerr << "Error: ID(s) must be valid!" << std::endl;
+            return false;
+        }
+
+        if (l_InstalledSporeMods[id].IsDisabled)
+        {
+            std::cerr << "Error: " << l_InstalledSporeMods[id].Name << " is disabled, enable it before merging it!" << std::endl;
+            return false;
+        }
+    }
+
+    if (!SporeMod::Xml::GetMergedPackages(previousMergedPackages))
+    {
+        std::cerr << "Error: failed to retrieve merged packages!" << std::endl;
+        return false;
+    }
+
+    // the game loads the packages of every data directory,
+    // so there's a merged package for every data directory,
+    // packages of later ids override the ones of earlier ids
+    for (const auto& id : ids)
+    {
+        for (const auto& installedFile : l_InstalledSporeMods[id].InstalledFiles)
+        {
+            if (get_extension(installedFile.FileName) != ".package" ||
+                installedFile.InstallLocation == SporeMod::InstallLocation::ModLibs)
+            {
+                continue;
+            }
+
+            auto mergedPackageIter = std::find_if(mergedPackages.begin(), mergedPackages.end(), [installedFile](const SporeMod::Xml::MergedPackage& mergedPackage)
+            {
+                return mergedPackage.InstallLocation == installedFile.InstallLocation;
+            });
+            if (mergedPackageIter == mergedPackages.end())
+            {
+                mergedPackages.push_back({ installedFile.InstallLocation, SPOREMODMANAGER_MERGED_PACKAGE, {} });
+                mergedPackageIter = mergedPackages.end() - 1;
+            }
+
+            // packages which are shared are only merged once
+            std::vector<std::filesystem::path>& sourceFileNames = mergedPackageIter->SourceFileNames;
+            sourceFileNames.erase(std::remove(sourceFileNames.begin(), sourceFileNames.end(), installedFile.FileName), sourceFileNames.end());
+            sourceFileNames.push_back(installedFile.FileName);
+        }
+    }
+
+    if (mergedPackages.empty())
+    {
+        std::cerr << "Error: the given mod(s) don't contain any packages!" << std::endl;
+        return false;
+    }
+
+    // the merge replaces the previous one, so restore
+    // the packages which aren't part of it anymore
+    for (const auto& installedSporeMod : l_InstalledSporeMods)
+    {
+        for (const auto& installedFile : installedSporeMod.InstalledFiles)
+        {
+            if (!installedSporeMod.IsDisabled && installedFile.IsMerged)
+            {
+                auto mergedPackageIter = std::find_if(mergedPackages.begin(), mergedPackages.end(), [installedFile](const SporeMod::Xml::MergedPackage& mergedPackage)
+                {
+                    return mergedPackage.InstallLocation == installedFile.InstallLocation &&
+                        std::find(mergedPackage.SourceFileNames.begin(), mergedPackage.SourceFileNames.end(), installedFile.FileName) != mergedPackage.SourceFileNames.end();
+                });
+                if (mergedPackageIter == mergedPackages.end())
+                {
+                    restoredFiles.push_back(installedFile);
+                }
+            }
+        }
+    }
+
+    for (const auto& restoredFile : restoredFiles)
+    {
+        if (is_merged_package(restoredFile.InstallLocation, restoredFile.FileName) &&
+            !SporeMod::SetPackageMerged(l_InstalledSporeMods, restoredFile, false))
+        {
+            returnValue = false;
+            break;
+        }
+    }
+
+    for (size_t i = 0; returnValue && i < mergedPackages.size(); i++)
+    {
+        const SporeMod::Xml::MergedPackage& mergedPackage = mergedPackages[i];
+
+        if (!build_merged_package(mergedPackage))
+        {
+            mergedPackages.erase(mergedPackages.begin() + i, mergedPackages.end());
+            returnValue = false;
+            break;
+        }
+
+        // the sources are moved after the merged package
+        // has been written, so they're never missing
+        for (const auto& sourceFileName : mergedPackage.SourceFileNames)
+        {
+            SporeMod::Xml::SporeModFile sourceFile;
+            sourceFile.InstallLocation = mergedPackage.InstallLocation;
+            sourceFile.FileName        = sourceFileName;
+
+            if (is_merged_package(sourceFile.InstallLocation, sourceFile.FileName))
+            {
+                continue;
+            }
+            if (!SporeMod::SetPackageMerged(l_InstalledSporeMods, sourceFile, true))
+            {
+                returnValue = false;
+                break;
+            }
+        }
+    }
+
+    // merged packages of which all sources have
+    // been restored have to be removed as well
+    for (const auto& previousMergedPackage : previousMergedPackages)
+    {
+        auto mergedPackageIter = std::find_if(mergedPackages.begin(), mergedPackages.end(), [previousMergedPackage](const SporeMod::Xml::MergedPackage& mergedPackage)
+        {
+            return mergedPackage.InstallLocation == previousMergedPackage.InstallLocation;
+        });
+        if (mergedPackageIter == mergedPackages.end())
+        {
+            mergedPackages.push_back(previousMergedPackage);
+        }
+    }
+
+    // the merged packages have to match the packages which have been moved,
+    // so save them even when we've failed, updating them removes the
+    // packages which haven't been moved from them
+    if (!SporeMod::Xml::SaveMergedPackages(mergedPackages) ||
+        !save_installedsporemodlist())
+    {
+        return false;
+    }
+
+    if (!update_merged_packages())
+    {
+        return false;
+    }
+
+    return returnValue;
+}
+
+bool SporeModManager::UnmergePackages(void)
+{
+    std::vector<const SporeMod::Xml::InstalledSporeMod*> installedSporeMods;
+    bool returnValue;
+
+    if (!get_installedsporemodlist())
+    {
+        return false;
+    }
+
+    for (const auto& installedSporeMod : l_InstalledSporeMods)
+    {
+        installedSporeMods.push_back(&installedSporeMod);
+    }
+
+    returnValue = unmerge_sporemods(installedSporeMods);
+
+    if (!save_installedsporemodlist())
+    {
+        return false;
+    }
+
+    return returnValue;
+}
+
+bool SporeModManager::CompactPackages(const std::vector<std::filesystem::path>& paths)
+{
+    std::error_code error;
+    uint64_t size;
+    uint64_t compactedSize;
+    bool     isCompacted;
+
+    for (const auto& path : paths)
+    {
+        size = std::filesystem::file_size(path, error);
+        if (error)
+        {
+            std::cerr << "Error: failed to retrieve file size of " << path << ": " << error.message() << std::endl;
+            return false;
+        }
+
+        if (!Dbpf::CompactPackage(path, path, isCompacted))
+        {
+            std::cerr << "Error: failed to compact " << path << std::endl;
+            return false;
+        }
+
+        if (!isCompacted)
+        {
+            std::cout << "-> " << path << " is already compact" << std::endl;
+            continue;
+        }
+
+        compactedSize = std::filesystem::file_size(path, error);
+        if (error)
+        {
+            std::cerr << "Error: failed to retrieve file size of " << path << ": " << error.message() << std::endl;
+            return false;
+        }
+
+        std::cout << "-> Compacted " << path << " from " << size << " to " << compactedSize << " bytes" << std::endl;
+    }
+
+    return true;
+}
+
+bool SporeModManager::InspectPackage(const std::filesystem::path& path, bool hashResources, const std::filesystem::path& dumpPath)
+{
+    std::vector<Dbpf::ResourceEntry> entries;
+    std::vector<std::string> resourceHashes;
+    std::error_code error;
+    uint64_t compressedSize = 0;
+    uint64_t size = 0;
+
+    if (!Dbpf::ReadIndex(path, entries))
+    {
+        std::cerr << "Error: failed to read the index of " << path << std::endl;
+        return false;
+    }
+
+    // the resources are only decompressed
+    // when their contents are needed
+    if (hashResources || !dumpPath.empty())
+    {
+        if (!dumpPath.empty())
+        {
+            std::filesystem::create_directories(dumpPath, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to create directory " << dumpPath << ": " << error.message() << std::endl;
+                return false;
+            }
+        }
+
+        resourceHashes.resize(entries.size());
+
+        const auto startTime = std::chrono::steady_clock::now();
+        if (!Dbpf::ReadResources(path, entries, [&](size_t index, const char* data, size_t dataSize)
+            {
+                if (hashResources)
+                {
+                    resourceHashes[index] = Hash::Sha256(data, dataSize);
+                }
+
+                if (!dumpPath.empty())
+                {
+                    const std::filesystem::path resourcePath = Path::Combine({ dumpPath, Dbpf::GetKeyString(entries[index].Key) });
+                    std::ofstream resourceStream(resourcePath, std::ios::binary | std::ios::trunc);
+                    if (!resourceStream.is_open() || !resourceStream.write(data, dataSize))
+                    {
+                        std::cerr << "Error: failed to write " << resourcePath << std::endl;
+                        return false;
+                    }
+                }
+
+                return true;
+            }))
+        {
+            return false;
+        }
+        const auto endTime = std::chrono::steady_clock::now();
+
+        if (UI::GetVerboseMode())
+        {
+            uint64_t decodedSize = 0;
+            for (const auto& entry : entries)
+            {
+                decodedSize += entry.IsCompressed ? entry.Size : entry.CompressedSize;
+            }
+
+            std::cout << "--> Decoded " << entries.size() << " resource(s), " << decodedSize << " bytes in "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << " ms" << std::endl;
+        }
+    }
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const Dbpf::ResourceEntry& entry = entries[i];
+        const uint32_t entrySize = entry.IsCompressed ? entry.Size : entry.CompressedSize;
+
+        std::cout << ResourceNames::GetKeyString(entry.Key) << " "
+                  << entry.CompressedSize << " / " << entrySize << " bytes "
+                  << "(" << (entrySize == 0 ? 100 : (static_cast<uint64_t>(entry.CompressedSize) * 100 / entrySize)) << "%)";
+        if (hashResources)
+        {
+            std::cout << " " << resourceHashes[i];
+        }
+        std::cout << std::endl;
+
+        compressedSize += entry.CompressedSize;
+        size           += entrySize;
+    }
+
+    std::cout << "Resources: " << entries.size() << std::endl
+              << "Size:      " << compressedSize << " / " << size << " bytes" << std::endl
+              << "Ratio:     " << (size == 0 ? 100 : (compressedSize * 100 / size)) << "%" << std::endl;
+    return true;
+}
+
+bool SporeModManager::AddNames(const std::vector<std::filesystem::path>& paths)
+{
+    std::vector<std::string> names;
+    std::string name;
+
+    for (const auto& path : paths)
+    {
+        std::ifstream namesStream(path);
+        if (!namesStream.is_open())
+        {
+            std::cerr << "Error: failed to open " << path << std::endl;
+            return false;
+        }
+
+        // every line is a name, which
+        // can end with a carriage return
+        while (std::getline(namesStream, name))
+        {
+            if (!name.empty() && name.back() == '\r')
+            {
+                name.pop_back();
+            }
+            names.push_back(name);
+        }
+
+        if (namesStream.bad())
+        {
+            std::cerr << "Error: failed to read " << path << std::endl;
+            return false;
+        }
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    if (!ResourceNames::AddNames(names))
+    {
+        return false;
+    }
+
+    if (UI::GetVerboseMode())
+    {
+        const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+        std::cout << "--> Added " << names.size() << " name(s) in " << duration.count() << " ms" << std::endl;
+    }
+
+    return true;
+}
+
+bool SporeModManager::HashNames(const std::vector<std::string>& names)
+{
+    std::vector<uint32_t> hashes;
+    char hashString[16];
+
+    Hash::Fnv(names, hashes);
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        std::snprintf(hashString, sizeof(hashString), "0x%08x", static_cast<unsigned int>(hashes[i]));
+        std::cout << hashString << " " << names[i] << std::endl;
+    }
+
+    return true;
+}
+
+bool SporeModManager::ShowLoadOrder(void)
+{
+    const std::filesystem::path modLibsPath = Path::GetModLibsPath();
+    LoadManifest::Manifest manifest;
+
+    if (LoadManifest::Read(modLibsPath, manifest) && LoadManifest::IsCurrent(modLibsPath, manifest))
+    {
+        if (UI::GetVerboseMode())
+        {
+            std::cout << "--> Using load manifest " << LoadManifest::GetManifestPath(modLibsPath) << std::endl;
+        }
+    }
+    else
+    {
+        if (UI::GetVerboseMode())
+        {
+            std::cout << "--> Load manifest " << LoadManifest::GetManifestPath(modLibsPath) << " is outdated, listing " << modLibsPath << std::endl;
+        }
+
+        if (!LoadManifest::Create(modLibsPath, manifest))
+        {
+            std::cerr << "Error: failed to list " << modLibsPath << std::endl;
+            return false;
+        }
+    }
+
+    for (const auto& file : manifest.Files)
+    {
+        std::cout << file.FileName.string() << std::endl;
+    }
+
+    return true;
+}
+
+bool SporeModManager::ShowLoaderReport(const std::filesystem::path& path)
+{
+    struct profiled_dll
+    {
+        std::filesystem::path FileName;
+        int64_t LoadDuration   = 0;
+        int64_t UnloadDuration = 0;
+        bool    HasFailed      = false;
+    };
+
+    std::vector<LoaderProfile::Event> events;
+    std::vector<profiled_dll> profiledDlls;
+    int64_t phaseDurations[static_cast<size_t>(LoaderProfile::EventType::Count)] = { 0 };
+    bool    hasPhase[static_cast<size_t>(LoaderProfile::EventType::Count)] = { false };
+    int64_t startTime = INT64_MAX;
+    int64_t loadedTime = 0;
+
+    if (!LoaderProfile::Read(path, events))
+    {
+        std::cerr << "Error: failed to read loader profile " << path << std::endl;
+        return false;
+    }
+
+    if (!get_installedsporemodlist())
+    {
+        return false;
+    }
+
+    if (UI::GetVerboseMode())
+    {
+        std::cout << "--> Read " << events.size() << " event(s) from " << path << std::endl;
+    }
+
+    for (const auto& event : events)
+    {
+        if (event.Type == LoaderProfile::EventType::LoadDll ||
+            event.Type == LoaderProfile::EventType::UnloadDll)
+        {
+            auto profiledDllIter = std::find_if(profiledDlls.begin(), profiledDlls.end(), [event](const profiled_dll& profiledDll)
+            {
+                return profiledDll.FileName == event.FileName;
+            });
+            if (profiledDllIter == profiledDlls.end())
+            {
+                profiledDlls.push_back({ event.FileName });
+                profiledDllIter = profiledDlls.end() - 1;
+            }
+
+            if (event.Type == LoaderProfile::EventType::LoadDll)
+            {
+                profiledDllIter->LoadDuration += event.Duration;
+            }
+            else
+            {
+                profiledDllIter->UnloadDuration += event.Duration;
+            }
+            profiledDllIter->HasFailed |= !event.Result;
+            continue;
+        }
+
+        phaseDurations[static_cast<size_t>(event.Type)] += event.Duration;
+        hasPhase[static_cast<size_t>(event.Type)] = true;
+
+        // the game initializes itself between the phases,
+        // which is included in the time until mods are loaded
+        startTime = std::min(startTime, event.StartTime);
+        if (event.Type == LoaderProfile::EventType::LoadModLibs)
+        {
+            loadedTime = event.StartTime + event.Duration;
+        }
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(LoaderProfile::EventType::Count); i++)
+    {
+        if (!hasPhase[i])
+        {
+            continue;
+        }
+
+        const std::string name = LoaderProfile::GetEventTypeName(static_cast<LoaderProfile::EventType>(i));
+        std::cout << name << ":" << std::string(name.size() < 23 ? 23 - name.size() : 1, ' ')
+                  << get_duration_string(phaseDurations[i]) << std::endl;
+    }
+
+    if (loadedTime != 0)
+    {
+        std::cout << "Startup:" << std::string(16, ' ') << get_duration_string(loadedTime - startTime) << std::endl;
+    }
+
+    // the DLLs which take the longest to load are the
+    // ones which add the most time to starting the game
+    std::stable_sort(profiledDlls.begin(), profiledDlls.end(), [](const profiled_dll& a, const profiled_dll& b)
+    {
+        if (a.LoadDuration != b.LoadDuration)
+        {
+            return a.LoadDuration > b.LoadDuration;
+        }
+        return a.UnloadDuration > b.UnloadDuration;
+    });
+
+    for (size_t i = 0; i < profiledDlls.size(); i++)
+    {
+        const profiled_dll& profiledDll = profiledDlls[i];
+
+        std::cout << (i + 1) << ". " << profiledDll.FileName;
+        for (const auto& installedSporeMod : l_InstalledSporeMods)
+        {
+            auto predicate = [profiledDll](const SporeMod::Xml::SporeModFile& installedFile)
+            {
+                return installedFile.InstallLocation == SporeMod::InstallLocation::ModLibs &&
+                        installedFile.FileName == profiledDll.FileName;
+            };
+            if (std::find_if(installedSporeMod.InstalledFiles.begin(), installedSporeMod.InstalledFiles.end(), predicate) !=
+                installedSporeMod.InstalledFiles.end())
+            {
+                std::cout << " (" << installedSporeMod.Name << ")";
+                break;
+            }
+        }
+        std::cout << ": load " << get_duration_string(profiledDll.LoadDuration)
+                  << ", unload " << get_duration_string(profiledDll.UnloadDuration);
+        if (profiledDll.HasFailed)
+        {
+            std::cout << " (failed)";
+        }
+        std::cout << std::endl;
+    }
+
     return true;
 }
 
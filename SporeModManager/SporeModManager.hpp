@@ -11,6 +11,7 @@
 #define SPOREMODMANAGER_HPP
 
 #include <filesystem>
+#include <string>
 #include <vector>
 
 namespace SporeModManager
@@ -20,6 +21,12 @@ namespace SporeModManager
     /// </summary>
     bool ListInstalledMods(void);
 
+    /// <summary>
+    ///  Checks installed mods for modified or missing files,
+    ///  when rehash is true, the contents of the files are checked
+    /// </summary>
+    bool CheckInstalledMods(bool rehash, bool& hasChanges);
+
     /// <summary>
     ///  Installs mod
     /// </summary>
@@ -30,11 +37,102 @@ namespace SporeModManager
     /// </summary>
     bool UpdateMods(std::vector<std::filesystem::path>& paths, bool requiresInstalled = true);
 
+    /// <summary>
+    ///  Installs or updates mods for every target configuration file,
+    ///  extracting each file only once
+    /// </summary>
+    bool InstallModsToTargets(const std::vector<std::filesystem::path>& paths, const std::vector<std::filesystem::path>& targets,
+                              bool update, bool skipInstalled);
+
     /// <summary>
     ///  Uninstalls mods with ids
     /// </summary>
     bool UninstallMods(const std::vector<int>& ids);
 
+    /// <summary>
+    ///  Enables or disables mods with ids
+    /// </summary>
+    bool SetModsEnabled(const std::vector<int>& ids, bool enable);
+
+    /// <summary>
+    ///  Lists profiles
+    /// </summary>
+    bool ListProfiles(void);
+
+    /// <summary>
+    ///  Saves the enabled mods as profile with name
+    /// </summary>
+    bool SaveProfile(const std::string& name);
+
+    /// <summary>
+    ///  Switches to profile with name by only enabling
+    ///  and disabling the mods which differ from it
+    /// </summary>
+    bool SwitchProfile(const std::string& name);
+
+    /// <summary>
+    ///  Deletes profile with name
+    /// </summary>
+    bool DeleteProfile(const std::string& name);
+
+    /// <summary>
+    ///  Shows the statistics of the extracted file cache
+    /// </summary>
+    bool ShowCacheStatistics(void);
+
+    /// <summary>
+    ///  Shows the resources which are in
+    ///  multiple packages of enabled mods
+    /// </summary>
+    bool ShowConflicts(void);
+
+    /// <summary>
+    ///  Merges the packages of the mods with ids into one package
+    ///  per install location, in the order of the ids
+    /// </summary>
+    bool MergePackages(const std::vector<int>& ids);
+
+    /// <summary>
+    ///  Restores the merged packages
+    /// </summary>
+    bool UnmergePackages(void);
+
+    /// <summary>
+    ///  Rewrites the packages at paths without
+    ///  the data which isn't part of any resource
+    /// </summary>
+    bool CompactPackages(const std::vector<std::filesystem::path>& paths);
+
+    /// <summary>
+    ///  Lists the resources of the package at path with their sizes,
+    ///  when hashResources is true, the SHA-256 of every decompressed resource is shown,
+    ///  when dumpPath isn't empty, every decompressed resource is written to it
+    /// </summary>
+    bool InspectPackage(const std::filesystem::path& path, bool hashResources, const std::filesystem::path& dumpPath);
+
+    /// <summary>
+    ///  Adds the names in the files at paths, one per line,
+    ///  to the names shown for the resources of packages
+    /// </summary>
+    bool AddNames(const std::vector<std::filesystem::path>& paths);
+
+    /// <summary>
+    ///  Shows the hashes Spore uses for names
+    /// </summary>
+    bool HashNames(const std::vector<std::string>& names);
+
+    /// <summary>
+    ///  Lists the DLLs in ModLibs in the order SporeModLoader loads them,
+    ///  the load manifest is used when it's current, like SporeModLoader does
+    /// </summary>
+    bool ShowLoadOrder(void);
+
+    /// <summary>
+    ///  Shows the time SporeModLoader spent in every phase from the profile at path,
+    ///  followed by the DLLs ranked by the time they took to load
+    /// </summary>
+    bool ShowLoaderReport(const std::filesystem::path& path);
+
     /// <summary>
     ///  Updates Spore-ModAPI DLLs
     /// </summary>
@@ -0,0 +1,392 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "AsyncIO.hpp"
+#include "Thread.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/uio.h>
+#endif // _WIN32
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define ASYNCIO_MAX_QUEUED_SIZE 67108864 /* 64 MiB */
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif // IOV_MAX
+
+//
+// Local Structures
+//
+
+struct async_operation
+{
+    std::vector<char> Buffer;
+    bool IsClose = false;
+    bool Sync    = false;
+};
+
+struct async_file
+{
+    std::filesystem::path Path;
+#ifdef _WIN32
+    std::ofstream Stream;
+#else
+    int FileDescriptor = -1;
+#endif // _WIN32
+    bool IsOpen   = false;
+    bool HasError = false;
+
+    // a file is only processed by one worker at a time,
+    // so the operations are performed in order
+    std::deque<async_operation> Operations;
+    bool IsQueued = false;
+};
+
+//
+// Local Variables
+//
+
+static std::mutex                l_Mutex;
+static std::condition_variable   l_WorkerCondition;
+static std::condition_variable   l_WaitCondition;
+static std::vector<std::thread>  l_Workers;
+static std::deque<async_file*>   l_QueuedFiles;
+static std::vector<std::string>  l_Errors;
+static size_t                    l_OpenFileCount  = 0;
+static uint64_t                  l_QueuedSize     = 0;
+static bool                      l_StopWorkers    = false;
+
+//
+// Helper Functions
+//
+
+#ifdef _WIN32
+static bool file_open(async_file* file, std::string& error)
+{
+    file->Stream.open(file->Path, std::ios::trunc | std::ios::binary);
+    if (!file->Stream.is_open())
+    {
+        error = "failed to open " + file->Path.string();
+        return false;
+    }
+    return true;
+}
+
+static bool file_write(async_file* file, const std::deque<async_operation>& operations, std::string& error)
+{
+    for (const auto& operation : operations)
+    {
+        file->Stream.write(operation.Buffer.data(), operation.Buffer.size());
+    }
+    if (file->Stream.fail())
+    {
+        error = "failed to write to " + file->Path.string();
+        return false;
+    }
+    return true;
+}
+
+static bool file_close(async_file* file, bool /*sync*/, std::string& error)
+{
+    file->Stream.close();
+    if (file->Stream.fail())
+    {
+        error = "failed to close " + file->Path.string();
+        return false;
+    }
+    return true;
+}
+#else
+static bool file_open(async_file* file, std::string& error)
+{
+    file->FileDescriptor = open(file->Path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file->FileDescriptor == -1)
+    {
+        error = "failed to open " + file->Path.string() + ": " + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+static bool file_write(async_file* file, const std::deque<async_operation>& operations, std::string& error)
+{
+    std::vector<struct iovec> ioVectors;
+    size_t  index = 0;
+    ssize_t ret;
+
+    for (const auto& operation : operations)
+    {
+        if (!operation.Buffer.empty())
+        {
+            ioVectors.push_back({ const_cast<char*>(operation.Buffer.data()), operation.Buffer.size() });
+        }
+    }
+
+    // write all queued buffers with as few
+    // system calls as possible, handling partial writes
+    while (index < ioVectors.size())
+    {
+        ret = writev(file->FileDescriptor, ioVectors.data() + index, static_cast<int>(std::min<size_t>(ioVectors.size() - index, IOV_MAX)));
+        if (ret == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            error = "failed to write to " + file->Path.string() + ": " + std::strerror(errno);
+            return false;
+        }
+
+        size_t written = static_cast<size_t>(ret);
+        while (index < ioVectors.size() && written >= ioVectors[index].iov_len)
+        {
+            written -= ioVectors[index].iov_len;
+            index++;
+        }
+        if (index < ioVectors.size())
+        {
+            ioVectors[index].iov_base = static_cast<char*>(ioVectors[index].iov_base) + written;
+            ioVectors[index].iov_len -= written;
+        }
+    }
+
+    return true;
+}
+
+static bool file_close(async_file* file, bool sync, std::string& error)
+{
+    bool ret = true;
+
+    if (sync && fsync(file->FileDescriptor) == -1)
+    {
+        error = "failed to sync " + file->Path.string() + ": " + std::strerror(errno);
+        ret = false;
+    }
+    if (close(file->FileDescriptor) == -1 && ret)
+    {
+        error = "failed to close " + file->Path.string() + ": " + std::strerror(errno);
+        ret = false;
+    }
+
+    file->FileDescriptor = -1;
+    return ret;
+}
+#endif // _WIN32
+
+static void process_operations(async_file* file, const std::deque<async_operation>& operations, std::string& error)
+{
+    bool isClose = !operations.empty() && operations.back().IsClose;
+    bool sync    = isClose && operations.back().Sync;
+
+    // after a failure, the remaining operations
+    // are discarded, but the file is still closed
+    if (!file->HasError && !file->IsOpen)
+    {
+        if (file_open(file, error))
+        {
+            file->IsOpen = true;
+        }
+        else
+        {
+            file->HasError = true;
+        }
+    }
+
+    if (!file->HasError && !file_write(file, operations, error))
+    {
+        file->HasError = true;
+    }
+
+    if (isClose && file->IsOpen)
+    {
+        std::string closeError;
+        if (!file_close(file, sync && !file->HasError, closeError) && !file->HasError)
+        {
+            error = closeError;
+            file->HasError = true;
+        }
+        file->IsOpen = false;
+    }
+}
+
+static void worker_thread(void)
+{
+    std::unique_lock<std::mutex> lock(l_Mutex);
+
+    while (true)
+    {
+        l_WorkerCondition.wait(lock, []() { return !l_QueuedFiles.empty() || l_StopWorkers; });
+        if (l_QueuedFiles.empty())
+        {
+            return;
+        }
+
+        async_file* file = l_QueuedFiles.front();
+        l_QueuedFiles.pop_front();
+
+        // take all operations which have been queued so far,
+        // so they can be completed with a single batch
+        std::deque<async_operation> operations = std::move(file->Operations);
+        file->Operations.clear();
+
+        bool     isClose = !operations.empty() && operations.back().IsClose;
+        uint64_t size    = 0;
+        for (const auto& operation : operations)
+        {
+            size += operation.Buffer.size();
+        }
+
+        lock.unlock();
+        std::string error;
+        process_operations(file, operations, error);
+        operations.clear();
+        lock.lock();
+
+        if (!error.empty())
+        {
+            l_Errors.push_back(error);
+        }
+
+        l_QueuedSize -= size;
+
+        if (isClose)
+        {
+            delete file;
+            l_OpenFileCount--;
+        }
+        else if (!file->Operations.empty())
+        {
+            l_QueuedFiles.push_back(file);
+        }
+        else
+        {
+            file->IsQueued = false;
+        }
+
+        l_WaitCondition.notify_all();
+    }
+}
+
+static void queue_operation(async_file* file, async_operation&& operation)
+{
+    std::unique_lock<std::mutex> lock(l_Mutex);
+
+    // limit the amount of memory used by queued buffers,
+    // but always allow a buffer when nothing is queued
+    l_WaitCondition.wait(lock, [&]() { return l_QueuedSize == 0 || (l_QueuedSize + operation.Buffer.size()) <= ASYNCIO_MAX_QUEUED_SIZE; });
+
+    l_QueuedSize += operation.Buffer.size();
+    file->Operations.push_back(std::move(operation));
+
+    if (!file->IsQueued)
+    {
+        file->IsQueued = true;
+        l_QueuedFiles.push_back(file);
+        l_WorkerCondition.notify_one();
+    }
+}
+
+//
+// Exported Functions
+//
+
+bool AsyncIO::OpenFile(File& file, const std::filesystem::path& path)
+{
+    std::lock_guard<std::mutex> lock(l_Mutex);
+
+    // workers are started on demand
+    // and stopped again by Wait()
+    if (l_Workers.empty())
+    {
+        unsigned int threadCount = Thread::GetThreadCount();
+        for (unsigned int i = 0; i < threadCount; i++)
+        {
+            l_Workers.emplace_back(worker_thread);
+        }
+    }
+
+    async_file* asyncFile = new async_file();
+    asyncFile->Path = path;
+    l_OpenFileCount++;
+
+    file = asyncFile;
+    return true;
+}
+
+void AsyncIO::WriteFile(File file, std::vector<char>&& buffer)
+{
+    async_operation operation;
+    operation.Buffer = std::move(buffer);
+    queue_operation(static_cast<async_file*>(file), std::move(operation));
+}
+
+void AsyncIO::CloseFile(File file, bool sync)
+{
+    async_operation operation;
+    operation.IsClose = true;
+    operation.Sync    = sync;
+    queue_operation(static_cast<async_file*>(file), std::move(operation));
+}
+
+bool AsyncIO::Wait(void)
+{
+    std::vector<std::thread> workers;
+    std::vector<std::string> errors;
+
+    {
+        std::unique_lock<std::mutex> lock(l_Mutex);
+        l_WaitCondition.wait(lock, []() { return l_OpenFileCount == 0; });
+
+        l_StopWorkers = true;
+        l_WorkerCondition.notify_all();
+
+        workers = std::move(l_Workers);
+        errors  = std::move(l_Errors);
+        l_Workers.clear();
+        l_Errors.clear();
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(l_Mutex);
+        l_StopWorkers = false;
+    }
+
+    for (const auto& error : errors)
+    {
+        std::cerr << "Error: " << error << std::endl;
+    }
+
+    return errors.empty();
+}
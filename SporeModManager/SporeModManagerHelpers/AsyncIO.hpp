@@ -0,0 +1,45 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_ASYNCIO_HPP
+#define SPOREMODMANAGERHELPERS_ASYNCIO_HPP
+
+#include <filesystem>
+#include <vector>
+
+namespace SporeModManagerHelpers
+{
+    namespace AsyncIO
+    {
+        typedef void* File;
+
+        /// <summary>
+        ///     Queues creating path for writing, every opened file has to be closed with CloseFile()
+        /// </summary>
+        bool OpenFile(File& file, const std::filesystem::path& path);
+
+        /// <summary>
+        ///     Queues appending buffer to file, blocks when too much data is queued
+        /// </summary>
+        void WriteFile(File file, std::vector<char>&& buffer);
+
+        /// <summary>
+        ///     Queues closing file, when sync is true, the file is flushed to disk first
+        /// </summary>
+        void CloseFile(File file, bool sync);
+
+        /// <summary>
+        ///     Waits until all queued operations are completed,
+        ///     returns false when any of them failed
+        /// </summary>
+        bool Wait(void);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_ASYNCIO_HPP
@@ -0,0 +1,375 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Cache.hpp"
+#include "FileLink.hpp"
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define CACHE_ENTRIES_DIRECTORY "entries"
+#define CACHE_STATISTICS_FILE   "statistics"
+#define CACHE_DEFAULT_SIZE      1073741824 /* 1 GiB */
+
+//
+// Local Structures
+//
+
+struct cache_entry
+{
+    uint64_t Size;
+    std::filesystem::file_time_type LastUsedTime;
+};
+
+//
+// Local Variables
+//
+
+static std::filesystem::path              l_CachePath;
+static uint64_t                           l_CacheMaxSize = CACHE_DEFAULT_SIZE;
+static uint64_t                           l_CacheSize    = 0;
+static bool                               l_HasEntries   = false;
+static std::map<std::string, cache_entry> l_Entries;
+static uint64_t                           l_Hits   = 0;
+static uint64_t                           l_Misses = 0;
+
+//
+// Helper Functions
+//
+
+static std::filesystem::path get_entry_path(const std::string& key)
+{
+    return l_CachePath / CACHE_ENTRIES_DIRECTORY / key.substr(0, 2) / key;
+}
+
+static void load_entries(void)
+{
+    std::filesystem::path entriesPath = l_CachePath / CACHE_ENTRIES_DIRECTORY;
+    std::error_code error;
+
+    if (l_HasEntries)
+    {
+        return;
+    }
+    l_HasEntries = true;
+
+    // the last write time of an entry is
+    // updated when it's used, which makes it
+    // the order in which entries are removed
+    for (auto iter = std::filesystem::recursive_directory_iterator(entriesPath, error);
+         !error && iter != std::filesystem::recursive_directory_iterator(); iter.increment(error))
+    {
+        const std::filesystem::path& path = iter->path();
+        if (!iter->is_regular_file(error) || path.extension() == ".tmp")
+        {
+            continue;
+        }
+
+        cache_entry entry;
+        entry.Size         = iter->file_size(error);
+        entry.LastUsedTime = iter->last_write_time(error);
+        if (!error)
+        {
+            l_Entries[path.filename().string()] = entry;
+            l_CacheSize += entry.Size;
+        }
+    }
+}
+
+static void remove_entry(std::map<std::string, cache_entry>::iterator entryIter)
+{
+    std::error_code error;
+
+    std::filesystem::remove(get_entry_path(entryIter->first), error);
+    l_CacheSize -= entryIter->second.Size;
+    l_Entries.erase(entryIter);
+}
+
+static void trim_entries(void)
+{
+    std::vector<std::map<std::string, cache_entry>::iterator> entryIters;
+
+    if (l_CacheSize <= l_CacheMaxSize)
+    {
+        return;
+    }
+
+    for (auto entryIter = l_Entries.begin(); entryIter != l_Entries.end(); entryIter++)
+    {
+        entryIters.push_back(entryIter);
+    }
+
+    // remove the least recently used entries first
+    std::sort(entryIters.begin(), entryIters.end(), [](const auto& a, const auto& b)
+    {
+        return a->second.LastUsedTime < b->second.LastUsedTime;
+    });
+
+    for (const auto& entryIter : entryIters)
+    {
+        if (l_CacheSize <= l_CacheMaxSize)
+        {
+            break;
+        }
+        remove_entry(entryIter);
+    }
+}
+
+static bool read_statistics(uint64_t& hits, uint64_t& misses)
+{
+    const std::filesystem::path statisticsPath = l_CachePath / CACHE_STATISTICS_FILE;
+    std::string name;
+    uint64_t    value;
+
+    hits   = 0;
+    misses = 0;
+
+    std::ifstream statisticsStream(statisticsPath);
+    if (!statisticsStream.is_open())
+    {
+        // the statistics don't exist for a new cache
+        return !std::filesystem::exists(statisticsPath);
+    }
+
+    while (statisticsStream >> name >> value)
+    {
+        if (name == "hits")
+        {
+            hits = value;
+        }
+        else if (name == "misses")
+        {
+            misses = value;
+        }
+    }
+
+    return true;
+}
+
+//
+// Exported Functions
+//
+
+void Cache::SetCachePath(const std::filesystem::path& path)
+{
+    std::error_code error;
+
+    l_CachePath = path.empty() ? path : std::filesystem::absolute(path, error);
+    l_HasEntries = false;
+    l_Entries.clear();
+    l_CacheSize = 0;
+}
+
+std::filesystem::path Cache::GetCachePath(void)
+{
+    return l_CachePath;
+}
+
+void Cache::SetCacheSize(uint64_t size)
+{
+    l_CacheMaxSize = size;
+}
+
+std::string Cache::GetKey(const std::string& fingerprint, const std::filesystem::path& file, uint64_t size, uint32_t crc32)
+{
+    std::string key = fingerprint + '\0' + file.string() + '\0' + std::to_string(size) + ':' + std::to_string(crc32);
+    return Hash::Sha256(key.data(), key.size());
+}
+
+bool Cache::GetFile(const std::string& key, const std::filesystem::path& destination)
+{
+    const std::filesystem::path entryPath = get_entry_path(key);
+    std::error_code error;
+
+    if (l_CachePath.empty())
+    {
+        return false;
+    }
+
+    load_entries();
+
+    auto entryIter = l_Entries.find(key);
+    if (entryIter == l_Entries.end())
+    {
+        l_Misses++;
+        return false;
+    }
+
+    // entries can be removed by another process
+    if (!std::filesystem::is_regular_file(entryPath, error))
+    {
+        l_CacheSize -= entryIter->second.Size;
+        l_Entries.erase(entryIter);
+        l_Misses++;
+        return false;
+    }
+
+    if (!FileLink::CloneFile(entryPath, destination))
+    {
+        return false;
+    }
+
+    entryIter->second.LastUsedTime = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(entryPath, entryIter->second.LastUsedTime, error);
+    l_Hits++;
+    return true;
+}
+
+bool Cache::AddFile(const std::string& key, const std::filesystem::path& source)
+{
+    const std::filesystem::path entryPath = get_entry_path(key);
+    std::filesystem::path       tempEntryPath = entryPath;
+    std::error_code error;
+    cache_entry entry;
+
+    if (l_CachePath.empty())
+    {
+        return true;
+    }
+
+    load_entries();
+
+    if (l_Entries.find(key) != l_Entries.end())
+    {
+        return true;
+    }
+
+    entry.Size = std::filesystem::file_size(source, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to retrieve file size of " << source << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    // files which don't fit aren't cached
+    if (entry.Size > l_CacheMaxSize)
+    {
+        return true;
+    }
+
+    tempEntryPath += ".tmp";
+
+    std::filesystem::create_directories(entryPath.parent_path(), error);
+    if (error)
+    {
+        std::cerr << "Error: failed to create directory " << entryPath.parent_path() << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    // remove what's left from an interrupted run
+    std::filesystem::remove(tempEntryPath, error);
+
+    if (!FileLink::CloneFile(source, tempEntryPath))
+    {
+        return false;
+    }
+
+    std::filesystem::rename(tempEntryPath, entryPath, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to add " << entryPath << " to cache: " << error.message() << std::endl;
+        std::filesystem::remove(tempEntryPath, error);
+        return false;
+    }
+
+    entry.LastUsedTime = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(entryPath, entry.LastUsedTime, error);
+
+    l_Entries[key] = entry;
+    l_CacheSize += entry.Size;
+
+    trim_entries();
+    return true;
+}
+
+bool Cache::SaveStatistics(void)
+{
+    const std::filesystem::path statisticsPath = l_CachePath / CACHE_STATISTICS_FILE;
+    std::filesystem::path       tempStatisticsPath = statisticsPath;
+    std::error_code error;
+    uint64_t hits;
+    uint64_t misses;
+
+    if (l_CachePath.empty() || (l_Hits == 0 && l_Misses == 0))
+    {
+        return true;
+    }
+
+    if (!read_statistics(hits, misses))
+    {
+        std::cerr << "Error: failed to read " << statisticsPath << std::endl;
+        return false;
+    }
+
+    tempStatisticsPath += ".tmp";
+
+    {
+        std::ofstream statisticsStream(tempStatisticsPath, std::ios::trunc);
+        if (!statisticsStream.is_open())
+        {
+            std::cerr << "Error: failed to open " << tempStatisticsPath << std::endl;
+            return false;
+        }
+
+        statisticsStream << "hits " << (hits + l_Hits) << "\n"
+                         << "misses " << (misses + l_Misses) << "\n";
+
+        statisticsStream.flush();
+        if (statisticsStream.fail())
+        {
+            std::cerr << "Error: failed to write " << tempStatisticsPath << std::endl;
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempStatisticsPath, statisticsPath, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to move " << tempStatisticsPath << " to " << statisticsPath << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    l_Hits   = 0;
+    l_Misses = 0;
+    return true;
+}
+
+bool Cache::GetStatistics(CacheStatistics& statistics)
+{
+    if (l_CachePath.empty())
+    {
+        return false;
+    }
+
+    load_entries();
+
+    if (!read_statistics(statistics.Hits, statistics.Misses))
+    {
+        std::cerr << "Error: failed to read " << (l_CachePath / CACHE_STATISTICS_FILE) << std::endl;
+        return false;
+    }
+
+    statistics.EntryCount = l_Entries.size();
+    statistics.Size       = l_CacheSize;
+    statistics.MaxSize    = l_CacheMaxSize;
+    statistics.Hits      += l_Hits;
+    statistics.Misses    += l_Misses;
+    return true;
+}
@@ -0,0 +1,74 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_CACHE_HPP
+#define SPOREMODMANAGERHELPERS_CACHE_HPP
+
+#include <filesystem>
+#include <cstdint>
+#include <string>
+
+namespace SporeModManagerHelpers
+{
+    namespace Cache
+    {
+        struct CacheStatistics
+        {
+            uint64_t EntryCount = 0;
+            uint64_t Size       = 0;
+            uint64_t MaxSize    = 0;
+            uint64_t Hits       = 0;
+            uint64_t Misses     = 0;
+        };
+
+        /// <summary>
+        ///     Sets the extracted file cache path for current session, an empty path disables the cache
+        /// </summary>
+        void SetCachePath(const std::filesystem::path& path);
+
+        /// <summary>
+        ///     Returns the extracted file cache path, empty when the cache is disabled
+        /// </summary>
+        std::filesystem::path GetCachePath(void);
+
+        /// <summary>
+        ///     Sets the maximum size of the cache in bytes
+        /// </summary>
+        void SetCacheSize(uint64_t size);
+
+        /// <summary>
+        ///     Returns the cache key of file with the given size and crc32 in the zip file with fingerprint
+        /// </summary>
+        std::string GetKey(const std::string& fingerprint, const std::filesystem::path& file, uint64_t size, uint32_t crc32);
+
+        /// <summary>
+        ///     Creates destination from the cached file with key,
+        ///     returns false when the cache doesn't contain it
+        /// </summary>
+        bool GetFile(const std::string& key, const std::filesystem::path& destination);
+
+        /// <summary>
+        ///     Adds a copy of source to the cache with key, the least
+        ///     recently used files are removed when the cache is full
+        /// </summary>
+        bool AddFile(const std::string& key, const std::filesystem::path& source);
+
+        /// <summary>
+        ///     Adds the hits and misses of current session to the saved statistics
+        /// </summary>
+        bool SaveStatistics(void);
+
+        /// <summary>
+        ///     Retrieves the statistics of the cache, including those of current session
+        /// </summary>
+        bool GetStatistics(CacheStatistics& statistics);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_CACHE_HPP
@@ -0,0 +1,916 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Dbpf.hpp"
+#include "FileMap.hpp"
+#include "RefPack.hpp"
+#include "Thread.hpp"
+
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define DBPF_MAGIC                 0x46504244 /* DBPF */
+#define DBPF_MAJOR_VERSION         2
+#define DBPF_INDEX_MAJOR_OFFSET    0x20
+#define DBPF_INDEX_COUNT_OFFSET    0x24
+#define DBPF_INDEX_SIZE_OFFSET     0x2C
+#define DBPF_INDEX_MINOR_OFFSET    0x3C
+#define DBPF_INDEX_OFFSET_OFFSET   0x40
+#define DBPF_INDEX_MAJOR_VERSION   7
+#define DBPF_INDEX_MINOR_VERSION   3
+#define DBPF_INDEX_ENTRY_SIZE      32
+
+#define DBPF_INDEX_TYPE_FLAG       (1 << 0)
+#define DBPF_INDEX_GROUP_FLAG      (1 << 1)
+#define DBPF_INDEX_UNKNOWN_FLAG    (1 << 2)
+
+#define DBPF_COMPRESSED_SIZE_MASK  0x7FFFFFFF
+#define DBPF_COMPRESSED_SIZE_FLAG  0x80000000
+#define DBPF_COMPRESSED            0xFFFF
+#define DBPF_COMMITTED             1
+
+#define DBPF_COPY_BUFFER_SIZE      1048576 /* 1 MiB */
+
+// a patched package is at most this many
+// times the size of the package it's patched to
+#define DBPF_PATCH_MAX_GROWTH      2
+
+//
+// Local Structures
+//
+
+struct package_record
+{
+    size_t PackageId;
+    Dbpf::ResourceEntry Entry;
+};
+
+struct patch_record
+{
+    size_t   EntryId;
+    size_t   PreviousEntryId;
+    uint32_t Position  = 0;
+    bool     IsWritten = false;
+};
+
+//
+// Helper Functions
+//
+
+static uint32_t read_uint32(const char* data)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint32_t>(bytes[0])       |
+           static_cast<uint32_t>(bytes[1]) << 8  |
+           static_cast<uint32_t>(bytes[2]) << 16 |
+           static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+static uint16_t read_uint16(const char* data)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint16_t>(bytes[0] | bytes[1] << 8);
+}
+
+static void write_uint32(char* data, uint32_t value)
+{
+    data[0] = static_cast<char>(value);
+    data[1] = static_cast<char>(value >> 8);
+    data[2] = static_cast<char>(value >> 16);
+    data[3] = static_cast<char>(value >> 24);
+}
+
+static void write_uint16(char* data, uint16_t value)
+{
+    data[0] = static_cast<char>(value);
+    data[1] = static_cast<char>(value >> 8);
+}
+
+static void write_header(char* header, uint32_t indexCount, uint32_t indexSize, uint32_t indexOffset)
+{
+    write_uint32(header, DBPF_MAGIC);
+    write_uint32(header + 4, DBPF_MAJOR_VERSION);
+    write_uint32(header + DBPF_INDEX_MAJOR_OFFSET, DBPF_INDEX_MAJOR_VERSION);
+    write_uint32(header + DBPF_INDEX_COUNT_OFFSET, indexCount);
+    write_uint32(header + DBPF_INDEX_SIZE_OFFSET, indexSize);
+    write_uint32(header + DBPF_INDEX_MINOR_OFFSET, DBPF_INDEX_MINOR_VERSION);
+    write_uint32(header + DBPF_INDEX_OFFSET_OFFSET, indexOffset);
+}
+
+static void write_index_entry(char* indexEntry, const Dbpf::ResourceEntry& entry, uint32_t offset)
+{
+    write_uint32(indexEntry,      entry.Key.TypeId);
+    write_uint32(indexEntry + 4,  entry.Key.GroupId);
+    write_uint32(indexEntry + 12, entry.Key.InstanceId);
+    write_uint32(indexEntry + 16, offset);
+    write_uint32(indexEntry + 20, entry.CompressedSize | DBPF_COMPRESSED_SIZE_FLAG);
+    write_uint32(indexEntry + 24, entry.Size);
+    write_uint16(indexEntry + 28, entry.IsCompressed ? DBPF_COMPRESSED : 0);
+    write_uint16(indexEntry + 30, DBPF_COMMITTED);
+}
+
+static bool write_records(const std::vector<std::filesystem::path>& paths, const std::vector<package_record>& records,
+                          std::ofstream& packageStream, const std::filesystem::path& destination)
+{
+    std::vector<char> header(DBPF_HEADER_SIZE, 0);
+    std::vector<char> index(4 + records.size() * DBPF_INDEX_ENTRY_SIZE, 0);
+    std::vector<char> buffer;
+    std::ifstream sourceStream;
+    size_t   sourceId = paths.size();
+    uint64_t offset   = DBPF_HEADER_SIZE;
+    uint32_t size;
+
+    // the header is written last, because
+    // it contains the offset of the index
+    packageStream.write(header.data(), header.size());
+
+    // the index doesn't share the type, group or unknown
+    // field between entries, so its flags are empty
+    char* indexEntry = index.data() + 4;
+    for (const auto& record : records)
+    {
+        // records are sorted by package, so
+        // every package is opened only once
+        if (record.PackageId != sourceId)
+        {
+            sourceId = record.PackageId;
+            sourceStream.close();
+            sourceStream.open(paths[sourceId], std::ios::binary);
+            if (!sourceStream.is_open())
+            {
+                std::cerr << "Error: failed to open " << paths[sourceId] << std::endl;
+                return false;
+            }
+        }
+
+        if (offset + record.Entry.CompressedSize > UINT32_MAX)
+        {
+            std::cerr << "Error: " << destination << " would exceed the maximum package size!" << std::endl;
+            return false;
+        }
+
+        // compressed records are copied as they are,
+        // only a buffer of a fixed size is kept in memory
+        sourceStream.seekg(record.Entry.Offset);
+        for (uint32_t remaining = record.Entry.CompressedSize; remaining > 0; remaining -= size)
+        {
+            size = std::min<uint32_t>(remaining, DBPF_COPY_BUFFER_SIZE);
+            buffer.resize(std::max<size_t>(buffer.size(), size));
+            if (!sourceStream.read(buffer.data(), size))
+            {
+                std::cerr << "Error: failed to read " << Dbpf::GetKeyString(record.Entry.Key) << " from " << paths[sourceId] << std::endl;
+                return false;
+            }
+            packageStream.write(buffer.data(), size);
+        }
+
+        write_index_entry(indexEntry, record.Entry, static_cast<uint32_t>(offset));
+        indexEntry += DBPF_INDEX_ENTRY_SIZE;
+
+        offset += record.Entry.CompressedSize;
+    }
+
+    if (offset + index.size() > UINT32_MAX)
+    {
+        std::cerr << "Error: " << destination << " would exceed the maximum package size!" << std::endl;
+        return false;
+    }
+
+    packageStream.write(index.data(), index.size());
+
+    write_header(header.data(), static_cast<uint32_t>(records.size()), static_cast<uint32_t>(index.size()), static_cast<uint32_t>(offset));
+    packageStream.seekp(0);
+    packageStream.write(header.data(), header.size());
+    return true;
+}
+
+static bool write_package(const std::vector<std::filesystem::path>& paths, const std::vector<package_record>& records,
+                          const std::filesystem::path& path, const std::filesystem::path& destination)
+{
+    std::error_code error;
+    bool ret;
+
+    {
+        std::ofstream packageStream(path, std::ios::binary | std::ios::trunc);
+        if (!packageStream.is_open())
+        {
+            std::cerr << "Error: failed to open " << path << std::endl;
+            return false;
+        }
+
+        ret = write_records(paths, records, packageStream, destination);
+        if (ret)
+        {
+            packageStream.flush();
+            if (packageStream.fail())
+            {
+                std::cerr << "Error: failed to write " << path << std::endl;
+                ret = false;
+            }
+        }
+    }
+
+    if (!ret)
+    {
+        std::filesystem::remove(path, error);
+    }
+
+    return ret;
+}
+
+static bool replace_package(const std::filesystem::path& tempPath, const std::filesystem::path& destination)
+{
+    std::error_code error;
+
+    std::filesystem::rename(tempPath, destination, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to move " << tempPath << " to " << destination << ": " << error.message() << std::endl;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+static bool is_compact(const std::vector<Dbpf::ResourceEntry>& entries, const Dbpf::PackageHeader& header, uint64_t size)
+{
+    uint64_t offset = DBPF_HEADER_SIZE;
+
+    // a compact package has its records stored contiguously in
+    // index order, directly followed by the index at its end
+    for (const auto& entry : entries)
+    {
+        if (entry.Offset != offset)
+        {
+            return false;
+        }
+        offset += entry.CompressedSize;
+    }
+
+    return header.IndexOffset == offset && offset + header.IndexSize == size;
+}
+
+static bool read_package_index(const std::filesystem::path& path, Dbpf::PackageHeader& header,
+                               std::vector<Dbpf::ResourceEntry>& entries, uint64_t& size)
+{
+    FileMap::MappedFile file;
+    bool ret;
+
+    // only the header and index of a package are read,
+    // mapping it ensures the rest of it isn't read at all
+    if (!FileMap::MapFile(path, file))
+    {
+        FileMap::UnmapFile(file);
+        return false;
+    }
+
+    size = file.Size;
+    ret  = Dbpf::ParseHeader(file.Data, file.Size, header) &&
+           header.IndexOffset <= file.Size &&
+           Dbpf::ParseIndex(file.Data + header.IndexOffset, file.Size - header.IndexOffset, header, entries);
+
+    FileMap::UnmapFile(file);
+    return ret;
+}
+
+static bool read_streamed_index(uint64_t size, const Dbpf::StreamFunction& streamFunction,
+                                Dbpf::PackageHeader& header, std::vector<Dbpf::ResourceEntry>& entries)
+{
+    std::vector<char> headerData;
+    std::vector<char> index;
+    uint64_t position  = 0;
+    bool     hasHeader = false;
+
+    // the stream is stopped once the index has been
+    // read, so the rest of the package isn't read
+    streamFunction([&](const char* data, size_t dataSize)
+    {
+        if (!hasHeader)
+        {
+            const size_t headerSize = std::min(dataSize, DBPF_HEADER_SIZE - headerData.size());
+            headerData.insert(headerData.end(), data, data + headerSize);
+            if (headerData.size() == DBPF_HEADER_SIZE)
+            {
+                if (!Dbpf::ParseHeader(headerData.data(), headerData.size(), header) ||
+                    header.IndexOffset < DBPF_HEADER_SIZE ||
+                    static_cast<uint64_t>(header.IndexOffset) + header.IndexSize > size)
+                {
+                    return false;
+                }
+                hasHeader = true;
+            }
+        }
+
+        if (hasHeader)
+        {
+            const uint64_t indexStart = std::max<uint64_t>(position, header.IndexOffset);
+            const uint64_t indexEnd   = std::min<uint64_t>(position + dataSize, static_cast<uint64_t>(header.IndexOffset) + header.IndexSize);
+            if (indexStart < indexEnd)
+            {
+                index.insert(index.end(), data + (indexStart - position), data + (indexEnd - position));
+            }
+        }
+
+        position += dataSize;
+        return !hasHeader || index.size() < header.IndexSize;
+    });
+
+    return hasHeader && index.size() == header.IndexSize &&
+           Dbpf::ParseIndex(index.data(), index.size(), header, entries);
+}
+
+static bool copy_file_data(std::ifstream& sourceStream, uint64_t offset, uint32_t size, std::ofstream& destinationStream)
+{
+    std::vector<char> buffer;
+    uint32_t chunkSize;
+
+    sourceStream.seekg(offset);
+    for (uint32_t remaining = size; remaining > 0; remaining -= chunkSize)
+    {
+        chunkSize = std::min<uint32_t>(remaining, DBPF_COPY_BUFFER_SIZE);
+        buffer.resize(chunkSize);
+        if (!sourceStream.read(buffer.data(), chunkSize))
+        {
+            return false;
+        }
+        destinationStream.write(buffer.data(), chunkSize);
+    }
+
+    return true;
+}
+
+static bool write_patch_records(const std::filesystem::path& path, uint64_t previousSize, const std::vector<Dbpf::ResourceEntry>& previousEntries,
+                                uint64_t size, const std::vector<Dbpf::ResourceEntry>& entries, const Dbpf::StreamFunction& streamFunction,
+                                std::ofstream& patchStream, std::vector<uint32_t>& offsets, uint64_t& writtenSize)
+{
+    std::unordered_map<Dbpf::ResourceKey, size_t, Dbpf::ResourceKeyHash> previousEntryIds;
+    std::vector<patch_record> records;
+    std::vector<char> buffer;
+    uint64_t position     = 0;
+    uint64_t appendOffset = previousSize;
+    size_t   recordId     = 0;
+    bool     ret          = true;
+
+    for (size_t i = 0; i < previousEntries.size(); i++)
+    {
+        previousEntryIds.emplace(previousEntries[i].Key, i);
+    }
+
+    // only records which have the same key and sizes
+    // as an installed record can be kept, the others
+    // always have to be written
+    records.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const Dbpf::ResourceEntry& entry = entries[i];
+        size_t previousEntryId = SIZE_MAX;
+
+        auto previousEntryIdIter = previousEntryIds.find(entry.Key);
+        if (previousEntryIdIter != previousEntryIds.end())
+        {
+            const Dbpf::ResourceEntry& previousEntry = previousEntries[previousEntryIdIter->second];
+            if (previousEntry.CompressedSize == entry.CompressedSize && previousEntry.Size == entry.Size &&
+                previousEntry.IsCompressed == entry.IsCompressed)
+            {
+                previousEntryId = previousEntryIdIter->second;
+            }
+        }
+
+        records.push_back({ i, previousEntryId });
+    }
+
+    // the package is read once from start to end,
+    // so the records have to be visited in that order
+    std::sort(records.begin(), records.end(), [&](const patch_record& a, const patch_record& b)
+    {
+        return entries[a.EntryId].Offset < entries[b.EntryId].Offset;
+    });
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const Dbpf::ResourceEntry& entry = entries[records[i].EntryId];
+        const uint64_t entryEnd = static_cast<uint64_t>(entry.Offset) + entry.CompressedSize;
+        if (entryEnd > size || (i + 1 < records.size() && entryEnd > entries[records[i + 1].EntryId].Offset))
+        {
+            return false;
+        }
+    }
+
+    std::ifstream previousStream(path, std::ios::binary);
+    if (!previousStream.is_open())
+    {
+        return false;
+    }
+
+    const auto writeRecords = [&](const char* data, size_t dataSize)
+    {
+        const uint64_t dataEnd = position + dataSize;
+
+        while (recordId < records.size())
+        {
+            patch_record& record = records[recordId];
+            const Dbpf::ResourceEntry& entry = entries[record.EntryId];
+
+            // unchanged records keep their installed offset
+            if (record.Position == entry.CompressedSize)
+            {
+                if (!record.IsWritten)
+                {
+                    offsets[record.EntryId] = record.PreviousEntryId == SIZE_MAX ?
+                                                static_cast<uint32_t>(appendOffset) :
+                                                previousEntries[record.PreviousEntryId].Offset;
+                }
+                recordId++;
+                continue;
+            }
+
+            const uint64_t recordStart = static_cast<uint64_t>(entry.Offset) + record.Position;
+            if (recordStart >= dataEnd)
+            {
+                break;
+            }
+
+            const char*  recordData = data + (recordStart - position);
+            const size_t recordSize = static_cast<size_t>(std::min<uint64_t>(dataEnd, static_cast<uint64_t>(entry.Offset) + entry.CompressedSize) - recordStart);
+
+            if (!record.IsWritten && record.PreviousEntryId != SIZE_MAX)
+            {
+                buffer.resize(recordSize);
+                previousStream.seekg(previousEntries[record.PreviousEntryId].Offset + record.Position);
+                if (!previousStream.read(buffer.data(), recordSize))
+                {
+                    ret = false;
+                    return false;
+                }
+
+                if (std::memcmp(buffer.data(), recordData, recordSize) == 0)
+                {
+                    record.Position += static_cast<uint32_t>(recordSize);
+                    continue;
+                }
+            }
+
+            // a changed record is appended, the part which
+            // matches the installed record is copied from it
+            if (!record.IsWritten)
+            {
+                writtenSize += entry.CompressedSize;
+                if (appendOffset + entry.CompressedSize > UINT32_MAX ||
+                    writtenSize > size / DBPF_PATCH_MAX_GROWTH ||
+                    previousSize + writtenSize > size * DBPF_PATCH_MAX_GROWTH)
+                {
+                    ret = false;
+                    return false;
+                }
+
+                offsets[record.EntryId] = static_cast<uint32_t>(appendOffset);
+                appendOffset += entry.CompressedSize;
+                record.IsWritten = true;
+
+                if (record.Position > 0 &&
+                    !copy_file_data(previousStream, previousEntries[record.PreviousEntryId].Offset, record.Position, patchStream))
+                {
+                    ret = false;
+                    return false;
+                }
+            }
+
+            patchStream.write(recordData, recordSize);
+            record.Position += static_cast<uint32_t>(recordSize);
+        }
+
+        position = dataEnd;
+        return true;
+    };
+
+    // records without data can be after the end of the stream
+    ret = streamFunction(writeRecords) && ret && writeRecords(nullptr, 0);
+    return ret && recordId == records.size() && !patchStream.fail();
+}
+
+static bool verify_package(const std::filesystem::path& sourcePath, const std::vector<Dbpf::ResourceEntry>& sourceEntries,
+                           const std::filesystem::path& path)
+{
+    std::vector<Dbpf::ResourceEntry> entries;
+    Dbpf::PackageHeader header;
+    std::vector<char> sourceBuffer;
+    std::vector<char> buffer;
+    uint64_t size;
+    uint32_t chunkSize;
+
+    if (!read_package_index(path, header, entries, size) || entries.size() != sourceEntries.size() ||
+        !is_compact(entries, header, size))
+    {
+        std::cerr << "Error: failed to read the index of " << path << std::endl;
+        return false;
+    }
+
+    std::ifstream sourceStream(sourcePath, std::ios::binary);
+    std::ifstream packageStream(path, std::ios::binary);
+    if (!sourceStream.is_open() || !packageStream.is_open())
+    {
+        std::cerr << "Error: failed to open " << (sourceStream.is_open() ? path : sourcePath) << std::endl;
+        return false;
+    }
+
+    // every record is compared in chunks, so only
+    // two buffers of a fixed size are kept in memory
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const Dbpf::ResourceEntry& sourceEntry = sourceEntries[i];
+        const Dbpf::ResourceEntry& entry       = entries[i];
+
+        if (!(entry.Key == sourceEntry.Key) || entry.CompressedSize != sourceEntry.CompressedSize ||
+            entry.Size != sourceEntry.Size || entry.IsCompressed != sourceEntry.IsCompressed)
+        {
+            std::cerr << "Error: " << Dbpf::GetKeyString(sourceEntry.Key) << " differs in " << path << std::endl;
+            return false;
+        }
+
+        sourceStream.seekg(sourceEntry.Offset);
+        packageStream.seekg(entry.Offset);
+        for (uint32_t remaining = entry.CompressedSize; remaining > 0; remaining -= chunkSize)
+        {
+            chunkSize = std::min<uint32_t>(remaining, DBPF_COPY_BUFFER_SIZE);
+            sourceBuffer.resize(std::max<size_t>(sourceBuffer.size(), chunkSize));
+            buffer.resize(sourceBuffer.size());
+            if (!sourceStream.read(sourceBuffer.data(), chunkSize) || !packageStream.read(buffer.data(), chunkSize) ||
+                std::memcmp(sourceBuffer.data(), buffer.data(), chunkSize) != 0)
+            {
+                std::cerr << "Error: " << Dbpf::GetKeyString(sourceEntry.Key) << " differs in " << path << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//
+// Exported Functions
+//
+
+bool Dbpf::ParseHeader(const char* data, size_t size, PackageHeader& header)
+{
+    if (size < DBPF_HEADER_SIZE || read_uint32(data) != DBPF_MAGIC ||
+        read_uint32(data + 4) != DBPF_MAJOR_VERSION)
+    {
+        return false;
+    }
+
+    header.IndexCount  = read_uint32(data + DBPF_INDEX_COUNT_OFFSET);
+    header.IndexSize   = read_uint32(data + DBPF_INDEX_SIZE_OFFSET);
+    header.IndexOffset = read_uint32(data + DBPF_INDEX_OFFSET_OFFSET);
+    return true;
+}
+
+bool Dbpf::ParseIndex(const char* data, size_t size, const PackageHeader& header, std::vector<ResourceEntry>& entries)
+{
+    const char* dataEnd = data + std::min(size, static_cast<size_t>(header.IndexSize));
+    uint32_t    flags;
+    ResourceEntry entry;
+    uint32_t    typeId  = 0;
+    uint32_t    groupId = 0;
+    size_t      entrySize;
+
+    if (size < header.IndexSize || header.IndexSize < 4)
+    {
+        return false;
+    }
+
+    // the type, group and unknown field are either
+    // stored once for every entry or in every entry
+    flags = read_uint32(data);
+    data += 4;
+
+    for (uint32_t flag : { DBPF_INDEX_TYPE_FLAG, DBPF_INDEX_GROUP_FLAG, DBPF_INDEX_UNKNOWN_FLAG })
+    {
+        if (flags & flag)
+        {
+            if (dataEnd - data < 4)
+            {
+                return false;
+            }
+            if (flag == DBPF_INDEX_TYPE_FLAG)
+            {
+                typeId = read_uint32(data);
+            }
+            else if (flag == DBPF_INDEX_GROUP_FLAG)
+            {
+                groupId = read_uint32(data);
+            }
+            data += 4;
+        }
+    }
+
+    entrySize = 20 +
+                ((flags & DBPF_INDEX_TYPE_FLAG)    ? 0 : 4) +
+                ((flags & DBPF_INDEX_GROUP_FLAG)   ? 0 : 4) +
+                ((flags & DBPF_INDEX_UNKNOWN_FLAG) ? 0 : 4);
+    if (static_cast<size_t>(dataEnd - data) / entrySize < header.IndexCount)
+    {
+        return false;
+    }
+
+    entries.reserve(entries.size() + header.IndexCount);
+
+    for (uint32_t i = 0; i < header.IndexCount; i++)
+    {
+        entry.Key.TypeId = typeId;
+        if (!(flags & DBPF_INDEX_TYPE_FLAG))
+        {
+            entry.Key.TypeId = read_uint32(data);
+            data += 4;
+        }
+        entry.Key.GroupId = groupId;
+        if (!(flags & DBPF_INDEX_GROUP_FLAG))
+        {
+            entry.Key.GroupId = read_uint32(data);
+            data += 4;
+        }
+        if (!(flags & DBPF_INDEX_UNKNOWN_FLAG))
+        {
+            data += 4;
+        }
+        entry.Key.InstanceId   = read_uint32(data);
+        entry.Offset           = read_uint32(data + 4);
+        entry.CompressedSize   = read_uint32(data + 8) & DBPF_COMPRESSED_SIZE_MASK;
+        entry.Size             = read_uint32(data + 12);
+        entry.IsCompressed     = read_uint16(data + 16) == DBPF_COMPRESSED;
+        data += 20;
+
+        entries.push_back(entry);
+    }
+
+    return true;
+}
+
+bool Dbpf::ReadIndex(const std::filesystem::path& path, std::vector<ResourceEntry>& entries)
+{
+    PackageHeader header;
+    uint64_t size;
+
+    return read_package_index(path, header, entries, size);
+}
+
+bool Dbpf::ReadResources(const std::filesystem::path& path, const std::vector<ResourceEntry>& entries,
+                         const std::function<bool(size_t, const char*, size_t)>& function)
+{
+    FileMap::MappedFile file;
+    std::vector<char> entryResults;
+    std::atomic<bool> hasFailed = false;
+
+    if (!FileMap::MapFile(path, file))
+    {
+        std::cerr << "Error: failed to open " << path << std::endl;
+        FileMap::UnmapFile(file);
+        return false;
+    }
+
+    entryResults.resize(entries.size(), true);
+
+    // every record is decompressed into a buffer which is
+    // kept per thread, so it's only reallocated when a
+    // record is larger than the ones before it
+    Thread::ParallelFor(entries.size(), [&](size_t index)
+    {
+        thread_local std::vector<char> buffer;
+        const ResourceEntry& entry = entries[index];
+
+        if (hasFailed)
+        {
+            return;
+        }
+
+        if (static_cast<uint64_t>(entry.Offset) + entry.CompressedSize > file.Size)
+        {
+            entryResults[index] = false;
+        }
+        else if (!entry.IsCompressed)
+        {
+            entryResults[index] = function(index, file.Data + entry.Offset, entry.CompressedSize);
+        }
+        else
+        {
+            buffer.resize(std::max<size_t>(buffer.size(), entry.Size));
+            entryResults[index] = RefPack::Decompress(file.Data + entry.Offset, entry.CompressedSize, buffer.data(), entry.Size) &&
+                                  function(index, buffer.data(), entry.Size);
+        }
+
+        if (!entryResults[index])
+        {
+            hasFailed = true;
+        }
+    });
+
+    FileMap::UnmapFile(file);
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (!entryResults[i])
+        {
+            std::cerr << "Error: failed to read " << GetKeyString(entries[i].Key) << " from " << path << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string Dbpf::GetKeyString(const ResourceKey& key)
+{
+    char keyString[64];
+
+    std::snprintf(keyString, sizeof(keyString), "0x%08x!0x%08x.0x%08x",
+                  static_cast<unsigned int>(key.GroupId),
+                  static_cast<unsigned int>(key.InstanceId),
+                  static_cast<unsigned int>(key.TypeId));
+    return keyString;
+}
+
+bool Dbpf::MergePackages(const std::vector<std::filesystem::path>& paths, const std::filesystem::path& destination)
+{
+    std::vector<std::vector<ResourceEntry>> packageEntries;
+    std::vector<char> packageResults;
+    std::unordered_map<ResourceKey, size_t, ResourceKeyHash> resourcePackageIds;
+    std::vector<package_record> records;
+
+    packageEntries.resize(paths.size());
+    packageResults.resize(paths.size(), false);
+
+    // only the header and index of every package are
+    // read, which allows reading all of them in parallel
+    Thread::ParallelFor(paths.size(), [&](size_t index)
+    {
+        packageResults[index] = ReadIndex(paths[index], packageEntries[index]);
+    });
+
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (!packageResults[i])
+        {
+            std::cerr << "Error: failed to read the index of " << paths[i] << std::endl;
+            return false;
+        }
+
+        // later packages override the resources of earlier ones
+        for (const auto& entry : packageEntries[i])
+        {
+            resourcePackageIds[entry.Key] = i;
+        }
+    }
+
+    // keep the records grouped by package, so the
+    // packages are read sequentially while writing
+    records.reserve(resourcePackageIds.size());
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        for (const auto& entry : packageEntries[i])
+        {
+            auto resourcePackageIdIter = resourcePackageIds.find(entry.Key);
+            if (resourcePackageIdIter != resourcePackageIds.end() && resourcePackageIdIter->second == i)
+            {
+                records.push_back({ i, entry });
+                // packages can contain a resource more than once
+                resourcePackageIds.erase(resourcePackageIdIter);
+            }
+        }
+    }
+
+    std::filesystem::path tempPath = destination;
+    tempPath += ".tmp";
+
+    return write_package(paths, records, tempPath, destination) &&
+           replace_package(tempPath, destination);
+}
+
+bool Dbpf::PatchPackage(const std::filesystem::path& path, uint64_t size, const StreamFunction& streamFunction, PackagePatch& patch)
+{
+    std::vector<ResourceEntry> previousEntries;
+    std::vector<ResourceEntry> entries;
+    std::vector<uint32_t> offsets;
+    std::vector<char>     index;
+    PackageHeader previousHeader;
+    PackageHeader header;
+    std::error_code error;
+    uint64_t previousSize;
+    uint64_t indexOffset;
+    bool ret;
+
+    // the installed package keeps growing with every
+    // patch, so it's written completely once it's too large
+    if (!read_package_index(path, previousHeader, previousEntries, previousSize) ||
+        previousSize > size * DBPF_PATCH_MAX_GROWTH ||
+        !read_streamed_index(size, streamFunction, header, entries))
+    {
+        return false;
+    }
+
+    offsets.resize(entries.size());
+    patch.Size        = previousSize;
+    patch.WrittenSize = 0;
+
+    // the records and index are appended after the
+    // installed package, which keeps it valid until
+    // its header is replaced
+    {
+        std::ofstream patchStream(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!patchStream.is_open())
+        {
+            return false;
+        }
+        patchStream.seekp(previousSize);
+
+        ret = write_patch_records(path, previousSize, previousEntries, size, entries, streamFunction, patchStream, offsets, patch.WrittenSize);
+        if (ret)
+        {
+            indexOffset = previousSize + patch.WrittenSize;
+            index.resize(4 + entries.size() * DBPF_INDEX_ENTRY_SIZE, 0);
+            for (size_t i = 0; i < entries.size(); i++)
+            {
+                write_index_entry(index.data() + 4 + (i * DBPF_INDEX_ENTRY_SIZE), entries[i], offsets[i]);
+            }
+
+            ret = indexOffset + index.size() <= UINT32_MAX;
+        }
+        if (ret)
+        {
+            patchStream.write(index.data(), index.size());
+            patchStream.flush();
+            ret = !patchStream.fail();
+        }
+    }
+
+    if (!ret)
+    {
+        std::filesystem::resize_file(path, previousSize, error);
+        return false;
+    }
+
+    patch.WrittenSize += index.size();
+    patch.Header.assign(DBPF_HEADER_SIZE, 0);
+    write_header(patch.Header.data(), static_cast<uint32_t>(entries.size()), static_cast<uint32_t>(index.size()), static_cast<uint32_t>(indexOffset));
+    return true;
+}
+
+bool Dbpf::CompactPackage(const std::filesystem::path& path, const std::filesystem::path& destination, bool& isCompacted)
+{
+    std::vector<ResourceEntry>  entries;
+    std::vector<package_record> records;
+    PackageHeader header;
+    std::filesystem::path tempPath = destination;
+    uint64_t size;
+
+    isCompacted = false;
+
+    if (!read_package_index(path, header, entries, size))
+    {
+        std::cerr << "Error: failed to read the index of " << path << std::endl;
+        return false;
+    }
+
+    if (is_compact(entries, header, size))
+    {
+        return true;
+    }
+
+    // records which aren't in the index and the
+    // space between records aren't written, every
+    // record of the index is written in its order
+    records.reserve(entries.size());
+    for (const auto& entry : entries)
+    {
+        records.push_back({ 0, entry });
+    }
+
+    // the package is only replaced when all of its
+    // resources are identical in the compacted package
+    tempPath += ".tmp";
+    if (!write_package({ path }, records, tempPath, destination) ||
+        !verify_package(path, entries, tempPath))
+    {
+        std::error_code error;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    isCompacted = true;
+    return replace_package(tempPath, destination);
+}
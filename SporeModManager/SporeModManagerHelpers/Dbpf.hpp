@@ -0,0 +1,139 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_DBPF_HPP
+#define SPOREMODMANAGERHELPERS_DBPF_HPP
+
+#include <filesystem>
+#include <functional>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define DBPF_HEADER_SIZE 96
+
+namespace SporeModManagerHelpers
+{
+    namespace Dbpf
+    {
+        struct ResourceKey
+        {
+            uint32_t InstanceId = 0;
+            uint32_t TypeId     = 0;
+            uint32_t GroupId    = 0;
+
+            bool operator==(const ResourceKey& other) const
+            {
+                return InstanceId == other.InstanceId &&
+                    TypeId == other.TypeId &&
+                    GroupId == other.GroupId;
+            }
+
+            bool operator<(const ResourceKey& other) const
+            {
+                if (GroupId != other.GroupId)
+                {
+                    return GroupId < other.GroupId;
+                }
+                if (InstanceId != other.InstanceId)
+                {
+                    return InstanceId < other.InstanceId;
+                }
+                return TypeId < other.TypeId;
+            }
+        };
+
+        struct ResourceKeyHash
+        {
+            size_t operator()(const ResourceKey& key) const
+            {
+                return ((static_cast<size_t>(key.GroupId) * 31) + key.InstanceId) * 31 + key.TypeId;
+            }
+        };
+
+        struct ResourceEntry
+        {
+            ResourceKey Key;
+            uint32_t    Offset         = 0;
+            uint32_t    CompressedSize = 0;
+            uint32_t    Size           = 0;
+            bool        IsCompressed   = false;
+        };
+
+        /// <summary>
+        ///     Reads a package from its start, calling the given function with every
+        ///     consecutive part of it, reading stops when the function returns false
+        /// </summary>
+        typedef std::function<bool(const std::function<bool(const char*, size_t)>&)> StreamFunction;
+
+        struct PackagePatch
+        {
+            uint64_t          Size        = 0;
+            uint64_t          WrittenSize = 0;
+            std::vector<char> Header;
+        };
+
+        struct PackageHeader
+        {
+            uint32_t IndexOffset = 0;
+            uint32_t IndexSize   = 0;
+            uint32_t IndexCount  = 0;
+        };
+
+        /// <summary>
+        ///     Parses the first DBPF_HEADER_SIZE bytes of a package
+        /// </summary>
+        bool ParseHeader(const char* data, size_t size, PackageHeader& header);
+
+        /// <summary>
+        ///     Parses the index of a package, data must contain the index of header
+        /// </summary>
+        bool ParseIndex(const char* data, size_t size, const PackageHeader& header, std::vector<ResourceEntry>& entries);
+
+        /// <summary>
+        ///     Reads the index of the given package, only the header and index are read
+        /// </summary>
+        bool ReadIndex(const std::filesystem::path& path, std::vector<ResourceEntry>& entries);
+
+        /// <summary>
+        ///     Decompresses the resources of entries from the package at path in parallel and calls function
+        ///     with the index of the entry and its data, function is called from multiple threads
+        /// </summary>
+        bool ReadResources(const std::filesystem::path& path, const std::vector<ResourceEntry>& entries,
+                           const std::function<bool(size_t, const char*, size_t)>& function);
+
+        /// <summary>
+        ///     Returns key formatted as group!instance.type
+        /// </summary>
+        std::string GetKeyString(const ResourceKey& key);
+
+        /// <summary>
+        ///     Writes the resources of the given packages into a new package at destination,
+        ///     when multiple packages contain a resource, the one of the last package is kept
+        /// </summary>
+        bool MergePackages(const std::vector<std::filesystem::path>& paths, const std::filesystem::path& destination);
+
+        /// <summary>
+        ///     Appends the records of the package of size read by streamFunction which differ from the ones of
+        ///     the package at path to it, followed by a new index, the package at path only uses them once
+        ///     patch.Header has been written to its start, patch.Size is its size before patching,
+        ///     returns false without changing it when it can't be patched or when writing the package is cheaper
+        /// </summary>
+        bool PatchPackage(const std::filesystem::path& path, uint64_t size, const StreamFunction& streamFunction, PackagePatch& patch);
+
+        /// <summary>
+        ///     Writes the package at path to destination with its records stored contiguously in index order,
+        ///     the resources are verified before destination is replaced, isCompacted is false when
+        ///     the package is compact already, in which case nothing is written
+        /// </summary>
+        bool CompactPackage(const std::filesystem::path& path, const std::filesystem::path& destination, bool& isCompacted);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_DBPF_HPP
@@ -0,0 +1,174 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "DllImports.hpp"
+#include "PeFile.hpp"
+#include "String.hpp"
+#include "Path.hpp"
+#include "UI.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <map>
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Structures
+//
+
+struct provider_dll
+{
+    DllImports::DllFile DllFile;
+    bool IsRead = false;
+    bool IsPe   = false;
+    PeFile::PeInfo PeInfo;
+};
+
+//
+// Helper Functions
+//
+
+static std::string get_dll_key(const std::filesystem::path& fileName)
+{
+    // Windows compares the names of DLLs case insensitively
+    return String::Lowercase(fileName.filename().u8string());
+}
+
+static void add_directory_dlls(const std::filesystem::path& path, std::map<std::string, provider_dll>& providerDlls)
+{
+    std::error_code error;
+
+    for (auto iter = std::filesystem::directory_iterator(path, error);
+         !error && iter != std::filesystem::directory_iterator(); iter.increment(error))
+    {
+        const std::filesystem::path& dllPath = iter->path();
+        if (!iter->is_regular_file(error) || String::Lowercase(dllPath.extension().u8string()) != ".dll")
+        {
+            continue;
+        }
+
+        providerDlls[get_dll_key(dllPath)].DllFile = { dllPath.filename(), dllPath };
+    }
+}
+
+static provider_dll& read_provider_dll(provider_dll& providerDll)
+{
+    // DLLs are only read once they're imported from
+    if (!providerDll.IsRead)
+    {
+        providerDll.IsRead = true;
+        providerDll.IsPe   = PeFile::ReadFile(providerDll.DllFile.Path, providerDll.PeInfo);
+    }
+
+    return providerDll;
+}
+
+static void check_imports(const std::vector<DllImports::DllFile>& dllFiles, std::map<std::string, provider_dll>& providerDlls,
+                          size_t& unresolvedCount)
+{
+    unresolvedCount = 0;
+
+    for (const auto& dllFile : dllFiles)
+    {
+        PeFile::PeInfo peInfo;
+
+        // files which aren't PE files aren't loaded by
+        // Windows, so there's nothing to resolve for them
+        if (!PeFile::ReadFile(dllFile.Path, peInfo))
+        {
+            continue;
+        }
+
+        if (UI::GetVerboseMode())
+        {
+            std::cout << "--> Checking imports of " << dllFile.FileName << std::endl;
+        }
+
+        for (const auto& importedDll : peInfo.ImportedDlls)
+        {
+            auto providerDllIter = providerDlls.find(get_dll_key(importedDll.Name));
+            if (providerDllIter == providerDlls.end())
+            {
+                continue;
+            }
+
+            const provider_dll& providerDll = read_provider_dll(providerDllIter->second);
+            if (!providerDll.IsPe)
+            {
+                continue;
+            }
+
+            for (const auto& functionName : importedDll.FunctionNames)
+            {
+                if (!PeFile::ExportsName(providerDll.PeInfo, functionName))
+                {
+                    std::cerr << "Error: " << dllFile.FileName << " imports \"" << functionName << "\" from "
+                              << providerDll.DllFile.FileName << ", which doesn't export it!" << std::endl;
+                    unresolvedCount++;
+                }
+            }
+
+            for (const auto& functionOrdinal : importedDll.FunctionOrdinals)
+            {
+                if (!PeFile::ExportsOrdinal(providerDll.PeInfo, functionOrdinal))
+                {
+                    std::cerr << "Error: " << dllFile.FileName << " imports ordinal " << functionOrdinal << " from "
+                              << providerDll.DllFile.FileName << ", which doesn't export it!" << std::endl;
+                    unresolvedCount++;
+                }
+            }
+        }
+    }
+}
+
+//
+// Exported Functions
+//
+
+void DllImports::CheckImports(const std::vector<DllFile>& dllFiles, const std::vector<std::filesystem::path>& removedFileNames,
+                              size_t& unresolvedCount)
+{
+    std::map<std::string, provider_dll> providerDlls;
+
+    // the DLLs in ModLibs replace the ones in CoreLibs
+    // when they have the same name, like they do when
+    // they're loaded, dllFiles replace both of them
+    add_directory_dlls(Path::GetCoreLibsPath(), providerDlls);
+    add_directory_dlls(Path::GetModLibsPath(), providerDlls);
+
+    for (const auto& removedFileName : removedFileNames)
+    {
+        providerDlls.erase(get_dll_key(removedFileName));
+    }
+
+    for (const auto& dllFile : dllFiles)
+    {
+        provider_dll providerDll;
+        providerDll.DllFile = dllFile;
+        providerDlls[get_dll_key(dllFile.FileName)] = providerDll;
+    }
+
+    check_imports(dllFiles, providerDlls, unresolvedCount);
+}
+
+void DllImports::CheckInstalledImports(size_t& unresolvedCount)
+{
+    std::map<std::string, provider_dll> modLibsDlls;
+    std::vector<DllFile> dllFiles;
+
+    add_directory_dlls(Path::GetModLibsPath(), modLibsDlls);
+    for (const auto& modLibsDll : modLibsDlls)
+    {
+        dllFiles.push_back(modLibsDll.second.DllFile);
+    }
+
+    CheckImports(dllFiles, {}, unresolvedCount);
+}
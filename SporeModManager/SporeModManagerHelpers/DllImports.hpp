@@ -0,0 +1,46 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_DLLIMPORTS_HPP
+#define SPOREMODMANAGERHELPERS_DLLIMPORTS_HPP
+
+#include <filesystem>
+#include <cstddef>
+#include <vector>
+
+namespace SporeModManagerHelpers
+{
+    namespace DllImports
+    {
+        struct DllFile
+        {
+            std::filesystem::path FileName;
+            // where the DLL can be read from,
+            // which differs from the ModLibs
+            // directory while installing it
+            std::filesystem::path Path;
+        };
+
+        /// <summary>
+        ///     Checks whether the functions which dllFiles import from the DLLs in CoreLibs and ModLibs
+        ///     are exported by them, dllFiles replace the DLLs in ModLibs with the same name and the DLLs
+        ///     in ModLibs named in removedFileNames are ignored, unresolvedCount is the amount of functions
+        ///     which aren't exported, DLLs which aren't in either directory are assumed to be system DLLs
+        /// </summary>
+        void CheckImports(const std::vector<DllFile>& dllFiles, const std::vector<std::filesystem::path>& removedFileNames,
+                          size_t& unresolvedCount);
+
+        /// <summary>
+        ///     Checks the imports of every DLL in ModLibs
+        /// </summary>
+        void CheckInstalledImports(size_t& unresolvedCount);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_DLLIMPORTS_HPP
@@ -8,19 +8,76 @@
  *  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include "Download.hpp"
+#include "Thread.hpp"
+#include "String.hpp"
+#include "Hash.hpp"
 #include "UI.hpp"
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <atomic>
+#include <mutex>
+#include <chrono>
 
 #ifdef _WIN32
+#include <windows.h>
 #include <urlmon.h>
+#include <wininet.h>
 #else
 #include <dlfcn.h>
 #endif // _WIN32
 
 using namespace SporeModManagerHelpers;
 
+//
+// Local Defines
+//
+
+#define DOWNLOAD_CHUNK_SIZE  4194304 /* 4 MiB */
+#define DOWNLOAD_BLOCK_SIZE  1048576 /* 1 MiB */
+#define DOWNLOAD_CONNECTIONS 4
+#define DOWNLOAD_CHECKPOINT_INTERVAL 2 /* seconds */
+#define DOWNLOAD_STATE_MAGIC "SporeModManagerDownload 2"
+#define DOWNLOAD_CHECKSUM_PREFIX "#sha256="
+
+//
+// Local Structures
+//
+
+struct download_chunk
+{
+    uint64_t Offset    = 0;
+    uint64_t Size      = 0;
+    uint64_t BytesDone = 0;
+    uint32_t Crc32     = 0;
+};
+
+struct download_state
+{
+    std::string Url;
+    std::string Validator;
+    uint64_t    Size = 0;
+    std::vector<download_chunk> Chunks;
+};
+
+struct remote_file
+{
+    std::string Url;
+    // the ETag or Last-Modified header, which is sent
+    // with range requests, so the server responds with
+    // the whole file when it has changed since opening it
+    std::string Validator;
+    bool        HasChanged = false;
+    uint64_t    Size       = 0;
+    uint64_t    BytesRead  = 0;
+#ifdef _WIN32
+    HINTERNET   Internet   = nullptr;
+#else
+    void*       Curl       = nullptr;
+#endif // _WIN32
+};
+
 //
 // Local Functions
 //
@@ -39,18 +96,101 @@ using namespace SporeModManagerHelpers;
 #define CURLOPT_WRITEDATA       10001
 #define CURLOPT_REDIR_PROTOCOLS 182
 #define CURLOPT_FOLLOWLOCATION  52
+#define CURLOPT_RANGE           10007
+#define CURLOPT_NOBODY          44
+#define CURLOPT_FAILONERROR     45
+#define CURLOPT_HTTPGET         80
+#define CURLOPT_NOSIGNAL        99
+#define CURLOPT_HTTPHEADER      10023
+#define CURLOPT_HEADERFUNCTION  20079
+#define CURLOPT_HEADERDATA      10029
+#define CURLINFO_RESPONSE_CODE  0x200002
+#define CURLINFO_CONTENT_LENGTH_DOWNLOAD_T 0x60000F
 #define CURLPROTO_HTTPS         (1 << 1)
 #define CURLE_OK                0
 
 // libcurl function pointers
 typedef void* (*ptr_curl_easy_init)(void);
 typedef int   (*ptr_curl_easy_setopt)(void* curl, int option, ...);
+typedef int   (*ptr_curl_easy_getinfo)(void* curl, int info, ...);
 typedef int   (*ptr_curl_easy_perform)(void* curl);
 typedef void  (*ptr_curl_easy_cleanup)(void* curl);
-static ptr_curl_easy_init    curl_easy_init    = nullptr;
-static ptr_curl_easy_setopt  curl_easy_setopt  = nullptr;
-static ptr_curl_easy_perform curl_easy_perform = nullptr;
-static ptr_curl_easy_cleanup curl_easy_cleanup = nullptr;
+typedef void* (*ptr_curl_slist_append)(void* list, const char* string);
+typedef void  (*ptr_curl_slist_free_all)(void* list);
+static ptr_curl_easy_init      curl_easy_init      = nullptr;
+static ptr_curl_easy_setopt    curl_easy_setopt    = nullptr;
+static ptr_curl_easy_getinfo   curl_easy_getinfo   = nullptr;
+static ptr_curl_easy_perform   curl_easy_perform   = nullptr;
+static ptr_curl_easy_cleanup   curl_easy_cleanup   = nullptr;
+static ptr_curl_slist_append   curl_slist_append   = nullptr;
+static ptr_curl_slist_free_all curl_slist_free_all = nullptr;
+
+// libcurl handle, we keep a reference count
+// because remote files keep libcurl loaded
+// until they're closed
+static void*  l_LibCurl         = nullptr;
+static size_t l_LibCurlRefCount = 0;
+
+struct curl_buffer
+{
+    std::vector<char>* Buffer;
+    uint64_t           MaxSize;
+};
+
+static bool libcurl_open(void)
+{
+    if (l_LibCurlRefCount > 0)
+    {
+        l_LibCurlRefCount++;
+        return true;
+    }
+
+    l_LibCurl = dlopen(LIBCURL_FILENAME, RTLD_LAZY);
+    if (l_LibCurl == nullptr)
+    {
+        std::cerr << "Error: failed to load libcurl: " << dlerror() << std::endl;
+        return false;
+    }
+
+    curl_easy_init    = reinterpret_cast<ptr_curl_easy_init>(dlsym(l_LibCurl, "curl_easy_init"));
+    curl_easy_setopt  = reinterpret_cast<ptr_curl_easy_setopt>(dlsym(l_LibCurl, "curl_easy_setopt"));
+    curl_easy_getinfo = reinterpret_cast<ptr_curl_easy_getinfo>(dlsym(l_LibCurl, "curl_easy_getinfo"));
+    curl_easy_perform = reinterpret_cast<ptr_curl_easy_perform>(dlsym(l_LibCurl, "curl_easy_perform"));
+    curl_easy_cleanup = reinterpret_cast<ptr_curl_easy_cleanup>(dlsym(l_LibCurl, "curl_easy_cleanup"));
+    curl_slist_append   = reinterpret_cast<ptr_curl_slist_append>(dlsym(l_LibCurl, "curl_slist_append"));
+    curl_slist_free_all = reinterpret_cast<ptr_curl_slist_free_all>(dlsym(l_LibCurl, "curl_slist_free_all"));
+    if (curl_easy_init      == nullptr ||
+        curl_easy_setopt    == nullptr ||
+        curl_easy_getinfo   == nullptr ||
+        curl_easy_perform   == nullptr ||
+        curl_easy_cleanup   == nullptr ||
+        curl_slist_append   == nullptr ||
+        curl_slist_free_all == nullptr)
+    {
+        dlclose(l_LibCurl);
+        l_LibCurl = nullptr;
+        std::cerr << "Error: failed to retrieve required symbols from libcurl!" << std::endl;
+        return false;
+    }
+
+    l_LibCurlRefCount = 1;
+    return true;
+}
+
+static void libcurl_close(void)
+{
+    if (l_LibCurlRefCount == 0)
+    {
+        return;
+    }
+
+    l_LibCurlRefCount--;
+    if (l_LibCurlRefCount == 0)
+    {
+        dlclose(l_LibCurl);
+        l_LibCurl = nullptr;
+    }
+}
 
 static size_t curl_write_data(char *data, size_t size, size_t nmemb, void* stream)
 {
@@ -59,57 +199,725 @@ static size_t curl_write_data(char *data, size_t size, size_t nmemb, void* strea
     fileStream->write(data, size * nmemb);
     return fileStream->tellp() - position;
 }
-#endif
 
+static size_t curl_write_buffer(char* data, size_t size, size_t nmemb, void* userdata)
+{
+    curl_buffer* curlBuffer = static_cast<curl_buffer*>(userdata);
 
-//
-// Exported Functions
-//
+    // servers which don't support range requests
+    // send the whole file, so abort the transfer
+    // when we receive more than we've asked for
+    if ((curlBuffer->Buffer->size() + (size * nmemb)) > curlBuffer->MaxSize)
+    {
+        return 0;
+    }
 
-bool Download::DownloadFile(const std::string& url, const std::filesystem::path& path)
+    curlBuffer->Buffer->insert(curlBuffer->Buffer->end(), data, data + (size * nmemb));
+    return size * nmemb;
+}
+
+static size_t curl_write_header(char* data, size_t size, size_t nmemb, void* userdata)
 {
-    std::cout << "-> Downloading " << path.filename() << std::endl;
+    std::vector<std::string>* headers = static_cast<std::vector<std::string>*>(userdata);
+    std::string header(data, size * nmemb);
 
-    if (UI::GetVerboseMode())
+    // only keep the headers of the last response,
+    // which is the one after following redirects
+    if (String::Lowercase(header).rfind("http/", 0) == 0)
+    {
+        headers->clear();
+    }
+
+    headers->push_back(header);
+    return size * nmemb;
+}
+#else
+static HINTERNET wininet_open_range(remote_file* remoteFile, uint64_t offset, uint64_t size, DWORD& statusCode)
+{
+    std::wstring wurl(remoteFile->Url.begin(), remoteFile->Url.end());
+    std::wstring headers;
+    DWORD statusCodeSize = sizeof(statusCode);
+
+    headers = L"Range: bytes=";
+    headers += std::to_wstring(offset);
+    headers += L"-";
+    headers += std::to_wstring(offset + size - 1);
+    headers += L"\r\n";
+    if (!remoteFile->Validator.empty())
+    {
+        headers += L"If-Range: ";
+        headers += std::wstring(remoteFile->Validator.begin(), remoteFile->Validator.end());
+        headers += L"\r\n";
+    }
+
+    HINTERNET url = InternetOpenUrlW(remoteFile->Internet, wurl.c_str(), headers.c_str(), static_cast<DWORD>(-1), 
+                                     INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE, 0);
+    if (url == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (!HttpQueryInfoW(url, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER, &statusCode, &statusCodeSize, nullptr))
+    {
+        InternetCloseHandle(url);
+        return nullptr;
+    }
+
+    return url;
+}
+#endif // _WIN32
+
+static std::string get_validator(const std::string& eTag, const std::string& lastModified)
+{
+    // weak ETags can't be used with If-Range
+    if (!eTag.empty() && eTag.rfind("W/", 0) != 0)
     {
-        std::cout << "--> Downloading " << url << std::endl;
+        return eTag;
     }
 
+    return lastModified;
+}
+
+static bool remote_file_open(remote_file*& remoteFile, const std::string& url, bool showErrors)
+{
+    remote_file* file = new remote_file();
+    file->Url = url;
+
 #ifdef _WIN32
-    std::wstring wurl(url.begin(), url.end());
+    DWORD statusCode = 0;
+    wchar_t contentRange[256];
+    DWORD contentRangeSize = sizeof(contentRange);
 
-    if (URLDownloadToFileW(nullptr, wurl.c_str(), path.wstring().c_str(), 0, nullptr) != S_OK)
+    file->Internet = InternetOpenW(L"SporeModManager", INTERNET_OPEN_TYPE_PRECONFIG, nullptr, nullptr, 0);
+    if (file->Internet == nullptr)
     {
-        std::cerr << "Error: failed to initialize download!" << std::endl;
+        delete file;
+        std::cerr << "Error: failed to initialize WinINet!" << std::endl;
+        return false;
+    }
+
+    // request the first byte to retrieve the
+    // file size from the Content-Range header
+    HINTERNET urlHandle = wininet_open_range(file, 0, 1, statusCode);
+    if (urlHandle == nullptr || statusCode != 206 ||
+        !HttpQueryInfoW(urlHandle, HTTP_QUERY_CONTENT_RANGE, contentRange, &contentRangeSize, nullptr))
+    {
+        if (urlHandle != nullptr)
+        {
+            InternetCloseHandle(urlHandle);
+        }
+        InternetCloseHandle(file->Internet);
+        delete file;
+        if (showErrors)
+        {
+            std::cerr << "Error: failed to open " << url << ", the server might not support range requests!" << std::endl;
+        }
         return false;
     }
 
+    // the headers are only read for the validator,
+    // so failing to retrieve them isn't an error
+    wchar_t eTag[256]         = { 0 };
+    wchar_t lastModified[256] = { 0 };
+    DWORD   eTagSize          = sizeof(eTag);
+    DWORD   lastModifiedSize  = sizeof(lastModified);
+    HttpQueryInfoW(urlHandle, HTTP_QUERY_ETAG, eTag, &eTagSize, nullptr);
+    HttpQueryInfoW(urlHandle, HTTP_QUERY_LAST_MODIFIED, lastModified, &lastModifiedSize, nullptr);
+    std::wstring eTagString(eTag);
+    std::wstring lastModifiedString(lastModified);
+    file->Validator = get_validator(std::string(eTagString.begin(), eTagString.end()),
+                                    std::string(lastModifiedString.begin(), lastModifiedString.end()));
+    InternetCloseHandle(urlHandle);
+
+    // Content-Range is 'bytes 0-0/size'
+    const wchar_t* sizeString = wcschr(contentRange, L'/');
+    if (sizeString == nullptr)
+    {
+        InternetCloseHandle(file->Internet);
+        delete file;
+        if (showErrors)
+        {
+            std::cerr << "Error: failed to retrieve file size of " << url << std::endl;
+        }
+        return false;
+    }
+    file->Size = _wcstoui64(sizeString + 1, nullptr, 10);
+#else
+    int64_t contentLength = -1;
+    std::vector<std::string> headers;
+    std::string eTag;
+    std::string lastModified;
+
+    if (!libcurl_open())
+    {
+        delete file;
+        return false;
+    }
+
+    file->Curl = curl_easy_init();
+    if (file->Curl == nullptr)
+    {
+        libcurl_close();
+        delete file;
+        std::cerr << "Error: failed to initialize cURL!" << std::endl;
+        return false;
+    }
+
+    // the handle is re-used for every range request,
+    // which allows libcurl to re-use the connection
+    curl_easy_setopt(file->Curl, CURLOPT_URL, file->Url.c_str());
+    curl_easy_setopt(file->Curl, CURLOPT_REDIR_PROTOCOLS, CURLPROTO_HTTPS);
+    curl_easy_setopt(file->Curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(file->Curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(file->Curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(file->Curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(file->Curl, CURLOPT_HEADERFUNCTION, curl_write_header);
+    curl_easy_setopt(file->Curl, CURLOPT_HEADERDATA, &headers);
+
+    if (curl_easy_perform(file->Curl) != CURLE_OK ||
+        curl_easy_getinfo(file->Curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength) != CURLE_OK ||
+        contentLength < 0)
+    {
+        curl_easy_cleanup(file->Curl);
+        libcurl_close();
+        delete file;
+        if (showErrors)
+        {
+            std::cerr << "Error: failed to retrieve file size of " << url << std::endl;
+        }
+        return false;
+    }
+
+    for (const auto& header : headers)
+    {
+        const size_t separatorPos = header.find(':');
+        const std::string name    = String::Lowercase(header.substr(0, separatorPos));
+        if (separatorPos == std::string::npos || (name != "etag" && name != "last-modified"))
+        {
+            continue;
+        }
+
+        const size_t valueStart = header.find_first_not_of(" \t", separatorPos + 1);
+        const size_t valueEnd   = header.find_last_not_of(" \t\r\n");
+        const std::string value = (valueStart == std::string::npos || valueEnd < valueStart) ?
+                                    std::string() : header.substr(valueStart, valueEnd - valueStart + 1);
+        (name == "etag" ? eTag : lastModified) = value;
+    }
+
+    // the headers are only needed for the first request
+    curl_easy_setopt(file->Curl, CURLOPT_HEADERFUNCTION, nullptr);
+    curl_easy_setopt(file->Curl, CURLOPT_HEADERDATA, nullptr);
+    curl_easy_setopt(file->Curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(file->Curl, CURLOPT_WRITEFUNCTION, curl_write_buffer);
+    file->Validator = get_validator(eTag, lastModified);
+    file->Size      = static_cast<uint64_t>(contentLength);
+#endif // _WIN32
+
+    remoteFile = file;
     return true;
+}
+
+static bool remote_file_clone(remote_file*& remoteFile, const remote_file* sourceFile)
+{
+    remote_file* file = new remote_file();
+    file->Url       = sourceFile->Url;
+    file->Validator = sourceFile->Validator;
+    file->Size      = sourceFile->Size;
+
+#ifdef _WIN32
+    file->Internet = InternetOpenW(L"SporeModManager", INTERNET_OPEN_TYPE_PRECONFIG, nullptr, nullptr, 0);
+    if (file->Internet == nullptr)
+    {
+        delete file;
+        std::cerr << "Error: failed to initialize WinINet!" << std::endl;
+        return false;
+    }
 #else
-    void* libcurl = dlopen(LIBCURL_FILENAME, RTLD_LAZY);
-    if (libcurl == nullptr)
+    if (!libcurl_open())
     {
-        std::cerr << "Error: failed to load libcurl: " << dlerror() << std::endl;
+        delete file;
         return false;
     }
 
-    curl_easy_init    = reinterpret_cast<ptr_curl_easy_init>(dlsym(libcurl, "curl_easy_init"));
-    curl_easy_setopt  = reinterpret_cast<ptr_curl_easy_setopt>(dlsym(libcurl, "curl_easy_setopt"));
-    curl_easy_perform = reinterpret_cast<ptr_curl_easy_perform>(dlsym(libcurl, "curl_easy_perform"));
-    curl_easy_cleanup = reinterpret_cast<ptr_curl_easy_cleanup>(dlsym(libcurl, "curl_easy_cleanup"));
-    if (curl_easy_init    == nullptr ||
-        curl_easy_setopt  == nullptr ||
-        curl_easy_perform == nullptr ||
-        curl_easy_cleanup == nullptr)
+    file->Curl = curl_easy_init();
+    if (file->Curl == nullptr)
+    {
+        libcurl_close();
+        delete file;
+        std::cerr << "Error: failed to initialize cURL!" << std::endl;
+        return false;
+    }
+
+    curl_easy_setopt(file->Curl, CURLOPT_URL, file->Url.c_str());
+    curl_easy_setopt(file->Curl, CURLOPT_REDIR_PROTOCOLS, CURLPROTO_HTTPS);
+    curl_easy_setopt(file->Curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(file->Curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(file->Curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(file->Curl, CURLOPT_WRITEFUNCTION, curl_write_buffer);
+#endif // _WIN32
+
+    remoteFile = file;
+    return true;
+}
+
+static bool remote_file_read(remote_file* file, uint64_t offset, uint64_t size, std::vector<char>& buffer, bool showErrors)
+{
+    buffer.clear();
+
+    // the data of a changed file doesn't
+    // match what has been read before
+    if (file->HasChanged)
+    {
+        return false;
+    }
+
+    if (size == 0)
+    {
+        return true;
+    }
+
+    if ((offset + size) > file->Size)
+    {
+        if (showErrors)
+        {
+            std::cerr << "Error: attempted to read past the end of " << file->Url << std::endl;
+        }
+        return false;
+    }
+
+    buffer.reserve(size);
+
+#ifdef _WIN32
+    DWORD statusCode = 0;
+    DWORD bytesRead  = 0;
+    char  readBuffer[16384];
+
+    HINTERNET url = wininet_open_range(file, offset, size, statusCode);
+    if (url == nullptr || statusCode != 206)
+    {
+        if (url != nullptr)
+        {
+            InternetCloseHandle(url);
+        }
+        if (statusCode == 200 && !file->Validator.empty())
+        {
+            file->HasChanged = true;
+        }
+        if (showErrors && !file->HasChanged)
+        {
+            std::cerr << "Error: failed to request range from " << file->Url << std::endl;
+        }
+        return false;
+    }
+
+    do
+    {
+        if (!InternetReadFile(url, readBuffer, sizeof(readBuffer), &bytesRead))
+        {
+            InternetCloseHandle(url);
+            if (showErrors)
+            {
+                std::cerr << "Error: failed to read range from " << file->Url << std::endl;
+            }
+            return false;
+        }
+        if ((buffer.size() + bytesRead) > size)
+        {
+            InternetCloseHandle(url);
+            if (showErrors)
+            {
+                std::cerr << "Error: received more data than requested from " << file->Url << std::endl;
+            }
+            return false;
+        }
+        buffer.insert(buffer.end(), readBuffer, readBuffer + bytesRead);
+    } while (bytesRead > 0);
+
+    InternetCloseHandle(url);
+#else
+    long responseCode = 0;
+    curl_buffer curlBuffer = { &buffer, size };
+    const std::string range = std::to_string(offset) + "-" + std::to_string(offset + size - 1);
+
+    void* headers = nullptr;
+
+    if (!file->Validator.empty())
+    {
+        const std::string ifRange = "If-Range: " + file->Validator;
+        headers = curl_slist_append(nullptr, ifRange.c_str());
+    }
+
+    curl_easy_setopt(file->Curl, CURLOPT_RANGE, range.c_str());
+    curl_easy_setopt(file->Curl, CURLOPT_WRITEDATA, &curlBuffer);
+    curl_easy_setopt(file->Curl, CURLOPT_HTTPHEADER, headers);
+
+    const int result = curl_easy_perform(file->Curl);
+    curl_easy_setopt(file->Curl, CURLOPT_HTTPHEADER, nullptr);
+    curl_slist_free_all(headers);
+
+    if (curl_easy_getinfo(file->Curl, CURLINFO_RESPONSE_CODE, &responseCode) == CURLE_OK &&
+        responseCode == 200 && !file->Validator.empty())
+    {
+        file->HasChanged = true;
+    }
+
+    if (result != CURLE_OK || responseCode != 206)
+    {
+        if (showErrors && !file->HasChanged)
+        {
+            std::cerr << "Error: failed to request range from " << file->Url 
+                      << ", the server might not support range requests!" << std::endl;
+        }
+        return false;
+    }
+#endif // _WIN32
+
+    if (buffer.size() != size)
+    {
+        if (showErrors)
+        {
+            std::cerr << "Error: received less data than requested from " << file->Url << std::endl;
+        }
+        return false;
+    }
+
+    file->BytesRead += size;
+    return true;
+}
+
+static void split_url_checksum(const std::string& url, std::string& downloadUrl, std::string& checksum)
+{
+    size_t pos = String::Lowercase(url).rfind(DOWNLOAD_CHECKSUM_PREFIX);
+    if (pos == std::string::npos)
+    {
+        downloadUrl = url;
+        checksum.clear();
+        return;
+    }
+
+    downloadUrl = url.substr(0, pos);
+    checksum    = String::Lowercase(url.substr(pos + std::string(DOWNLOAD_CHECKSUM_PREFIX).size()));
+}
+
+static std::filesystem::path get_state_path(const std::filesystem::path& path)
+{
+    std::filesystem::path statePath = path;
+    statePath += ".state";
+    return statePath;
+}
+
+static bool read_download_state(const std::filesystem::path& statePath, download_state& state)
+{
+    std::ifstream stateFileStream(statePath);
+    std::string line;
+    size_t chunkCount = 0;
+
+    if (!stateFileStream.is_open())
+    {
+        return false;
+    }
+
+    if (!std::getline(stateFileStream, line) || line != DOWNLOAD_STATE_MAGIC ||
+        !std::getline(stateFileStream, state.Url) ||
+        !std::getline(stateFileStream, state.Validator) ||
+        !(stateFileStream >> state.Size >> chunkCount))
+    {
+        return false;
+    }
+
+    state.Chunks.resize(chunkCount);
+    for (auto& chunk : state.Chunks)
+    {
+        if (!(stateFileStream >> chunk.Offset >> chunk.Size >> chunk.BytesDone >> chunk.Crc32) ||
+            chunk.BytesDone > chunk.Size || (chunk.Offset + chunk.Size) > state.Size)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool write_download_state(const std::filesystem::path& statePath, const download_state& state)
+{
+    std::filesystem::path tempStatePath = statePath;
+    std::ofstream stateFileStream;
+    std::error_code error;
+
+    tempStatePath += ".tmp";
+
+    stateFileStream.open(tempStatePath, std::ios::trunc);
+    if (!stateFileStream.is_open())
+    {
+        return false;
+    }
+
+    stateFileStream << DOWNLOAD_STATE_MAGIC << "\n"
+                    << state.Url << "\n"
+                    << state.Validator << "\n"
+                    << state.Size << " " << state.Chunks.size() << "\n";
+    for (const auto& chunk : state.Chunks)
+    {
+        stateFileStream << chunk.Offset << " " << chunk.Size << " " << chunk.BytesDone << " " << chunk.Crc32 << "\n";
+    }
+    stateFileStream.flush();
+    stateFileStream.close();
+    if (stateFileStream.fail())
+    {
+        return false;
+    }
+
+    // rename over the old state file so
+    // an interrupted write never corrupts it
+    std::filesystem::rename(tempStatePath, statePath, error);
+    return !error;
+}
+
+static bool verify_download_state(const std::filesystem::path& path, download_state& state)
+{
+    std::vector<char> buffer;
+    std::ifstream inputFileStream(path, std::ios::binary);
+    uint64_t bytesDone = 0;
+
+    if (!inputFileStream.is_open())
+    {
+        return false;
+    }
+
+    // re-verify the data of each chunk we've
+    // received before, restart chunks which
+    // don't match the stored checksum
+    for (auto& chunk : state.Chunks)
+    {
+        if (chunk.BytesDone == 0)
+        {
+            continue;
+        }
+
+        buffer.resize(chunk.BytesDone);
+        inputFileStream.seekg(chunk.Offset);
+        inputFileStream.read(buffer.data(), buffer.size());
+        if (!inputFileStream.good() || Hash::Crc32(buffer.data(), buffer.size()) != chunk.Crc32)
+        {
+            inputFileStream.clear();
+            chunk.BytesDone = 0;
+            chunk.Crc32     = 0;
+            continue;
+        }
+
+        bytesDone += chunk.BytesDone;
+    }
+
+    if (bytesDone > 0)
+    {
+        std::cout << "-> Resuming download of " << path.filename() << " (" << bytesDone << " of " << state.Size << " bytes)" << std::endl;
+    }
+
+    return true;
+}
+
+static bool download_chunked(remote_file* file, const std::filesystem::path& path, bool& hasChanged)
+{
+    const std::filesystem::path statePath = get_state_path(path);
+    std::vector<remote_file*> remoteFiles;
+    std::mutex                mutex;
+    std::mutex                stateFileMutex;
+    std::atomic<bool>         failed(false);
+    std::chrono::steady_clock::time_point checkpointTime = std::chrono::steady_clock::now();
+    download_state state;
+    std::error_code error;
+
+    hasChanged = false;
+
+    // try to resume from the state file, when it doesn't match the url,
+    // the validator or the file size, start over with a new preallocated file,
+    // without a validator we can't know whether the file has changed
+    if (!read_download_state(statePath, state) ||
+        state.Url != file->Url || state.Size != file->Size ||
+        state.Validator.empty() || state.Validator != file->Validator ||
+        std::filesystem::file_size(path, error) != file->Size || error ||
+        !verify_download_state(path, state))
+    {
+        state = {};
+        state.Url       = file->Url;
+        state.Validator = file->Validator;
+        state.Size      = file->Size;
+        for (uint64_t offset = 0; offset < file->Size; offset += DOWNLOAD_CHUNK_SIZE)
+        {
+            download_chunk chunk;
+            chunk.Offset = offset;
+            chunk.Size   = std::min<uint64_t>(DOWNLOAD_CHUNK_SIZE, file->Size - offset);
+            state.Chunks.push_back(chunk);
+        }
+
+        std::ofstream outputFileStream(path, std::ios::trunc | std::ios::binary);
+        if (!outputFileStream.is_open())
+        {
+            std::cerr << "Error: failed to open " << path << std::endl;
+            return false;
+        }
+        outputFileStream.close();
+
+        std::filesystem::resize_file(path, file->Size, error);
+        if (error)
+        {
+            std::cerr << "Error: failed to allocate " << path << ": " << error.message() << std::endl;
+            return false;
+        }
+
+        if (!write_download_state(statePath, state))
+        {
+            std::cerr << "Error: failed to write " << statePath << std::endl;
+            return false;
+        }
+    }
+
+    // each connection has its own handle
+    remoteFiles.push_back(file);
+    for (int i = 1; i < DOWNLOAD_CONNECTIONS; i++)
+    {
+        remote_file* clonedFile = nullptr;
+        if (!remote_file_clone(clonedFile, file))
+        {
+            break;
+        }
+        remoteFiles.push_back(clonedFile);
+    }
+    std::vector<remote_file*> freeRemoteFiles = remoteFiles;
+
+    Thread::ParallelFor(state.Chunks.size(), [&](size_t index)
+    {
+        std::vector<char> buffer;
+        download_state checkpointState;
+        bool          checkpoint;
+        remote_file*  remoteFile;
+        std::fstream  outputFileStream;
+        uint64_t      offset;
+        uint64_t      size;
+        uint32_t      crc;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (failed || state.Chunks[index].BytesDone == state.Chunks[index].Size)
+            {
+                return;
+            }
+            remoteFile = freeRemoteFiles.back();
+            freeRemoteFiles.pop_back();
+            offset = state.Chunks[index].Offset + state.Chunks[index].BytesDone;
+            crc    = state.Chunks[index].Crc32;
+        }
+
+        outputFileStream.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!outputFileStream.is_open())
+        {
+            failed = true;
+        }
+
+        while (!failed && offset < (state.Chunks[index].Offset + state.Chunks[index].Size))
+        {
+            size = std::min<uint64_t>(DOWNLOAD_BLOCK_SIZE, state.Chunks[index].Offset + state.Chunks[index].Size - offset);
+            if (!remote_file_read(remoteFile, offset, size, buffer, true))
+            {
+                failed = true;
+                break;
+            }
+
+            outputFileStream.seekp(offset);
+            outputFileStream.write(buffer.data(), buffer.size());
+            outputFileStream.flush();
+            if (outputFileStream.fail())
+            {
+                failed = true;
+                break;
+            }
+
+            crc = Hash::Crc32(buffer.data(), buffer.size(), crc);
+            offset += size;
+
+            // only store progress after the data has been written,
+            // the state file is written when the chunk is done
+            // or after an interval, which limits the amount of
+            // data which has to be downloaded again on resume
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                state.Chunks[index].BytesDone += size;
+                state.Chunks[index].Crc32      = crc;
+
+                const auto now = std::chrono::steady_clock::now();
+                checkpoint = state.Chunks[index].BytesDone == state.Chunks[index].Size ||
+                             (now - checkpointTime) >= std::chrono::seconds(DOWNLOAD_CHECKPOINT_INTERVAL);
+                if (checkpoint)
+                {
+                    checkpointTime  = now;
+                    checkpointState = state;
+                }
+            }
+
+            // write the copy without holding the lock, so the other
+            // connections can continue, writing an older copy after
+            // a newer one only loses progress, which is safe
+            if (checkpoint)
+            {
+                std::lock_guard<std::mutex> lock(stateFileMutex);
+                write_download_state(statePath, checkpointState);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        freeRemoteFiles.push_back(remoteFile);
+    }, static_cast<unsigned int>(remoteFiles.size()));
+
+    // the first handle is owned by the caller
+    for (size_t i = 0; i < remoteFiles.size(); i++)
+    {
+        hasChanged = hasChanged || remoteFiles[i]->HasChanged;
+        if (i > 0)
+        {
+            Download::CloseRemoteFile(remoteFiles[i]);
+        }
+    }
+
+    // the downloaded data belongs to another
+    // version of the file, so it can't be resumed
+    if (hasChanged)
+    {
+        std::filesystem::remove(statePath, error);
+        return false;
+    }
+
+    if (failed)
+    {
+        std::cerr << "Error: failed to download file, rerun to resume the download!" << std::endl;
+        return false;
+    }
+
+    std::filesystem::remove(statePath, error);
+    return true;
+}
+
+static bool download_single(const std::string& url, const std::filesystem::path& path)
+{
+#ifdef _WIN32
+    std::wstring wurl(url.begin(), url.end());
+
+    if (URLDownloadToFileW(nullptr, wurl.c_str(), path.wstring().c_str(), 0, nullptr) != S_OK)
+    {
+        std::cerr << "Error: failed to initialize download!" << std::endl;
+        return false;
+    }
+
+    return true;
+#else
+    if (!libcurl_open())
     {
-        dlclose(libcurl);
-        std::cerr << "Error: failed to retrieve required symbols from libcurl!" << std::endl;
         return false;
     }
 
     void* curl = curl_easy_init();
     if (curl == nullptr)
     {
+        libcurl_close();
         std::cerr << "Error: failed to initialize cURL!" << std::endl;;
         return false;
     }
@@ -118,7 +926,7 @@ bool Download::DownloadFile(const std::string& url, const std::filesystem::path&
     if (!fileStream.is_open())
     {
         curl_easy_cleanup(curl);
-        dlclose(libcurl);
+        libcurl_close();
         std::cerr << "Error: failed to open " << path << std::endl;
         return false;
     }
@@ -132,13 +940,206 @@ bool Download::DownloadFile(const std::string& url, const std::filesystem::path&
     if (curl_easy_perform(curl) != CURLE_OK)
     {
         curl_easy_cleanup(curl);
-        dlclose(libcurl);
+        libcurl_close();
         std::cerr << "Error: failed to download file!" << std::endl;
         return false;
     }
 
     curl_easy_cleanup(curl);
-    dlclose(libcurl);
+    libcurl_close();
+    return true;
+#endif // _WIN32
+}
+
+//
+// Exported Functions
+//
+
+bool Download::IsUrl(const std::string& path)
+{
+    const std::string lowercasePath = String::Lowercase(path);
+    return lowercasePath.rfind("http://", 0) == 0 ||
+           lowercasePath.rfind("https://", 0) == 0;
+}
+
+std::filesystem::path Download::GetFileName(const std::string& url)
+{
+    std::string fileName = url.substr(0, url.find_first_of("?#"));
+    size_t pos = fileName.rfind('/');
+    if (pos != std::string::npos)
+    {
+        fileName.erase(0, pos + 1);
+    }
+    return fileName;
+}
+
+bool Download::HasChecksum(const std::string& url)
+{
+    return String::Lowercase(url).rfind(DOWNLOAD_CHECKSUM_PREFIX) != std::string::npos;
+}
+
+bool Download::DownloadFile(const std::string& url, const std::filesystem::path& path)
+{
+    remote_file* remoteFile = nullptr;
+    std::string downloadUrl;
+    std::string expectedChecksum;
+    std::string checksum;
+    std::vector<char> buffer;
+    std::error_code error;
+    bool ret = false;
+
+    split_url_checksum(url, downloadUrl, expectedChecksum);
+
+    // when the file has already been downloaded
+    // and matches the checksum, we're done
+    if (!expectedChecksum.empty() && !std::filesystem::exists(get_state_path(path), error) &&
+        std::filesystem::is_regular_file(path, error) && 
+        Hash::Sha256File(path, checksum) && checksum == expectedChecksum)
+    {
+        std::cout << "-> Using already downloaded " << path.filename() << std::endl;
+        return true;
+    }
+
+    std::cout << "-> Downloading " << path.filename() << std::endl;
+
+    if (UI::GetVerboseMode())
+    {
+        std::cout << "--> Downloading " << downloadUrl << std::endl;
+    }
+
+    // use chunked range requests when the server supports them,
+    // which allows resuming interrupted downloads, otherwise
+    // fallback to a single request, when the file changes
+    // on the server during the download, restart it once
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        bool hasChanged = false;
+
+        if (remote_file_open(remoteFile, downloadUrl, false) && 
+            remoteFile->Size > 0 && remote_file_read(remoteFile, 0, 1, buffer, false))
+        {
+            remoteFile->BytesRead = 0;
+            ret = download_chunked(remoteFile, path, hasChanged);
+        }
+        else
+        {
+            ret = download_single(downloadUrl, path);
+        }
+        Download::CloseRemoteFile(remoteFile);
+        remoteFile = nullptr;
+
+        if (!hasChanged)
+        {
+            break;
+        }
+
+        ret = false;
+        if (attempt == 0)
+        {
+            std::cout << "-> " << path.filename() << " has changed on the server, restarting the download" << std::endl;
+        }
+        else
+        {
+            std::cerr << "Error: " << downloadUrl << " has changed on the server during the download!" << std::endl;
+        }
+    }
+
+    if (!ret)
+    {
+        return false;
+    }
+
+    // verify the checksum before anything uses the file
+    if (!expectedChecksum.empty())
+    {
+        if (!Hash::Sha256File(path, checksum))
+        {
+            return false;
+        }
+
+        if (UI::GetVerboseMode())
+        {
+            std::cout << "--> SHA-256 of " << path.filename() << ": " << checksum << std::endl;
+        }
+
+        if (checksum != expectedChecksum)
+        {
+            std::filesystem::remove(path, error);
+            std::cerr << "Error: SHA-256 of " << path.filename() << " doesn't match, expected " 
+                      << expectedChecksum << " but got " << checksum << "!" << std::endl;
+            return false;
+        }
+    }
+
     return true;
+}
+
+void Download::RemoveDownloadedFile(const std::filesystem::path& path)
+{
+    std::error_code error;
+
+    std::filesystem::remove(path, error);
+    std::filesystem::remove(get_state_path(path), error);
+}
+
+bool Download::OpenRemoteFile(RemoteFile& remoteFile, const std::string& url)
+{
+    remote_file* file = nullptr;
+
+    if (UI::GetVerboseMode())
+    {
+        std::cout << "--> Opening " << url << std::endl;
+    }
+
+    if (!remote_file_open(file, url, true))
+    {
+        return false;
+    }
+
+    remoteFile = file;
+    return true;
+}
+
+void Download::CloseRemoteFile(RemoteFile remoteFile)
+{
+    remote_file* file = static_cast<remote_file*>(remoteFile);
+    if (file == nullptr)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    InternetCloseHandle(file->Internet);
+#else
+    curl_easy_cleanup(file->Curl);
+    libcurl_close();
 #endif // _WIN32
+
+    delete file;
+}
+
+uint64_t Download::GetRemoteFileSize(RemoteFile remoteFile)
+{
+    return static_cast<remote_file*>(remoteFile)->Size;
+}
+
+uint64_t Download::GetRemoteFileBytesRead(RemoteFile remoteFile)
+{
+    return static_cast<remote_file*>(remoteFile)->BytesRead;
+}
+
+bool Download::ReadRemoteFile(RemoteFile remoteFile, uint64_t offset, uint64_t size, std::vector<char>& buffer)
+{
+    remote_file* file = static_cast<remote_file*>(remoteFile);
+
+    if (!remote_file_read(file, offset, size, buffer, true))
+    {
+        if (file->HasChanged)
+        {
+            std::cerr << "Error: " << file->Url << " has changed on the server!" << std::endl;
+        }
+        return false;
+    }
+
+    return true;
 }
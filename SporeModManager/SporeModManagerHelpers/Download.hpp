@@ -11,17 +11,67 @@
 #define SPOREMODMANAGERHELPERS_DOWNLOAD_HPP
 
 #include <string>
+#include <vector>
+#include <cstdint>
 #include <filesystem>
 
 namespace SporeModManagerHelpers
 {
     namespace Download
     {
+        typedef void* RemoteFile;
+
+        /// <summary>
+        ///     Returns whether the given path is an url
+        /// </summary>
+        bool IsUrl(const std::string& path);
+
+        /// <summary>
+        ///     Returns the filename of the given url
+        /// </summary>
+        std::filesystem::path GetFileName(const std::string& url);
+
         /// <summary>
-        ///     Downloads url to path
+        ///     Returns whether the given url contains a '#sha256=' checksum
+        /// </summary>
+        bool HasChecksum(const std::string& url);
+
+        /// <summary>
+        ///     Downloads url to path, using resumable chunked range requests when supported,
+        ///     when url ends with '#sha256=checksum', the downloaded file is verified
         /// </summary>
         bool DownloadFile(const std::string& url, const std::filesystem::path& path);
+
+        /// <summary>
+        ///     Removes the file downloaded to path by DownloadFile() and its download state
+        /// </summary>
+        void RemoveDownloadedFile(const std::filesystem::path& path);
+
+        /// <summary>
+        ///     Opens url for range requests
+        /// </summary>
+        bool OpenRemoteFile(RemoteFile& remoteFile, const std::string& url);
+
+        /// <summary>
+        ///     Closes the given remote file
+        /// </summary>
+        void CloseRemoteFile(RemoteFile remoteFile);
+
+        /// <summary>
+        ///     Returns the size of the given remote file
+        /// </summary>
+        uint64_t GetRemoteFileSize(RemoteFile remoteFile);
+
+        /// <summary>
+        ///     Returns the amount of bytes transferred for the given remote file
+        /// </summary>
+        uint64_t GetRemoteFileBytesRead(RemoteFile remoteFile);
+
+        /// <summary>
+        ///     Reads size bytes at offset from the given remote file to buffer
+        /// </summary>
+        bool ReadRemoteFile(RemoteFile remoteFile, uint64_t offset, uint64_t size, std::vector<char>& buffer);
     }
 }
 
-#endif // SPOREMODMANAGERHELPERS_DOWNLOAD_HPP
\ No newline at end of file
+#endif // SPOREMODMANAGERHELPERS_DOWNLOAD_HPP
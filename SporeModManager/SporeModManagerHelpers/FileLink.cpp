@@ -0,0 +1,180 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "FileLink.hpp"
+
+#include <iostream>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#endif // __linux__
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Variables
+//
+
+static FileLink::LinkMode l_LinkMode = FileLink::LinkMode::Auto;
+
+//
+// Helper Functions
+//
+
+static bool reflink_file(const std::filesystem::path& source, const std::filesystem::path& destination, std::error_code& error)
+{
+#if defined(__linux__) && defined(FICLONE)
+    struct stat sourceStat;
+    int sourceFileDescriptor;
+    int destinationFileDescriptor;
+    int ret;
+
+    sourceFileDescriptor = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (sourceFileDescriptor == -1)
+    {
+        error = std::error_code(errno, std::generic_category());
+        return false;
+    }
+
+    if (fstat(sourceFileDescriptor, &sourceStat) == -1)
+    {
+        error = std::error_code(errno, std::generic_category());
+        close(sourceFileDescriptor);
+        return false;
+    }
+
+    destinationFileDescriptor = open(destination.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, sourceStat.st_mode & 0777);
+    if (destinationFileDescriptor == -1)
+    {
+        error = std::error_code(errno, std::generic_category());
+        close(sourceFileDescriptor);
+        return false;
+    }
+
+    // share the blocks of source with destination,
+    // this fails when the filesystem doesn't support it
+    ret = ioctl(destinationFileDescriptor, FICLONE, sourceFileDescriptor);
+    if (ret == -1)
+    {
+        error = std::error_code(errno, std::generic_category());
+    }
+
+    close(destinationFileDescriptor);
+    close(sourceFileDescriptor);
+
+    if (ret == -1)
+    {
+        unlink(destination.c_str());
+        return false;
+    }
+
+    return true;
+#else
+    (void)source;
+    (void)destination;
+    error = std::make_error_code(std::errc::operation_not_supported);
+    return false;
+#endif // __linux__ && FICLONE
+}
+
+static bool hardlink_file(const std::filesystem::path& source, const std::filesystem::path& destination, std::error_code& error)
+{
+    std::filesystem::create_hard_link(source, destination, error);
+    return !error;
+}
+
+static bool full_copy_file(const std::filesystem::path& source, const std::filesystem::path& destination, std::error_code& error)
+{
+    std::filesystem::copy_file(source, destination, error);
+    return !error;
+}
+
+static bool is_read_only(const std::filesystem::path& path)
+{
+    std::error_code error;
+    std::filesystem::perms permissions = std::filesystem::status(path, error).permissions();
+    if (error)
+    {
+        return false;
+    }
+
+    return (permissions & (std::filesystem::perms::owner_write |
+                           std::filesystem::perms::group_write |
+                           std::filesystem::perms::others_write)) == std::filesystem::perms::none;
+}
+
+//
+// Exported Functions
+//
+
+void FileLink::SetLinkMode(LinkMode mode)
+{
+    l_LinkMode = mode;
+}
+
+FileLink::LinkMode FileLink::GetLinkMode(void)
+{
+    return l_LinkMode;
+}
+
+bool FileLink::LinkFile(const std::filesystem::path& source, const std::filesystem::path& destination)
+{
+    std::error_code error;
+    const char* linkType = "copy";
+    bool ret = false;
+
+    switch (l_LinkMode)
+    {
+    default:
+    case LinkMode::Auto:
+        // a hardlinked file changes along with source,
+        // so only use one when source is read-only
+        ret = reflink_file(source, destination, error) ||
+                (is_read_only(source) && hardlink_file(source, destination, error)) ||
+                full_copy_file(source, destination, error);
+        break;
+    case LinkMode::Reflink:
+        linkType = "reflink";
+        ret = reflink_file(source, destination, error);
+        break;
+    case LinkMode::Hardlink:
+        linkType = "hardlink";
+        ret = hardlink_file(source, destination, error);
+        break;
+    case LinkMode::Copy:
+        ret = full_copy_file(source, destination, error);
+        break;
+    }
+
+    if (!ret)
+    {
+        std::cerr << "Error: failed to " << linkType << " " << source << " to " << destination << ": " << error.message() << std::endl;
+    }
+
+    return ret;
+}
+
+bool FileLink::CloneFile(const std::filesystem::path& source, const std::filesystem::path& destination)
+{
+    std::error_code error;
+
+    if (!reflink_file(source, destination, error) &&
+        !full_copy_file(source, destination, error))
+    {
+        std::cerr << "Error: failed to copy " << source << " to " << destination << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
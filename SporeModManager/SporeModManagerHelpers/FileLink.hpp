@@ -0,0 +1,52 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_FILELINK_HPP
+#define SPOREMODMANAGERHELPERS_FILELINK_HPP
+
+#include <filesystem>
+
+namespace SporeModManagerHelpers
+{
+    namespace FileLink
+    {
+        enum class LinkMode
+        {
+            Auto     = 0,
+            Reflink  = 1,
+            Hardlink = 2,
+            Copy     = 3
+        };
+
+        /// <summary>
+        ///     Sets link mode
+        /// </summary>
+        void SetLinkMode(LinkMode mode);
+
+        /// <summary>
+        ///     Gets link mode
+        /// </summary>
+        LinkMode GetLinkMode(void);
+
+        /// <summary>
+        ///     Creates destination with the contents of source using the link mode,
+        ///     with LinkMode::Auto, a reflink is tried first, then a hardlink when
+        ///     source is read-only, and a copy when both fail
+        /// </summary>
+        bool LinkFile(const std::filesystem::path& source, const std::filesystem::path& destination);
+
+        /// <summary>
+        ///     Creates destination as an independent copy of source,
+        ///     using a reflink when supported
+        /// </summary>
+        bool CloneFile(const std::filesystem::path& source, const std::filesystem::path& destination);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_FILELINK_HPP
@@ -0,0 +1,120 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "FileMap.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // _WIN32
+
+using namespace SporeModManagerHelpers;
+
+//
+// Exported Functions
+//
+
+bool FileMap::MapFile(const std::filesystem::path& path, MappedFile& file)
+{
+#ifdef _WIN32
+    LARGE_INTEGER fileSize;
+    HANDLE fileHandle;
+
+    fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    file.FileHandle = fileHandle;
+    if (!GetFileSizeEx(fileHandle, &fileSize))
+    {
+        return false;
+    }
+
+    file.Size = static_cast<size_t>(fileSize.QuadPart);
+    if (file.Size == 0)
+    {
+        return true;
+    }
+
+    file.MappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (file.MappingHandle == nullptr)
+    {
+        return false;
+    }
+
+    file.Data = static_cast<const char*>(MapViewOfFile(file.MappingHandle, FILE_MAP_READ, 0, 0, 0));
+    return file.Data != nullptr;
+#else
+    struct stat fileStat;
+    void* data;
+    int fileDescriptor;
+
+    fileDescriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor == -1)
+    {
+        return false;
+    }
+
+    if (fstat(fileDescriptor, &fileStat) == -1)
+    {
+        close(fileDescriptor);
+        return false;
+    }
+
+    file.Size = static_cast<size_t>(fileStat.st_size);
+    if (file.Size == 0)
+    {
+        close(fileDescriptor);
+        return true;
+    }
+
+    data = mmap(nullptr, file.Size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    file.Data = static_cast<const char*>(data);
+    return true;
+#endif // _WIN32
+}
+
+void FileMap::UnmapFile(MappedFile& file)
+{
+#ifdef _WIN32
+    if (file.Data != nullptr)
+    {
+        UnmapViewOfFile(file.Data);
+    }
+    if (file.MappingHandle != nullptr)
+    {
+        CloseHandle(file.MappingHandle);
+    }
+    if (file.FileHandle != nullptr)
+    {
+        CloseHandle(file.FileHandle);
+    }
+    file.MappingHandle = nullptr;
+    file.FileHandle    = nullptr;
+#else
+    if (file.Data != nullptr)
+    {
+        munmap(const_cast<char*>(file.Data), file.Size);
+    }
+#endif // _WIN32
+    file.Data = nullptr;
+    file.Size = 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_FILEMAP_HPP
+#define SPOREMODMANAGERHELPERS_FILEMAP_HPP
+
+#include <filesystem>
+#include <cstddef>
+
+namespace SporeModManagerHelpers
+{
+    namespace FileMap
+    {
+        struct MappedFile
+        {
+            const char* Data = nullptr;
+            size_t      Size = 0;
+#ifdef _WIN32
+            void* FileHandle    = nullptr;
+            void* MappingHandle = nullptr;
+#endif // _WIN32
+        };
+
+        /// <summary>
+        ///     Maps the given file read-only, only the parts of it which are
+        ///     accessed are read, UnmapFile() has to be called even when it fails
+        /// </summary>
+        bool MapFile(const std::filesystem::path& path, MappedFile& file);
+
+        /// <summary>
+        ///     Unmaps the given file
+        /// </summary>
+        void UnmapFile(MappedFile& file);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_FILEMAP_HPP
@@ -0,0 +1,329 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <vector>
+
+#include <zlib.h>
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define HASH_READ_SIZE 1048576 /* 1 MiB */
+
+#define HASH_FNV_OFFSET_BASIS 0x811C9DC5
+#define HASH_FNV_PRIME        0x01000193
+#define HASH_FNV_LANES        8
+
+//
+// Local Structures
+//
+
+struct sha256_context
+{
+    uint32_t State[8];
+    uint64_t Length;
+    uint8_t  Block[64];
+    size_t   BlockSize;
+};
+
+//
+// Local Variables
+//
+
+static const uint32_t l_Sha256RoundConstants[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+//
+// Local Functions
+//
+
+static uint32_t sha256_rotr(uint32_t value, uint32_t count)
+{
+    return (value >> count) | (value << (32 - count));
+}
+
+static void sha256_transform(sha256_context& context, const uint8_t* block)
+{
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+
+    for (int i = 0; i < 16; i++)
+    {
+        w[i] = (static_cast<uint32_t>(block[i * 4]) << 24)     |
+               (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(block[i * 4 + 2]) << 8)  |
+               (static_cast<uint32_t>(block[i * 4 + 3]));
+    }
+    for (int i = 16; i < 64; i++)
+    {
+        uint32_t s0 = sha256_rotr(w[i - 15], 7) ^ sha256_rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = sha256_rotr(w[i - 2], 17) ^ sha256_rotr(w[i - 2], 19)  ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    a = context.State[0]; b = context.State[1]; c = context.State[2]; d = context.State[3];
+    e = context.State[4]; f = context.State[5]; g = context.State[6]; h = context.State[7];
+
+    for (int i = 0; i < 64; i++)
+    {
+        uint32_t s1    = sha256_rotr(e, 6) ^ sha256_rotr(e, 11) ^ sha256_rotr(e, 25);
+        uint32_t ch    = (e & f) ^ (~e & g);
+        uint32_t temp1 = h + s1 + ch + l_Sha256RoundConstants[i] + w[i];
+        uint32_t s0    = sha256_rotr(a, 2) ^ sha256_rotr(a, 13) ^ sha256_rotr(a, 22);
+        uint32_t maj   = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t temp2 = s0 + maj;
+
+        h = g; g = f; f = e; e = d + temp1;
+        d = c; c = b; b = a; a = temp1 + temp2;
+    }
+
+    context.State[0] += a; context.State[1] += b; context.State[2] += c; context.State[3] += d;
+    context.State[4] += e; context.State[5] += f; context.State[6] += g; context.State[7] += h;
+}
+
+static void sha256_init(sha256_context& context)
+{
+    const uint32_t initialState[8] =
+    {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    std::memcpy(context.State, initialState, sizeof(initialState));
+    context.Length    = 0;
+    context.BlockSize = 0;
+}
+
+static void sha256_update(sha256_context& context, const uint8_t* data, size_t size)
+{
+    context.Length += size;
+
+    // fill the pending block first
+    while (size > 0 && context.BlockSize > 0)
+    {
+        context.Block[context.BlockSize++] = *data++;
+        size--;
+        if (context.BlockSize == 64)
+        {
+            sha256_transform(context, context.Block);
+            context.BlockSize = 0;
+        }
+    }
+
+    // transform full blocks directly from data
+    while (size >= 64)
+    {
+        sha256_transform(context, data);
+        data += 64;
+        size -= 64;
+    }
+
+    std::memcpy(context.Block, data, size);
+    context.BlockSize = size;
+}
+
+static std::string sha256_final(sha256_context& context)
+{
+    const char hexCharacters[] = "0123456789abcdef";
+    const uint64_t bitLength = context.Length * 8;
+    uint8_t padding[72] = { 0x80 };
+    size_t  paddingSize;
+    std::string hash;
+
+    // pad to 56 bytes in the last block, then append the length
+    paddingSize = (context.BlockSize < 56) ? (56 - context.BlockSize) : (120 - context.BlockSize);
+    for (int i = 0; i < 8; i++)
+    {
+        padding[paddingSize + i] = static_cast<uint8_t>(bitLength >> (56 - (i * 8)));
+    }
+    sha256_update(context, padding, paddingSize + 8);
+
+    hash.reserve(64);
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 28; j >= 0; j -= 4)
+        {
+            hash += hexCharacters[(context.State[i] >> j) & 0xF];
+        }
+    }
+
+    return hash;
+}
+
+static uint32_t fnv_lowercase(char c)
+{
+    // Spore's characters are signed, so
+    // characters above 0x7F are sign extended
+    const int value = static_cast<signed char>(c);
+    return static_cast<uint32_t>(value + (static_cast<int>(static_cast<unsigned int>(value - 'A') < 26) << 5));
+}
+
+static uint32_t fnv_update(uint32_t hash, const char* data, size_t size)
+{
+    // Spore multiplies before xor'ing, so it's FNV-1
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash * HASH_FNV_PRIME) ^ fnv_lowercase(data[i]);
+    }
+    return hash;
+}
+
+//
+// Exported Functions
+//
+
+uint32_t Hash::Crc32(const char* data, size_t size, uint32_t crc)
+{
+    return static_cast<uint32_t>(crc32_z(crc, reinterpret_cast<const Bytef*>(data), size));
+}
+
+bool Hash::Crc32File(const std::filesystem::path& path, uint32_t& crc)
+{
+    std::vector<char> buffer(HASH_READ_SIZE);
+    std::ifstream inputFileStream;
+
+    inputFileStream.open(path, std::ios::binary);
+    if (!inputFileStream.is_open())
+    {
+        std::cerr << "Error: failed to open " << path << std::endl;
+        return false;
+    }
+
+    crc = 0;
+    do
+    {
+        inputFileStream.read(buffer.data(), buffer.size());
+        crc = Crc32(buffer.data(), static_cast<size_t>(inputFileStream.gcount()), crc);
+    } while (inputFileStream.good());
+
+    if (inputFileStream.bad())
+    {
+        std::cerr << "Error: failed to read " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+std::string Hash::Sha256(const char* data, size_t size)
+{
+    sha256_context context;
+
+    sha256_init(context);
+    sha256_update(context, reinterpret_cast<const uint8_t*>(data), size);
+    return sha256_final(context);
+}
+
+bool Hash::Sha256File(const std::filesystem::path& path, std::string& hash)
+{
+    std::vector<char> buffer(HASH_READ_SIZE);
+    std::ifstream inputFileStream;
+    sha256_context context;
+
+    inputFileStream.open(path, std::ios::binary);
+    if (!inputFileStream.is_open())
+    {
+        std::cerr << "Error: failed to open " << path << std::endl;
+        return false;
+    }
+
+    sha256_init(context);
+    do
+    {
+        inputFileStream.read(buffer.data(), buffer.size());
+        sha256_update(context, reinterpret_cast<const uint8_t*>(buffer.data()), static_cast<size_t>(inputFileStream.gcount()));
+    } while (inputFileStream.good());
+
+    if (inputFileStream.bad())
+    {
+        std::cerr << "Error: failed to read " << path << std::endl;
+        return false;
+    }
+
+    hash = sha256_final(context);
+    return true;
+}
+
+uint32_t Hash::Fnv(const char* data, size_t size)
+{
+    return fnv_update(HASH_FNV_OFFSET_BASIS, data, size);
+}
+
+void Hash::Fnv(const std::vector<std::string>& names, std::vector<uint32_t>& hashes)
+{
+    std::vector<size_t> nameIds(names.size());
+    uint32_t    laneHashes[HASH_FNV_LANES];
+    const char* laneData[HASH_FNV_LANES];
+
+    hashes.resize(names.size());
+
+    // every character depends on the hash of the characters
+    // before it, so a single name can't be hashed any faster,
+    // hashing names of similar lengths side by side keeps the
+    // multiplier busy instead of waiting for the previous result
+    for (size_t i = 0; i < nameIds.size(); i++)
+    {
+        nameIds[i] = i;
+    }
+    std::sort(nameIds.begin(), nameIds.end(), [&](size_t a, size_t b)
+    {
+        return names[a].size() < names[b].size();
+    });
+
+    size_t i = 0;
+    for (; i + HASH_FNV_LANES <= nameIds.size(); i += HASH_FNV_LANES)
+    {
+        // the first name is the shortest one, so every
+        // name has at least that many characters
+        const size_t size = names[nameIds[i]].size();
+
+        for (size_t lane = 0; lane < HASH_FNV_LANES; lane++)
+        {
+            laneHashes[lane] = HASH_FNV_OFFSET_BASIS;
+            laneData[lane]   = names[nameIds[i + lane]].data();
+        }
+
+        for (size_t j = 0; j < size; j++)
+        {
+            for (size_t lane = 0; lane < HASH_FNV_LANES; lane++)
+            {
+                laneHashes[lane] = (laneHashes[lane] * HASH_FNV_PRIME) ^ fnv_lowercase(laneData[lane][j]);
+            }
+        }
+
+        for (size_t lane = 0; lane < HASH_FNV_LANES; lane++)
+        {
+            const std::string& name = names[nameIds[i + lane]];
+            hashes[nameIds[i + lane]] = fnv_update(laneHashes[lane], name.data() + size, name.size() - size);
+        }
+    }
+
+    for (; i < nameIds.size(); i++)
+    {
+        const std::string& name = names[nameIds[i]];
+        hashes[nameIds[i]] = Fnv(name.data(), name.size());
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_HASH_HPP
+#define SPOREMODMANAGERHELPERS_HASH_HPP
+
+#include <filesystem>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SporeModManagerHelpers
+{
+    namespace Hash
+    {
+        /// <summary>
+        ///     Returns the CRC32 of data, continuing from crc
+        /// </summary>
+        uint32_t Crc32(const char* data, size_t size, uint32_t crc = 0);
+
+        /// <summary>
+        ///     Calculates the CRC32 of the given file
+        /// </summary>
+        bool Crc32File(const std::filesystem::path& path, uint32_t& crc);
+
+        /// <summary>
+        ///     Returns the SHA-256 of data as a lowercase hex string
+        /// </summary>
+        std::string Sha256(const char* data, size_t size);
+
+        /// <summary>
+        ///     Calculates the SHA-256 of the given file as a lowercase hex string
+        /// </summary>
+        bool Sha256File(const std::filesystem::path& path, std::string& hash);
+
+        /// <summary>
+        ///     Returns the hash Spore uses for names, which is the FNV-1 of the lowercase name
+        /// </summary>
+        uint32_t Fnv(const char* data, size_t size);
+
+        /// <summary>
+        ///     Hashes names the same way as Fnv(), multiple names are hashed at once
+        /// </summary>
+        void Fnv(const std::vector<std::string>& names, std::vector<uint32_t>& hashes);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_HASH_HPP
@@ -0,0 +1,401 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "LoadManifest.hpp"
+#include "PeFile.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif // _WIN32
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define LOADMANIFEST_MAGIC   "SMLM"
+#define LOADMANIFEST_VERSION 2
+
+//
+// Local Structures
+//
+
+// the manifest consists of the header followed by every
+// file, which is a manifest_file_header followed by its name
+struct manifest_header
+{
+    char     Magic[4];
+    uint32_t Version;
+    uint32_t FileCount;
+    uint32_t Reserved;
+    int64_t  ModifiedTime;
+};
+
+struct manifest_file_header
+{
+    uint64_t Size;
+    int64_t  ModifiedTime;
+    uint32_t NameSize;
+    uint32_t Reserved;
+};
+
+//
+// Helper Functions
+//
+
+static bool get_modified_time(const std::filesystem::path& path, int64_t& modifiedTime)
+{
+    // the epoch of std::filesystem::file_time_type differs per
+    // compiler, the manager and the loader can be built with
+    // different ones, so the time is stored in microseconds
+    // since the unix epoch, which is retrieved from the system
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA fileAttributeData;
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &fileAttributeData))
+    {
+        return false;
+    }
+
+    // FILETIME counts 100 nanoseconds since 1601-01-01
+    const int64_t fileTime = (static_cast<int64_t>(fileAttributeData.ftLastWriteTime.dwHighDateTime) << 32) |
+                                fileAttributeData.ftLastWriteTime.dwLowDateTime;
+    modifiedTime = (fileTime - 116444736000000000LL) / 10;
+#else
+    struct stat fileStat;
+    if (stat(path.c_str(), &fileStat) != 0)
+    {
+        return false;
+    }
+
+    modifiedTime = static_cast<int64_t>(fileStat.st_mtim.tv_sec) * 1000000 + fileStat.st_mtim.tv_nsec / 1000;
+#endif // _WIN32
+    return true;
+}
+
+static bool get_file_stat(const std::filesystem::path& path, uint64_t& size, int64_t& modifiedTime)
+{
+    std::error_code error;
+
+    size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return false;
+    }
+
+    return get_modified_time(path, modifiedTime);
+}
+
+template <typename T>
+static bool less_lowercase(const std::basic_string<T>& a, const std::basic_string<T>& b)
+{
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](T x, T y)
+    {
+        return (x >= 'A' && x <= 'Z' ? x + 32 : x) < (y >= 'A' && y <= 'Z' ? y + 32 : y);
+    });
+}
+
+static bool is_dll_file_name(const std::filesystem::path& fileName)
+{
+    // Windows compares file names case insensitively
+    const auto extension = fileName.extension().native();
+    const char dllExtension[] = ".dll";
+    return std::equal(extension.begin(), extension.end(), dllExtension, dllExtension + std::strlen(dllExtension), [](auto x, char y)
+    {
+        return (x >= 'A' && x <= 'Z' ? x + 32 : x) == y;
+    });
+}
+
+static bool is_file_name(const std::filesystem::path& fileName)
+{
+    return !fileName.empty() && fileName == fileName.filename() &&
+        fileName != "." && fileName != "..";
+}
+
+static void sort_by_imports(const std::filesystem::path& modLibsPath, std::vector<LoadManifest::ManifestFile>& files)
+{
+    std::vector<std::vector<size_t>> dependencies(files.size());
+    std::vector<LoadManifest::ManifestFile> sortedFiles;
+    std::vector<bool> isSorted(files.size(), false);
+
+    // files which aren't PE files or can't be
+    // read don't depend on any of the others
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        PeFile::PeInfo peInfo;
+        if (!PeFile::ReadFile(modLibsPath / files[i].FileName, peInfo))
+        {
+            continue;
+        }
+
+        for (const auto& importedDll : peInfo.ImportedDlls)
+        {
+            for (size_t j = 0; j < files.size(); j++)
+            {
+                if (j != i && PeFile::IsSameDllName(importedDll.Name, files[j].FileName.u8string()))
+                {
+                    dependencies[i].push_back(j);
+                }
+            }
+        }
+    }
+
+    // a DLL is loaded after the DLLs it imports from, otherwise
+    // the order stays the same, when the DLLs import from each
+    // other, the first one is loaded and Windows resolves the rest
+    sortedFiles.reserve(files.size());
+    while (sortedFiles.size() < files.size())
+    {
+        size_t next = files.size();
+        for (size_t i = 0; i < files.size() && next == files.size(); i++)
+        {
+            if (!isSorted[i] && std::all_of(dependencies[i].begin(), dependencies[i].end(), [&](size_t j) { return isSorted[j]; }))
+            {
+                next = i;
+            }
+        }
+
+        if (next == files.size())
+        {
+            next = static_cast<size_t>(std::find(isSorted.begin(), isSorted.end(), false) - isSorted.begin());
+        }
+
+        isSorted[next] = true;
+        sortedFiles.push_back(files[next]);
+    }
+
+    files = std::move(sortedFiles);
+}
+
+//
+// Exported Functions
+//
+
+std::filesystem::path LoadManifest::GetManifestPath(const std::filesystem::path& modLibsPath)
+{
+    std::filesystem::path manifestPath = modLibsPath;
+
+    // the manifest is stored next to the directory, storing it
+    // inside of it would change the directory when writing it
+    if (!manifestPath.has_filename())
+    {
+        manifestPath = manifestPath.parent_path();
+    }
+    manifestPath += ".manifest";
+    return manifestPath;
+}
+
+bool LoadManifest::Create(const std::filesystem::path& modLibsPath, Manifest& manifest)
+{
+    std::error_code error;
+
+    manifest.Files.clear();
+
+    // the time is retrieved first, so when the directory
+    // changes while listing it, the manifest isn't current
+    if (!get_modified_time(modLibsPath, manifest.ModifiedTime))
+    {
+        return false;
+    }
+
+    for (auto iter = std::filesystem::directory_iterator(modLibsPath, error);
+         !error && iter != std::filesystem::directory_iterator(); iter.increment(error))
+    {
+        // skip non-files & non-dlls, this also skips the
+        // directory SporeModManager moves disabled mods into
+        const std::filesystem::path& path = iter->path();
+        if (!iter->is_regular_file(error) || !is_dll_file_name(path))
+        {
+            continue;
+        }
+
+        ManifestFile file;
+        file.FileName = path.filename();
+        if (!get_file_stat(path, file.Size, file.ModifiedTime))
+        {
+            return false;
+        }
+        manifest.Files.push_back(file);
+    }
+
+    if (error)
+    {
+        return false;
+    }
+
+    // the order of the directory depends on the file system,
+    // so sort the DLLs like Windows lists them instead
+    std::sort(manifest.Files.begin(), manifest.Files.end(), [](const ManifestFile& a, const ManifestFile& b)
+    {
+        return less_lowercase(a.FileName.native(), b.FileName.native());
+    });
+
+    sort_by_imports(modLibsPath, manifest.Files);
+    return true;
+}
+
+bool LoadManifest::Parse(const char* data, size_t size, Manifest& manifest)
+{
+    manifest_header header;
+    manifest_file_header fileHeader;
+    size_t offset = sizeof(header);
+
+    manifest.Files.clear();
+
+    if (size < sizeof(header))
+    {
+        return false;
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.Magic, LOADMANIFEST_MAGIC, sizeof(header.Magic)) != 0 ||
+        header.Version != LOADMANIFEST_VERSION ||
+        header.FileCount > (size - offset) / sizeof(fileHeader))
+    {
+        return false;
+    }
+
+    manifest.ModifiedTime = header.ModifiedTime;
+    manifest.Files.reserve(header.FileCount);
+
+    for (uint32_t i = 0; i < header.FileCount; i++)
+    {
+        if (size - offset < sizeof(fileHeader))
+        {
+            return false;
+        }
+        std::memcpy(&fileHeader, data + offset, sizeof(fileHeader));
+        offset += sizeof(fileHeader);
+
+        if (size - offset < fileHeader.NameSize)
+        {
+            return false;
+        }
+
+        // names are stored as UTF-8, a name which isn't only a file name
+        // would make the loader load a DLL outside of the directory
+        ManifestFile file;
+        file.FileName     = std::filesystem::u8path(data + offset, data + offset + fileHeader.NameSize);
+        file.Size         = fileHeader.Size;
+        file.ModifiedTime = fileHeader.ModifiedTime;
+        offset += fileHeader.NameSize;
+
+        if (!is_file_name(file.FileName) || !is_dll_file_name(file.FileName))
+        {
+            return false;
+        }
+        manifest.Files.push_back(file);
+    }
+
+    return offset == size;
+}
+
+bool LoadManifest::Read(const std::filesystem::path& modLibsPath, Manifest& manifest)
+{
+    const std::filesystem::path manifestPath = GetManifestPath(modLibsPath);
+    std::vector<char> data;
+    std::error_code error;
+
+    uintmax_t size = std::filesystem::file_size(manifestPath, error);
+    if (error)
+    {
+        return false;
+    }
+
+    // the manifest is read at once
+    data.resize(size);
+    std::ifstream manifestStream(manifestPath, std::ios::binary);
+    if (!manifestStream.is_open() || !manifestStream.read(data.data(), data.size()))
+    {
+        return false;
+    }
+
+    return Parse(data.data(), data.size(), manifest);
+}
+
+bool LoadManifest::Write(const std::filesystem::path& modLibsPath, const Manifest& manifest)
+{
+    const std::filesystem::path manifestPath = GetManifestPath(modLibsPath);
+    std::filesystem::path tempManifestPath = manifestPath;
+    std::string data;
+    manifest_header header;
+    manifest_file_header fileHeader;
+    std::error_code error;
+
+    std::memcpy(header.Magic, LOADMANIFEST_MAGIC, sizeof(header.Magic));
+    header.Version      = LOADMANIFEST_VERSION;
+    header.FileCount    = static_cast<uint32_t>(manifest.Files.size());
+    header.Reserved     = 0;
+    header.ModifiedTime = manifest.ModifiedTime;
+    data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& file : manifest.Files)
+    {
+        const std::string fileName = file.FileName.u8string();
+
+        fileHeader.Size         = file.Size;
+        fileHeader.ModifiedTime = file.ModifiedTime;
+        fileHeader.NameSize     = static_cast<uint32_t>(fileName.size());
+        fileHeader.Reserved     = 0;
+        data.append(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+        data.append(fileName);
+    }
+
+    tempManifestPath += ".tmp";
+
+    {
+        std::ofstream manifestStream(tempManifestPath, std::ios::binary | std::ios::trunc);
+        if (!manifestStream.is_open())
+        {
+            return false;
+        }
+
+        manifestStream.write(data.data(), data.size());
+        manifestStream.flush();
+        if (manifestStream.fail())
+        {
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempManifestPath, manifestPath, error);
+    return !error;
+}
+
+bool LoadManifest::IsCurrent(const std::filesystem::path& modLibsPath, const Manifest& manifest)
+{
+    int64_t  modifiedTime;
+    uint64_t fileSize;
+    int64_t  fileModifiedTime;
+
+    // adding, removing or renaming a DLL changes the directory,
+    // replacing one changes the DLL itself
+    if (!get_modified_time(modLibsPath, modifiedTime) || modifiedTime != manifest.ModifiedTime)
+    {
+        return false;
+    }
+
+    for (const auto& file : manifest.Files)
+    {
+        if (!get_file_stat(modLibsPath / file.FileName, fileSize, fileModifiedTime) ||
+            fileSize != file.Size || fileModifiedTime != file.ModifiedTime)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,72 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_LOADMANIFEST_HPP
+#define SPOREMODMANAGERHELPERS_LOADMANIFEST_HPP
+
+#include <filesystem>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// the load manifest is shared with SporeModLoader, so it may
+// only depend on the standard library and the system headers
+namespace SporeModManagerHelpers
+{
+    namespace LoadManifest
+    {
+        struct ManifestFile
+        {
+            std::filesystem::path FileName;
+            uint64_t Size         = 0;
+            // microseconds since the unix epoch
+            int64_t  ModifiedTime = 0;
+        };
+
+        struct Manifest
+        {
+            int64_t ModifiedTime = 0;
+            std::vector<ManifestFile> Files;
+        };
+
+        /// <summary>
+        ///     Returns the path of the load manifest of the ModLibs directory at path
+        /// </summary>
+        std::filesystem::path GetManifestPath(const std::filesystem::path& modLibsPath);
+
+        /// <summary>
+        ///     Creates a load manifest by listing the DLLs in the ModLibs directory at path in load order,
+        ///     DLLs are loaded after the DLLs they import from
+        /// </summary>
+        bool Create(const std::filesystem::path& modLibsPath, Manifest& manifest);
+
+        /// <summary>
+        ///     Parses a load manifest, file names which aren't in the ModLibs directory are rejected
+        /// </summary>
+        bool Parse(const char* data, size_t size, Manifest& manifest);
+
+        /// <summary>
+        ///     Reads the load manifest of the ModLibs directory at path
+        /// </summary>
+        bool Read(const std::filesystem::path& modLibsPath, Manifest& manifest);
+
+        /// <summary>
+        ///     Writes the load manifest of the ModLibs directory at path
+        /// </summary>
+        bool Write(const std::filesystem::path& modLibsPath, const Manifest& manifest);
+
+        /// <summary>
+        ///     Returns whether the load manifest still matches the ModLibs directory at path,
+        ///     when it doesn't, it has to be created again
+        /// </summary>
+        bool IsCurrent(const std::filesystem::path& modLibsPath, const Manifest& manifest);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_LOADMANIFEST_HPP
@@ -0,0 +1,206 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "LoaderProfile.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <string>
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define LOADERPROFILE_MAGIC   "SMLP"
+#define LOADERPROFILE_VERSION 1
+
+//
+// Local Structures
+//
+
+// the profile consists of the header followed by every
+// event, which is an event_header followed by its file name
+struct profile_header
+{
+    char     Magic[4];
+    uint32_t Version;
+    uint32_t EventCount;
+    uint32_t Reserved;
+};
+
+struct event_header
+{
+    uint32_t Type;
+    uint32_t Result;
+    int64_t  StartTime;
+    int64_t  Duration;
+    uint32_t FileNameSize;
+    uint32_t Reserved;
+};
+
+//
+// Local Variables
+//
+
+// the events are added while the game is starting,
+// so they're only kept in memory until they're written
+static std::string l_Events;
+static uint32_t    l_EventCount = 0;
+
+//
+// Exported Functions
+//
+
+void LoaderProfile::AddEvent(EventType type, std::chrono::steady_clock::time_point startTime, bool result,
+                             const std::filesystem::path& fileName)
+{
+    const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+    const std::string fileNameString = fileName.u8string();
+    event_header header;
+
+    if (l_Events.empty())
+    {
+        l_Events.reserve(4096);
+    }
+
+    header.Type         = static_cast<uint32_t>(type);
+    header.Result       = result ? 1 : 0;
+    header.StartTime    = std::chrono::duration_cast<std::chrono::nanoseconds>(startTime.time_since_epoch()).count();
+    header.Duration     = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    header.FileNameSize = static_cast<uint32_t>(fileNameString.size());
+    header.Reserved     = 0;
+
+    l_Events.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    l_Events.append(fileNameString);
+    l_EventCount++;
+}
+
+bool LoaderProfile::Write(const std::filesystem::path& path)
+{
+    profile_header header;
+
+    std::memcpy(header.Magic, LOADERPROFILE_MAGIC, sizeof(header.Magic));
+    header.Version    = LOADERPROFILE_VERSION;
+    header.EventCount = l_EventCount;
+    header.Reserved   = 0;
+
+    std::ofstream profileStream(path, std::ios::binary | std::ios::trunc);
+    if (!profileStream.is_open())
+    {
+        return false;
+    }
+
+    profileStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    profileStream.write(l_Events.data(), l_Events.size());
+    profileStream.flush();
+    return !profileStream.fail();
+}
+
+bool LoaderProfile::Parse(const char* data, size_t size, std::vector<Event>& events)
+{
+    profile_header header;
+    event_header eventHeader;
+    size_t offset = sizeof(header);
+
+    events.clear();
+
+    if (size < sizeof(header))
+    {
+        return false;
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.Magic, LOADERPROFILE_MAGIC, sizeof(header.Magic)) != 0 ||
+        header.Version != LOADERPROFILE_VERSION ||
+        header.EventCount > (size - offset) / sizeof(eventHeader))
+    {
+        return false;
+    }
+
+    events.reserve(header.EventCount);
+
+    for (uint32_t i = 0; i < header.EventCount; i++)
+    {
+        if (size - offset < sizeof(eventHeader))
+        {
+            return false;
+        }
+        std::memcpy(&eventHeader, data + offset, sizeof(eventHeader));
+        offset += sizeof(eventHeader);
+
+        if (size - offset < eventHeader.FileNameSize ||
+            eventHeader.Type >= static_cast<uint32_t>(EventType::Count) ||
+            eventHeader.Duration < 0)
+        {
+            return false;
+        }
+
+        Event event;
+        event.Type      = static_cast<EventType>(eventHeader.Type);
+        event.Result    = eventHeader.Result != 0;
+        event.StartTime = eventHeader.StartTime;
+        event.Duration  = eventHeader.Duration;
+        event.FileName  = std::filesystem::u8path(data + offset, data + offset + eventHeader.FileNameSize);
+        offset += eventHeader.FileNameSize;
+
+        events.push_back(event);
+    }
+
+    return offset == size;
+}
+
+bool LoaderProfile::Read(const std::filesystem::path& path, std::vector<Event>& events)
+{
+    std::vector<char> data;
+    std::error_code error;
+
+    uintmax_t size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return false;
+    }
+
+    data.resize(size);
+    std::ifstream profileStream(path, std::ios::binary);
+    if (!profileStream.is_open() || !profileStream.read(data.data(), data.size()))
+    {
+        return false;
+    }
+
+    return Parse(data.data(), data.size(), events);
+}
+
+const char* LoaderProfile::GetEventTypeName(EventType type)
+{
+    switch (type)
+    {
+    case EventType::Initialize:
+        return "Initialize";
+    case EventType::AttachAllocatorDetours:
+        return "AttachAllocatorDetours";
+    case EventType::InitializeAllocator:
+        return "InitializeAllocator";
+    case EventType::LoadCoreLibs:
+        return "LoadCoreLibs";
+    case EventType::LoadModLibs:
+        return "LoadModLibs";
+    case EventType::LoadDll:
+        return "LoadDll";
+    case EventType::UnloadModLibs:
+        return "UnloadModLibs";
+    case EventType::UnloadCoreLibs:
+        return "UnloadCoreLibs";
+    case EventType::UnloadDll:
+        return "UnloadDll";
+    default:
+        return "Unknown";
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_LOADERPROFILE_HPP
+#define SPOREMODMANAGERHELPERS_LOADERPROFILE_HPP
+
+#include <filesystem>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// the loader profile is shared with SporeModLoader,
+// so it may only depend on the standard library
+namespace SporeModManagerHelpers
+{
+    namespace LoaderProfile
+    {
+        enum class EventType : uint32_t
+        {
+            Initialize = 0,
+            AttachAllocatorDetours,
+            InitializeAllocator,
+            LoadCoreLibs,
+            LoadModLibs,
+            LoadDll,
+            UnloadModLibs,
+            UnloadCoreLibs,
+            UnloadDll,
+            Count
+        };
+
+        struct Event
+        {
+            EventType Type      = EventType::Initialize;
+            bool      Result    = false;
+            int64_t   StartTime = 0;
+            int64_t   Duration  = 0;
+            std::filesystem::path FileName;
+        };
+
+        /// <summary>
+        ///     Adds an event which started at startTime and ends now to the profile,
+        ///     fileName is the DLL of LoadDll and UnloadDll events
+        /// </summary>
+        void AddEvent(EventType type, std::chrono::steady_clock::time_point startTime, bool result,
+                      const std::filesystem::path& fileName = std::filesystem::path());
+
+        /// <summary>
+        ///     Writes the events of the profile to path
+        /// </summary>
+        bool Write(const std::filesystem::path& path);
+
+        /// <summary>
+        ///     Parses a profile, the times of the events are in nanoseconds
+        /// </summary>
+        bool Parse(const char* data, size_t size, std::vector<Event>& events);
+
+        /// <summary>
+        ///     Reads the profile at path
+        /// </summary>
+        bool Read(const std::filesystem::path& path, std::vector<Event>& events);
+
+        /// <summary>
+        ///     Returns the name of the event type
+        /// </summary>
+        const char* GetEventTypeName(EventType type);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_LOADERPROFILE_HPP
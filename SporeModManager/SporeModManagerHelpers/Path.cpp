@@ -31,6 +31,7 @@ static std::filesystem::path l_CoreLibsPath;
 static std::filesystem::path l_ModLibsPath;
 static std::filesystem::path l_GalacticAdventuresDataPath;
 static std::filesystem::path l_CoreSporeDataPath;
+static std::filesystem::path l_ConfigFilePath;
 
 //
 // Exported Functions
@@ -228,32 +229,36 @@ std::filesystem::path Path::GetFullInstallPath(SporeMod::InstallLocation install
     return Path::Combine({ installPath, path });
 }
 
+void Path::SetConfigFilePath(const std::filesystem::path& path)
+{
+    l_ConfigFilePath = path;
+}
+
 std::filesystem::path Path::GetConfigFilePath(void)
 {
-    static std::filesystem::path cachedConfigFilePath;
-    if (!cachedConfigFilePath.empty())
+    if (!l_ConfigFilePath.empty())
     {
-        return cachedConfigFilePath;
+        return l_ConfigFilePath;
     }
 
 #ifdef _WIN32
     wchar_t envBuffer[MAX_PATH] = {0};
     if (GetEnvironmentVariableW(L"SPOREMODMANAGER_CONFIGFILE", envBuffer, MAX_PATH) != 0)
     {
-        cachedConfigFilePath = envBuffer;
+        l_ConfigFilePath = envBuffer;
     }
 #else
     const char* configFile = std::getenv("SPOREMODMANAGER_CONFIGFILE");
     if (configFile != nullptr)
     {
-        cachedConfigFilePath = configFile;
+        l_ConfigFilePath = configFile;
     }
 #endif
-    if (cachedConfigFilePath.empty())
+    if (l_ConfigFilePath.empty())
     {
-        cachedConfigFilePath = Path::Combine({ Path::GetCurrentExecutablePath(), "SporeModManager.xml" });
+        l_ConfigFilePath = Path::Combine({ Path::GetCurrentExecutablePath(), "SporeModManager.xml" });
     }
-    return cachedConfigFilePath;
+    return l_ConfigFilePath;
 }
 
 std::filesystem::path Path::GetCoreLibsPath(void)
@@ -261,3 +266,8 @@ std::filesystem::path Path::GetCoreLibsPath(void)
     return l_CoreLibsPath;
 }
 
+std::filesystem::path Path::GetModLibsPath(void)
+{
+    return l_ModLibsPath;
+}
+
@@ -49,6 +49,11 @@ namespace SporeModManagerHelpers
         /// </summary>
         std::filesystem::path GetCurrentExecutablePath(void);
 
+        /// <summary>
+        ///     Sets the config file path for current session
+        /// </summary>
+        void SetConfigFilePath(const std::filesystem::path& path);
+
         /// <summary>
         ///     Returns full path to the config file
         /// </summary>
@@ -58,6 +63,11 @@ namespace SporeModManagerHelpers
         ///     Returns the CoreLibs path
         /// </summary>
         std::filesystem::path GetCoreLibsPath(void);
+
+        /// <summary>
+        ///     Returns the ModLibs path
+        /// </summary>
+        std::filesystem::path GetModLibsPath(void);
     }
 }
 
@@ -0,0 +1,366 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "PeFile.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define PE_DOS_HEADER_SIZE        64
+#define PE_COFF_HEADER_SIZE       20
+#define PE_SECTION_HEADER_SIZE    40
+#define PE_IMPORT_DESCRIPTOR_SIZE 20
+#define PE_EXPORT_DIRECTORY_SIZE  40
+#define PE_MAGIC_PE32             0x10b
+#define PE_MAGIC_PE32_PLUS        0x20b
+#define PE_DIRECTORY_EXPORT       0
+#define PE_DIRECTORY_IMPORT       1
+#define PE_MAX_NAME_SIZE          4096
+// limits what a corrupt PE file can make us read
+#define PE_MAX_ENTRIES            65536
+
+//
+// Local Structures
+//
+
+struct pe_section
+{
+    uint32_t VirtualAddress;
+    uint32_t VirtualSize;
+    uint32_t RawDataOffset;
+    uint32_t RawDataSize;
+};
+
+struct pe_file
+{
+    const char* Data;
+    size_t      Size;
+    bool        IsPe32Plus;
+    std::vector<pe_section> Sections;
+};
+
+//
+// Helper Functions
+//
+
+template <typename T>
+static bool read_value(const char* data, size_t size, uint64_t offset, T& value)
+{
+    if (offset > size || size - offset < sizeof(T))
+    {
+        return false;
+    }
+    std::memcpy(&value, data + offset, sizeof(T));
+    return true;
+}
+
+static bool rva_to_offset(const pe_file& peFile, uint32_t rva, uint64_t& offset)
+{
+    for (const auto& section : peFile.Sections)
+    {
+        const uint32_t sectionSize = std::max(section.VirtualSize, section.RawDataSize);
+        if (rva >= section.VirtualAddress && rva - section.VirtualAddress < sectionSize)
+        {
+            // the part of the section which isn't in the file is zeroed
+            // in memory, which the data we're looking for never is
+            if (rva - section.VirtualAddress >= section.RawDataSize)
+            {
+                return false;
+            }
+            offset = static_cast<uint64_t>(section.RawDataOffset) + (rva - section.VirtualAddress);
+            return offset < peFile.Size;
+        }
+    }
+
+    return false;
+}
+
+template <typename T>
+static bool read_rva_value(const pe_file& peFile, uint32_t rva, T& value)
+{
+    uint64_t offset;
+    return rva_to_offset(peFile, rva, offset) &&
+            read_value(peFile.Data, peFile.Size, offset, value);
+}
+
+static bool read_rva_string(const pe_file& peFile, uint32_t rva, std::string& string)
+{
+    uint64_t offset;
+
+    if (!rva_to_offset(peFile, rva, offset))
+    {
+        return false;
+    }
+
+    const size_t maxSize = std::min<size_t>(peFile.Size - offset, PE_MAX_NAME_SIZE);
+    const char*  start   = peFile.Data + offset;
+    const char*  end     = static_cast<const char*>(std::memchr(start, '\0', maxSize));
+    if (end == nullptr || end == start)
+    {
+        return false;
+    }
+
+    string.assign(start, end);
+    return true;
+}
+
+static bool read_imports(const pe_file& peFile, uint32_t rva, PeFile::PeInfo& peInfo)
+{
+    const uint64_t ordinalFlag = peFile.IsPe32Plus ? 0x8000000000000000ULL : 0x80000000ULL;
+    const uint32_t thunkSize   = peFile.IsPe32Plus ? 8 : 4;
+    uint32_t nameRva;
+    uint32_t lookupRva;
+    uint32_t addressRva;
+
+    for (uint32_t i = 0; i < PE_MAX_ENTRIES; i++)
+    {
+        const uint32_t descriptorRva = rva + (i * PE_IMPORT_DESCRIPTOR_SIZE);
+        if (!read_rva_value(peFile, descriptorRva, lookupRva) ||
+            !read_rva_value(peFile, descriptorRva + 12, nameRva) ||
+            !read_rva_value(peFile, descriptorRva + 16, addressRva))
+        {
+            return false;
+        }
+
+        // the table ends with a zeroed descriptor
+        if (nameRva == 0 && addressRva == 0)
+        {
+            return true;
+        }
+
+        PeFile::ImportedDll importedDll;
+        if (!read_rva_string(peFile, nameRva, importedDll.Name))
+        {
+            return false;
+        }
+
+        // old linkers only fill in the address table,
+        // which is the same as the lookup table on disk
+        const uint32_t thunkRva = lookupRva != 0 ? lookupRva : addressRva;
+        for (uint32_t j = 0; j < PE_MAX_ENTRIES; j++)
+        {
+            uint64_t thunk;
+            if (peFile.IsPe32Plus)
+            {
+                if (!read_rva_value(peFile, thunkRva + (j * thunkSize), thunk))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                uint32_t thunk32;
+                if (!read_rva_value(peFile, thunkRva + (j * thunkSize), thunk32))
+                {
+                    return false;
+                }
+                thunk = thunk32;
+            }
+
+            if (thunk == 0)
+            {
+                break;
+            }
+
+            if (thunk & ordinalFlag)
+            {
+                importedDll.FunctionOrdinals.push_back(static_cast<uint32_t>(thunk & 0xFFFF));
+            }
+            else
+            {
+                // skip the hint in front of the name
+                std::string functionName;
+                if (!read_rva_string(peFile, static_cast<uint32_t>(thunk & 0x7FFFFFFF) + 2, functionName))
+                {
+                    return false;
+                }
+                importedDll.FunctionNames.push_back(functionName);
+            }
+        }
+
+        peInfo.ImportedDlls.push_back(importedDll);
+    }
+
+    return false;
+}
+
+static bool read_exports(const pe_file& peFile, uint32_t rva, PeFile::PeInfo& peInfo)
+{
+    uint32_t ordinalBase;
+    uint32_t functionCount;
+    uint32_t nameCount;
+    uint32_t functionsRva;
+    uint32_t namesRva;
+    uint32_t functionRva;
+    uint32_t nameRva;
+
+    if (!read_rva_value(peFile, rva + 16, ordinalBase) ||
+        !read_rva_value(peFile, rva + 20, functionCount) ||
+        !read_rva_value(peFile, rva + 24, nameCount) ||
+        !read_rva_value(peFile, rva + 28, functionsRva) ||
+        !read_rva_value(peFile, rva + 32, namesRva) ||
+        functionCount > PE_MAX_ENTRIES || nameCount > PE_MAX_ENTRIES)
+    {
+        return false;
+    }
+
+    // unused ordinals have no address
+    for (uint32_t i = 0; i < functionCount; i++)
+    {
+        if (!read_rva_value(peFile, functionsRva + (i * 4), functionRva))
+        {
+            return false;
+        }
+        if (functionRva != 0)
+        {
+            peInfo.ExportedOrdinals.push_back(ordinalBase + i);
+        }
+    }
+
+    for (uint32_t i = 0; i < nameCount; i++)
+    {
+        std::string name;
+        if (!read_rva_value(peFile, namesRva + (i * 4), nameRva) ||
+            !read_rva_string(peFile, nameRva, name))
+        {
+            return false;
+        }
+        peInfo.ExportedNames.push_back(name);
+    }
+
+    std::sort(peInfo.ExportedNames.begin(), peInfo.ExportedNames.end());
+    return true;
+}
+
+//
+// Exported Functions
+//
+
+bool PeFile::Parse(const char* data, size_t size, PeInfo& peInfo)
+{
+    pe_file  peFile = { data, size, false, {} };
+    uint32_t peOffset;
+    uint16_t sectionCount;
+    uint16_t optionalHeaderSize;
+    uint16_t magic;
+    uint32_t directoryCount;
+    uint32_t directoryRvas[2] = { 0, 0 };
+
+    peInfo = PeInfo();
+
+    if (size < PE_DOS_HEADER_SIZE || std::memcmp(data, "MZ", 2) != 0 ||
+        !read_value(data, size, 0x3C, peOffset) ||
+        peOffset > size || size - peOffset < 4 + PE_COFF_HEADER_SIZE ||
+        std::memcmp(data + peOffset, "PE\0\0", 4) != 0)
+    {
+        return false;
+    }
+
+    const uint64_t coffOffset     = static_cast<uint64_t>(peOffset) + 4;
+    const uint64_t optionalOffset = coffOffset + PE_COFF_HEADER_SIZE;
+    if (!read_value(data, size, coffOffset + 2, sectionCount) ||
+        !read_value(data, size, coffOffset + 16, optionalHeaderSize) ||
+        !read_value(data, size, optionalOffset, magic) ||
+        (magic != PE_MAGIC_PE32 && magic != PE_MAGIC_PE32_PLUS))
+    {
+        return false;
+    }
+
+    // the data directories follow the fields which differ
+    // in size between 32-bit and 64-bit PE files
+    peFile.IsPe32Plus = magic == PE_MAGIC_PE32_PLUS;
+    const uint64_t directoryCountOffset = optionalOffset + (peFile.IsPe32Plus ? 108 : 92);
+    if (!read_value(data, size, directoryCountOffset, directoryCount) ||
+        directoryCountOffset + 4 + (static_cast<uint64_t>(std::min<uint32_t>(directoryCount, 16)) * 8) > optionalOffset + optionalHeaderSize)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < 2 && i < directoryCount; i++)
+    {
+        if (!read_value(data, size, directoryCountOffset + 4 + (i * 8), directoryRvas[i]))
+        {
+            return false;
+        }
+    }
+
+    const uint64_t sectionsOffset = optionalOffset + optionalHeaderSize;
+    for (uint16_t i = 0; i < sectionCount; i++)
+    {
+        const uint64_t sectionOffset = sectionsOffset + (static_cast<uint64_t>(i) * PE_SECTION_HEADER_SIZE);
+        pe_section section;
+        if (!read_value(data, size, sectionOffset + 8, section.VirtualSize) ||
+            !read_value(data, size, sectionOffset + 12, section.VirtualAddress) ||
+            !read_value(data, size, sectionOffset + 16, section.RawDataSize) ||
+            !read_value(data, size, sectionOffset + 20, section.RawDataOffset))
+        {
+            return false;
+        }
+        peFile.Sections.push_back(section);
+    }
+
+    if (directoryRvas[PE_DIRECTORY_IMPORT] != 0 && !read_imports(peFile, directoryRvas[PE_DIRECTORY_IMPORT], peInfo))
+    {
+        return false;
+    }
+
+    if (directoryRvas[PE_DIRECTORY_EXPORT] != 0 && !read_exports(peFile, directoryRvas[PE_DIRECTORY_EXPORT], peInfo))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool PeFile::ReadFile(const std::filesystem::path& path, PeInfo& peInfo)
+{
+    std::vector<char> data;
+    std::error_code error;
+
+    uintmax_t size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return false;
+    }
+
+    // the tables can be anywhere in the file
+    data.resize(size);
+    std::ifstream peStream(path, std::ios::binary);
+    if (!peStream.is_open() || !peStream.read(data.data(), data.size()))
+    {
+        return false;
+    }
+
+    return Parse(data.data(), data.size(), peInfo);
+}
+
+bool PeFile::ExportsName(const PeInfo& peInfo, const std::string& name)
+{
+    return std::binary_search(peInfo.ExportedNames.begin(), peInfo.ExportedNames.end(), name);
+}
+
+bool PeFile::ExportsOrdinal(const PeInfo& peInfo, uint32_t ordinal)
+{
+    return std::find(peInfo.ExportedOrdinals.begin(), peInfo.ExportedOrdinals.end(), ordinal) != peInfo.ExportedOrdinals.end();
+}
+
+bool PeFile::IsSameDllName(const std::string& a, const std::string& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+    {
+        return (x >= 'A' && x <= 'Z' ? x + 32 : x) == (y >= 'A' && y <= 'Z' ? y + 32 : y);
+    });
+}
@@ -0,0 +1,67 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_PEFILE_HPP
+#define SPOREMODMANAGERHELPERS_PEFILE_HPP
+
+#include <filesystem>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// the PE parser is shared with SporeModLoader,
+// so it may only depend on the standard library
+namespace SporeModManagerHelpers
+{
+    namespace PeFile
+    {
+        struct ImportedDll
+        {
+            std::string Name;
+            std::vector<std::string> FunctionNames;
+            std::vector<uint32_t>    FunctionOrdinals;
+        };
+
+        struct PeInfo
+        {
+            std::vector<ImportedDll> ImportedDlls;
+            // sorted, so they can be searched
+            std::vector<std::string> ExportedNames;
+            std::vector<uint32_t>    ExportedOrdinals;
+        };
+
+        /// <summary>
+        ///     Parses the imports and exports of a PE file
+        /// </summary>
+        bool Parse(const char* data, size_t size, PeInfo& peInfo);
+
+        /// <summary>
+        ///     Reads the imports and exports of the PE file at path
+        /// </summary>
+        bool ReadFile(const std::filesystem::path& path, PeInfo& peInfo);
+
+        /// <summary>
+        ///     Returns whether peInfo exports the function with the given name
+        /// </summary>
+        bool ExportsName(const PeInfo& peInfo, const std::string& name);
+
+        /// <summary>
+        ///     Returns whether peInfo exports the function with the given ordinal
+        /// </summary>
+        bool ExportsOrdinal(const PeInfo& peInfo, uint32_t ordinal);
+
+        /// <summary>
+        ///     Returns whether the DLL names are the same, which Windows compares case insensitively
+        /// </summary>
+        bool IsSameDllName(const std::string& a, const std::string& b);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_PEFILE_HPP
@@ -0,0 +1,175 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "RefPack.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define REFPACK_MAGIC                0xFB
+#define REFPACK_LARGE_SIZE_FLAG      0x80
+#define REFPACK_COMPRESSED_SIZE_FLAG 0x01
+
+//
+// Helper Functions
+//
+
+static bool parse_header(const unsigned char* data, size_t size, size_t& headerSize, size_t& decompressedSize)
+{
+    size_t sizeLength;
+
+    // the flags are followed by the magic, the compressed
+    // size when it's present and the decompressed size,
+    // which are 3 bytes or 4 bytes when the large flag is set
+    if (size < 2 || data[1] != REFPACK_MAGIC)
+    {
+        return false;
+    }
+
+    sizeLength = (data[0] & REFPACK_LARGE_SIZE_FLAG) ? 4 : 3;
+    headerSize = 2 + sizeLength;
+    if (data[0] & REFPACK_COMPRESSED_SIZE_FLAG)
+    {
+        headerSize += sizeLength;
+    }
+
+    if (size < headerSize)
+    {
+        return false;
+    }
+
+    decompressedSize = 0;
+    for (size_t i = headerSize - sizeLength; i < headerSize; i++)
+    {
+        decompressedSize = (decompressedSize << 8) | data[i];
+    }
+
+    return true;
+}
+
+//
+// Exported Functions
+//
+
+bool RefPack::GetDecompressedSize(const char* data, size_t size, size_t& decompressedSize)
+{
+    size_t headerSize;
+    return parse_header(reinterpret_cast<const unsigned char*>(data), size, headerSize, decompressedSize);
+}
+
+bool RefPack::Decompress(const char* data, size_t size, char* output, size_t outputSize)
+{
+    const unsigned char* input    = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* inputEnd = input + size;
+    unsigned char* outputStart    = reinterpret_cast<unsigned char*>(output);
+    unsigned char* outputIter     = outputStart;
+    unsigned char* outputEnd      = outputStart + outputSize;
+    size_t headerSize;
+    size_t decompressedSize;
+    size_t literalSize;
+    size_t copySize;
+    size_t copyOffset;
+    unsigned char control;
+
+    if (!parse_header(input, size, headerSize, decompressedSize) || decompressedSize != outputSize)
+    {
+        return false;
+    }
+    input += headerSize;
+
+    while (input < inputEnd)
+    {
+        // every command copies literal bytes from the input,
+        // followed by bytes which have already been written
+        control = input[0];
+        if (control < 0x80)
+        {
+            if (inputEnd - input < 2)
+            {
+                return false;
+            }
+            literalSize = control & 0x03;
+            copySize    = ((control & 0x1C) >> 2) + 3;
+            copyOffset  = ((control & 0x60) << 3) + input[1] + 1;
+            input += 2;
+        }
+        else if (control < 0xC0)
+        {
+            if (inputEnd - input < 3)
+            {
+                return false;
+            }
+            literalSize = input[1] >> 6;
+            copySize    = (control & 0x3F) + 4;
+            copyOffset  = ((input[1] & 0x3F) << 8) + input[2] + 1;
+            input += 3;
+        }
+        else if (control < 0xE0)
+        {
+            if (inputEnd - input < 4)
+            {
+                return false;
+            }
+            literalSize = control & 0x03;
+            copySize    = ((control & 0x0C) << 6) + input[3] + 5;
+            copyOffset  = ((control & 0x10) << 12) + (input[1] << 8) + input[2] + 1;
+            input += 4;
+        }
+        else
+        {
+            // literal only commands, the last
+            // command has at most 3 literal bytes
+            literalSize = control < 0xFC ? ((control & 0x1F) << 2) + 4 : control & 0x03;
+            copySize    = 0;
+            copyOffset  = 0;
+            input += 1;
+        }
+
+        if (static_cast<size_t>(inputEnd - input) < literalSize ||
+            static_cast<size_t>(outputEnd - outputIter) < literalSize + copySize)
+        {
+            return false;
+        }
+
+        std::memcpy(outputIter, input, literalSize);
+        input      += literalSize;
+        outputIter += literalSize;
+
+        if (control >= 0xFC)
+        {
+            return outputIter == outputEnd;
+        }
+
+        if (copyOffset > static_cast<size_t>(outputIter - outputStart))
+        {
+            return false;
+        }
+
+        // when the copy overlaps itself, it repeats the bytes
+        // in between, copying from the same source doubles the
+        // size which can be copied without overlapping every time
+        const unsigned char* copySource = outputIter - copyOffset;
+        while (copySize > 0)
+        {
+            const size_t chunkSize = std::min(copySize, static_cast<size_t>(outputIter - copySource));
+            std::memcpy(outputIter, copySource, chunkSize);
+            outputIter += chunkSize;
+            copySize   -= chunkSize;
+        }
+    }
+
+    // the input has to end with a stop command
+    return false;
+}
@@ -0,0 +1,32 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_REFPACK_HPP
+#define SPOREMODMANAGERHELPERS_REFPACK_HPP
+
+#include <cstddef>
+
+namespace SporeModManagerHelpers
+{
+    namespace RefPack
+    {
+        /// <summary>
+        ///     Retrieves the decompressed size from the header of RefPack compressed data
+        /// </summary>
+        bool GetDecompressedSize(const char* data, size_t size, size_t& decompressedSize);
+
+        /// <summary>
+        ///     Decompresses RefPack compressed data into output,
+        ///     outputSize must be the decompressed size of data
+        /// </summary>
+        bool Decompress(const char* data, size_t size, char* output, size_t outputSize);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_REFPACK_HPP
@@ -0,0 +1,290 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ResourceIndex.hpp"
+#include "SporeMod.hpp"
+#include "Path.hpp"
+#include "UI.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <utility>
+#include <map>
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define RESOURCEINDEX_MAGIC   "SMRI"
+#define RESOURCEINDEX_VERSION 1
+
+//
+// Local Structures
+//
+
+struct indexed_package
+{
+    uint64_t Size         = 0;
+    int64_t  ModifiedTime = 0;
+    std::vector<Dbpf::ResourceKey> ResourceKeys;
+};
+
+typedef std::pair<SporeMod::InstallLocation, std::filesystem::path> package_id;
+
+//
+// Local Variables
+//
+
+static std::filesystem::path                 l_IndexPath;
+static bool                                  l_HasChanged = false;
+static std::map<package_id, indexed_package> l_IndexedPackages;
+
+//
+// Helper Functions
+//
+
+static std::filesystem::path get_index_path(void)
+{
+    std::filesystem::path indexPath = Path::GetConfigFilePath();
+    indexPath += ".resources";
+    return indexPath;
+}
+
+template <typename T>
+static bool read_value(std::ifstream& stream, T& value)
+{
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template <typename T>
+static void write_value(std::ofstream& stream, const T& value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static bool read_index(const std::filesystem::path& indexPath, std::map<package_id, indexed_package>& indexedPackages)
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t packageCount;
+    uint32_t installLocation;
+    uint32_t fileNameSize;
+    uint32_t resourceKeyCount;
+    std::string fileName;
+
+    std::ifstream indexStream(indexPath, std::ios::binary);
+    if (!indexStream.is_open() ||
+        !indexStream.read(magic, sizeof(magic)) || std::memcmp(magic, RESOURCEINDEX_MAGIC, sizeof(magic)) != 0 ||
+        !read_value(indexStream, version) || version != RESOURCEINDEX_VERSION ||
+        !read_value(indexStream, packageCount))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < packageCount; i++)
+    {
+        indexed_package indexedPackage;
+
+        if (!read_value(indexStream, installLocation) || !read_value(indexStream, fileNameSize))
+        {
+            return false;
+        }
+
+        fileName.resize(fileNameSize);
+        if (!indexStream.read(fileName.data(), fileNameSize) ||
+            !read_value(indexStream, indexedPackage.Size) ||
+            !read_value(indexStream, indexedPackage.ModifiedTime) ||
+            !read_value(indexStream, resourceKeyCount))
+        {
+            return false;
+        }
+
+        // the keys are stored as they are in memory,
+        // which allows reading them in one go
+        indexedPackage.ResourceKeys.resize(resourceKeyCount);
+        if (!indexStream.read(reinterpret_cast<char*>(indexedPackage.ResourceKeys.data()), resourceKeyCount * sizeof(Dbpf::ResourceKey)))
+        {
+            return false;
+        }
+
+        indexedPackages[{ static_cast<SporeMod::InstallLocation>(installLocation), fileName }] = std::move(indexedPackage);
+    }
+
+    return true;
+}
+
+static void load_index(void)
+{
+    const std::filesystem::path indexPath = get_index_path();
+
+    // the config file path differs per target
+    if (l_IndexPath == indexPath)
+    {
+        return;
+    }
+
+    l_IndexPath  = indexPath;
+    l_HasChanged = false;
+    l_IndexedPackages.clear();
+
+    // an invalid index is rebuilt when needed
+    if (!read_index(indexPath, l_IndexedPackages))
+    {
+        l_IndexedPackages.clear();
+    }
+}
+
+//
+// Exported Functions
+//
+
+bool ResourceIndex::UpdatePackage(SporeMod::InstallLocation installLocation, const std::filesystem::path& fileName,
+                                  const std::filesystem::path& path)
+{
+    indexed_package indexedPackage;
+    std::vector<Dbpf::ResourceEntry> resourceEntries;
+
+    load_index();
+
+    if (!SporeMod::GetFileStat(path, indexedPackage.Size, indexedPackage.ModifiedTime))
+    {
+        return false;
+    }
+
+    auto indexedPackageIter = l_IndexedPackages.find({ installLocation, fileName });
+    if (indexedPackageIter != l_IndexedPackages.end() &&
+        indexedPackageIter->second.Size == indexedPackage.Size &&
+        indexedPackageIter->second.ModifiedTime == indexedPackage.ModifiedTime)
+    {
+        return true;
+    }
+
+    if (UI::GetVerboseMode())
+    {
+        std::cout << "--> Indexing resources of " << path << std::endl;
+    }
+
+    // files which aren't DBPF packages don't have
+    // any resources, they're indexed as such so
+    // they aren't read again until they change
+    if (Dbpf::ReadIndex(path, resourceEntries))
+    {
+        indexedPackage.ResourceKeys.reserve(resourceEntries.size());
+        for (const auto& resourceEntry : resourceEntries)
+        {
+            indexedPackage.ResourceKeys.push_back(resourceEntry.Key);
+        }
+    }
+
+    l_IndexedPackages[{ installLocation, fileName }] = std::move(indexedPackage);
+    l_HasChanged = true;
+    return true;
+}
+
+bool ResourceIndex::GetResources(SporeMod::InstallLocation installLocation, const std::filesystem::path& fileName,
+                                 std::vector<Dbpf::ResourceKey>& resourceKeys)
+{
+    load_index();
+
+    auto indexedPackageIter = l_IndexedPackages.find({ installLocation, fileName });
+    if (indexedPackageIter == l_IndexedPackages.end())
+    {
+        return false;
+    }
+
+    resourceKeys = indexedPackageIter->second.ResourceKeys;
+    return true;
+}
+
+void ResourceIndex::RemoveUnusedPackages(const std::vector<SporeMod::Xml::InstalledSporeMod>& installedSporeMods)
+{
+    std::map<package_id, indexed_package> usedPackages;
+
+    load_index();
+
+    for (const auto& installedSporeMod : installedSporeMods)
+    {
+        for (const auto& installedFile : installedSporeMod.InstalledFiles)
+        {
+            auto indexedPackageIter = l_IndexedPackages.find({ installedFile.InstallLocation, installedFile.FileName });
+            if (indexedPackageIter != l_IndexedPackages.end())
+            {
+                usedPackages.insert(l_IndexedPackages.extract(indexedPackageIter));
+            }
+        }
+    }
+
+    if (!l_IndexedPackages.empty())
+    {
+        l_HasChanged = true;
+    }
+
+    l_IndexedPackages = std::move(usedPackages);
+}
+
+bool ResourceIndex::SaveIndex(void)
+{
+    std::filesystem::path tempIndexPath;
+    std::error_code error;
+
+    if (!l_HasChanged)
+    {
+        return true;
+    }
+
+    tempIndexPath = l_IndexPath;
+    tempIndexPath += ".tmp";
+
+    {
+        std::ofstream indexStream(tempIndexPath, std::ios::binary | std::ios::trunc);
+        if (!indexStream.is_open())
+        {
+            std::cerr << "Error: failed to open " << tempIndexPath << std::endl;
+            return false;
+        }
+
+        indexStream.write(RESOURCEINDEX_MAGIC, 4);
+        write_value(indexStream, static_cast<uint32_t>(RESOURCEINDEX_VERSION));
+        write_value(indexStream, static_cast<uint32_t>(l_IndexedPackages.size()));
+
+        for (const auto& indexedPackage : l_IndexedPackages)
+        {
+            const std::string fileName = indexedPackage.first.second.string();
+
+            write_value(indexStream, static_cast<uint32_t>(indexedPackage.first.first));
+            write_value(indexStream, static_cast<uint32_t>(fileName.size()));
+            indexStream.write(fileName.data(), fileName.size());
+            write_value(indexStream, indexedPackage.second.Size);
+            write_value(indexStream, indexedPackage.second.ModifiedTime);
+            write_value(indexStream, static_cast<uint32_t>(indexedPackage.second.ResourceKeys.size()));
+            indexStream.write(reinterpret_cast<const char*>(indexedPackage.second.ResourceKeys.data()),
+                              indexedPackage.second.ResourceKeys.size() * sizeof(Dbpf::ResourceKey));
+        }
+
+        indexStream.flush();
+        if (indexStream.fail())
+        {
+            std::cerr << "Error: failed to write " << tempIndexPath << std::endl;
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempIndexPath, l_IndexPath, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to move " << tempIndexPath << " to " << l_IndexPath << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    l_HasChanged = false;
+    return true;
+}
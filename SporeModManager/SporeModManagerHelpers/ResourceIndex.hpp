@@ -0,0 +1,48 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_RESOURCEINDEX_HPP
+#define SPOREMODMANAGERHELPERS_RESOURCEINDEX_HPP
+
+#include <filesystem>
+#include <vector>
+
+#include "SporeModXml.hpp"
+#include "Dbpf.hpp"
+
+namespace SporeModManagerHelpers
+{
+    namespace ResourceIndex
+    {
+        /// <summary>
+        ///     Indexes the resources of the installed package at path when
+        ///     it isn't indexed yet or when it has changed since it was indexed
+        /// </summary>
+        bool UpdatePackage(SporeMod::InstallLocation installLocation, const std::filesystem::path& fileName,
+                           const std::filesystem::path& path);
+
+        /// <summary>
+        ///     Retrieves the indexed resources of the installed package
+        /// </summary>
+        bool GetResources(SporeMod::InstallLocation installLocation, const std::filesystem::path& fileName,
+                          std::vector<Dbpf::ResourceKey>& resourceKeys);
+
+        /// <summary>
+        ///     Removes the packages which aren't part of any of the installed mods from the index
+        /// </summary>
+        void RemoveUnusedPackages(const std::vector<SporeMod::Xml::InstalledSporeMod>& installedSporeMods);
+
+        /// <summary>
+        ///     Saves the index when it has changed
+        /// </summary>
+        bool SaveIndex(void);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_RESOURCEINDEX_HPP
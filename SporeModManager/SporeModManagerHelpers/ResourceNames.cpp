@@ -0,0 +1,281 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ResourceNames.hpp"
+#include "FileMap.hpp"
+#include "Hash.hpp"
+#include "Path.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define RESOURCENAMES_MAGIC   "SMRN"
+#define RESOURCENAMES_VERSION 1
+
+//
+// Local Structures
+//
+
+// the dictionary is used as it's mapped, it consists of
+// the header, the entries sorted by hash and the names,
+// which are null terminated and referenced by the entries
+struct dictionary_header
+{
+    char     Magic[4];
+    uint32_t Version;
+    uint32_t EntryCount;
+    uint32_t NamesSize;
+};
+
+struct dictionary_entry
+{
+    uint32_t Hash;
+    uint32_t NameOffset;
+};
+
+//
+// Local Variables
+//
+
+static std::filesystem::path   l_DictionaryPath;
+static FileMap::MappedFile     l_Dictionary;
+static const dictionary_entry* l_Entries    = nullptr;
+static const char*             l_Names      = nullptr;
+static uint32_t                l_EntryCount = 0;
+
+//
+// Helper Functions
+//
+
+static std::filesystem::path get_dictionary_path(void)
+{
+    std::filesystem::path dictionaryPath = Path::GetConfigFilePath();
+    dictionaryPath += ".names";
+    return dictionaryPath;
+}
+
+static bool parse_dictionary(const FileMap::MappedFile& dictionary)
+{
+    dictionary_header header;
+
+    if (dictionary.Size < sizeof(header))
+    {
+        return false;
+    }
+
+    std::memcpy(&header, dictionary.Data, sizeof(header));
+    if (std::memcmp(header.Magic, RESOURCENAMES_MAGIC, sizeof(header.Magic)) != 0 ||
+        header.Version != RESOURCENAMES_VERSION ||
+        (dictionary.Size - sizeof(header)) / sizeof(dictionary_entry) < header.EntryCount ||
+        dictionary.Size - sizeof(header) - (header.EntryCount * sizeof(dictionary_entry)) != header.NamesSize)
+    {
+        return false;
+    }
+
+    l_Entries    = reinterpret_cast<const dictionary_entry*>(dictionary.Data + sizeof(header));
+    l_Names      = dictionary.Data + sizeof(header) + (header.EntryCount * sizeof(dictionary_entry));
+    l_EntryCount = header.EntryCount;
+
+    // every name has to be inside of the dictionary,
+    // the last one is null terminated when it ends with 0
+    if (l_EntryCount > 0 && (header.NamesSize == 0 || l_Names[header.NamesSize - 1] != '\0'))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < l_EntryCount; i++)
+    {
+        if (l_Entries[i].NameOffset >= header.NamesSize)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void unload_dictionary(void)
+{
+    FileMap::UnmapFile(l_Dictionary);
+    l_Entries    = nullptr;
+    l_Names      = nullptr;
+    l_EntryCount = 0;
+}
+
+static void load_dictionary(void)
+{
+    const std::filesystem::path dictionaryPath = get_dictionary_path();
+
+    // the config file path differs per target
+    if (l_DictionaryPath == dictionaryPath)
+    {
+        return;
+    }
+
+    unload_dictionary();
+    l_DictionaryPath = dictionaryPath;
+
+    // the dictionary is optional, so
+    // an invalid one is treated as empty
+    if (!FileMap::MapFile(dictionaryPath, l_Dictionary) || !parse_dictionary(l_Dictionary))
+    {
+        unload_dictionary();
+    }
+}
+
+//
+// Exported Functions
+//
+
+bool ResourceNames::AddNames(const std::vector<std::string>& names)
+{
+    std::vector<std::string> dictionaryNames;
+    std::vector<uint32_t>    hashes;
+    std::vector<std::pair<uint32_t, size_t>> hashNameIds;
+    std::vector<dictionary_entry> entries;
+    std::string namesData;
+    std::filesystem::path dictionaryPath;
+    std::filesystem::path tempDictionaryPath;
+    dictionary_header header;
+    std::error_code error;
+
+    load_dictionary();
+
+    dictionaryNames.reserve(l_EntryCount + names.size());
+    for (uint32_t i = 0; i < l_EntryCount; i++)
+    {
+        dictionaryNames.push_back(l_Names + l_Entries[i].NameOffset);
+    }
+    for (const auto& name : names)
+    {
+        // names can't contain the terminator
+        if (!name.empty() && name.find('\0') == std::string::npos)
+        {
+            dictionaryNames.push_back(name);
+        }
+    }
+
+    std::sort(dictionaryNames.begin(), dictionaryNames.end());
+    dictionaryNames.erase(std::unique(dictionaryNames.begin(), dictionaryNames.end()), dictionaryNames.end());
+
+    Hash::Fnv(dictionaryNames, hashes);
+
+    hashNameIds.reserve(dictionaryNames.size());
+    for (size_t i = 0; i < dictionaryNames.size(); i++)
+    {
+        hashNameIds.push_back({ hashes[i], i });
+    }
+    std::sort(hashNameIds.begin(), hashNameIds.end());
+
+    entries.reserve(hashNameIds.size());
+    for (const auto& hashNameId : hashNameIds)
+    {
+        entries.push_back({ hashNameId.first, static_cast<uint32_t>(namesData.size()) });
+        namesData += dictionaryNames[hashNameId.second];
+        namesData += '\0';
+        if (namesData.size() > UINT32_MAX)
+        {
+            std::cerr << "Error: too many names have been given!" << std::endl;
+            return false;
+        }
+    }
+
+    std::memcpy(header.Magic, RESOURCENAMES_MAGIC, sizeof(header.Magic));
+    header.Version    = RESOURCENAMES_VERSION;
+    header.EntryCount = static_cast<uint32_t>(entries.size());
+    header.NamesSize  = static_cast<uint32_t>(namesData.size());
+
+    // the mapped dictionary is replaced, so it can't be used anymore
+    dictionaryPath = l_DictionaryPath;
+    unload_dictionary();
+    l_DictionaryPath.clear();
+
+    tempDictionaryPath = dictionaryPath;
+    tempDictionaryPath += ".tmp";
+
+    {
+        std::ofstream dictionaryStream(tempDictionaryPath, std::ios::binary | std::ios::trunc);
+        if (!dictionaryStream.is_open())
+        {
+            std::cerr << "Error: failed to open " << tempDictionaryPath << std::endl;
+            return false;
+        }
+
+        dictionaryStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        dictionaryStream.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(dictionary_entry));
+        dictionaryStream.write(namesData.data(), namesData.size());
+
+        dictionaryStream.flush();
+        if (dictionaryStream.fail())
+        {
+            std::cerr << "Error: failed to write " << tempDictionaryPath << std::endl;
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempDictionaryPath, dictionaryPath, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to move " << tempDictionaryPath << " to " << dictionaryPath << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool ResourceNames::GetName(uint32_t hash, std::string& name)
+{
+    load_dictionary();
+
+    const dictionary_entry* entriesEnd = l_Entries + l_EntryCount;
+    const dictionary_entry* entry = std::lower_bound(l_Entries, entriesEnd, hash, [](const dictionary_entry& entry, uint32_t hash)
+    {
+        return entry.Hash < hash;
+    });
+    if (entry == entriesEnd || entry->Hash != hash)
+    {
+        return false;
+    }
+
+    name = l_Names + entry->NameOffset;
+    return true;
+}
+
+std::string ResourceNames::GetKeyString(const Dbpf::ResourceKey& key)
+{
+    std::string keyString;
+    std::string name;
+    char hashString[16];
+
+    for (const auto& [hash, separator] : { std::pair<uint32_t, const char*>{ key.GroupId, "!" },
+                                           std::pair<uint32_t, const char*>{ key.InstanceId, "." },
+                                           std::pair<uint32_t, const char*>{ key.TypeId, "" } })
+    {
+        if (GetName(hash, name))
+        {
+            keyString += name;
+        }
+        else
+        {
+            std::snprintf(hashString, sizeof(hashString), "0x%08x", static_cast<unsigned int>(hash));
+            keyString += hashString;
+        }
+        keyString += separator;
+    }
+
+    return keyString;
+}
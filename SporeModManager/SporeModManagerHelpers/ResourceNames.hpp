@@ -0,0 +1,42 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_RESOURCENAMES_HPP
+#define SPOREMODMANAGERHELPERS_RESOURCENAMES_HPP
+
+#include <filesystem>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Dbpf.hpp"
+
+namespace SporeModManagerHelpers
+{
+    namespace ResourceNames
+    {
+        /// <summary>
+        ///     Adds names to the name dictionary, which maps hashes back to names
+        /// </summary>
+        bool AddNames(const std::vector<std::string>& names);
+
+        /// <summary>
+        ///     Retrieves the name of hash from the name dictionary
+        /// </summary>
+        bool GetName(uint32_t hash, std::string& name);
+
+        /// <summary>
+        ///     Returns key formatted as group!instance.type,
+        ///     using names from the name dictionary when they're known
+        /// </summary>
+        std::string GetKeyString(const Dbpf::ResourceKey& key);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_RESOURCENAMES_HPP
@@ -8,383 +8,1812 @@
  *  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include "SporeMod.hpp"
+#include "AsyncIO.hpp"
+#include "Cache.hpp"
+#include "Dbpf.hpp"
+#include "DllImports.hpp"
+#include "FileLink.hpp"
 #include "String.hpp"
 #include "Path.hpp"
+#include "Hash.hpp"
+#include "ResourceIndex.hpp"
+#include "ResourceNames.hpp"
+#include "Store.hpp"
+#include "Transaction.hpp"
+#include "Thread.hpp"
 #include "UI.hpp"
 
 #include <iostream>
+#include <fstream>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <map>
+#include <tuple>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif // _WIN32
 
 using namespace SporeModManagerHelpers;
 
+//
+// Local Defines
+//
+
+// the game and SporeModLoader don't load files
+// from sub directories of the install locations
+#define SPOREMOD_DISABLED_DIRECTORY "SporeModManagerDisabled"
+#define SPOREMOD_MERGED_DIRECTORY   "SporeModManagerMerged"
+
+//
+// Local Structures
+//
+
+struct staged_file
+{
+    SporeMod::Xml::SporeModFile* File;
+    std::filesystem::path StagingPath;
+    uint32_t Crc32;
+    // only set for extracted files,
+    // which are added to the cache
+    std::string CacheKey;
+};
+
+struct extracted_file
+{
+    std::filesystem::path InstallPath;
+    uint64_t Size;
+    int64_t  ModifiedTime;
+};
+
+//
+// Local Variables
+//
+
+// files installed during this session, keyed by name, size and crc32,
+// this allows installing the same mod to multiple targets
+// while only extracting every file once
+static std::map<std::tuple<std::string, uint64_t, uint32_t>, extracted_file> l_ExtractedFiles;
+
+static bool l_CompactPackages = false;
+static bool l_PatchPackages   = false;
+
 //
 // Helper Functions
 //
 
+static std::filesystem::path get_installed_file_name(const SporeMod::Xml::InstalledSporeMod& installedSporeMod, 
+                                                     const SporeMod::Xml::SporeModFile& installedFile)
+{
+    if (installedSporeMod.IsDisabled)
+    {
+        return Path::Combine({ SPOREMOD_DISABLED_DIRECTORY, installedSporeMod.UniqueName, installedFile.FileName });
+    }
+
+    if (installedFile.IsMerged)
+    {
+        return Path::Combine({ SPOREMOD_MERGED_DIRECTORY, installedFile.FileName });
+    }
+
+    return installedFile.FileName;
+}
+
+static void remove_disabled_directories(const SporeMod::Xml::InstalledSporeMod& installedSporeMod)
+{
+    std::vector<SporeMod::InstallLocation> installLocations;
+    std::error_code error;
+
+    for (const auto& installedFile : installedSporeMod.InstalledFiles)
+    {
+        if (std::find(installLocations.begin(), installLocations.end(), installedFile.InstallLocation) != installLocations.end())
+        {
+            continue;
+        }
+        installLocations.push_back(installedFile.InstallLocation);
+
+        // only empty directories are removed
+        std::filesystem::path disabledPath = Path::GetFullInstallPath(installedFile.InstallLocation, SPOREMOD_DISABLED_DIRECTORY);
+        std::filesystem::remove(Path::Combine({ disabledPath, installedSporeMod.UniqueName }), error);
+        std::filesystem::remove(disabledPath, error);
+    }
+}
+
+static bool is_same_file(const SporeMod::Xml::SporeModFile& a, const SporeMod::Xml::SporeModFile& b)
+{
+    return a.InstallLocation == b.InstallLocation && a.FileName == b.FileName;
+}
+
+static const SporeMod::Xml::SporeModFile* find_installed_file(const SporeMod::Xml::InstalledSporeMod& installedSporeMod,
+                                                             const SporeMod::Xml::SporeModFile& file)
+{
+    for (const auto& installedFile : installedSporeMod.InstalledFiles)
+    {
+        if (is_same_file(installedFile, file))
+        {
+            return &installedFile;
+        }
+    }
+
+    return nullptr;
+}
+
+static std::vector<const SporeMod::Xml::InstalledSporeMod*> get_other_owners(const std::vector<SporeMod::Xml::InstalledSporeMod>& installedSporeMods,
+                                                                            const std::vector<std::string>& excludedUniqueNames,
+                                                                            const SporeMod::Xml::SporeModFile& file)
+{
+    std::vector<const SporeMod::Xml::InstalledSporeMod*> owners;
+
+    // a file which is shared by multiple mods is only
+    // removed when the last mod which has it is removed,
+    // so the amount of mods with it is its reference count
+    for (const auto& installedSporeMod : installedSporeMods)
+    {
+        if (std::find(excludedUniqueNames.begin(), excludedUniqueNames.end(), installedSporeMod.UniqueName) != excludedUniqueNames.end())
+        {
+            continue;
+        }
+
+        if (find_installed_file(installedSporeMod, file) != nullptr)
+        {
+            owners.push_back(&installedSporeMod);
+        }
+    }
+
+    return owners;
+}
+
+static const SporeMod::Xml::InstalledSporeMod* find_enabled_owner(const std::vector<const SporeMod::Xml::InstalledSporeMod*>& owners)
+{
+    auto ownerIter = std::find_if(owners.begin(), owners.end(), [](const SporeMod::Xml::InstalledSporeMod* owner)
+    {
+        return !owner->IsDisabled;
+    });
+
+    return ownerIter == owners.end() ? nullptr : *ownerIter;
+}
+
+static bool has_enabled_owner(const std::vector<const SporeMod::Xml::InstalledSporeMod*>& owners)
+{
+    return find_enabled_owner(owners) != nullptr;
+}
+
 static bool check_other_mod_files(const SporeMod::Xml::InstalledSporeMod& installedSporeMod,
-                                         const std::vector<SporeMod::Xml::InstalledSporeMod>& installedSporeMods)
+                                  const std::vector<SporeMod::Xml::InstalledSporeMod>& installedSporeMods)
 {
     for (const auto& installedSporeModIter : installedSporeMods)
     {
+        if (installedSporeMod.UniqueName == installedSporeModIter.UniqueName)
+        {
+            continue;
+        }
+
         for (const auto& sporeModFile : installedSporeMod.InstalledFiles)
         {
-            auto predicate = [installedSporeMod, installedSporeModIter, sporeModFile](const SporeMod::Xml::SporeModFile& file)
+            auto predicate = [sporeModFile](const SporeMod::Xml::SporeModFile& file)
             {
-                return installedSporeMod.UniqueName != installedSporeModIter.UniqueName && file == sporeModFile;
+                return is_same_file(file, sporeModFile);
             };
             auto installedFileIter = std::find_if(installedSporeModIter.InstalledFiles.begin(), installedSporeModIter.InstalledFiles.end(), predicate);
-            if (installedFileIter != installedSporeModIter.InstalledFiles.end())
+            if (installedFileIter == installedSporeModIter.InstalledFiles.end())
             {
-                std::cerr << "Error: an already installed mod (" << installedSporeModIter.Name
-                          << ") contains a file (" << (*installedFileIter).FileName << ") that this mod wants to install!" << std::endl;
-                return true;
+                continue;
             }
+
+            // identical files can be shared, the size and CRC32 are either
+            // the fingerprint of the installed file or the ones of the
+            // file in the mod when the other mod is being installed too
+            if (!installedSporeModIter.IsDisabled &&
+                installedFileIter->Size == sporeModFile.Size && installedFileIter->Crc32 == sporeModFile.Crc32)
+            {
+                if (UI::GetVerboseMode())
+                {
+                    std::cout << "--> Sharing " << sporeModFile.FileName << " with " << installedSporeModIter.Name << std::endl;
+                }
+                continue;
+            }
+
+            std::cerr << "Error: an already installed mod (" << installedSporeModIter.Name
+                      << ") contains a file (" << (*installedFileIter).FileName << ") that this mod wants to install!" << std::endl;
+            return true;
         }
     }
 
     return false;
 }
 
-//
-// Exported Functions
-//
-
-bool SporeMod::FindInstalledMod(const std::string& uniqueName, int& installedSporeModId, 
-                                const std::vector<Xml::InstalledSporeMod>& installedSporeMods)
+static bool is_package_file(const std::filesystem::path& path)
 {
-    Xml::InstalledSporeMod installedSporeMod;
+    return String::Lowercase(path.extension().string()) == ".package";
+}
 
-    for (size_t i = 0; i < installedSporeMods.size(); i++)
-    {
-        installedSporeMod = installedSporeMods[i];
-        if (installedSporeMod.UniqueName == uniqueName)
-        {
-            installedSporeModId = i;
-            return true;
-        }
-    }
+static bool read_zip_package_resources(Zip::ZipFile zipFile, const std::filesystem::path& sourcePath,
+                                       std::vector<Dbpf::ResourceEntry>& resourceEntries)
+{
+    Dbpf::PackageHeader header;
+    std::vector<char>   buffer;
 
-    return false;
+    // only the header and the index are read from the zip
+    // file, so the rest of the package doesn't have to be
+    // extracted to know which resources it contains
+    return Zip::ReadFile(zipFile, sourcePath, 0, DBPF_HEADER_SIZE, buffer) &&
+            Dbpf::ParseHeader(buffer.data(), buffer.size(), header) &&
+            Zip::ReadFile(zipFile, sourcePath, header.IndexOffset, header.IndexSize, buffer) &&
+            Dbpf::ParseIndex(buffer.data(), buffer.size(), header, resourceEntries);
 }
 
-bool SporeMod::ConfigureSporeMod(Zip::ZipFile zipFile, const Xml::SporeModInfo& sporeModInfo, 
-                                 Xml::InstalledSporeMod& installedSporeMod,
-                                 const std::vector<Xml::InstalledSporeMod> &installedSporeMods)
+static void check_resource_conflicts(const SporeMod::Xml::InstalledSporeMod& installedSporeMod, const SporeMod::Xml::SporeModFile& packageFile,
+                                     const std::vector<Dbpf::ResourceEntry>& resourceEntries,
+                                     const std::vector<SporeMod::Xml::InstalledSporeMod>& installedSporeMods)
 {
-    Xml::SporeModInfoComponent component;
-    size_t             componentsSize;
-    std::optional<int> defaultComponentId;
-    int                componentId;
-    std::vector<int>   defaultComponentIds;
-    std::vector<int>   componentIds;
-    std::string        uiText;
-    bool               configurationRequired = false;
-    std::vector<std::filesystem::path> zipFileList;
+    std::unordered_set<Dbpf::ResourceKey, Dbpf::ResourceKeyHash> resourceKeys;
+    std::vector<Dbpf::ResourceKey> installedResourceKeys;
+    size_t conflictCount;
 
-    // support for pre-modinfo.xml mods
-    if (!sporeModInfo.HasModInfoXml)
+    for (const auto& resourceEntry : resourceEntries)
     {
-        installedSporeMod.UniqueName = sporeModInfo.UniqueName;
-        installedSporeMod.Name       = sporeModInfo.UniqueName;
+        resourceKeys.insert(resourceEntry.Key);
+    }
 
-        if (!Zip::GetFileList(zipFile, zipFileList))
+    // resource conflicts aren't always unintended, a mod can
+    // override the resources of another mod on purpose,
+    // so only warn about them before anything is installed
+    for (const auto& installedSporeModIter : installedSporeMods)
+    {
+        if (installedSporeModIter.UniqueName == installedSporeMod.UniqueName || installedSporeModIter.IsDisabled)
         {
-            std::cerr << "Error: failed to retrieve file list from zip file!" << std::endl;
-            return false;
+            continue;
         }
 
-        for (const auto& path : zipFileList)
+        for (const auto& installedFile : installedSporeModIter.InstalledFiles)
         {
-            const std::string extension = String::Lowercase(path.extension().string());
-            if (extension == ".dll")
+            if (!is_package_file(installedFile.FileName) || is_same_file(installedFile, packageFile) ||
+                !ResourceIndex::GetResources(installedFile.InstallLocation, installedFile.FileName, installedResourceKeys))
             {
-                installedSporeMod.InstalledFiles.push_back({InstallLocation::ModLibs, path.filename(), path});
+                continue;
             }
-            else if (extension == ".package")
+
+            conflictCount = 0;
+            for (const auto& installedResourceKey : installedResourceKeys)
             {
-                installedSporeMod.InstalledFiles.push_back({InstallLocation::GalacticAdventuresData, path.filename(), path});
+                if (resourceKeys.find(installedResourceKey) != resourceKeys.end())
+                {
+                    if (UI::GetVerboseMode())
+                    {
+                        std::cout << "--> " << ResourceNames::GetKeyString(installedResourceKey) << " is also in " << installedFile.FileName << std::endl;
+                    }
+                    conflictCount++;
+                }
+            }
+
+            if (conflictCount > 0)
+            {
+                std::cerr << "Warning: " << packageFile.FileName << " contains " << conflictCount << " resource(s) which are also in "
+                          << installedFile.FileName << " (" << installedSporeModIter.Name << ")!" << std::endl;
             }
         }
+    }
+}
+
+static bool find_shared_file(const std::vector<SporeMod::Xml::InstalledSporeMod>& installedSporeMods, 
+                             const SporeMod::Xml::InstalledSporeMod& installedSporeMod, SporeMod::Xml::SporeModFile& installedFile,
+                             uint64_t size, uint32_t crc32, bool& isShared)
+{
+    const SporeMod::Xml::InstalledSporeMod* owner = find_enabled_owner(get_other_owners(installedSporeMods, { installedSporeMod.UniqueName }, installedFile));
+    std::filesystem::path installPath;
+    uint64_t installedSize;
+    int64_t  installedModifiedTime;
+    uint32_t installedCrc32;
+
+    isShared = false;
+
+    if (owner == nullptr)
+    {
         return true;
     }
 
-    installedSporeMod.Name        = sporeModInfo.Name;
-    installedSporeMod.UniqueName  = sporeModInfo.UniqueName;
-    installedSporeMod.Description = sporeModInfo.Description;
+    // the file of the other mod can be merged
+    const SporeMod::Xml::SporeModFile* ownerFile = find_installed_file(*owner, installedFile);
+    installPath = SporeMod::GetInstalledFilePath(*owner, *ownerFile);
 
-    configurationRequired = sporeModInfo.IsExperimental           || 
-                            sporeModInfo.RequiresGalaxyReset      ||
-                            sporeModInfo.CausesSaveDataDependency ||
-                            (sporeModInfo.HasCustomInstaller &&
-                            (!sporeModInfo.ComponentGroups.empty() ||
-                             !sporeModInfo.Components.empty()));
+    // without a fingerprint the other mod is being
+    // installed too and its file will be shared with this one
+    if (!ownerFile->HasFingerprint)
+    {
+        return true;
+    }
 
-    if (configurationRequired)
+    // the file of the other mod has been accepted as shared
+    // when configuring, when it differs on disk, replacing it
+    // would leave the other mod with a file it doesn't have
+    if (!SporeMod::GetFileStat(installPath, installedSize, installedModifiedTime) || installedSize != size ||
+        !Hash::Crc32File(installPath, installedCrc32) || installedCrc32 != crc32)
     {
-        std::cout << "-> Configuring " << sporeModInfo.Name << std::endl;
+        std::cerr << "Error: " << installedFile.FileName << " is shared with " << owner->Name << " but differs on disk!" << std::endl;
+        return false;
     }
 
-    const struct
+    installedFile.HasFingerprint = true;
+    installedFile.Size           = installedSize;
+    installedFile.ModifiedTime   = installedModifiedTime;
+    installedFile.Crc32          = installedCrc32;
+    installedFile.IsMerged       = ownerFile->IsMerged;
+
+    if (UI::GetVerboseMode())
     {
-        bool NeedsWarn;
-        std::string Text;
-    } warningOptions[] =
+        std::cout << "--> Skipping shared " << installedFile.FileName << std::endl;
+    }
+    isShared = true;
+    return true;
+}
+
+static bool compact_staged_package(const SporeMod::Xml::SporeModFile& installedFile, const std::filesystem::path& path,
+                                   const std::filesystem::path& stagingPath, uint32_t& crc32, bool& isCompacted)
+{
+    std::vector<Dbpf::ResourceEntry> resourceEntries;
+
+    isCompacted = false;
+
+    // files with the package extension which
+    // aren't DBPF packages are installed as they are
+    if (!l_CompactPackages || !is_package_file(installedFile.FileName) ||
+        !Dbpf::ReadIndex(path, resourceEntries))
     {
-        { sporeModInfo.IsExperimental,           "--> This mod is experimental" },
-        { sporeModInfo.RequiresGalaxyReset,      "--> This mod requires a galaxy reset" },
-        { sporeModInfo.CausesSaveDataDependency, "--> This mod causes save data dependency" }
-    };
+        return true;
+    }
 
-    for (const auto& warnOption : warningOptions)
+    if (!Dbpf::CompactPackage(path, stagingPath, isCompacted))
     {
-        if (warnOption.NeedsWarn)
+        std::cerr << "Error: failed to compact " << installedFile.FileName << std::endl;
+        return false;
+    }
+
+    if (!isCompacted)
+    {
+        return true;
+    }
+
+    if (UI::GetVerboseMode())
+    {
+        std::cout << "--> Compacted " << installedFile.FileName << std::endl;
+    }
+
+    return Hash::Crc32File(stagingPath, crc32);
+}
+
+static bool set_file_fingerprint(SporeMod::Xml::SporeModFile& installedFile, const std::filesystem::path& installPath, uint32_t crc32)
+{
+    if (!SporeMod::GetFileStat(installPath, installedFile.Size, installedFile.ModifiedTime))
+    {
+        std::cerr << "Error: failed to retrieve file information of " << installPath << std::endl;
+        return false;
+    }
+
+    installedFile.Crc32          = crc32;
+    installedFile.HasFingerprint = true;
+    return true;
+}
+
+static bool stream_file(const std::filesystem::path& path, const std::function<bool(const char*, size_t)>& function)
+{
+    std::vector<char> buffer(1048576);
+
+    std::ifstream fileStream(path, std::ios::binary);
+    if (!fileStream.is_open())
+    {
+        std::cerr << "Error: failed to open " << path << std::endl;
+        return false;
+    }
+
+    while (fileStream.read(buffer.data(), buffer.size()) || fileStream.gcount() > 0)
+    {
+        if (!function(buffer.data(), static_cast<size_t>(fileStream.gcount())))
         {
-            std::string inputText = warnOption.Text;
-            bool userAnswer = false;
-            inputText += "\n--> Are you sure you want to continue? [y/N]: ";
-            UI::AskUserInput(inputText, userAnswer, false);
-            if (!userAnswer)
-            {
-                return false;
-            }
+            return false;
+        }
+    }
+
+    return fileStream.eof();
+}
+
+static bool patch_installed_package(Transaction::Transaction transaction, const SporeMod::Xml::InstalledSporeMod* previousSporeMod,
+                                    const std::vector<SporeMod::Xml::InstalledSporeMod>& installedSporeMods,
+                                    const SporeMod::Xml::InstalledSporeMod& installedSporeMod, const SporeMod::Xml::SporeModFile& installedFile,
+                                    uint64_t size, const Dbpf::StreamFunction& streamFunction)
+{
+    const SporeMod::Xml::SporeModFile* previousFile;
+    std::filesystem::path installPath;
+    Dbpf::PackagePatch patch;
+    std::error_code error;
+
+    if (!l_PatchPackages || l_CompactPackages || previousSporeMod == nullptr || !is_package_file(installedFile.FileName))
+    {
+        return false;
+    }
+
+    // the installed package is changed in place, so it can't be
+    // used by anything else, which means it can't be in the content
+    // store, have other owners or be linked to another file, and it
+    // has to be the file which has been installed by the mod
+    previousFile = find_installed_file(*previousSporeMod, installedFile);
+    if (previousFile == nullptr || !previousFile->HasFingerprint || previousFile->IsMerged ||
+        !previousSporeMod->StorePath.empty() || !installedSporeMod.StorePath.empty() ||
+        !get_other_owners(installedSporeMods, { installedSporeMod.UniqueName }, installedFile).empty() ||
+        SporeMod::CheckInstalledFile(*previousSporeMod, *previousFile, false) != SporeMod::FileState::Unchanged)
+    {
+        return false;
+    }
+
+    installPath = Path::GetFullInstallPath(installedFile.InstallLocation, installedFile.FileName);
+    if (std::filesystem::hard_link_count(installPath, error) != 1 || error)
+    {
+        return false;
+    }
+
+    if (!Dbpf::PatchPackage(installPath, size, streamFunction, patch))
+    {
+        if (UI::GetVerboseMode())
+        {
+            std::cout << "--> Unable to patch " << installedFile.FileName << ", installing it completely" << std::endl;
+        }
+        return false;
+    }
+
+    if (!Transaction::PatchFile(transaction, installPath, patch.Size, patch.Header))
+    {
+        std::filesystem::resize_file(installPath, patch.Size, error);
+        return false;
+    }
+
+    if (UI::GetVerboseMode())
+    {
+        std::cout << "--> Patching " << installedFile.FileName << ", wrote " << patch.WrittenSize << " of " << size << " bytes" << std::endl;
+    }
+    return true;
+}
+
+static bool set_patched_fingerprints(const std::vector<SporeMod::Xml::SporeModFile*>& patchedFiles)
+{
+    uint32_t crc32;
+
+    // the patched packages differ from the ones they're
+    // patched to, so their fingerprint is of the installed file
+    for (const auto& patchedFile : patchedFiles)
+    {
+        const std::filesystem::path installPath = Path::GetFullInstallPath(patchedFile->InstallLocation, patchedFile->FileName);
+        if (!Hash::Crc32File(installPath, crc32) || !set_file_fingerprint(*patchedFile, installPath, crc32))
+        {
+            std::cerr << "Error: failed to retrieve fingerprint of " << installPath << std::endl;
+            return false;
         }
     }
 
-    if (sporeModInfo.HasCustomInstaller)
+    return true;
+}
+
+static bool find_unchanged_file(const SporeMod::Xml::InstalledSporeMod* previousSporeMod, SporeMod::Xml::SporeModFile& installedFile,
+                                uint64_t size, uint32_t crc32)
+{
+    // files from a different content store
+    // have to be installed again
+    if (previousSporeMod == nullptr || previousSporeMod->StorePath != Store::GetStorePath())
+    {
+        return false;
+    }
+
+    for (const auto& previousFile : previousSporeMod->InstalledFiles)
+    {
+        // the file on disk has to match the fingerprint
+        // we've recorded, and the fingerprint has to match
+        // the new file, only then we can skip it
+        if (is_same_file(previousFile, installedFile) && previousFile.HasFingerprint &&
+            previousFile.Size == size && previousFile.Crc32 == crc32 &&
+            SporeMod::CheckInstalledFile(*previousSporeMod, previousFile, false) == SporeMod::FileState::Unchanged)
+        {
+            installedFile.HasFingerprint = true;
+            installedFile.Size           = previousFile.Size;
+            installedFile.ModifiedTime   = previousFile.ModifiedTime;
+            installedFile.Crc32          = previousFile.Crc32;
+            installedFile.StoreHash      = previousFile.StoreHash;
+
+            if (UI::GetVerboseMode())
+            {
+                std::cout << "--> Skipping unchanged " << installedFile.FileName << std::endl;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool remove_stale_files(Transaction::Transaction transaction, const SporeMod::Xml::InstalledSporeMod* previousSporeMod, 
+                               const SporeMod::Xml::InstalledSporeMod& installedSporeMod,
+                               const std::vector<SporeMod::Xml::InstalledSporeMod>& installedSporeMods)
+{
+    std::filesystem::path installPath;
+
+    if (previousSporeMod == nullptr)
+    {
+        return true;
+    }
+
+    for (const auto& previousFile : previousSporeMod->InstalledFiles)
+    {
+        auto predicate = [previousFile](const SporeMod::Xml::SporeModFile& file)
+        {
+            return is_same_file(previousFile, file);
+        };
+        if (std::find_if(installedSporeMod.InstalledFiles.begin(), installedSporeMod.InstalledFiles.end(), predicate) != 
+                installedSporeMod.InstalledFiles.end())
+        {
+            continue;
+        }
+
+        // another mod still uses the file
+        if (has_enabled_owner(get_other_owners(installedSporeMods, { installedSporeMod.UniqueName }, previousFile)))
+        {
+            continue;
+        }
+
+        installPath = Path::GetFullInstallPath(previousFile.InstallLocation, previousFile.FileName);
+        if (UI::GetVerboseMode())
+        {
+            std::cout << "--> Removing " << installPath << std::endl;
+        }
+        if (!Transaction::RemoveFile(transaction, installPath))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void update_store_references(const SporeMod::Xml::InstalledSporeMod* previousSporeMod,
+                                    const SporeMod::Xml::InstalledSporeMod& installedSporeMod,
+                                    const std::vector<std::string>& storedHashes)
+{
+    std::vector<std::string> referencedHashes;
+    std::vector<std::string> releasedHashes;
+    bool isSameStore = previousSporeMod != nullptr && previousSporeMod->StorePath == installedSporeMod.StorePath;
+
+    // the stored files have been referenced when storing them,
+    // the files which are kept by an update move the reference
+    // of the previous mod over, so they have to be referenced
+    // before the references of the previous mod are released
+    for (const auto& installedFile : installedSporeMod.InstalledFiles)
+    {
+        if (!installedFile.StoreHash.empty())
+        {
+            referencedHashes.push_back(installedFile.StoreHash);
+        }
+    }
+    for (const auto& storedHash : storedHashes)
+    {
+        auto hashIter = std::find(referencedHashes.begin(), referencedHashes.end(), storedHash);
+        if (hashIter != referencedHashes.end())
+        {
+            referencedHashes.erase(hashIter);
+        }
+    }
+
+    if (previousSporeMod != nullptr)
+    {
+        for (const auto& previousFile : previousSporeMod->InstalledFiles)
+        {
+            if (!previousFile.StoreHash.empty())
+            {
+                releasedHashes.push_back(previousFile.StoreHash);
+            }
+        }
+    }
+
+    // the files have been installed already,
+    // so failing to update the store isn't fatal
+    if (isSameStore)
+    {
+        if ((!referencedHashes.empty() || !releasedHashes.empty()) &&
+            !Store::UpdateReferences(installedSporeMod.StorePath, referencedHashes, releasedHashes))
+        {
+            std::cerr << "Warning: failed to update the references of the content store!" << std::endl;
+        }
+    }
+    else if ((!referencedHashes.empty() && !Store::UpdateReferences(installedSporeMod.StorePath, referencedHashes, {})) ||
+             (!releasedHashes.empty() && !Store::UpdateReferences(previousSporeMod->StorePath, {}, releasedHashes)))
+    {
+        std::cerr << "Warning: failed to update the references of the content store!" << std::endl;
+    }
+}
+
+static bool find_extracted_file(const std::filesystem::path& sourcePath, uint64_t size, uint32_t crc32, std::filesystem::path& extractedPath)
+{
+    uint64_t extractedSize;
+    int64_t  extractedModifiedTime;
+
+    auto extractedFileIter = l_ExtractedFiles.find({ sourcePath.string(), size, crc32 });
+    if (extractedFileIter == l_ExtractedFiles.end())
+    {
+        return false;
+    }
+
+    // the extracted file can only be used
+    // when it hasn't changed since installing it
+    const extracted_file& extractedFile = extractedFileIter->second;
+    if (!SporeMod::GetFileStat(extractedFile.InstallPath, extractedSize, extractedModifiedTime) ||
+        extractedSize != extractedFile.Size || extractedModifiedTime != extractedFile.ModifiedTime)
+    {
+        l_ExtractedFiles.erase(extractedFileIter);
+        return false;
+    }
+
+    extractedPath = extractedFile.InstallPath;
+    return true;
+}
+
+static void add_extracted_files(const SporeMod::Xml::InstalledSporeMod& installedSporeMod)
+{
+    for (const auto& installedFile : installedSporeMod.InstalledFiles)
+    {
+        if (!installedFile.HasFingerprint)
+        {
+            continue;
+        }
+
+        std::filesystem::path sourcePath  = installedFile.FullPath.empty() ? 
+                                                installedFile.FileName :
+                                                installedFile.FullPath;
+        std::filesystem::path installPath = Path::GetFullInstallPath(installedFile.InstallLocation, installedFile.FileName);
+
+        l_ExtractedFiles[{ sourcePath.string(), installedFile.Size, installedFile.Crc32 }] = 
+            { installPath, installedFile.Size, installedFile.ModifiedTime };
+    }
+}
+
+static bool check_dll_imports(const SporeMod::Xml::InstalledSporeMod& installedSporeMod, const SporeMod::Xml::InstalledSporeMod* previousSporeMod,
+                              const std::vector<staged_file>& stagedFiles)
+{
+    std::vector<DllImports::DllFile> dllFiles;
+    std::vector<std::filesystem::path> removedFileNames;
+    size_t unresolvedCount;
+
+    for (const auto& installedFile : installedSporeMod.InstalledFiles)
+    {
+        if (installedFile.InstallLocation != SporeMod::InstallLocation::ModLibs ||
+            String::Lowercase(installedFile.FileName.extension().u8string()) != ".dll")
+        {
+            continue;
+        }
+
+        // staged files are only moved into ModLibs when the transaction is
+        // committed, the other files are installed already or are shared
+        auto stagedFileIter = std::find_if(stagedFiles.begin(), stagedFiles.end(), [&](const staged_file& stagedFile)
+        {
+            return stagedFile.File == &installedFile;
+        });
+        dllFiles.push_back({ installedFile.FileName, stagedFileIter != stagedFiles.end() ?
+                                                        stagedFileIter->StagingPath :
+                                                        Path::GetFullInstallPath(installedFile.InstallLocation, installedFile.FileName) });
+    }
+
+    if (dllFiles.empty())
+    {
+        return true;
+    }
+
+    // the DLLs of the previous version are removed after committing,
+    // so they can't resolve the imports of the new version
+    if (previousSporeMod != nullptr && !previousSporeMod->IsDisabled)
+    {
+        for (const auto& installedFile : previousSporeMod->InstalledFiles)
+        {
+            if (installedFile.InstallLocation == SporeMod::InstallLocation::ModLibs)
+            {
+                removedFileNames.push_back(installedFile.FileName);
+            }
+        }
+    }
+
+    // a DLL with unresolved imports fails to load,
+    // which makes Spore fail to start, so reject it
+    DllImports::CheckImports(dllFiles, removedFileNames, unresolvedCount);
+    return unresolvedCount == 0;
+}
+
+static bool commit_transaction(Transaction::Transaction transaction, bool success, const std::vector<std::string>& storedHashes)
+{
+    // either all files of the mod are moved
+    // into place or none of them are
+    if (!success || !Transaction::Commit(transaction))
+    {
+        Transaction::Rollback(transaction);
+
+        // the files which have been added to the
+        // content store aren't used by the mod anymore
+        if (!storedHashes.empty() && !Store::UpdateReferences(Store::GetStorePath(), {}, storedHashes))
+        {
+            std::cerr << "Warning: failed to update the references of the content store!" << std::endl;
+        }
+        return false;
+    }
+
+    Transaction::End(transaction);
+    return true;
+}
+
+//
+// Exported Functions
+//
+
+void SporeMod::SetCompactPackages(bool compactPackages)
+{
+    l_CompactPackages = compactPackages;
+}
+
+void SporeMod::SetPatchPackages(bool patchPackages)
+{
+    l_PatchPackages = patchPackages;
+}
+
+bool SporeMod::GetFileStat(const std::filesystem::path& path, uint64_t& size, int64_t& modifiedTime)
+{
+    std::error_code error;
+
+    size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return false;
+    }
+
+    // the epoch of the file clock differs per platform,
+    // which is fine because we only compare against
+    // values retrieved on the same platform
+    std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(path, error);
+    if (error)
+    {
+        return false;
+    }
+
+    modifiedTime = std::chrono::duration_cast<std::chrono::microseconds>(lastWriteTime.time_since_epoch()).count();
+    return true;
+}
+
+std::filesystem::path SporeMod::GetInstalledFilePath(const Xml::InstalledSporeMod& installedSporeMod, const Xml::SporeModFile& installedFile)
+{
+    return Path::GetFullInstallPath(installedFile.InstallLocation, get_installed_file_name(installedSporeMod, installedFile));
+}
+
+SporeMod::FileState SporeMod::CheckInstalledFile(const Xml::InstalledSporeMod& installedSporeMod, const Xml::SporeModFile& installedFile, bool rehash)
+{
+    std::filesystem::path installPath = GetInstalledFilePath(installedSporeMod, installedFile);
+    std::error_code error;
+    uint64_t size;
+    int64_t  modifiedTime;
+    uint32_t crc32;
+
+    if (!std::filesystem::is_regular_file(installPath, error))
+    {
+        return FileState::Missing;
+    }
+
+    if (!installedFile.HasFingerprint)
+    {
+        return FileState::Unknown;
+    }
+
+    if (!GetFileStat(installPath, size, modifiedTime) || size != installedFile.Size)
+    {
+        return FileState::Modified;
+    }
+
+    // when rehashing, the contents decide, otherwise
+    // assume a changed modification time means it's modified
+    if (rehash)
+    {
+        if (!Hash::Crc32File(installPath, crc32) || crc32 != installedFile.Crc32)
+        {
+            return FileState::Modified;
+        }
+    }
+    else if (modifiedTime != installedFile.ModifiedTime)
+    {
+        return FileState::Modified;
+    }
+
+    return FileState::Unchanged;
+}
+
+bool SporeMod::FindInstalledMod(const std::string& uniqueName, int& installedSporeModId, 
+                                const std::vector<Xml::InstalledSporeMod>& installedSporeMods)
+{
+    Xml::InstalledSporeMod installedSporeMod;
+
+    for (size_t i = 0; i < installedSporeMods.size(); i++)
+    {
+        installedSporeMod = installedSporeMods[i];
+        if (installedSporeMod.UniqueName == uniqueName)
+        {
+            installedSporeModId = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SporeMod::RecoverInstallDirectories(void)
+{
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+
+    for (const auto installLocation : { InstallLocation::ModLibs, InstallLocation::GalacticAdventuresData, InstallLocation::CoreSporeData })
+    {
+        std::filesystem::path installPath = Path::GetFullInstallPath(installLocation, {});
+        if (!installPath.has_filename())
+        {
+            installPath = installPath.parent_path();
+        }
+
+        // files are moved into the directories of disabled
+        // and merged files as well, which are inside of it
+        std::filesystem::path disabledPath = Path::GetFullInstallPath(installLocation, SPOREMOD_DISABLED_DIRECTORY);
+        paths.push_back(installPath);
+        paths.push_back(Path::GetFullInstallPath(installLocation, SPOREMOD_MERGED_DIRECTORY));
+        paths.push_back(disabledPath);
+
+        for (auto iter = std::filesystem::directory_iterator(disabledPath, error);
+             !error && iter != std::filesystem::directory_iterator(); iter.increment(error))
+        {
+            if (iter->is_directory(error))
+            {
+                paths.push_back(iter->path());
+            }
+        }
+    }
+
+    for (const auto& path : paths)
+    {
+        if (!Transaction::Recover(path))
+        {
+            std::cerr << "Error: failed to recover " << path << "!" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SporeMod::ConfigureSporeMod(Zip::ZipFile zipFile, const Xml::SporeModInfo& sporeModInfo, 
+                                 Xml::InstalledSporeMod& installedSporeMod,
+                                 const std::vector<Xml::InstalledSporeMod> &installedSporeMods)
+{
+    Xml::SporeModInfoComponent component;
+    size_t             componentsSize;
+    std::optional<int> defaultComponentId;
+    int                componentId;
+    std::vector<int>   defaultComponentIds;
+    std::vector<int>   componentIds;
+    std::string        uiText;
+    bool               configurationRequired = false;
+    std::vector<std::filesystem::path> zipFileList;
+
+    // support for pre-modinfo.xml mods
+    if (!sporeModInfo.HasModInfoXml)
+    {
+        installedSporeMod.UniqueName = sporeModInfo.UniqueName;
+        installedSporeMod.Name       = sporeModInfo.UniqueName;
+
+        if (!Zip::GetFileList(zipFile, zipFileList))
+        {
+            std::cerr << "Error: failed to retrieve file list from zip file!" << std::endl;
+            return false;
+        }
+
+        for (const auto& path : zipFileList)
+        {
+            const std::string extension = String::Lowercase(path.extension().string());
+            if (extension == ".dll")
+            {
+                installedSporeMod.InstalledFiles.push_back({InstallLocation::ModLibs, path.filename(), path});
+            }
+            else if (extension == ".package")
+            {
+                installedSporeMod.InstalledFiles.push_back({InstallLocation::GalacticAdventuresData, path.filename(), path});
+            }
+        }
+        return true;
+    }
+
+    installedSporeMod.Name        = sporeModInfo.Name;
+    installedSporeMod.UniqueName  = sporeModInfo.UniqueName;
+    installedSporeMod.Description = sporeModInfo.Description;
+
+    configurationRequired = sporeModInfo.IsExperimental           || 
+                            sporeModInfo.RequiresGalaxyReset      ||
+                            sporeModInfo.CausesSaveDataDependency ||
+                            (sporeModInfo.HasCustomInstaller &&
+                            (!sporeModInfo.ComponentGroups.empty() ||
+                             !sporeModInfo.Components.empty()));
+
+    if (configurationRequired)
+    {
+        std::cout << "-> Configuring " << sporeModInfo.Name << std::endl;
+    }
+
+    const struct
+    {
+        bool NeedsWarn;
+        std::string Text;
+    } warningOptions[] =
+    {
+        { sporeModInfo.IsExperimental,           "--> This mod is experimental" },
+        { sporeModInfo.RequiresGalaxyReset,      "--> This mod requires a galaxy reset" },
+        { sporeModInfo.CausesSaveDataDependency, "--> This mod causes save data dependency" }
+    };
+
+    for (const auto& warnOption : warningOptions)
+    {
+        if (warnOption.NeedsWarn)
+        {
+            std::string inputText = warnOption.Text;
+            bool userAnswer = false;
+            inputText += "\n--> Are you sure you want to continue? [y/N]: ";
+            UI::AskUserInput(inputText, userAnswer, false);
+            if (!userAnswer)
+            {
+                return false;
+            }
+        }
+    }
+
+    if (sporeModInfo.HasCustomInstaller)
+    {
+        for (const auto& componentGroup : sporeModInfo.ComponentGroups)
+        {
+            std::cout << "--> " << componentGroup.Name << std::endl;
+
+            componentsSize     = componentGroup.Components.size();
+            componentId        = 0;
+            defaultComponentId = std::nullopt;
+
+            for (size_t i = 0; i < componentsSize; i++)
+            {
+                component = componentGroup.Components[i];
+                std::cout << "[" << i << "] " << component.Name << std::endl;
+
+                // set default checked component id
+                if (component.DefaultChecked &&
+                    !defaultComponentId.has_value())
+                {
+                    defaultComponentId = i;
+                }
+            }
+
+            uiText = "--> select which component you want";
+            if (defaultComponentId.has_value())
+            {
+                uiText += " [";
+                uiText += std::to_string(defaultComponentId.value());
+                uiText += "]: ";
+            }
+            else
+            {
+                uiText += ": ";
+            }
+
+            UI::AskUserInput(uiText, componentId, defaultComponentId, 0, componentsSize - 1);
+
+            component = componentGroup.Components[componentId];
+
+            for (const auto& file : component.Files)
+            {
+                installedSporeMod.InstalledFiles.push_back(file);
+            }
+        }
+
+        if (!sporeModInfo.Components.empty())
+        {
+            componentsSize = sporeModInfo.Components.size();
+            defaultComponentIds.clear();
+            componentIds.clear();
+
+            for (size_t i = 0; i < componentsSize; i++)
+            {
+                component = sporeModInfo.Components[i];
+                std::cout << "[" << i << "] " << component.Name << std::endl
+                          << "  " << component.Description << std::endl;
+
+                // set default checked component ids
+                if (component.DefaultChecked)
+                {
+                    defaultComponentIds.push_back(i);
+                }
+            }
+
+            uiText = "--> select which components you want to install (comma seperated";
+            if (!defaultComponentIds.empty())
+            {
+                uiText += " or N for none) [";
+                uiText += String::Join(defaultComponentIds, ',');
+                uiText += "]: ";
+            }
+            else
+            {
+                uiText += "): ";
+            }
+
+            UI::AskUserInput(uiText, ',', componentIds, defaultComponentIds, 0, componentsSize - 1);
+
+            for (const auto& componentId : componentIds)
+            {
+                component = sporeModInfo.Components[componentId];
+
+                for (const auto& file : component.Files)
+                {
+                    installedSporeMod.InstalledFiles.push_back(file);
+                }
+            }
+        }
+    }
+
+    for (const auto& prerequisite : sporeModInfo.Prerequisites)
+    {
+        for (const auto& file : prerequisite.Files)
+        {
+            installedSporeMod.InstalledFiles.push_back(file);
+        }
+    }
+
+    for (const auto& compatFile : sporeModInfo.CompatFiles)
+    {
+        bool installFiles = true;
+
+        for (const auto& requiredFile : compatFile.RequiredFiles)
+        {
+            std::filesystem::path requiredFilePath = Path::GetFullInstallPath(requiredFile.InstallLocation, requiredFile.FileName);
+            if (!std::filesystem::is_regular_file(requiredFilePath))
+            {
+                installFiles = false;
+                break;
+            }
+        }
+
+        if (installFiles)
+        {
+            for (const auto& file : compatFile.Files)
+            {
+                installedSporeMod.InstalledFiles.push_back(file);
+            }
+        }
+    }
+
+    // retrieve the size and CRC32 of the files, so identical files
+    // of other mods can be shared, missing files are reported when
+    // installing the mod
+    for (auto& installedFile : installedSporeMod.InstalledFiles)
+    {
+        const std::filesystem::path sourcePath = installedFile.FullPath.empty() ? 
+                                                    installedFile.FileName :
+                                                    installedFile.FullPath;
+        if (!Zip::LocateFile(zipFile, sourcePath))
+        {
+            continue;
+        }
+
+        if (!Zip::GetFileInfo(zipFile, sourcePath, installedFile.Size, installedFile.Crc32))
+        {
+            return false;
+        }
+
+        std::vector<Dbpf::ResourceEntry> resourceEntries;
+        if (is_package_file(installedFile.FileName) && read_zip_package_resources(zipFile, sourcePath, resourceEntries))
+        {
+            check_resource_conflicts(installedSporeMod, installedFile, resourceEntries, installedSporeMods);
+        }
+    }
+
+    // file collision detection
+    if (check_other_mod_files(installedSporeMod, installedSporeMods))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool SporeMod::ConfigurePackage(const std::filesystem::path& path, Xml::InstalledSporeMod& installedSporeMod,
+                                const std::vector<Xml::InstalledSporeMod>& installedSporeMods)
+{
+    Xml::SporeModFile installedModFile;
+    std::error_code error;
+
+    std::string baseName = path.stem().string();
+
+    installedModFile.FileName = path.filename();
+    installedModFile.InstallLocation = InstallLocation::GalacticAdventuresData;
+    installedModFile.Size = std::filesystem::file_size(path, error);
+    if (error || !Hash::Crc32File(path, installedModFile.Crc32))
+    {
+        std::cerr << "Error: failed to read " << path << std::endl;
+        return false;
+    }
+
+    installedSporeMod.Name       = baseName;
+    installedSporeMod.UniqueName = baseName;
+    installedSporeMod.InstalledFiles.push_back(installedModFile);
+
+    std::vector<Dbpf::ResourceEntry> resourceEntries;
+    if (Dbpf::ReadIndex(path, resourceEntries))
+    {
+        check_resource_conflicts(installedSporeMod, installedModFile, resourceEntries, installedSporeMods);
+    }
+
+    // file collision detection
+    if (check_other_mod_files(installedSporeMod, installedSporeMods))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool SporeMod::InstallSporeMod(Zip::ZipFile zipFile, Xml::InstalledSporeMod& installedSporeMod,
+                               const std::vector<Xml::InstalledSporeMod>& installedSporeMods,
+                               const Xml::InstalledSporeMod* previousSporeMod)
+{
+    Transaction::Transaction transaction;
+    std::vector<staged_file> stagedFiles;
+    std::vector<Xml::SporeModFile*> patchedFiles;
+    std::filesystem::path stagingPath;
+    std::filesystem::path extractedPath;
+    std::vector<std::string> storedHashes;
+    std::string fingerprint;
+    std::string cacheKey;
+    uint64_t size;
+    uint32_t crc32;
+    bool isShared;
+    bool ret = true;
+
+    std::cout << "-> Installing " << installedSporeMod.Name << std::endl;
+
+    installedSporeMod.StorePath = Store::GetStorePath();
+
+    if (!Cache::GetCachePath().empty() && !Zip::GetFingerprint(zipFile, fingerprint))
+    {
+        return false;
+    }
+
+    if (!Transaction::Begin(transaction))
+    {
+        return false;
+    }
+
+    for (auto& installedFile : installedSporeMod.InstalledFiles)
+    {
+        std::filesystem::path sourcePath  = installedFile.FullPath.empty() ? 
+                                                installedFile.FileName :
+                                                installedFile.FullPath;
+        std::filesystem::path installPath = Path::GetFullInstallPath(installedFile.InstallLocation, installedFile.FileName);
+
+        if (!Zip::GetFileInfo(zipFile, sourcePath, size, crc32))
+        {
+            ret = false;
+            break;
+        }
+
+        if (find_unchanged_file(previousSporeMod, installedFile, size, crc32))
+        {
+            continue;
+        }
+
+        if (!find_shared_file(installedSporeMods, installedSporeMod, installedFile, size, crc32, isShared))
+        {
+            ret = false;
+            break;
+        }
+
+        if (isShared)
+        {
+            continue;
+        }
+
+        if (patch_installed_package(transaction, previousSporeMod, installedSporeMods, installedSporeMod, installedFile, size,
+                                    [&](const std::function<bool(const char*, size_t)>& function)
+                                    {
+                                        return Zip::StreamFile(zipFile, sourcePath, function);
+                                    }))
+        {
+            patchedFiles.push_back(&installedFile);
+            continue;
+        }
+
+        if (UI::GetVerboseMode())
+        {
+            std::cout << "--> Installing " << installedFile.FileName  << " to " << installPath << std::endl;
+        }
+
+        if (!Transaction::StageFile(transaction, installPath, stagingPath))
+        {
+            ret = false;
+            break;
+        }
+
+        // the same file may have been extracted for another
+        // target already, copying it is cheaper than extracting
+        if (find_extracted_file(sourcePath, size, crc32, extractedPath))
+        {
+            if (UI::GetVerboseMode())
+            {
+                std::cout << "--> Copying " << installedFile.FileName << " from " << extractedPath << std::endl;
+            }
+
+            if (!FileLink::CloneFile(extractedPath, stagingPath))
+            {
+                ret = false;
+                break;
+            }
+            stagedFiles.push_back({ &installedFile, stagingPath, crc32, {} });
+            continue;
+        }
+
+        cacheKey = fingerprint.empty() ? "" : Cache::GetKey(fingerprint, sourcePath, size, crc32);
+        if (!cacheKey.empty() && Cache::GetFile(cacheKey, stagingPath))
+        {
+            if (UI::GetVerboseMode())
+            {
+                std::cout << "--> Using cached " << installedFile.FileName << std::endl;
+            }
+            stagedFiles.push_back({ &installedFile, stagingPath, crc32, {} });
+            continue;
+        }
+
+        // the staged file replaces the installed file on commit,
+        // so ensure it's on disk before that happens
+        if (!Zip::ExtractFile(zipFile, sourcePath, stagingPath, true))
+        {
+            std::cerr << "Error: failed to extract file from zip file!" << std::endl;
+            ret = false;
+            break;
+        }
+
+        stagedFiles.push_back({ &installedFile, stagingPath, crc32, cacheKey });
+    }
+
+    // the staged files are written asynchronously,
+    // so wait for them before the fingerprints can be
+    // retrieved or the transaction can be committed
+    if (!AsyncIO::Wait())
+    {
+        std::cerr << "Error: failed to extract file from zip file!" << std::endl;
+        ret = false;
+    }
+
+    for (size_t i = 0; ret && i < stagedFiles.size(); i++)
+    {
+        // the cache is only an optimization,
+        // so failing to add a file isn't fatal
+        if (!stagedFiles[i].CacheKey.empty() && !Cache::AddFile(stagedFiles[i].CacheKey, stagedFiles[i].StagingPath))
+        {
+            std::cerr << "Warning: failed to add " << stagedFiles[i].File->FileName << " to the cache!" << std::endl;
+        }
+
+        // the compacted package is a new file, so
+        // a staged file linked to the cache isn't changed
+        bool isCompacted;
+        ret = compact_staged_package(*stagedFiles[i].File, stagedFiles[i].StagingPath, stagedFiles[i].StagingPath,
+                                     stagedFiles[i].Crc32, isCompacted);
+
+        // replace the staged file with a link to the content store
+        if (ret && !installedSporeMod.StorePath.empty())
+        {
+            ret = Store::StoreFile(stagedFiles[i].StagingPath, true, stagedFiles[i].StagingPath, stagedFiles[i].File->StoreHash);
+            if (ret)
+            {
+                storedHashes.push_back(stagedFiles[i].File->StoreHash);
+            }
+        }
+        ret = ret && set_file_fingerprint(*stagedFiles[i].File, stagedFiles[i].StagingPath, stagedFiles[i].Crc32);
+    }
+
+    if (!ret || !check_dll_imports(installedSporeMod, previousSporeMod, stagedFiles))
+    {
+        return commit_transaction(transaction, false, storedHashes);
+    }
+
+    if (!commit_transaction(transaction, remove_stale_files(transaction, previousSporeMod, installedSporeMod, installedSporeMods), storedHashes))
+    {
+        return false;
+    }
+
+    update_store_references(previousSporeMod, installedSporeMod, storedHashes);
+    add_extracted_files(installedSporeMod);
+    return set_patched_fingerprints(patchedFiles);
+}
+
+bool SporeMod::UninstallSporeMods(const std::vector<const Xml::InstalledSporeMod*>& removedSporeMods,
+                                  const std::vector<Xml::InstalledSporeMod>& installedSporeMods)
+{
+    struct install_root
+    {
+        std::filesystem::path Path;
+#ifndef _WIN32
+        int DirectoryFd = -1;
+#endif // _WIN32
+    };
+    struct root_file
+    {
+        install_root*         Root;
+        std::filesystem::path FileName;
+    };
+
+    std::map<InstallLocation, install_root> installRoots;
+    std::vector<root_file>   rootFiles;
+    std::vector<std::string> removedUniqueNames;
+    std::vector<std::string> errors;
+    std::mutex mutex;
+    std::error_code error;
+    bool       ret = true;
+
+    for (const auto& removedSporeMod : removedSporeMods)
+    {
+        removedUniqueNames.push_back(removedSporeMod->UniqueName);
+    }
+
+    // group the files by install location, so
+    // every directory only has to be opened once
+    for (const auto& installedSporeMod : removedSporeMods)
     {
-        for (const auto& componentGroup : sporeModInfo.ComponentGroups)
+        for (const auto& installedFile : installedSporeMod->InstalledFiles)
         {
-            std::cout << "--> " << componentGroup.Name << std::endl;
+            install_root& installRoot = installRoots[installedFile.InstallLocation];
+            if (installRoot.Path.empty())
+            {
+                installRoot.Path = Path::GetFullInstallPath(installedFile.InstallLocation, installedFile.FileName).parent_path();
+            }
 
-            componentsSize     = componentGroup.Components.size();
-            componentId        = 0;
-            defaultComponentId = std::nullopt;
+            // the files of disabled mods are
+            // in a sub directory of the install root
+            const std::filesystem::path fileName = get_installed_file_name(*installedSporeMod, installedFile);
 
-            for (size_t i = 0; i < componentsSize; i++)
+            // shared files are kept while another mod uses them,
+            // when those mods are disabled, the file is moved
+            // to where the first of them without it expects it
+            const auto owners = get_other_owners(installedSporeMods, removedUniqueNames, installedFile);
+            if (!installedSporeMod->IsDisabled && has_enabled_owner(owners))
             {
-                component = componentGroup.Components[i];
-                std::cout << "[" << i << "] " << component.Name << std::endl;
-
-                // set default checked component id
-                if (component.DefaultChecked &&
-                    !defaultComponentId.has_value())
+                if (UI::GetVerboseMode())
                 {
-                    defaultComponentId = i;
+                    std::cout << "--> Keeping shared " << installedFile.FileName << std::endl;
                 }
+                continue;
             }
 
-            uiText = "--> select which component you want";
-            if (defaultComponentId.has_value())
+            bool isMoved = false;
+            const std::filesystem::path installPath = Path::Combine({ installRoot.Path, fileName });
+            for (const auto& owner : owners)
             {
-                uiText += " [";
-                uiText += std::to_string(defaultComponentId.value());
-                uiText += "]: ";
+                const std::filesystem::path ownerPath = GetInstalledFilePath(*owner, installedFile);
+                if (!owner->IsDisabled || std::filesystem::exists(ownerPath, error) ||
+                    !std::filesystem::exists(installPath, error))
+                {
+                    continue;
+                }
+
+                if (UI::GetVerboseMode())
+                {
+                    std::cout << "--> Moving " << installPath << " to " << ownerPath << std::endl;
+                }
+
+                std::filesystem::create_directories(ownerPath.parent_path(), error);
+                if (!error)
+                {
+                    std::filesystem::rename(installPath, ownerPath, error);
+                }
+                if (error)
+                {
+                    errors.push_back("Error: failed to move " + installPath.string() + " to " + ownerPath.string() + ": " + error.message());
+                }
+                isMoved = true;
+                break;
             }
-            else
+            if (isMoved)
             {
-                uiText += ": ";
+                continue;
             }
 
-            UI::AskUserInput(uiText, componentId, defaultComponentId, 0, componentsSize - 1);
-
-            component = componentGroup.Components[componentId];
-
-            for (const auto& file : component.Files)
+            if (UI::GetVerboseMode())
             {
-                installedSporeMod.InstalledFiles.push_back(file);
+                std::cout << "--> Removing " << Path::Combine({ installRoot.Path, fileName }) << std::endl;
             }
+
+            rootFiles.push_back({ &installRoot, fileName });
         }
+    }
 
-        if (!sporeModInfo.Components.empty())
+#ifndef _WIN32
+    for (auto& installRoot : installRoots)
+    {
+        installRoot.second.DirectoryFd = open(installRoot.second.Path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (installRoot.second.DirectoryFd == -1)
         {
-            componentsSize = sporeModInfo.Components.size();
-            defaultComponentIds.clear();
-            componentIds.clear();
-
-            for (size_t i = 0; i < componentsSize; i++)
-            {
-                component = sporeModInfo.Components[i];
-                std::cout << "[" << i << "] " << component.Name << std::endl
-                          << "  " << component.Description << std::endl;
+            std::cerr << "Error: failed to open " << installRoot.second.Path << ": " << std::strerror(errno) << std::endl;
+            ret = false;
+        }
+    }
+#endif // _WIN32
 
-                // set default checked component ids
-                if (component.DefaultChecked)
-                {
-                    defaultComponentIds.push_back(i);
-                }
-            }
+    if (ret)
+    {
+        Thread::ParallelFor(rootFiles.size(), [&](size_t index)
+        {
+            const root_file& rootFile = rootFiles[index];
+            std::string errorMessage;
 
-            uiText = "--> select which components you want to install (comma seperated";
-            if (!defaultComponentIds.empty())
+            // removing a file which doesn't exist isn't an error
+#ifdef _WIN32
+            std::error_code error;
+            std::filesystem::remove(Path::Combine({ rootFile.Root->Path, rootFile.FileName }), error);
+            if (error)
             {
-                uiText += " or N for none) [";
-                uiText += String::Join(defaultComponentIds, ',');
-                uiText += "]: ";
+                errorMessage = error.message();
             }
-            else
+#else
+            if (unlinkat(rootFile.Root->DirectoryFd, rootFile.FileName.c_str(), 0) == -1 && errno != ENOENT)
             {
-                uiText += "): ";
+                errorMessage = std::strerror(errno);
             }
+#endif // _WIN32
 
-            UI::AskUserInput(uiText, ',', componentIds, defaultComponentIds, 0, componentsSize - 1);
-
-            for (const auto& componentId : componentIds)
+            if (!errorMessage.empty())
             {
-                component = sporeModInfo.Components[componentId];
-
-                for (const auto& file : component.Files)
-                {
-                    installedSporeMod.InstalledFiles.push_back(file);
-                }
+                std::lock_guard<std::mutex> lock(mutex);
+                errors.push_back("Error: failed to remove " + Path::Combine({ rootFile.Root->Path, rootFile.FileName }).string() + 
+                                 ": " + errorMessage);
             }
-        }
+        });
     }
 
-    for (const auto& prerequisite : sporeModInfo.Prerequisites)
+#ifndef _WIN32
+    for (auto& installRoot : installRoots)
     {
-        for (const auto& file : prerequisite.Files)
+        if (installRoot.second.DirectoryFd != -1)
         {
-            installedSporeMod.InstalledFiles.push_back(file);
+            close(installRoot.second.DirectoryFd);
         }
     }
+#endif // _WIN32
 
-    for (const auto& compatFile : sporeModInfo.CompatFiles)
+    for (const auto& error : errors)
     {
-        bool installFiles = true;
+        std::cerr << error << std::endl;
+    }
 
-        for (const auto& requiredFile : compatFile.RequiredFiles)
+    if (!ret || !errors.empty())
+    {
+        return false;
+    }
+
+    for (const auto& installedSporeMod : removedSporeMods)
+    {
+        if (installedSporeMod->IsDisabled)
         {
-            std::filesystem::path requiredFilePath = Path::GetFullInstallPath(requiredFile.InstallLocation, requiredFile.FileName);
-            if (!std::filesystem::is_regular_file(requiredFilePath))
-            {
-                installFiles = false;
-                break;
-            }
+            remove_disabled_directories(*installedSporeMod);
         }
-
-        if (installFiles)
+        else
         {
-            for (const auto& file : compatFile.Files)
+            // only empty directories are removed
+            for (const auto& installedFile : installedSporeMod->InstalledFiles)
             {
-                installedSporeMod.InstalledFiles.push_back(file);
+                if (installedFile.IsMerged)
+                {
+                    std::filesystem::remove(Path::GetFullInstallPath(installedFile.InstallLocation, SPOREMOD_MERGED_DIRECTORY), error);
+                }
             }
         }
-    }
-
-    // file collision detection
-    if (check_other_mod_files(installedSporeMod, installedSporeMods))
-    {
-        return false;
+        update_store_references(installedSporeMod, Xml::InstalledSporeMod(), {});
     }
 
     return true;
 }
 
-bool SporeMod::ConfigurePackage(const std::filesystem::path& path, Xml::InstalledSporeMod& installedSporeMod,
-                                const std::vector<Xml::InstalledSporeMod>& installedSporeMods)
+bool SporeMod::SetSporeModEnabled(Xml::InstalledSporeMod& installedSporeMod, bool enable,
+                                  const std::vector<Xml::InstalledSporeMod>& installedSporeMods)
 {
-    Xml::SporeModFile installedModFile;
+    Xml::InstalledSporeMod disabledSporeMod = installedSporeMod;
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> movedFiles;
+    std::filesystem::path sourcePath;
+    std::filesystem::path destinationPath;
+    std::error_code error;
+    bool ret = true;
 
-    std::string baseName = path.stem().string();
+    disabledSporeMod.IsDisabled = true;
 
-    installedModFile.FileName = path.filename();
-    installedModFile.InstallLocation = InstallLocation::GalacticAdventuresData;
+    for (auto& installedFile : installedSporeMod.InstalledFiles)
+    {
+        const std::filesystem::path installPath  = Path::GetFullInstallPath(installedFile.InstallLocation, installedFile.FileName);
+        const std::filesystem::path disabledPath = GetInstalledFilePath(disabledSporeMod, installedFile);
 
-    installedSporeMod.Name       = baseName;
-    installedSporeMod.UniqueName = baseName;
-    installedSporeMod.InstalledFiles.push_back(installedModFile);
+        sourcePath      = enable ? disabledPath : installPath;
+        destinationPath = enable ? installPath : disabledPath;
 
-    // file collision detection
-    if (check_other_mod_files(installedSporeMod, installedSporeMods))
+        // shared files stay in the install location while
+        // another enabled mod uses them, otherwise a disabled
+        // mod which shares the file may have moved it
+        const auto owners = get_other_owners(installedSporeMods, { installedSporeMod.UniqueName }, installedFile);
+        if (has_enabled_owner(owners))
+        {
+            if (UI::GetVerboseMode())
+            {
+                std::cout << "--> Keeping shared " << installedFile.FileName << std::endl;
+            }
+            if (enable)
+            {
+                std::filesystem::remove(disabledPath, error);
+                installedFile.IsMerged = find_installed_file(*find_enabled_owner(owners), installedFile)->IsMerged;
+            }
+            continue;
+        }
+        for (const auto& owner : owners)
+        {
+            const std::filesystem::path ownerPath = GetInstalledFilePath(*owner, installedFile);
+            if (enable && !std::filesystem::exists(sourcePath, error) && std::filesystem::exists(ownerPath, error))
+            {
+                sourcePath = ownerPath;
+            }
+        }
+
+        // files which have been removed by
+        // the user can't be moved, so skip them
+        if (!std::filesystem::exists(sourcePath, error))
+        {
+            std::cerr << "Warning: " << sourcePath << " doesn't exist!" << std::endl;
+            continue;
+        }
+
+        // don't overwrite a file which has been
+        // placed in the install location afterwards
+        if (std::filesystem::exists(destinationPath, error))
+        {
+            std::cerr << "Error: " << destinationPath << " already exists!" << std::endl;
+            ret = false;
+            break;
+        }
+
+        if (UI::GetVerboseMode())
+        {
+            std::cout << "--> Moving " << sourcePath << " to " << destinationPath << std::endl;
+        }
+
+        // the sub directory is in the same install
+        // location, so moving a file is only a rename
+        std::filesystem::create_directories(destinationPath.parent_path(), error);
+        if (!error)
+        {
+            std::filesystem::rename(sourcePath, destinationPath, error);
+        }
+        if (error)
+        {
+            std::cerr << "Error: failed to move " << sourcePath << " to " << destinationPath << ": " << error.message() << std::endl;
+            ret = false;
+            break;
+        }
+
+        movedFiles.push_back({ sourcePath, destinationPath });
+        if (enable)
+        {
+            installedFile.IsMerged = false;
+        }
+    }
+
+    // move the files back when we've failed
+    if (!ret)
     {
-        return false;
+        for (const auto& movedFile : movedFiles)
+        {
+            std::filesystem::rename(movedFile.second, movedFile.first, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to move " << movedFile.second << " to " << movedFile.first << ": " << error.message() << std::endl;
+            }
+        }
     }
 
-    return true;
+    // the sub directories are empty when the files
+    // have been moved back into the install locations
+    if (ret == enable)
+    {
+        remove_disabled_directories(disabledSporeMod);
+    }
+
+    if (ret)
+    {
+        installedSporeMod.IsDisabled = !enable;
+    }
+
+    return ret;
 }
 
-bool SporeMod::InstallSporeMod(Zip::ZipFile zipFile, const Xml::InstalledSporeMod& installedSporeMod)
+bool SporeMod::SetPackageMerged(std::vector<Xml::InstalledSporeMod>& installedSporeMods, const Xml::SporeModFile& packageFile, bool merge)
 {
+    const std::filesystem::path installPath = Path::GetFullInstallPath(packageFile.InstallLocation, packageFile.FileName);
+    const std::filesystem::path mergedPath  = Path::Combine({ Path::GetFullInstallPath(packageFile.InstallLocation, SPOREMOD_MERGED_DIRECTORY),
+                                                              packageFile.FileName });
+    const std::filesystem::path& sourcePath      = merge ? installPath : mergedPath;
+    const std::filesystem::path& destinationPath = merge ? mergedPath : installPath;
     std::error_code error;
 
-    std::cout << "-> Installing " << installedSporeMod.Name << std::endl;
-
-    for (const auto& installedFile : installedSporeMod.InstalledFiles)
+    // packages which have been removed by the user
+    // can't be moved back, so only warn about them
+    if (!merge && !std::filesystem::exists(sourcePath, error))
     {
-        std::filesystem::path sourcePath  = installedFile.FullPath.empty() ? 
-                                                installedFile.FileName :
-                                                installedFile.FullPath;
-        std::filesystem::path installPath = Path::GetFullInstallPath(installedFile.InstallLocation, installedFile.FileName);
+        std::cerr << "Warning: " << sourcePath << " doesn't exist!" << std::endl;
+    }
+    else
+    {
+        // don't overwrite a file which has been
+        // placed in the install location afterwards
+        if (std::filesystem::exists(destinationPath, error))
+        {
+            std::cerr << "Error: " << destinationPath << " already exists!" << std::endl;
+            return false;
+        }
 
         if (UI::GetVerboseMode())
         {
-            std::cout << "--> Installing " << installedFile.FileName  << " to " << installPath << std::endl;
+            std::cout << "--> Moving " << sourcePath << " to " << destinationPath << std::endl;
         }
 
-        if (!Zip::ExtractFile(zipFile, sourcePath, installPath))
+        std::filesystem::create_directories(destinationPath.parent_path(), error);
+        if (!error)
         {
-            std::cerr << "Error: failed to extract file from zip file!" << std::endl;
-            // cleanup installed files that were left over
-            for (const auto& installedFileToRemove : installedSporeMod.InstalledFiles)
+            std::filesystem::rename(sourcePath, destinationPath, error);
+        }
+        if (error)
+        {
+            std::cerr << "Error: failed to move " << sourcePath << " to " << destinationPath << ": " << error.message() << std::endl;
+            return false;
+        }
+    }
+
+    // only empty directories are removed
+    if (!merge)
+    {
+        std::filesystem::remove(mergedPath.parent_path(), error);
+    }
+
+    // enabled mods which share the package use
+    // the same file, so it's merged for all of them
+    for (auto& installedSporeMod : installedSporeMods)
+    {
+        if (installedSporeMod.IsDisabled)
+        {
+            continue;
+        }
+
+        for (auto& installedFile : installedSporeMod.InstalledFiles)
+        {
+            if (is_same_file(installedFile, packageFile))
             {
-                installPath = Path::GetFullInstallPath(installedFileToRemove.InstallLocation, installedFileToRemove.FileName);
-                if (std::filesystem::is_regular_file(installPath))
-                {
-                    if (UI::GetVerboseMode())
-                    {
-                        std::cout << "--> Removing " << installPath << std::endl;
-                    }
-                    std::filesystem::remove(installPath, error);
-                    if (error)
-                    {
-                        std::cerr << "Error: failed to remove " << installPath << ": " << error.message() << std::endl;
-                    }
-                }
+                installedFile.IsMerged = merge;
             }
-            return false;
         }
     }
 
     return true;
 }
 
-bool SporeMod::InstallPackage(const std::filesystem::path& path, const Xml::InstalledSporeMod& installedSporeMod)
+bool SporeMod::InstallPackage(const std::filesystem::path& path, Xml::InstalledSporeMod& installedSporeMod,
+                              const std::vector<Xml::InstalledSporeMod>& installedSporeMods,
+                              const Xml::InstalledSporeMod* previousSporeMod)
 {
+    Transaction::Transaction transaction;
+    std::vector<Xml::SporeModFile*> patchedFiles;
+    std::vector<std::string> storedHashes;
+    std::filesystem::path stagingPath;
     std::error_code error;
+    uint64_t size;
+    uint32_t crc32;
+    bool isShared;
 
     std::cout << "-> Installing " << installedSporeMod.Name << std::endl;
-    
-    for (const auto& installedFile : installedSporeMod.InstalledFiles)
+
+    installedSporeMod.StorePath = Store::GetStorePath();
+
+    size = std::filesystem::file_size(path, error);
+    if (error)
     {
+        std::cerr << "Error: failed to retrieve file size of " << path << ": " << error.message() << std::endl;
+        return false;
+    }
 
+    if (!Hash::Crc32File(path, crc32) || !Transaction::Begin(transaction))
+    {
+        return false;
+    }
+    
+    for (auto& installedFile : installedSporeMod.InstalledFiles)
+    {
         const std::filesystem::path& sourcePath  = path;
         const std::filesystem::path& installPath = Path::GetFullInstallPath(installedFile.InstallLocation, installedFile.FileName);
 
+        if (find_unchanged_file(previousSporeMod, installedFile, size, crc32))
+        {
+            continue;
+        }
+
+        if (!find_shared_file(installedSporeMods, installedSporeMod, installedFile, size, crc32, isShared))
+        {
+            return commit_transaction(transaction, false, storedHashes);
+        }
+
+        if (isShared)
+        {
+            continue;
+        }
+
+        if (patch_installed_package(transaction, previousSporeMod, installedSporeMods, installedSporeMod, installedFile, size,
+                                    [&](const std::function<bool(const char*, size_t)>& function)
+                                    {
+                                        return stream_file(sourcePath, function);
+                                    }))
+        {
+            patchedFiles.push_back(&installedFile);
+            continue;
+        }
+
         if (UI::GetVerboseMode())
         {
             std::cout << "--> Installing " << installedFile.FileName << " to " << installPath << std::endl;
         }
 
-        // mingw doesn't respect copy_options::overwrite_existing in
-        // std::filesystem::copy_file(), so just delete the target file
-        // first before trying to copy the package file over
-#ifdef __MINGW32__
-        std::filesystem::remove(installPath, error);
-        if (error)
+        if (!Transaction::StageFile(transaction, installPath, stagingPath))
         {
-            std::cerr << "Error: failed to remove " << installPath << ": " << error.message() << std::endl;
-            return false;
+            return commit_transaction(transaction, false, storedHashes);
         }
-#endif
 
-        std::filesystem::copy_file(sourcePath, installPath, std::filesystem::copy_options::overwrite_existing, error);
-        if (error)
+        // a compacted package is written to the staging path,
+        // so it has to be moved into the content store instead
+        uint32_t fileCrc32 = crc32;
+        bool     isCompacted;
+        if (!compact_staged_package(installedFile, sourcePath, stagingPath, fileCrc32, isCompacted))
         {
-            std::cerr << "Error: failed to copy " << sourcePath << " to " << installPath << ": " << error.message() << std::endl;
-            return false;
+            return commit_transaction(transaction, false, storedHashes);
+        }
+
+        if (isCompacted)
+        {
+            if (!installedSporeMod.StorePath.empty() && !Store::StoreFile(stagingPath, true, stagingPath, installedFile.StoreHash))
+            {
+                return commit_transaction(transaction, false, storedHashes);
+            }
+        }
+        else if (installedSporeMod.StorePath.empty() ?
+                    !FileLink::LinkFile(sourcePath, stagingPath) :
+                    !Store::StoreFile(sourcePath, false, stagingPath, installedFile.StoreHash))
+        {
+            return commit_transaction(transaction, false, storedHashes);
+        }
+
+        if (!installedFile.StoreHash.empty())
+        {
+            storedHashes.push_back(installedFile.StoreHash);
+        }
+
+        if (!set_file_fingerprint(installedFile, stagingPath, fileCrc32))
+        {
+            return commit_transaction(transaction, false, storedHashes);
         }
     }
 
-    return true;
-}
+    if (!commit_transaction(transaction, remove_stale_files(transaction, previousSporeMod, installedSporeMod, installedSporeMods), storedHashes))
+    {
+        return false;
+    }
 
+    update_store_references(previousSporeMod, installedSporeMod, storedHashes);
+    return set_patched_fingerprints(patchedFiles);
+}
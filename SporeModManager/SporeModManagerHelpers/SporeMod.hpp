@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <cstdint>
 
 #include "SporeModXml.hpp"
 #include "Zip.hpp"
@@ -21,12 +22,55 @@ namespace SporeModManagerHelpers
 {
     namespace SporeMod
     {
+        enum class FileState
+        {
+            Unchanged = 0,
+            Modified  = 1,
+            Missing   = 2,
+            Unknown   = 3
+        };
+
+        /// <summary>
+        ///     Sets whether packages are compacted while installing them
+        /// </summary>
+        void SetCompactPackages(bool compactPackages);
+
+        /// <summary>
+        ///     Sets whether installed packages are patched in place when updating
+        ///     mods, so only the resources which have changed are written
+        /// </summary>
+        void SetPatchPackages(bool patchPackages);
+
+        /// <summary>
+        ///     Retrieves the size and modification time of path
+        /// </summary>
+        bool GetFileStat(const std::filesystem::path& path, uint64_t& size, int64_t& modifiedTime);
+
+        /// <summary>
+        ///     Returns full path to the installed file of the installed mod,
+        ///     which differs from the install path when the mod is disabled
+        ///     or when the file has been merged
+        /// </summary>
+        std::filesystem::path GetInstalledFilePath(const Xml::InstalledSporeMod& installedSporeMod, const Xml::SporeModFile& installedFile);
+
+        /// <summary>
+        ///     Compares the installed file against its fingerprint,
+        ///     when rehash is true, the CRC32 of the file is compared as well
+        /// </summary>
+        FileState CheckInstalledFile(const Xml::InstalledSporeMod& installedSporeMod, const Xml::SporeModFile& installedFile, bool rehash);
+
         /// <summary>
         ///     Tries to find installed mod with uniqueName
         /// </summary>
         bool FindInstalledMod(const std::string& uniqueName, int& installedSporeModId, 
                               const std::vector<Xml::InstalledSporeMod>& installedSporeMods);
 
+        /// <summary>
+        ///     Rolls back the installs which were interrupted while their
+        ///     files were being moved into the install directories
+        /// </summary>
+        bool RecoverInstallDirectories(void);
+
         /// <summary>
         ///     Configures sporemod file
         /// </summary>
@@ -41,14 +85,43 @@ namespace SporeModManagerHelpers
                               const std::vector<Xml::InstalledSporeMod>& installedSporeMods);
 
         /// <summary>
-        ///     Installs sporemod file
+        ///     Installs sporemod file, when previousSporeMod is given,
+        ///     unchanged files are skipped and removed files are deleted,
+        ///     identical files of other installed mods are shared
+        /// </summary>
+        bool InstallSporeMod(Zip::ZipFile zipFile, Xml::InstalledSporeMod& installedSporeMod,
+                             const std::vector<Xml::InstalledSporeMod>& installedSporeMods,
+                             const Xml::InstalledSporeMod* previousSporeMod = nullptr);
+
+        /// <summary>
+        ///    Removes the installed files of the given mods, files are grouped
+        ///    by install location and removed in parallel, files which
+        ///    are shared with other installed mods are kept
+        /// </summary>
+        bool UninstallSporeMods(const std::vector<const Xml::InstalledSporeMod*>& removedSporeMods,
+                                const std::vector<Xml::InstalledSporeMod>& installedSporeMods);
+
+        /// <summary>
+        ///     Enables or disables installed mod by moving its files,
+        ///     disabled files are moved into a directory the game doesn't load
+        /// </summary>
+        bool SetSporeModEnabled(Xml::InstalledSporeMod& installedSporeMod, bool enable,
+                                const std::vector<Xml::InstalledSporeMod>& installedSporeMods);
+
+        /// <summary>
+        ///     Moves the installed package into or out of the directory with merged
+        ///     packages, which the game doesn't load, for every enabled mod which has it
         /// </summary>
-        bool InstallSporeMod(Zip::ZipFile zipFile, const Xml::InstalledSporeMod& installedSporeMod);
+        bool SetPackageMerged(std::vector<Xml::InstalledSporeMod>& installedSporeMods, const Xml::SporeModFile& packageFile, bool merge);
 
         /// <summary>
-        ///    Installs package file
+        ///    Installs package file, when previousSporeMod is given,
+        ///    unchanged files are skipped and removed files are deleted,
+        ///    identical files of other installed mods are shared
         /// </summary>
-        bool InstallPackage(const std::filesystem::path& path, const Xml::InstalledSporeMod& installedSporeMod);
+        bool InstallPackage(const std::filesystem::path& path, Xml::InstalledSporeMod& installedSporeMod,
+                            const std::vector<Xml::InstalledSporeMod>& installedSporeMods,
+                            const Xml::InstalledSporeMod* previousSporeMod = nullptr);
     }
 }
 
@@ -14,6 +14,9 @@
 #include <tinyxml2.h>
 #include <algorithm>
 #include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
 
 using namespace SporeModManagerHelpers;
 
@@ -248,6 +251,21 @@ static std::vector<SporeMod::Xml::SporeModFile> parse_installedsporemodfiles_ele
             sporeModFile.FileName        = get_element_text(find_element(xmlElement, "FileName"));
             sporeModFile.InstallLocation = parse_install_location(get_element_text(find_element(xmlElement, "InstallLocation")), true);
 
+            // older configuration files don't have a fingerprint
+            tinyxml2::XMLElement* sizeXmlElement         = find_element(xmlElement, "Size");
+            tinyxml2::XMLElement* modifiedTimeXmlElement = find_element(xmlElement, "ModifiedTime");
+            tinyxml2::XMLElement* crc32XmlElement        = find_element(xmlElement, "Crc32");
+            if (sizeXmlElement != nullptr && modifiedTimeXmlElement != nullptr && crc32XmlElement != nullptr)
+            {
+                sporeModFile.HasFingerprint = true;
+                sporeModFile.Size           = std::strtoull(get_element_text(sizeXmlElement).c_str(), nullptr, 10);
+                sporeModFile.ModifiedTime   = std::strtoll(get_element_text(modifiedTimeXmlElement).c_str(), nullptr, 10);
+                sporeModFile.Crc32          = static_cast<uint32_t>(std::strtoul(get_element_text(crc32XmlElement).c_str(), nullptr, 16));
+            }
+
+            sporeModFile.StoreHash = get_element_text(find_element(xmlElement, "StoreHash"));
+            sporeModFile.IsMerged  = get_element_text(find_element(xmlElement, "Merged")) == "true";
+
             sporeModFiles.push_back(sporeModFile);
         }
 
@@ -264,11 +282,121 @@ static SporeMod::Xml::InstalledSporeMod parse_installedsporemod_element(tinyxml2
     installedSporeMod.Name           = get_element_text(find_element(element, "Name"));
     installedSporeMod.UniqueName     = get_element_text(find_element(element, "UniqueName"));
     installedSporeMod.Description    = get_element_text(find_element(element, "Description"));
+    installedSporeMod.StorePath      = get_element_text(find_element(element, "StorePath"));
+    installedSporeMod.IsDisabled     = get_element_text(find_element(element, "Disabled")) == "true";
     installedSporeMod.InstalledFiles = parse_installedsporemodfiles_element(find_element(element, "Files"));
 
     return installedSporeMod;
 }
 
+static void insert_installedsporemod_element(tinyxml2::XMLElement* element, const SporeMod::Xml::InstalledSporeMod& installedSporeMod)
+{
+    tinyxml2::XMLElement* xmlElement;
+    tinyxml2::XMLElement* filesXmlElement;
+    tinyxml2::XMLElement* installedModFileElement;
+
+    xmlElement = element->InsertNewChildElement("InstalledSporeMod");
+    xmlElement->InsertNewChildElement("Name")->SetText(installedSporeMod.Name.c_str());
+    xmlElement->InsertNewChildElement("UniqueName")->SetText(installedSporeMod.UniqueName.c_str());
+    xmlElement->InsertNewChildElement("Description")->SetText(installedSporeMod.Description.c_str());
+    if (!installedSporeMod.StorePath.empty())
+    {
+        xmlElement->InsertNewChildElement("StorePath")->SetText(installedSporeMod.StorePath.string().c_str());
+    }
+    if (installedSporeMod.IsDisabled)
+    {
+        xmlElement->InsertNewChildElement("Disabled")->SetText("true");
+    }
+
+    filesXmlElement = xmlElement->InsertNewChildElement("Files");
+
+    for (const auto& installedFile : installedSporeMod.InstalledFiles)
+    {
+        std::string fileName = installedFile.FileName.string();
+        std::string installLocation = install_location_to_string(installedFile.InstallLocation);
+
+        installedModFileElement = filesXmlElement->InsertNewChildElement("InstalledModFile");
+        installedModFileElement->InsertNewChildElement("FileName")->SetText(fileName.c_str());
+        installedModFileElement->InsertNewChildElement("InstallLocation")->SetText(installLocation.c_str());
+
+        if (installedFile.HasFingerprint)
+        {
+            char crc32[9];
+            std::snprintf(crc32, sizeof(crc32), "%08x", installedFile.Crc32);
+
+            installedModFileElement->InsertNewChildElement("Size")->SetText(std::to_string(installedFile.Size).c_str());
+            installedModFileElement->InsertNewChildElement("ModifiedTime")->SetText(std::to_string(installedFile.ModifiedTime).c_str());
+            installedModFileElement->InsertNewChildElement("Crc32")->SetText(crc32);
+        }
+
+        if (!installedFile.StoreHash.empty())
+        {
+            installedModFileElement->InsertNewChildElement("StoreHash")->SetText(installedFile.StoreHash.c_str());
+        }
+
+        if (installedFile.IsMerged)
+        {
+            installedModFileElement->InsertNewChildElement("Merged")->SetText("true");
+        }
+    }
+}
+
+static SporeMod::Xml::Profile parse_profile_element(tinyxml2::XMLElement* element)
+{
+    SporeMod::Xml::Profile profile;
+    tinyxml2::XMLElement*  xmlElement;
+
+    profile.Name = get_element_text(find_element(element, "Name"));
+
+    xmlElement = find_element(element, "Mods");
+    if (xmlElement != nullptr)
+    {
+        xmlElement = xmlElement->FirstChildElement();
+        while (xmlElement != nullptr)
+        {
+            if (get_element_name(xmlElement) == "UniqueName")
+            {
+                profile.UniqueNames.push_back(get_element_text(xmlElement));
+            }
+            xmlElement = xmlElement->NextSiblingElement();
+        }
+    }
+
+    return profile;
+}
+
+static SporeMod::Xml::MergedPackage parse_mergedpackage_element(tinyxml2::XMLElement* element)
+{
+    SporeMod::Xml::MergedPackage mergedPackage;
+    tinyxml2::XMLElement*        xmlElement;
+
+    mergedPackage.FileName        = get_element_text(find_element(element, "FileName"));
+    mergedPackage.InstallLocation = parse_install_location(get_element_text(find_element(element, "InstallLocation")), true);
+
+    xmlElement = find_element(element, "Sources");
+    if (xmlElement != nullptr)
+    {
+        xmlElement = xmlElement->FirstChildElement();
+        while (xmlElement != nullptr)
+        {
+            if (get_element_name(xmlElement) == "FileName")
+            {
+                mergedPackage.SourceFileNames.push_back(get_element_text(xmlElement));
+            }
+            xmlElement = xmlElement->NextSiblingElement();
+        }
+    }
+
+    return mergedPackage;
+}
+
+static std::filesystem::path get_journal_path(void)
+{
+    std::filesystem::path journalPath = Path::GetConfigFilePath();
+    journalPath += ".journal";
+    return journalPath;
+}
+
 //
 // Exported Functions
 //
@@ -621,9 +749,6 @@ bool SporeMod::Xml::SaveInstalledModList(const std::vector<InstalledSporeMod>& i
     tinyxml2::XMLDocument xmlDocument;
     tinyxml2::XMLElement* rootXmlElement;
     tinyxml2::XMLElement* installedSporeModsElement;
-    tinyxml2::XMLElement* xmlElement;
-    tinyxml2::XMLElement* filesXmlElement;
-    tinyxml2::XMLElement* installedModFileElement;
     tinyxml2::XMLError    error;
     std::string xmlElementName;
 
@@ -651,21 +776,211 @@ bool SporeMod::Xml::SaveInstalledModList(const std::vector<InstalledSporeMod>& i
 
     for (const auto& installedSporeMod : installedSporeModList)
     {
-        xmlElement = installedSporeModsElement->InsertNewChildElement("InstalledSporeMod");
-        xmlElement->InsertNewChildElement("Name")->SetText(installedSporeMod.Name.c_str());
-        xmlElement->InsertNewChildElement("UniqueName")->SetText(installedSporeMod.UniqueName.c_str());
-        xmlElement->InsertNewChildElement("Description")->SetText(installedSporeMod.Description.c_str());
+        insert_installedsporemod_element(installedSporeModsElement, installedSporeMod);
+    }
 
-        filesXmlElement = xmlElement->InsertNewChildElement("Files");
+    xmlDocument.SaveFile(configFilePath.string().c_str());
+    return true;
+}
+
+bool SporeMod::Xml::GetProfiles(std::vector<Profile>& profiles, std::string& activeProfile)
+{
+    std::filesystem::path configFilePath;
+    tinyxml2::XMLDocument xmlDocument;
+    tinyxml2::XMLElement* xmlElement;
+    tinyxml2::XMLElement* childXmlElement;
+    tinyxml2::XMLError    error;
+    std::string xmlElementName;
+
+    configFilePath = Path::GetConfigFilePath();
+
+    if (!std::filesystem::is_regular_file(configFilePath))
+    { 
+        return true;
+    }
+
+    error = xmlDocument.LoadFile(configFilePath.string().c_str());
+    if (error != tinyxml2::XMLError::XML_SUCCESS)
+    {
+        std::cerr << "Error: failed to load XML file: " << xmlDocument.ErrorName() << std::endl;
+        return false;
+    }
+
+    xmlElement = xmlDocument.RootElement();
+    if (xmlElement == nullptr)
+    {
+        std::cerr << "Error: failed to retrieve root element from XML: " << xmlDocument.ErrorName() << std::endl;
+        return false;
+    }
+
+    xmlElement = find_element(xmlElement, "Profiles");
+    if (xmlElement == nullptr)
+    {
+        return true;
+    }
 
-        for (const auto& installedFile : installedSporeMod.InstalledFiles)
+    childXmlElement = xmlElement->FirstChildElement();
+    while (childXmlElement != nullptr)
+    {
+        xmlElementName = get_element_name(childXmlElement);
+        if (xmlElementName == "ActiveProfile")
+        {
+            activeProfile = get_element_text(childXmlElement);
+        }
+        else if (xmlElementName == "Profile")
         {
-            std::string fileName = installedFile.FileName.string();
-            std::string installLocation = install_location_to_string(installedFile.InstallLocation);
+            profiles.push_back(parse_profile_element(childXmlElement));
+        }
 
-            installedModFileElement = filesXmlElement->InsertNewChildElement("InstalledModFile");
-            installedModFileElement->InsertNewChildElement("FileName")->SetText(fileName.c_str());
-            installedModFileElement->InsertNewChildElement("InstallLocation")->SetText(installLocation.c_str());
+        childXmlElement = childXmlElement->NextSiblingElement();
+    }
+
+    return true;
+}
+
+bool SporeMod::Xml::SaveProfiles(const std::vector<Profile>& profiles, const std::string& activeProfile)
+{
+    std::filesystem::path configFilePath;
+    tinyxml2::XMLDocument xmlDocument;
+    tinyxml2::XMLElement* rootXmlElement;
+    tinyxml2::XMLElement* profilesElement;
+    tinyxml2::XMLElement* profileElement;
+    tinyxml2::XMLElement* modsElement;
+    tinyxml2::XMLError    error;
+
+    configFilePath = Path::GetConfigFilePath();
+
+    error = xmlDocument.LoadFile(configFilePath.string().c_str());
+    if (error != tinyxml2::XMLError::XML_SUCCESS)
+    {
+        std::cerr << "Error: failed to load XML file: " << xmlDocument.ErrorName() << std::endl;
+        return false;
+    }
+
+    rootXmlElement = xmlDocument.RootElement();
+
+    profilesElement = find_element(rootXmlElement, "Profiles");
+    if (profilesElement != nullptr)
+    { // element exists, so remove all children
+        profilesElement->DeleteChildren();
+    }
+    else
+    { // element doesn't exist, so insert it
+        profilesElement = rootXmlElement->InsertNewChildElement("Profiles");
+    }
+
+    if (!activeProfile.empty())
+    {
+        profilesElement->InsertNewChildElement("ActiveProfile")->SetText(activeProfile.c_str());
+    }
+
+    for (const auto& profile : profiles)
+    {
+        profileElement = profilesElement->InsertNewChildElement("Profile");
+        profileElement->InsertNewChildElement("Name")->SetText(profile.Name.c_str());
+        modsElement = profileElement->InsertNewChildElement("Mods");
+        for (const auto& uniqueName : profile.UniqueNames)
+        {
+            modsElement->InsertNewChildElement("UniqueName")->SetText(uniqueName.c_str());
+        }
+    }
+
+    xmlDocument.SaveFile(configFilePath.string().c_str());
+    return true;
+}
+
+bool SporeMod::Xml::GetMergedPackages(std::vector<MergedPackage>& mergedPackages)
+{
+    std::filesystem::path configFilePath;
+    tinyxml2::XMLDocument xmlDocument;
+    tinyxml2::XMLElement* xmlElement;
+    tinyxml2::XMLElement* childXmlElement;
+    tinyxml2::XMLError    error;
+
+    configFilePath = Path::GetConfigFilePath();
+
+    if (!std::filesystem::is_regular_file(configFilePath))
+    { 
+        return true;
+    }
+
+    error = xmlDocument.LoadFile(configFilePath.string().c_str());
+    if (error != tinyxml2::XMLError::XML_SUCCESS)
+    {
+        std::cerr << "Error: failed to load XML file: " << xmlDocument.ErrorName() << std::endl;
+        return false;
+    }
+
+    xmlElement = xmlDocument.RootElement();
+    if (xmlElement == nullptr)
+    {
+        std::cerr << "Error: failed to retrieve root element from XML: " << xmlDocument.ErrorName() << std::endl;
+        return false;
+    }
+
+    xmlElement = find_element(xmlElement, "MergedPackages");
+    if (xmlElement == nullptr)
+    {
+        return true;
+    }
+
+    childXmlElement = xmlElement->FirstChildElement();
+    while (childXmlElement != nullptr)
+    {
+        if (get_element_name(childXmlElement) == "MergedPackage")
+        {
+            mergedPackages.push_back(parse_mergedpackage_element(childXmlElement));
+        }
+
+        childXmlElement = childXmlElement->NextSiblingElement();
+    }
+
+    return true;
+}
+
+bool SporeMod::Xml::SaveMergedPackages(const std::vector<MergedPackage>& mergedPackages)
+{
+    std::filesystem::path configFilePath;
+    tinyxml2::XMLDocument xmlDocument;
+    tinyxml2::XMLElement* rootXmlElement;
+    tinyxml2::XMLElement* mergedPackagesElement;
+    tinyxml2::XMLElement* mergedPackageElement;
+    tinyxml2::XMLElement* sourcesElement;
+    tinyxml2::XMLError    error;
+
+    configFilePath = Path::GetConfigFilePath();
+
+    error = xmlDocument.LoadFile(configFilePath.string().c_str());
+    if (error != tinyxml2::XMLError::XML_SUCCESS)
+    {
+        std::cerr << "Error: failed to load XML file: " << xmlDocument.ErrorName() << std::endl;
+        return false;
+    }
+
+    rootXmlElement = xmlDocument.RootElement();
+
+    mergedPackagesElement = find_element(rootXmlElement, "MergedPackages");
+    if (mergedPackagesElement != nullptr)
+    { // element exists, so remove all children
+        mergedPackagesElement->DeleteChildren();
+    }
+    else
+    { // element doesn't exist, so insert it
+        mergedPackagesElement = rootXmlElement->InsertNewChildElement("MergedPackages");
+    }
+
+    for (const auto& mergedPackage : mergedPackages)
+    {
+        std::string fileName = mergedPackage.FileName.string();
+        std::string installLocation = install_location_to_string(mergedPackage.InstallLocation);
+
+        mergedPackageElement = mergedPackagesElement->InsertNewChildElement("MergedPackage");
+        mergedPackageElement->InsertNewChildElement("FileName")->SetText(fileName.c_str());
+        mergedPackageElement->InsertNewChildElement("InstallLocation")->SetText(installLocation.c_str());
+        sourcesElement = mergedPackageElement->InsertNewChildElement("Sources");
+        for (const auto& sourceFileName : mergedPackage.SourceFileNames)
+        {
+            sourcesElement->InsertNewChildElement("FileName")->SetText(sourceFileName.string().c_str());
         }
     }
 
@@ -673,3 +988,84 @@ bool SporeMod::Xml::SaveInstalledModList(const std::vector<InstalledSporeMod>& i
     return true;
 }
 
+bool SporeMod::Xml::AppendInstalledModJournal(const InstalledSporeMod& installedSporeMod)
+{
+    tinyxml2::XMLDocument xmlDocument;
+    tinyxml2::XMLPrinter  xmlPrinter(nullptr, true);
+    std::ofstream journalFileStream;
+    std::string   journalLine;
+
+    // every entry is a single line, newlines are escaped
+    // so the line based format stays intact
+    xmlDocument.InsertFirstChild(xmlDocument.NewElement("Journal"));
+    insert_installedsporemod_element(xmlDocument.RootElement(), installedSporeMod);
+    xmlDocument.RootElement()->FirstChildElement()->Accept(&xmlPrinter);
+    journalLine = String::Replace(xmlPrinter.CStr(), "\n", "&#10;");
+    journalLine = String::Replace(journalLine, "\r", "&#13;");
+
+    journalFileStream.open(get_journal_path(), std::ios::app | std::ios::binary);
+    if (!journalFileStream.is_open())
+    {
+        std::cerr << "Error: failed to open " << get_journal_path() << std::endl;
+        return false;
+    }
+
+    journalFileStream << journalLine << "\n";
+    journalFileStream.flush();
+    if (journalFileStream.fail())
+    {
+        std::cerr << "Error: failed to write to " << get_journal_path() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool SporeMod::Xml::GetInstalledModJournal(std::vector<InstalledSporeMod>& installedSporeModList)
+{
+    std::ifstream journalFileStream;
+    std::string   journalLine;
+
+    journalFileStream.open(get_journal_path(), std::ios::binary);
+    if (!journalFileStream.is_open())
+    {
+        return true;
+    }
+
+    while (std::getline(journalFileStream, journalLine))
+    {
+        tinyxml2::XMLDocument xmlDocument;
+        tinyxml2::XMLElement* xmlElement;
+
+        // a line which fails to parse was being written
+        // when we were interrupted, so it can be ignored
+        if (xmlDocument.Parse(journalLine.c_str(), journalLine.size()) != tinyxml2::XMLError::XML_SUCCESS)
+        {
+            continue;
+        }
+
+        xmlElement = xmlDocument.RootElement();
+        if (xmlElement == nullptr || get_element_name(xmlElement) != "InstalledSporeMod")
+        {
+            continue;
+        }
+
+        installedSporeModList.push_back(parse_installedsporemod_element(xmlElement));
+    }
+
+    return true;
+}
+
+bool SporeMod::Xml::RemoveInstalledModJournal(void)
+{
+    std::error_code error;
+
+    std::filesystem::remove(get_journal_path(), error);
+    if (error)
+    {
+        std::cerr << "Error: failed to remove " << get_journal_path() << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -11,6 +11,7 @@
 #define SPOREMODMANAGERHELPERS_SPOREMODXML_HPP
 
 #include <filesystem>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -35,6 +36,21 @@ namespace SporeModManagerHelpers
                 std::filesystem::path     FileName;
                 std::filesystem::path     FullPath;
 
+                // fingerprint of the installed file,
+                // only valid when HasFingerprint is true
+                bool     HasFingerprint = false;
+                uint64_t Size           = 0;
+                int64_t  ModifiedTime   = 0;
+                uint32_t Crc32          = 0;
+
+                // SHA-256 of the file in the content store,
+                // empty when the file isn't from the store
+                std::string StoreHash = {};
+
+                // merged packages are moved into a directory the
+                // game doesn't load, the merged package replaces them
+                bool IsMerged = false;
+
                 bool operator==(const SporeModFile& other) const
                 {
                     return InstallLocation == other.InstallLocation &&
@@ -98,6 +114,13 @@ namespace SporeModManagerHelpers
                 std::string UniqueName;
                 std::string Description;
 
+                // content store the files were installed from
+                std::filesystem::path StorePath;
+
+                // disabled mods have their files moved
+                // out of the way, so the game doesn't load them
+                bool IsDisabled = false;
+
                 std::vector<SporeModFile> InstalledFiles;
 
                 bool operator==(const InstalledSporeMod& other) const
@@ -109,6 +132,24 @@ namespace SporeModManagerHelpers
                 }
             };
 
+            struct Profile
+            {
+                std::string Name;
+
+                // unique names of the enabled mods
+                std::vector<std::string> UniqueNames;
+            };
+
+            struct MergedPackage
+            {
+                SporeMod::InstallLocation InstallLocation;
+                std::filesystem::path     FileName;
+
+                // file names of the merged packages, resources
+                // of later packages override earlier ones
+                std::vector<std::filesystem::path> SourceFileNames;
+            };
+
             /// <summary>
             ///     Parses SporeMod.xml buffer into a SporeModInfo
             /// </summary>
@@ -136,6 +177,41 @@ namespace SporeModManagerHelpers
             ///     Saves installed mod list
             /// </summary>
             bool SaveInstalledModList(const std::vector<InstalledSporeMod>& installedSporeModList);
+
+            /// <summary>
+            ///     Retrieves profiles and the name of the active profile
+            /// </summary>
+            bool GetProfiles(std::vector<Profile>& profiles, std::string& activeProfile);
+
+            /// <summary>
+            ///     Saves profiles and the name of the active profile
+            /// </summary>
+            bool SaveProfiles(const std::vector<Profile>& profiles, const std::string& activeProfile);
+
+            /// <summary>
+            ///     Retrieves merged packages
+            /// </summary>
+            bool GetMergedPackages(std::vector<MergedPackage>& mergedPackages);
+
+            /// <summary>
+            ///     Saves merged packages
+            /// </summary>
+            bool SaveMergedPackages(const std::vector<MergedPackage>& mergedPackages);
+
+            /// <summary>
+            ///     Appends installed mod to the journal next to the configuration file
+            /// </summary>
+            bool AppendInstalledModJournal(const InstalledSporeMod& installedSporeMod);
+
+            /// <summary>
+            ///     Retrieves the installed mods from the journal
+            /// </summary>
+            bool GetInstalledModJournal(std::vector<InstalledSporeMod>& installedSporeModList);
+
+            /// <summary>
+            ///     Removes the journal
+            /// </summary>
+            bool RemoveInstalledModJournal(void);
         }
     }
 }
@@ -0,0 +1,367 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Store.hpp"
+#include "FileLink.hpp"
+#include "Hash.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif // _WIN32
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define STORE_OBJECTS_DIRECTORY "objects"
+#define STORE_INDEX_FILE        "index"
+#define STORE_LOCK_FILE         "index.lock"
+
+//
+// Local Structures
+//
+
+struct store_lock
+{
+#ifdef _WIN32
+    HANDLE Handle = INVALID_HANDLE_VALUE;
+#else
+    int FileDescriptor = -1;
+#endif // _WIN32
+};
+
+//
+// Local Variables
+//
+
+static std::filesystem::path l_StorePath;
+
+//
+// Helper Functions
+//
+
+static bool lock_store(const std::filesystem::path& storePath, store_lock& lock)
+{
+    // the store can be shared by multiple
+    // SporeModManager processes, so the index
+    // and objects are only modified while locked
+    const std::filesystem::path lockPath = storePath / STORE_LOCK_FILE;
+#ifdef _WIN32
+    OVERLAPPED overlapped = { 0 };
+    lock.Handle = CreateFileW(lockPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (lock.Handle == INVALID_HANDLE_VALUE || !LockFileEx(lock.Handle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped))
+#else
+    lock.FileDescriptor = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lock.FileDescriptor == -1 || flock(lock.FileDescriptor, LOCK_EX) == -1)
+#endif // _WIN32
+    {
+        std::cerr << "Error: failed to lock " << lockPath << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static void unlock_store(store_lock& lock)
+{
+#ifdef _WIN32
+    if (lock.Handle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(lock.Handle);
+        lock.Handle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (lock.FileDescriptor != -1)
+    {
+        close(lock.FileDescriptor);
+        lock.FileDescriptor = -1;
+    }
+#endif // _WIN32
+}
+
+static std::filesystem::path get_object_path(const std::filesystem::path& storePath, const std::string& hash)
+{
+    // spread the objects over directories
+    // named after the first byte of the hash
+    return storePath / STORE_OBJECTS_DIRECTORY / hash.substr(0, 2) / hash;
+}
+
+static bool read_index(const std::filesystem::path& storePath, std::map<std::string, uint64_t>& index)
+{
+    const std::filesystem::path indexPath = storePath / STORE_INDEX_FILE;
+    std::string line;
+    std::string hash;
+    uint64_t    references;
+
+    std::ifstream indexStream(indexPath);
+    if (!indexStream.is_open())
+    {
+        // the index doesn't exist for a new store
+        return !std::filesystem::exists(indexPath);
+    }
+
+    while (std::getline(indexStream, line))
+    {
+        std::istringstream lineStream(line);
+        if (lineStream >> hash >> references)
+        {
+            index[hash] = references;
+        }
+    }
+
+    return true;
+}
+
+static bool write_index(const std::filesystem::path& storePath, const std::map<std::string, uint64_t>& index)
+{
+    const std::filesystem::path indexPath     = storePath / STORE_INDEX_FILE;
+    std::filesystem::path       tempIndexPath = indexPath;
+    std::error_code error;
+
+    tempIndexPath += ".tmp";
+
+    {
+        std::ofstream indexStream(tempIndexPath, std::ios::trunc);
+        if (!indexStream.is_open())
+        {
+            std::cerr << "Error: failed to open " << tempIndexPath << std::endl;
+            return false;
+        }
+
+        for (const auto& entry : index)
+        {
+            indexStream << entry.first << " " << entry.second << "\n";
+        }
+
+        indexStream.flush();
+        if (indexStream.fail())
+        {
+            std::cerr << "Error: failed to write " << tempIndexPath << std::endl;
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempIndexPath, indexPath, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to move " << tempIndexPath << " to " << indexPath << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool add_object(const std::filesystem::path& source, bool moveSource, const std::filesystem::path& objectPath)
+{
+    std::filesystem::path tempObjectPath = objectPath;
+    std::error_code error;
+
+    tempObjectPath += ".tmp";
+
+    std::filesystem::create_directories(objectPath.parent_path(), error);
+    if (error)
+    {
+        std::cerr << "Error: failed to create directory " << objectPath.parent_path() << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    // remove what's left from an interrupted run
+    std::filesystem::remove(tempObjectPath, error);
+
+    // moving only works on the same filesystem,
+    // so fallback to copying when it fails
+    if (moveSource)
+    {
+        std::filesystem::rename(source, tempObjectPath, error);
+    }
+    if ((!moveSource || error) && !FileLink::CloneFile(source, tempObjectPath))
+    {
+        return false;
+    }
+
+    // stored files are shared by every install,
+    // so make them read-only, this also allows
+    // FileLink::LinkFile() to use hardlinks
+    std::filesystem::permissions(tempObjectPath,
+                                 std::filesystem::perms::owner_read | std::filesystem::perms::group_read | std::filesystem::perms::others_read,
+                                 error);
+    if (!error)
+    {
+        std::filesystem::rename(tempObjectPath, objectPath, error);
+    }
+    if (error)
+    {
+        std::cerr << "Error: failed to add " << objectPath << " to store: " << error.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool remove_object(const std::filesystem::path& objectPath)
+{
+    std::error_code error;
+
+    // stored files are read-only,
+    // which prevents removal on windows
+    std::filesystem::permissions(objectPath, std::filesystem::perms::owner_write, std::filesystem::perm_options::add, error);
+    std::filesystem::remove(objectPath, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to remove " << objectPath << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+//
+// Exported Functions
+//
+
+void Store::SetStorePath(const std::filesystem::path& path)
+{
+    std::error_code error;
+
+    l_StorePath = path.empty() ? path : std::filesystem::absolute(path, error);
+}
+
+std::filesystem::path Store::GetStorePath(void)
+{
+    return l_StorePath;
+}
+
+bool Store::StoreFile(const std::filesystem::path& source, bool moveSource, const std::filesystem::path& destination, std::string& hash)
+{
+    std::map<std::string, uint64_t> index;
+    std::filesystem::path objectPath;
+    std::error_code error;
+    store_lock lock;
+    bool ret = true;
+
+    if (!Hash::Sha256File(source, hash))
+    {
+        std::cerr << "Error: failed to hash " << source << std::endl;
+        return false;
+    }
+
+    objectPath = get_object_path(l_StorePath, hash);
+
+    if (!lock_store(l_StorePath, lock))
+    {
+        unlock_store(lock);
+        return false;
+    }
+
+    if (!read_index(l_StorePath, index))
+    {
+        std::cerr << "Error: failed to read store index of " << l_StorePath << std::endl;
+        unlock_store(lock);
+        return false;
+    }
+
+    if (!std::filesystem::exists(objectPath, error))
+    {
+        ret = add_object(source, moveSource, objectPath);
+    }
+
+    if (ret && moveSource)
+    {
+        std::filesystem::remove(source, error);
+        if (error)
+        {
+            std::cerr << "Error: failed to remove " << source << ": " << error.message() << std::endl;
+            ret = false;
+        }
+    }
+
+    // another process sharing the store removes the stored file
+    // when it releases the last reference to it, so the destination
+    // is linked and referenced before the store is unlocked
+    if (ret && FileLink::LinkFile(objectPath, destination))
+    {
+        index[hash]++;
+        ret = write_index(l_StorePath, index);
+    }
+    else
+    {
+        ret = false;
+    }
+
+    unlock_store(lock);
+    return ret;
+}
+
+bool Store::UpdateReferences(const std::filesystem::path& storePath, const std::vector<std::string>& referencedHashes,
+                             const std::vector<std::string>& releasedHashes)
+{
+    std::map<std::string, uint64_t> index;
+    store_lock lock;
+    bool ret = true;
+
+    if (!lock_store(storePath, lock))
+    {
+        unlock_store(lock);
+        return false;
+    }
+
+    if (!read_index(storePath, index))
+    {
+        std::cerr << "Error: failed to read store index of " << storePath << std::endl;
+        unlock_store(lock);
+        return false;
+    }
+
+    for (const auto& hash : referencedHashes)
+    {
+        index[hash]++;
+    }
+
+    for (const auto& hash : releasedHashes)
+    {
+        auto indexIter = index.find(hash);
+        if (indexIter != index.end() && indexIter->second > 1)
+        {
+            indexIter->second--;
+            continue;
+        }
+
+        // the last reference is gone,
+        // so the stored file can be removed
+        if (indexIter != index.end())
+        {
+            index.erase(indexIter);
+        }
+        if (!remove_object(get_object_path(storePath, hash)))
+        {
+            ret = false;
+        }
+    }
+
+    if (!write_index(storePath, index))
+    {
+        ret = false;
+    }
+
+    unlock_store(lock);
+    return ret;
+}
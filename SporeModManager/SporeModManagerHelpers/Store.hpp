@@ -0,0 +1,47 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_STORE_HPP
+#define SPOREMODMANAGERHELPERS_STORE_HPP
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace SporeModManagerHelpers
+{
+    namespace Store
+    {
+        /// <summary>
+        ///     Sets the content store path for current session, an empty path disables the store
+        /// </summary>
+        void SetStorePath(const std::filesystem::path& path);
+
+        /// <summary>
+        ///     Returns the content store path, empty when the store is disabled
+        /// </summary>
+        std::filesystem::path GetStorePath(void);
+
+        /// <summary>
+        ///     Adds the contents of source to the store, when moveSource is true, source is moved
+        ///     into the store, afterwards destination is created as a link to the stored file,
+        ///     which is referenced once, UpdateReferences() has to release it when it isn't used
+        /// </summary>
+        bool StoreFile(const std::filesystem::path& source, bool moveSource, const std::filesystem::path& destination, std::string& hash);
+
+        /// <summary>
+        ///     Adds a reference for every hash in referencedHashes and releases one for
+        ///     every hash in releasedHashes, stored files without references are removed
+        /// </summary>
+        bool UpdateReferences(const std::filesystem::path& storePath, const std::vector<std::string>& referencedHashes,
+                              const std::vector<std::string>& releasedHashes);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_STORE_HPP
@@ -0,0 +1,85 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Thread.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+// std::thread and std::mutex are used throughout SporeModManager,
+// which mingw only supports with the posix thread model
+#if defined(__MINGW32__) && !defined(_GLIBCXX_HAS_GTHREADS)
+#error "mingw has to use the posix thread model"
+#endif
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define THREAD_MAX_COUNT 8
+
+//
+// Exported Functions
+//
+
+unsigned int Thread::GetThreadCount(void)
+{
+    unsigned int threadCount = std::thread::hardware_concurrency();
+    return std::clamp<unsigned int>(threadCount, 1, THREAD_MAX_COUNT);
+}
+
+void Thread::ParallelFor(size_t count, const std::function<void(size_t)>& function, unsigned int threadCount)
+{
+    std::vector<std::thread> threads;
+    std::atomic<size_t>      nextIndex(0);
+
+    if (threadCount == 0)
+    {
+        threadCount = GetThreadCount();
+    }
+    threadCount = static_cast<unsigned int>(std::min<size_t>(threadCount, count));
+
+    // don't bother creating threads
+    // when there's nothing to parallelize
+    if (threadCount <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            function(i);
+        }
+        return;
+    }
+
+    auto worker = [&]()
+    {
+        size_t index;
+        while ((index = nextIndex.fetch_add(1)) < count)
+        {
+            function(index);
+        }
+    };
+
+    threads.reserve(threadCount - 1);
+    for (unsigned int i = 0; i < (threadCount - 1); i++)
+    {
+        threads.emplace_back(worker);
+    }
+
+    // the calling thread also does work
+    worker();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
@@ -0,0 +1,33 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_THREAD_HPP
+#define SPOREMODMANAGERHELPERS_THREAD_HPP
+
+#include <functional>
+#include <cstddef>
+
+namespace SporeModManagerHelpers
+{
+    namespace Thread
+    {
+        /// <summary>
+        ///     Returns the amount of worker threads to use
+        /// </summary>
+        unsigned int GetThreadCount(void);
+
+        /// <summary>
+        ///     Calls function for every index in [0, count) using up to threadCount threads,
+        ///     when threadCount is 0, GetThreadCount() is used
+        /// </summary>
+        void ParallelFor(size_t count, const std::function<void(size_t)>& function, unsigned int threadCount = 0);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_THREAD_HPP
@@ -0,0 +1,596 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Transaction.hpp"
+#include "UI.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace SporeModManagerHelpers;
+
+//
+// Local Defines
+//
+
+#define TRANSACTION_STAGING_DIRECTORY ".SporeModManager-staging"
+#define TRANSACTION_BACKUP_DIRECTORY  ".SporeModManager-backup"
+#define TRANSACTION_JOURNAL_FILE      "journal"
+
+//
+// Local Structures
+//
+
+struct transaction_root
+{
+    std::filesystem::path StagingPath;
+    std::filesystem::path BackupPath;
+};
+
+struct transaction_file
+{
+    std::filesystem::path InstallPath;
+    std::filesystem::path StagingPath;
+    std::filesystem::path BackupPath;
+    bool HasBackup   = false;
+    bool IsInstalled = false;
+    // files which are patched in place
+    // instead of being replaced
+    bool IsPatch   = false;
+    bool IsPatched = false;
+    uint64_t          OriginalSize = 0;
+    std::vector<char> OriginalData;
+    std::vector<char> PatchData;
+};
+
+// every file of a root is recorded in its journal before
+// committing, so an interrupted commit can be rolled back
+struct journal_entry
+{
+    char        Action = 0;
+    std::string Name;
+    uint64_t    Size = 0;
+    std::filesystem::path FileName;
+};
+
+struct transaction
+{
+    std::map<std::filesystem::path, transaction_root> Roots;
+    std::vector<transaction_file> Files;
+};
+
+//
+// Helper Functions
+//
+
+static transaction_root get_root_paths(const std::filesystem::path& rootPath)
+{
+    // the staging and backup directories are placed
+    // inside the install directory, so they're on the
+    // same filesystem and committing only requires renames
+    transaction_root root;
+    root.StagingPath = rootPath / TRANSACTION_STAGING_DIRECTORY;
+    root.BackupPath  = rootPath / TRANSACTION_BACKUP_DIRECTORY;
+    return root;
+}
+
+static bool read_file_data(const std::filesystem::path& path, size_t size, std::vector<char>& data)
+{
+    std::ifstream fileStream(path, std::ios::binary);
+    data.resize(size);
+    if (!fileStream.is_open() || !fileStream.read(data.data(), data.size()))
+    {
+        std::cerr << "Error: failed to read " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool write_file_data(const std::filesystem::path& path, const std::vector<char>& data, bool createFile)
+{
+    std::fstream fileStream(path, std::ios::binary | std::ios::out | (createFile ? std::ios::trunc : std::ios::in));
+    if (!fileStream.is_open())
+    {
+        std::cerr << "Error: failed to open " << path << std::endl;
+        return false;
+    }
+
+    fileStream.write(data.data(), data.size());
+    fileStream.flush();
+    if (fileStream.fail())
+    {
+        std::cerr << "Error: failed to write " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool read_journal(const std::filesystem::path& journalPath, std::vector<journal_entry>& journalEntries)
+{
+    std::string line;
+
+    std::ifstream journalStream(journalPath);
+    if (!journalStream.is_open())
+    {
+        return false;
+    }
+
+    while (std::getline(journalStream, line))
+    {
+        std::istringstream lineStream(line);
+        std::string fileName;
+        journal_entry journalEntry;
+
+        // the file name is last, because it may contain spaces
+        if (!(lineStream >> journalEntry.Action >> journalEntry.Name >> journalEntry.Size) ||
+            lineStream.get() != ' ' || !std::getline(lineStream, fileName) ||
+            (journalEntry.Action != 'S' && journalEntry.Action != 'R' && journalEntry.Action != 'P'))
+        {
+            return false;
+        }
+
+        journalEntry.FileName = std::filesystem::u8path(fileName);
+        if (journalEntry.FileName != journalEntry.FileName.filename() ||
+            journalEntry.Name != std::filesystem::path(journalEntry.Name).filename())
+        {
+            return false;
+        }
+        journalEntries.push_back(journalEntry);
+    }
+
+    return journalStream.eof();
+}
+
+static bool write_journal(const std::filesystem::path& journalPath, const std::vector<journal_entry>& journalEntries)
+{
+    std::filesystem::path tempJournalPath = journalPath;
+    std::error_code error;
+
+    tempJournalPath += ".tmp";
+
+    {
+        std::ofstream journalStream(tempJournalPath, std::ios::trunc);
+        if (!journalStream.is_open())
+        {
+            std::cerr << "Error: failed to open " << tempJournalPath << std::endl;
+            return false;
+        }
+
+        for (const auto& journalEntry : journalEntries)
+        {
+            journalStream << journalEntry.Action << ' ' << journalEntry.Name << ' ' << journalEntry.Size
+                          << ' ' << journalEntry.FileName.u8string() << '\n';
+        }
+
+        journalStream.flush();
+        if (journalStream.fail())
+        {
+            std::cerr << "Error: failed to write " << tempJournalPath << std::endl;
+            return false;
+        }
+    }
+
+    // the journal has to be complete before the
+    // first file is moved, so it's written at once
+    std::filesystem::rename(tempJournalPath, journalPath, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to move " << tempJournalPath << " to " << journalPath << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool remove_root_directories(const transaction_root& root)
+{
+    std::error_code error;
+
+    // the journal is removed first, an interrupted
+    // removal leaves a backup which isn't needed anymore
+    std::filesystem::remove(root.BackupPath / TRANSACTION_JOURNAL_FILE, error);
+    if (error)
+    {
+        std::cerr << "Error: failed to remove " << (root.BackupPath / TRANSACTION_JOURNAL_FILE) << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    for (const auto& path : { root.StagingPath, root.BackupPath })
+    {
+        std::filesystem::remove_all(path, error);
+        if (error)
+        {
+            std::cerr << "Error: failed to remove " << path << ": " << error.message() << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool recover_root(const std::filesystem::path& rootPath, const transaction_root& root)
+{
+    const std::filesystem::path journalPath = root.BackupPath / TRANSACTION_JOURNAL_FILE;
+    std::vector<journal_entry> journalEntries;
+    std::vector<char> data;
+    std::error_code error;
+    bool ret = true;
+
+    // without a journal, nothing has been moved yet
+    // or the transaction has ended, either way the
+    // directories only contain files which aren't needed
+    if (!std::filesystem::exists(journalPath, error))
+    {
+        return !error && remove_root_directories(root);
+    }
+
+    // the backup may contain the only copy of files,
+    // so it's kept when the journal can't be read
+    if (!read_journal(journalPath, journalEntries))
+    {
+        std::cerr << "Error: failed to read " << journalPath << std::endl;
+        return false;
+    }
+
+    std::cout << "-> Rolling back interrupted changes to " << rootPath << std::endl;
+
+    // undo the changes in reverse order, like Rollback(),
+    // the staged file is moved back, so running this again
+    // after being interrupted doesn't remove a restored file
+    for (auto journalEntryIter = journalEntries.rbegin(); journalEntryIter != journalEntries.rend(); journalEntryIter++)
+    {
+        const journal_entry&        journalEntry = *journalEntryIter;
+        const std::filesystem::path installPath  = rootPath / journalEntry.FileName;
+        const std::filesystem::path stagingPath  = root.StagingPath / journalEntry.Name;
+        const std::filesystem::path backupPath   = root.BackupPath / journalEntry.Name;
+
+        if (UI::GetVerboseMode())
+        {
+            std::cout << "--> Restoring " << installPath << std::endl;
+        }
+
+        if (journalEntry.Action == 'P')
+        {
+            if (!std::filesystem::exists(installPath, error))
+            {
+                continue;
+            }
+
+            if (std::filesystem::exists(backupPath, error) &&
+                (!read_file_data(backupPath, std::filesystem::file_size(backupPath, error), data) ||
+                 !write_file_data(installPath, data, false)))
+            {
+                ret = false;
+                continue;
+            }
+
+            std::filesystem::resize_file(installPath, journalEntry.Size, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to restore " << installPath << ": " << error.message() << std::endl;
+                ret = false;
+            }
+            continue;
+        }
+
+        if (journalEntry.Action == 'S' && !std::filesystem::exists(stagingPath, error) &&
+            std::filesystem::exists(installPath, error))
+        {
+            std::filesystem::rename(installPath, stagingPath, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to move " << installPath << " to " << stagingPath << ": " << error.message() << std::endl;
+                ret = false;
+                continue;
+            }
+        }
+
+        if (std::filesystem::exists(backupPath, error))
+        {
+            std::filesystem::rename(backupPath, installPath, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to restore " << installPath << ": " << error.message() << std::endl;
+                ret = false;
+            }
+        }
+    }
+
+    // keep the journal when a file couldn't
+    // be restored, so it can be tried again
+    return ret && remove_root_directories(root);
+}
+
+static bool get_transaction_root(transaction* transaction, const std::filesystem::path& installPath, transaction_root*& root)
+{
+    const std::filesystem::path rootPath = installPath.parent_path();
+    std::error_code error;
+
+    auto rootIter = transaction->Roots.find(rootPath);
+    if (rootIter != transaction->Roots.end())
+    {
+        root = &rootIter->second;
+        return true;
+    }
+
+    // roll back what's left over from an interrupted run
+    transaction_root newRoot = get_root_paths(rootPath);
+    if (!recover_root(rootPath, newRoot))
+    {
+        return false;
+    }
+
+    for (const auto& path : { newRoot.StagingPath, newRoot.BackupPath })
+    {
+        std::filesystem::create_directory(path, error);
+        if (error)
+        {
+            std::cerr << "Error: failed to create directory " << path << ": " << error.message() << std::endl;
+            return false;
+        }
+    }
+
+    root = &transaction->Roots.emplace(rootPath, newRoot).first->second;
+    return true;
+}
+
+static bool add_transaction_file(transaction* transaction, const std::filesystem::path& installPath, bool stageFile)
+{
+    transaction_root* root;
+    transaction_file  file;
+
+    if (!get_transaction_root(transaction, installPath, root))
+    {
+        return false;
+    }
+
+    // use the index as filename, because
+    // the same file could be staged more than once
+    const std::string fileName = std::to_string(transaction->Files.size());
+
+    file.InstallPath = installPath;
+    file.BackupPath  = root->BackupPath / fileName;
+    if (stageFile)
+    {
+        file.StagingPath = root->StagingPath / fileName;
+    }
+
+    transaction->Files.push_back(file);
+    return true;
+}
+
+static void remove_transaction_directories(transaction* transaction)
+{
+    for (const auto& root : transaction->Roots)
+    {
+        remove_root_directories(root.second);
+    }
+}
+
+static bool write_transaction_journals(transaction* transaction)
+{
+    for (const auto& root : transaction->Roots)
+    {
+        std::vector<journal_entry> journalEntries;
+
+        for (const auto& file : transaction->Files)
+        {
+            if (file.InstallPath.parent_path() != root.first)
+            {
+                continue;
+            }
+
+            journal_entry journalEntry;
+            journalEntry.Action   = file.IsPatch ? 'P' : (file.StagingPath.empty() ? 'R' : 'S');
+            journalEntry.Name     = file.BackupPath.filename().string();
+            journalEntry.Size     = file.OriginalSize;
+            journalEntry.FileName = file.InstallPath.filename();
+            journalEntries.push_back(journalEntry);
+        }
+
+        if (!write_journal(root.second.BackupPath / TRANSACTION_JOURNAL_FILE, journalEntries))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// Exported Functions
+//
+
+bool Transaction::Begin(Transaction& transaction)
+{
+    transaction = new struct transaction();
+    return true;
+}
+
+bool Transaction::StageFile(Transaction transaction, const std::filesystem::path& installPath, std::filesystem::path& stagingPath)
+{
+    struct transaction* transactionData = static_cast<struct transaction*>(transaction);
+
+    if (!add_transaction_file(transactionData, installPath, true))
+    {
+        return false;
+    }
+
+    stagingPath = transactionData->Files.back().StagingPath;
+    return true;
+}
+
+bool Transaction::RemoveFile(Transaction transaction, const std::filesystem::path& installPath)
+{
+    return add_transaction_file(static_cast<struct transaction*>(transaction), installPath, false);
+}
+
+bool Transaction::PatchFile(Transaction transaction, const std::filesystem::path& installPath, uint64_t size, const std::vector<char>& data)
+{
+    struct transaction* transactionData = static_cast<struct transaction*>(transaction);
+
+    // the original data is written to the backup
+    // directory on commit, so it can be restored
+    // after the commit has been interrupted
+    if (!add_transaction_file(transactionData, installPath, false))
+    {
+        return false;
+    }
+
+    transaction_file& file = transactionData->Files.back();
+    file.IsPatch      = true;
+    file.OriginalSize = size;
+    file.PatchData    = data;
+    return true;
+}
+
+bool Transaction::Commit(Transaction transaction)
+{
+    struct transaction* transactionData = static_cast<struct transaction*>(transaction);
+    std::error_code error;
+
+    if (!write_transaction_journals(transactionData))
+    {
+        return false;
+    }
+
+    for (auto& file : transactionData->Files)
+    {
+        // the original data is kept in memory,
+        // so the patch can be undone
+        if (file.IsPatch)
+        {
+            if (!read_file_data(file.InstallPath, file.PatchData.size(), file.OriginalData) ||
+                !write_file_data(file.BackupPath, file.OriginalData, true) ||
+                !write_file_data(file.InstallPath, file.PatchData, false))
+            {
+                return false;
+            }
+            file.IsPatched = true;
+            continue;
+        }
+
+        // move the existing file out of the way
+        if (std::filesystem::exists(file.InstallPath, error))
+        {
+            std::filesystem::rename(file.InstallPath, file.BackupPath, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to move " << file.InstallPath << " to " << file.BackupPath << ": " << error.message() << std::endl;
+                return false;
+            }
+            file.HasBackup = true;
+        }
+
+        if (!file.StagingPath.empty())
+        {
+            std::filesystem::rename(file.StagingPath, file.InstallPath, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to move " << file.StagingPath << " to " << file.InstallPath << ": " << error.message() << std::endl;
+                return false;
+            }
+            file.IsInstalled = true;
+        }
+    }
+
+    return true;
+}
+
+bool Transaction::Recover(const std::filesystem::path& path)
+{
+    std::error_code error;
+
+    // only directories which have been used
+    // for a transaction have to be recovered
+    const transaction_root root = get_root_paths(path);
+    if (!std::filesystem::exists(root.StagingPath, error) &&
+        !std::filesystem::exists(root.BackupPath, error))
+    {
+        return true;
+    }
+
+    return recover_root(path, root);
+}
+
+void Transaction::End(Transaction transaction)
+{
+    struct transaction* transactionData = static_cast<struct transaction*>(transaction);
+
+    remove_transaction_directories(transactionData);
+    delete transactionData;
+}
+
+void Transaction::Rollback(Transaction transaction)
+{
+    struct transaction* transactionData = static_cast<struct transaction*>(transaction);
+    std::error_code error;
+
+    // undo the changes in reverse order,
+    // so files which have been staged more
+    // than once are restored correctly
+    for (auto fileIter = transactionData->Files.rbegin(); fileIter != transactionData->Files.rend(); fileIter++)
+    {
+        const transaction_file& file = *fileIter;
+
+        if (file.IsPatch)
+        {
+            if (UI::GetVerboseMode())
+            {
+                std::cout << "--> Restoring " << file.InstallPath << std::endl;
+            }
+
+            if (file.IsPatched)
+            {
+                write_file_data(file.InstallPath, file.OriginalData, false);
+            }
+
+            std::filesystem::resize_file(file.InstallPath, file.OriginalSize, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to restore " << file.InstallPath << ": " << error.message() << std::endl;
+            }
+            continue;
+        }
+
+        // move the staged file back instead of removing it, so when
+        // this is interrupted, the journal still matches the files
+        if (file.IsInstalled)
+        {
+            std::filesystem::rename(file.InstallPath, file.StagingPath, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to move " << file.InstallPath << " to " << file.StagingPath << ": " << error.message() << std::endl;
+            }
+        }
+
+        if (file.HasBackup)
+        {
+            if (UI::GetVerboseMode())
+            {
+                std::cout << "--> Restoring " << file.InstallPath << std::endl;
+            }
+
+            std::filesystem::rename(file.BackupPath, file.InstallPath, error);
+            if (error)
+            {
+                std::cerr << "Error: failed to restore " << file.InstallPath << ": " << error.message() << std::endl;
+            }
+        }
+    }
+
+    remove_transaction_directories(transactionData);
+    delete transactionData;
+}
@@ -0,0 +1,71 @@
+/*
+ * SporeModLoader - https://github.com/Rosalie241/SporeModLoader
+ *  Copyright (C) 2022 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPOREMODMANAGERHELPERS_TRANSACTION_HPP
+#define SPOREMODMANAGERHELPERS_TRANSACTION_HPP
+
+#include <filesystem>
+#include <cstdint>
+#include <vector>
+
+namespace SporeModManagerHelpers
+{
+    namespace Transaction
+    {
+        typedef void* Transaction;
+
+        /// <summary>
+        ///     Begins a new transaction
+        /// </summary>
+        bool Begin(Transaction& transaction);
+
+        /// <summary>
+        ///     Retrieves the path in the staging directory next to installPath
+        ///     where the file has to be written to, it's moved to installPath on commit
+        /// </summary>
+        bool StageFile(Transaction transaction, const std::filesystem::path& installPath, std::filesystem::path& stagingPath);
+
+        /// <summary>
+        ///     Removes installPath on commit
+        /// </summary>
+        bool RemoveFile(Transaction transaction, const std::filesystem::path& installPath);
+
+        /// <summary>
+        ///     Writes data at the start of installPath on commit, installPath
+        ///     is truncated to size when the transaction is rolled back,
+        ///     which removes what has been appended to it
+        /// </summary>
+        bool PatchFile(Transaction transaction, const std::filesystem::path& installPath, uint64_t size, const std::vector<char>& data);
+
+        /// <summary>
+        ///     Moves the staged files into place, the displaced files are kept until End()
+        ///     is called, so Rollback() can restore them, or Recover() when interrupted
+        /// </summary>
+        bool Commit(Transaction transaction);
+
+        /// <summary>
+        ///     Rolls back the transaction which was interrupted while committing
+        ///     files to the directory at path and removes what's left of it
+        /// </summary>
+        bool Recover(const std::filesystem::path& path);
+
+        /// <summary>
+        ///     Ends the transaction, removing the displaced files
+        /// </summary>
+        void End(Transaction transaction);
+
+        /// <summary>
+        ///     Discards the staged files and restores
+        ///     the displaced files, ending the transaction
+        /// </summary>
+        void Rollback(Transaction transaction);
+    }
+}
+
+#endif // SPOREMODMANAGERHELPERS_TRANSACTION_HPP
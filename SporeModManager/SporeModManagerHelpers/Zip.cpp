@@ -8,10 +8,17 @@
  *  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include "Zip.hpp"
+#include "AsyncIO.hpp"
+#include "Download.hpp"
+#include "Hash.hpp"
+#include "UI.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <cstring>
 #include <map>
+#include <unordered_map>
 
 #include <unzip.h>
 
@@ -21,14 +28,55 @@ using namespace SporeModManagerHelpers;
 // Local Defines
 //
 
-#define UNZIP_READ_SIZE 67108860 /* 64 MiB */
+#define UNZIP_READ_SIZE  67108860 /* 64 MiB */
+#define UNZIP_WRITE_SIZE 4194304  /* 4 MiB */
+#define UNZIP_SKIP_SIZE  262144   /* 256 KiB */
+
+#define REMOTE_MIN_READ_AHEAD  65536   /* 64 KiB */
+#define REMOTE_MAX_READ_AHEAD  1048576 /* 1 MiB */
+#define REMOTE_EOCD_SIZE       22
+#define REMOTE_EOCD_SIGNATURE  0x06054b50
+#define REMOTE_ZIP64_LOCATOR_SIZE      20
+#define REMOTE_ZIP64_LOCATOR_SIGNATURE 0x07064b50
+#define REMOTE_ZIP64_EOCD_SIZE         56
+
+//
+// Local Structures
+//
+
+struct zip_remote_stream
+{
+    Download::RemoteFile RemoteFile = nullptr;
+    uint64_t Size     = 0;
+    uint64_t Position = 0;
+
+    // end of central directory record and the central directory,
+    // these are fetched once when opening the remote file
+    uint64_t          DirectoryOffset = 0;
+    std::vector<char> DirectoryBuffer;
+
+    // read-ahead window for local file headers and file data
+    uint64_t          WindowOffset  = 0;
+    std::vector<char> WindowBuffer;
+    uint64_t          ReadAheadSize = REMOTE_MIN_READ_AHEAD;
+};
+
+struct zip_data_stream
+{
+    zlib_filefunc64_def FileFuncs;
+    voidpf              Stream = nullptr;
+};
 
 //
 // Local Variables
 //
 
 static std::map<std::filesystem::path, std::ifstream> l_ZipFileStreams;
+static std::map<std::string, zip_remote_stream>     l_ZipRemoteStreams;
 static std::vector<char>                              l_ZipFileBuffer;
+static std::map<Zip::ZipFile, std::unordered_map<std::string, unz64_file_pos>> l_ZipFileIndexes;
+static std::map<Zip::ZipFile, std::string> l_ZipFileFingerprints;
+static std::map<Zip::ZipFile, zip_data_stream> l_ZipFileDataStreams;
 
 //
 // Local Functions
@@ -107,6 +155,354 @@ static int zlib_filefunc_testerror(voidpf /*opaque*/, voidpf /*stream*/)
     return errno;
 }
 
+static uint64_t read_le(const char* buffer, size_t size)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(buffer[i])) << (i * 8);
+    }
+    return value;
+}
+
+static bool remote_stream_read_directory(zip_remote_stream& remoteStream)
+{
+    std::vector<char> buffer;
+    uint64_t tailOffset;
+    uint64_t directoryOffset;
+    uint64_t zip64EocdOffset;
+
+    // the end of central directory record is at most
+    // 64 KiB (the maximum comment size) away from the end,
+    // also account for the zip64 end of central directory locator
+    tailOffset = remoteStream.Size - std::min<uint64_t>(remoteStream.Size, 0xFFFF + REMOTE_EOCD_SIZE + REMOTE_ZIP64_LOCATOR_SIZE);
+    if (!Download::ReadRemoteFile(remoteStream.RemoteFile, tailOffset, remoteStream.Size - tailOffset, remoteStream.DirectoryBuffer))
+    {
+        return false;
+    }
+    remoteStream.DirectoryOffset = tailOffset;
+
+    const std::vector<char>& tail = remoteStream.DirectoryBuffer;
+    for (size_t i = (tail.size() >= REMOTE_EOCD_SIZE ? (tail.size() - REMOTE_EOCD_SIZE + 1) : 0); i-- > 0;)
+    {
+        if (read_le(tail.data() + i, 4) != REMOTE_EOCD_SIGNATURE)
+        {
+            continue;
+        }
+
+        directoryOffset = read_le(tail.data() + i + 16, 4);
+
+        // zip64 stores the central directory offset
+        // in the zip64 end of central directory record
+        if (directoryOffset == 0xFFFFFFFF && i >= REMOTE_ZIP64_LOCATOR_SIZE &&
+            read_le(tail.data() + i - REMOTE_ZIP64_LOCATOR_SIZE, 4) == REMOTE_ZIP64_LOCATOR_SIGNATURE)
+        {
+            zip64EocdOffset = read_le(tail.data() + i - REMOTE_ZIP64_LOCATOR_SIZE + 8, 8);
+            if ((zip64EocdOffset + REMOTE_ZIP64_EOCD_SIZE) > remoteStream.Size ||
+                !Download::ReadRemoteFile(remoteStream.RemoteFile, zip64EocdOffset, REMOTE_ZIP64_EOCD_SIZE, buffer))
+            {
+                return false;
+            }
+            directoryOffset = read_le(buffer.data() + 48, 8);
+        }
+
+        // fetch the part of the central directory
+        // which isn't part of the tail yet
+        if (directoryOffset < tailOffset)
+        {
+            if (!Download::ReadRemoteFile(remoteStream.RemoteFile, directoryOffset, tailOffset - directoryOffset, buffer))
+            {
+                return false;
+            }
+            remoteStream.DirectoryBuffer.insert(remoteStream.DirectoryBuffer.begin(), buffer.begin(), buffer.end());
+            remoteStream.DirectoryOffset = directoryOffset;
+        }
+        break;
+    }
+
+    return true;
+}
+
+static voidpf zlib_remote_filefunc_open(voidpf /*opaque*/, const void* filename, int /*mode*/)
+{
+    const std::string url = *static_cast<const std::string*>(filename);
+
+    // if the stream is cached, ensure it's closed
+    auto iter = l_ZipRemoteStreams.find(url);
+    if (iter != l_ZipRemoteStreams.end())
+    {
+        Download::CloseRemoteFile(iter->second.RemoteFile);
+        l_ZipRemoteStreams.erase(iter);
+    }
+
+    zip_remote_stream& remoteStream = l_ZipRemoteStreams[url];
+    if (!Download::OpenRemoteFile(remoteStream.RemoteFile, url))
+    {
+        l_ZipRemoteStreams.erase(url);
+        return nullptr;
+    }
+
+    remoteStream.Size = Download::GetRemoteFileSize(remoteStream.RemoteFile);
+    if (!remote_stream_read_directory(remoteStream))
+    {
+        Download::CloseRemoteFile(remoteStream.RemoteFile);
+        l_ZipRemoteStreams.erase(url);
+        return nullptr;
+    }
+
+    return &remoteStream;
+}
+
+static uLong zlib_remote_filefunc_read(voidpf /*opaque*/, voidpf stream, void* buf, uLong size)
+{
+    zip_remote_stream* remoteStream = static_cast<zip_remote_stream*>(stream);
+    char*    outputBuffer = static_cast<char*>(buf);
+    uint64_t remaining    = std::min<uint64_t>(size, remoteStream->Size - std::min(remoteStream->Position, remoteStream->Size));
+    uint64_t bytesRead    = 0;
+    uint64_t copySize;
+    uint64_t fetchSize;
+
+    while (remaining > 0)
+    {
+        const uint64_t position  = remoteStream->Position;
+        const uint64_t windowEnd = remoteStream->WindowOffset + remoteStream->WindowBuffer.size();
+
+        if (position >= remoteStream->DirectoryOffset)
+        { // central directory
+            copySize = std::min(remaining, remoteStream->Size - position);
+            std::memcpy(outputBuffer + bytesRead, remoteStream->DirectoryBuffer.data() + (position - remoteStream->DirectoryOffset), copySize);
+        }
+        else if (position >= remoteStream->WindowOffset && position < windowEnd)
+        { // read-ahead window
+            copySize = std::min(remaining, windowEnd - position);
+            std::memcpy(outputBuffer + bytesRead, remoteStream->WindowBuffer.data() + (position - remoteStream->WindowOffset), copySize);
+        }
+        else
+        { // fetch new window, grow the read-ahead size when reading
+          // sequentially and reset it when seeking elsewhere
+            if (position == windowEnd && !remoteStream->WindowBuffer.empty())
+            {
+                remoteStream->ReadAheadSize = std::min<uint64_t>(remoteStream->ReadAheadSize * 2, REMOTE_MAX_READ_AHEAD);
+            }
+            else
+            {
+                remoteStream->ReadAheadSize = REMOTE_MIN_READ_AHEAD;
+            }
+
+            fetchSize = std::max(remaining, remoteStream->ReadAheadSize);
+            fetchSize = std::min(fetchSize, remoteStream->DirectoryOffset - position);
+            if (!Download::ReadRemoteFile(remoteStream->RemoteFile, position, fetchSize, remoteStream->WindowBuffer))
+            {
+                remoteStream->WindowBuffer.clear();
+                break;
+            }
+            remoteStream->WindowOffset = position;
+            continue;
+        }
+
+        remoteStream->Position += copySize;
+        bytesRead += copySize;
+        remaining -= copySize;
+    }
+
+    return static_cast<uLong>(bytesRead);
+}
+
+static ZPOS64_T zlib_remote_filefunc_tell(voidpf /*opaque*/, voidpf stream)
+{
+    return static_cast<zip_remote_stream*>(stream)->Position;
+}
+
+static long zlib_remote_filefunc_seek(voidpf /*opaque*/, voidpf stream, ZPOS64_T offset, int origin)
+{
+    zip_remote_stream* remoteStream = static_cast<zip_remote_stream*>(stream);
+    uint64_t position;
+
+    switch (origin)
+    {
+    default:
+        return -1;
+    case ZLIB_FILEFUNC_SEEK_CUR:
+        position = remoteStream->Position + offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_END:
+        position = remoteStream->Size + offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_SET:
+        position = offset;
+        break;
+    }
+
+    if (position > remoteStream->Size)
+    {
+        return -1;
+    }
+
+    remoteStream->Position = position;
+    return 0;
+}
+
+static int zlib_remote_filefunc_close(voidpf /*opaque*/, voidpf stream)
+{
+    zip_remote_stream* remoteStream = static_cast<zip_remote_stream*>(stream);
+
+    if (UI::GetVerboseMode())
+    {
+        std::cout << "--> Downloaded " << Download::GetRemoteFileBytesRead(remoteStream->RemoteFile)
+                  << " of " << remoteStream->Size << " bytes" << std::endl;
+    }
+
+    Download::CloseRemoteFile(remoteStream->RemoteFile);
+
+    for (auto iter = l_ZipRemoteStreams.begin(); iter != l_ZipRemoteStreams.end(); iter++)
+    {
+        if (&iter->second == remoteStream)
+        {
+            l_ZipRemoteStreams.erase(iter);
+            break;
+        }
+    }
+    return 0;
+}
+
+static std::string get_index_key(const std::string& fileName)
+{
+    std::string key = fileName;
+    // files are located case insensitively
+    for (char& c : key)
+    {
+        if (c >= 'a' && c <= 'z')
+        {
+            c = static_cast<char>(c - 'a' + 'A');
+        }
+    }
+    return key;
+}
+
+static bool locate_file(Zip::ZipFile zipFile, const std::filesystem::path& file)
+{
+    unz64_file_pos filePosition;
+    char           fileName[2048];
+    int ret = 0;
+
+    // unzLocateFile() walks the central directory every time,
+    // which is slow for zip files with thousands of files,
+    // so build an index of the central directory once
+    auto indexIter = l_ZipFileIndexes.find(zipFile);
+    if (indexIter == l_ZipFileIndexes.end())
+    {
+        std::unordered_map<std::string, unz64_file_pos>& index = l_ZipFileIndexes[zipFile];
+
+        ret = unzGoToFirstFile(zipFile);
+        while (ret == UNZ_OK)
+        {
+            if (unzGetCurrentFileInfo64(zipFile, nullptr, fileName, sizeof(fileName), nullptr, 0, nullptr, 0) == UNZ_OK &&
+                unzGetFilePos64(zipFile, &filePosition) == UNZ_OK)
+            {
+                // keep the first match, like unzLocateFile()
+                index.emplace(get_index_key(fileName), filePosition);
+            }
+            ret = unzGoToNextFile(zipFile);
+        }
+
+        indexIter = l_ZipFileIndexes.find(zipFile);
+    }
+
+    auto fileIter = indexIter->second.find(get_index_key(file.string()));
+    if (fileIter == indexIter->second.end())
+    {
+        return false;
+    }
+
+    return unzGoToFilePos64(zipFile, &fileIter->second) == UNZ_OK;
+}
+
+static bool read_stored_file(Zip::ZipFile zipFile, uint64_t offset, uint64_t size, std::vector<char>& buffer)
+{
+    int      method;
+    uint64_t dataOffset;
+    int ret;
+
+    auto dataStreamIter = l_ZipFileDataStreams.find(zipFile);
+    if (dataStreamIter == l_ZipFileDataStreams.end())
+    {
+        return false;
+    }
+
+    // opening the file raw skips the local header, which
+    // makes the stream position the start of the file data
+    ret = unzOpenCurrentFile2(zipFile, &method, nullptr, 1);
+    if (ret != UNZ_OK)
+    {
+        std::cerr << "Error: failed to open file in zip file: " << ret << std::endl;
+        return false;
+    }
+    dataOffset = unzGetCurrentFileZStreamPos64(zipFile);
+    unzCloseCurrentFile(zipFile);
+
+    // minizip seeks before every read, so
+    // sharing the stream with it is fine
+    const zip_data_stream& dataStream = dataStreamIter->second;
+    buffer.resize(size);
+    if (dataStream.FileFuncs.zseek64_file(nullptr, dataStream.Stream, dataOffset + offset, ZLIB_FILEFUNC_SEEK_SET) != 0 ||
+        dataStream.FileFuncs.zread_file(nullptr, dataStream.Stream, buffer.data(), static_cast<uLong>(size)) != size)
+    {
+        std::cerr << "Error: failed to read data from file in zip file!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool read_compressed_file(Zip::ZipFile zipFile, uint64_t offset, uint64_t size, std::vector<char>& buffer)
+{
+    std::vector<char> skipBuffer;
+    uint64_t position = 0;
+    int      bytesRead;
+
+    bytesRead = unzOpenCurrentFile(zipFile);
+    if (bytesRead != UNZ_OK)
+    {
+        std::cerr << "Error: failed to open file in zip file: " << bytesRead << std::endl;
+        return false;
+    }
+
+    // deflate streams can't be entered halfway, so inflate up
+    // to offset, but don't keep the data, only the requested
+    // range is kept, which keeps memory usage constant
+    skipBuffer.resize(static_cast<size_t>(std::min<uint64_t>(offset, UNZIP_SKIP_SIZE)));
+    while (position < offset)
+    {
+        bytesRead = unzReadCurrentFile(zipFile, skipBuffer.data(), static_cast<unsigned>(std::min<uint64_t>(offset - position, skipBuffer.size())));
+        if (bytesRead <= 0)
+        {
+            unzCloseCurrentFile(zipFile);
+            std::cerr << "Error: failed to read data from file in zip file: " << bytesRead << std::endl;
+            return false;
+        }
+        position += bytesRead;
+    }
+
+    buffer.resize(size);
+    position = 0;
+    while (position < size)
+    {
+        bytesRead = unzReadCurrentFile(zipFile, buffer.data() + position, static_cast<unsigned>(size - position));
+        if (bytesRead <= 0)
+        {
+            unzCloseCurrentFile(zipFile);
+            std::cerr << "Error: failed to read data from file in zip file: " << bytesRead << std::endl;
+            return false;
+        }
+        position += bytesRead;
+    }
+
+    // the file hasn't been read completely,
+    // so the CRC32 can't be verified here
+    unzCloseCurrentFile(zipFile);
+    return true;
+}
+
 //
 // Exported Functions
 //
@@ -128,17 +524,48 @@ bool Zip::OpenFile(ZipFile& zipFile, const std::filesystem::path& path)
     {
         std::cerr << "Error: failed to open zip file: " << path << std::endl; 
     }
+    else
+    {
+        l_ZipFileDataStreams[zipFile] = { filefuncs, &l_ZipFileStreams[path] };
+    }
+    return zipFile != nullptr;
+}
+
+bool Zip::OpenUrl(ZipFile& zipFile, const std::string& url)
+{
+    zlib_filefunc64_def filefuncs;
+    filefuncs.zopen64_file = zlib_remote_filefunc_open;
+    filefuncs.zread_file   = zlib_remote_filefunc_read;
+    filefuncs.zwrite_file  = nullptr;
+    filefuncs.ztell64_file = zlib_remote_filefunc_tell;
+    filefuncs.zseek64_file = zlib_remote_filefunc_seek;
+    filefuncs.zclose_file  = zlib_remote_filefunc_close;
+    filefuncs.zerror_file  = zlib_filefunc_testerror;
+    filefuncs.opaque       = nullptr;
+
+    zipFile = unzOpen2_64(&url, &filefuncs);
+    if (zipFile == nullptr)
+    {
+        std::cerr << "Error: failed to open zip file: " << url << std::endl;
+    }
+    else
+    {
+        l_ZipFileDataStreams[zipFile] = { filefuncs, &l_ZipRemoteStreams[url] };
+    }
     return zipFile != nullptr;
 }
 
 bool Zip::CloseFile(ZipFile zipFile)
 {
+    l_ZipFileIndexes.erase(zipFile);
+    l_ZipFileFingerprints.erase(zipFile);
+    l_ZipFileDataStreams.erase(zipFile);
     return unzClose(zipFile) == UNZ_OK;
 }
 
 bool Zip::LocateFile(ZipFile zipFile, const std::filesystem::path& file)
 {
-    return unzLocateFile(zipFile, file.string().c_str(), 2) == UNZ_OK;
+    return locate_file(zipFile, file);
 }
 
 bool Zip::GetFileList(ZipFile zipFile, std::vector<std::filesystem::path>& fileList)
@@ -155,6 +582,15 @@ bool Zip::GetFileList(ZipFile zipFile, std::vector<std::filesystem::path>& fileL
         return false;
     }
 
+    // the current file could've been changed
+    // by locating a file, so start at the first file
+    ret = unzGoToFirstFile(zipFile);
+    if (ret != UNZ_OK && zipInfo.number_entry > 0)
+    {
+        std::cerr << "Error: failed to go to first file in zip file: " << ret << std::endl;
+        return false;
+    }
+
     for (ZPOS64_T i = 0; i < zipInfo.number_entry; i++)
     {
         // skip invalid files from the file list
@@ -189,25 +625,173 @@ bool Zip::GetFileList(ZipFile zipFile, std::vector<std::filesystem::path>& fileL
     return true;
 }
 
-bool Zip::ExtractFile(ZipFile zipFile, const std::filesystem::path& file, const std::filesystem::path& outputFile)
+bool Zip::GetFileInfo(ZipFile zipFile, const std::filesystem::path& file, uint64_t& size, uint32_t& crc32)
 {
-    int bytesRead = 0;
-    std::ofstream outputFileStream;
+    unz_file_info64 zipFileInfo;
+    int ret = 0;
 
-    // ensure the global buffer has the size reserved
-    l_ZipFileBuffer.reserve(UNZIP_READ_SIZE);
+    if (!locate_file(zipFile, file))
+    {
+        std::cerr << "Error: failed to find " << file << " in zip file!" << std::endl;
+        return false;
+    }
+
+    ret = unzGetCurrentFileInfo64(zipFile, &zipFileInfo, nullptr, 0, nullptr, 0, nullptr, 0);
+    if (ret != UNZ_OK)
+    {
+        std::cerr << "Error: failed to retrieve file info from zip file: " << ret << std::endl;
+        return false;
+    }
+
+    size  = zipFileInfo.uncompressed_size;
+    crc32 = static_cast<uint32_t>(zipFileInfo.crc);
+    return true;
+}
+
+bool Zip::GetFingerprint(ZipFile zipFile, std::string& fingerprint)
+{
+    unz_file_info64 zipFileInfo;
+    char            zipFileName[2048];
+    std::string     directory;
+    int ret = 0;
+
+    auto fingerprintIter = l_ZipFileFingerprints.find(zipFile);
+    if (fingerprintIter != l_ZipFileFingerprints.end())
+    {
+        fingerprint = fingerprintIter->second;
+        return true;
+    }
+
+    // the central directory describes the name, size and CRC32
+    // of every file, so hashing it identifies the zip file
+    // without having to read the file data
+    ret = unzGoToFirstFile(zipFile);
+    while (ret == UNZ_OK)
+    {
+        ret = unzGetCurrentFileInfo64(zipFile, &zipFileInfo, zipFileName, sizeof(zipFileName), nullptr, 0, nullptr, 0);
+        if (ret != UNZ_OK)
+        {
+            break;
+        }
+
+        directory += zipFileName;
+        directory += '\0';
+        directory += std::to_string(zipFileInfo.crc) + ':' + 
+                     std::to_string(zipFileInfo.compressed_size) + ':' + 
+                     std::to_string(zipFileInfo.uncompressed_size) + '\n';
+        ret = unzGoToNextFile(zipFile);
+    }
+
+    if (ret != UNZ_END_OF_LIST_OF_FILE)
+    {
+        std::cerr << "Error: failed to read central directory of zip file: " << ret << std::endl;
+        return false;
+    }
+
+    fingerprint = Hash::Sha256(directory.data(), directory.size());
+    l_ZipFileFingerprints[zipFile] = fingerprint;
+    return true;
+}
+
+bool Zip::ReadFile(ZipFile zipFile, const std::filesystem::path& file, uint64_t offset, uint64_t size, std::vector<char>& buffer)
+{
+    unz_file_info64 zipFileInfo;
+    int ret;
+
+    if (!locate_file(zipFile, file))
+    {
+        std::cerr << "Error: failed to find " << file << " in zip file!" << std::endl;
+        return false;
+    }
+
+    ret = unzGetCurrentFileInfo64(zipFile, &zipFileInfo, nullptr, 0, nullptr, 0, nullptr, 0);
+    if (ret != UNZ_OK)
+    {
+        std::cerr << "Error: failed to retrieve file info from zip file: " << ret << std::endl;
+        return false;
+    }
+
+    if (offset > zipFileInfo.uncompressed_size || size > (zipFileInfo.uncompressed_size - offset))
+    {
+        return false;
+    }
+
+    // stored files can be read directly from the
+    // zip file, encrypted files are never stored as-is
+    if (zipFileInfo.compression_method == 0 && (zipFileInfo.flag & 1) == 0)
+    {
+        return read_stored_file(zipFile, offset, size, buffer);
+    }
+
+    return read_compressed_file(zipFile, offset, size, buffer);
+}
+
+bool Zip::StreamFile(ZipFile zipFile, const std::filesystem::path& file, const std::function<bool(const char*, size_t)>& function)
+{
+    std::vector<char> buffer(UNZIP_WRITE_SIZE);
+    int bytesRead;
+
+    if (!locate_file(zipFile, file))
+    {
+        std::cerr << "Error: failed to find " << file << " in zip file!" << std::endl;
+        return false;
+    }
+
+    bytesRead = unzOpenCurrentFile(zipFile);
+    if (bytesRead != UNZ_OK)
+    {
+        std::cerr << "Error: failed to open file in zip file: " << bytesRead << std::endl;
+        return false;
+    }
+
+    // only one buffer is kept in memory,
+    // function has to copy what it needs
+    while ((bytesRead = unzReadCurrentFile(zipFile, buffer.data(), static_cast<unsigned>(buffer.size()))) > 0)
+    {
+        if (!function(buffer.data(), static_cast<size_t>(bytesRead)))
+        {
+            unzCloseCurrentFile(zipFile);
+            return false;
+        }
+    }
+
+    if (bytesRead < 0)
+    {
+        unzCloseCurrentFile(zipFile);
+        std::cerr << "Error: failed to read data from file in zip file: " << bytesRead << std::endl;
+        return false;
+    }
+
+    // the file has been read completely,
+    // so closing it verifies the CRC32
+    bytesRead = unzCloseCurrentFile(zipFile);
+    if (bytesRead != UNZ_OK)
+    {
+        std::cerr << "Error: failed to read data from file in zip file: " << bytesRead << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool Zip::ExtractFile(ZipFile zipFile, const std::filesystem::path& file, const std::filesystem::path& outputFile, bool sync)
+{
+    unz_file_info64 zipFileInfo;
+    AsyncIO::File   asyncFile;
+    size_t bufferSize;
+    int    bytesRead = 0;
 
     // try to find file in zip
-    if (unzLocateFile(zipFile, file.string().c_str(), 2) != UNZ_OK)
+    if (!locate_file(zipFile, file))
     {
         std::cerr << "Error: failed to find " << file << " in zip file!" << std::endl;
         return false;
     }
 
-    outputFileStream.open(outputFile, std::ios::trunc | std::ios::binary);
-    if (!outputFileStream.is_open())
+    bytesRead = unzGetCurrentFileInfo64(zipFile, &zipFileInfo, nullptr, 0, nullptr, 0, nullptr, 0);
+    if (bytesRead != UNZ_OK)
     {
-        std::cerr << "Error: failed to open " << outputFile << std::endl;
+        std::cerr << "Error: failed to retrieve file info from zip file: " << bytesRead << std::endl;
         return false;
     }
 
@@ -218,24 +802,44 @@ bool Zip::ExtractFile(ZipFile zipFile, const std::filesystem::path& file, const
         return false;
     }
 
+    if (!AsyncIO::OpenFile(asyncFile, outputFile))
+    {
+        unzCloseCurrentFile(zipFile);
+        return false;
+    }
+
+    // the inflated data is handed over to the
+    // writer threads, so small files only need
+    // a buffer the size of the file
+    bufferSize = static_cast<size_t>(std::clamp<uint64_t>(zipFileInfo.uncompressed_size, 1, UNZIP_WRITE_SIZE));
+
     do
     {
-        bytesRead = unzReadCurrentFile(zipFile, l_ZipFileBuffer.data(), UNZIP_READ_SIZE);
+        std::vector<char> buffer(bufferSize);
+        bytesRead = unzReadCurrentFile(zipFile, buffer.data(), static_cast<unsigned>(buffer.size()));
         if (bytesRead < 0)
         {
+            AsyncIO::CloseFile(asyncFile, false);
             unzCloseCurrentFile(zipFile);
             std::cerr << "Error: failed to read data from file in zip file: " << bytesRead << std::endl;
             return false;
         }
         else if (bytesRead > 0)
         {
-            outputFileStream.write(l_ZipFileBuffer.data(), bytesRead);
+            buffer.resize(bytesRead);
+            AsyncIO::WriteFile(asyncFile, std::move(buffer));
         }
     } while (bytesRead > 0);
 
-    unzCloseCurrentFile(zipFile);
-    outputFileStream.flush();
-    outputFileStream.close();
+    AsyncIO::CloseFile(asyncFile, sync);
+
+    // unzCloseCurrentFile() verifies the CRC32
+    bytesRead = unzCloseCurrentFile(zipFile);
+    if (bytesRead != UNZ_OK)
+    {
+        std::cerr << "Error: failed to close file in zip file: " << bytesRead << std::endl;
+        return false;
+    }
     return true;
 }
 
@@ -247,7 +851,7 @@ bool Zip::ExtractFile(ZipFile zipFile, const std::filesystem::path& file, std::v
     l_ZipFileBuffer.reserve(UNZIP_READ_SIZE);
 
     // try to find file in zip
-    if (!file.empty() && unzLocateFile(zipFile, file.string().c_str(), 2) != UNZ_OK)
+    if (!file.empty() && !locate_file(zipFile, file))
     {
         std::cerr << "Error: failed to find " << file << " in zip file!" << std::endl;
         return false;
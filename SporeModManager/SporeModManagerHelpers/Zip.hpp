@@ -11,7 +11,10 @@
 #define SPOREMODMANAGERHELPERS_ZIP_HPP
 
 #include <vector>
+#include <string>
 #include <filesystem>
+#include <functional>
+#include <cstdint>
 
 namespace SporeModManagerHelpers
 {
@@ -24,6 +27,12 @@ namespace SporeModManagerHelpers
         /// </summary>
         bool OpenFile(ZipFile& zipFile, const std::filesystem::path& path);
 
+        /// <summary>
+        ///     Opens the given remote zip file using range requests,
+        ///     only the central directory is downloaded when opening
+        /// </summary>
+        bool OpenUrl(ZipFile& zipFile, const std::string& url);
+
         /// <summary>
         ///     Closes the given zip
         /// </summary>
@@ -40,9 +49,36 @@ namespace SporeModManagerHelpers
         bool LocateFile(ZipFile zipFile, const std::filesystem::path& file);
 
         /// <summary>
-        ///     Extracts file to outputFile
+        ///     Retrieves the uncompressed size and CRC32 of file
+        ///     from the central directory of the given zip
+        /// </summary>
+        bool GetFileInfo(ZipFile zipFile, const std::filesystem::path& file, uint64_t& size, uint32_t& crc32);
+
+        /// <summary>
+        ///     Retrieves a fingerprint of the given zip,
+        ///     which is based on its central directory
+        /// </summary>
+        bool GetFingerprint(ZipFile zipFile, std::string& fingerprint);
+
+        /// <summary>
+        ///     Reads size bytes at offset of file into buffer without extracting the rest of it,
+        ///     stored files are read directly, compressed files are inflated up to offset
+        ///     without keeping the data, returns false when the range is outside of file
+        /// </summary>
+        bool ReadFile(ZipFile zipFile, const std::filesystem::path& file, uint64_t offset, uint64_t size, std::vector<char>& buffer);
+
+        /// <summary>
+        ///     Reads file from its start, calling function with every consecutive part of it,
+        ///     reading stops when function returns false, in which case false is returned
+        /// </summary>
+        bool StreamFile(ZipFile zipFile, const std::filesystem::path& file, const std::function<bool(const char*, size_t)>& function);
+
+        /// <summary>
+        ///     Extracts file to outputFile, outputFile is written asynchronously,
+        ///     so AsyncIO::Wait() has to be called before using it,
+        ///     when sync is true, outputFile is flushed to disk
         /// </summary>
-        bool ExtractFile(ZipFile zipFile, const std::filesystem::path& file, const std::filesystem::path& outputFile);
+        bool ExtractFile(ZipFile zipFile, const std::filesystem::path& file, const std::filesystem::path& outputFile, bool sync);
 
         /// <summary>
         ///     Extracts file to buffer
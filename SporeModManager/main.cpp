@@ -7,6 +7,10 @@
  *  You should have received a copy of the GNU General Public License
  *  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
+#include "SporeModManagerHelpers/Cache.hpp"
+#include "SporeModManagerHelpers/FileLink.hpp"
+#include "SporeModManagerHelpers/SporeMod.hpp"
+#include "SporeModManagerHelpers/Store.hpp"
 #include "SporeModManagerHelpers/String.hpp"
 #include "SporeModManagerHelpers/Path.hpp"
 #include "SporeModManagerHelpers/UI.hpp"
@@ -52,10 +56,104 @@ struct path_argument
     std::filesystem::path& path;
 };
 
+struct value_argument
+{
+    arg_str_type  argument;
+    arg_str_type& value;
+};
+
+struct link_mode_value
+{
+    arg_str_type       value;
+    FileLink::LinkMode linkMode;
+};
+
 //
 // Local Functions
 //
 
+static bool get_argument_value(std::vector<arg_str_type>& args, size_t index, const arg_str_type& arg, arg_str_type& value)
+{
+    if (!arg.empty() && arg[0] == arg_char('='))
+    { // use value after =
+        value = arg.substr(1);
+    }
+    else
+    { // use next argument as value
+        if (index == (args.size() - 1))
+        {
+            return false;
+        }
+        value = args[index + 1];
+        args.erase(args.begin() + index + 1);
+    }
+
+    return !value.empty();
+}
+
+static bool parse_ids(const std::vector<arg_str_type>& args, std::vector<int>& ids)
+{
+    // we support 2 types to parse the IDs,
+    // either a range (i.e '0-3') or the IDs specified (i.e '0 1 2 3')
+    if (args.size() == 3 && args[2].find(arg_char('-')) != arg_str_type::npos)
+    {
+        int startIndex = 0;
+        int endIndex   = 0;
+        std::vector<arg_str_type> splitString = String::Split(args[2], arg_char('-'));
+        if (splitString.size() != 2)
+        {
+            std::cerr << "Error: range can only contain 2 positive numbers!" << std::endl;
+            return false;
+        }
+
+        // attempt to parse the strings into numbers
+        if (!String::ToInt(splitString[0], startIndex) ||
+            !String::ToInt(splitString[1], endIndex))
+        {
+            std::cerr << "Error: range can only contain numbers!" << std::endl;
+            return false;
+        }
+
+        // validate start and end index
+        if (startIndex == endIndex)
+        {
+            std::cerr << "Error: start number cannot be equal to the end number!" << std::endl;
+            return false;
+        }
+        else if (startIndex > endIndex)
+        {
+            std::cerr << "Error: start number must be less than the end number!" << std::endl;
+            return false;
+        }
+        else if (endIndex > 256)
+        {
+            std::cerr << "Error: end number cannot be bigger than 256!" << std::endl;
+            return false;
+        }
+
+        ids.reserve(endIndex - startIndex);
+        for (int i = startIndex; i <= endIndex; i++)
+        {
+            ids.push_back(i);
+        }
+    }
+    else
+    {
+        int number = 0;
+        for (size_t i = 2; i < args.size(); i++)
+        {
+            if (!String::ToInt(args[i], number))
+            {
+                std::cerr << "Error: ID must be a number!" << std::endl;
+                return false;
+            }
+            ids.push_back(number);
+        }
+    }
+
+    return true;
+}
+
 static void show_usage()
 {
     std::cout << "SporeModManager is a commandline mod manager for Spore" << std::endl
@@ -64,10 +162,27 @@ static void show_usage()
               << std::endl
               << "Commands:" << std::endl
               << "  list-installed      lists installed mod(s) with id(s)" << std::endl
-              << "  install file(s)     installs file(s)" << std::endl
-              << "  update file(s)      updates mod(s) using file(s)" << std::endl
+              << "  check               checks installed mod(s) for modified or missing files and unresolved DLL imports" << std::endl
+              << "  install file(s)     installs file(s) or sporemod url(s)" << std::endl
+              << "  update file(s)      updates mod(s) using file(s) or sporemod url(s)" << std::endl
               << "  uninstall id(s)     uninstalls mod with id(s)" << std::endl
+              << "  disable id(s)       disables mod with id(s) without removing its files" << std::endl
+              << "  enable id(s)        enables disabled mod with id(s)" << std::endl
+              << "  profile list        lists profiles, the active profile is marked with *" << std::endl
+              << "  profile save name   saves enabled mod(s) as profile" << std::endl
+              << "  profile switch name switches to profile by enabling and disabling mod(s)" << std::endl
+              << "  profile delete name deletes profile" << std::endl
               << "  update-modapi       updates modapi dll" << std::endl
+              << "  cache-stats         shows statistics of the extracted file cache" << std::endl
+              << "  conflicts           shows resources which are in packages of multiple mods" << std::endl
+              << "  merge-packages id(s) merges packages of mod(s) with id(s), later id(s) override earlier ones" << std::endl
+              << "  unmerge-packages    restores merged packages" << std::endl
+              << "  compact-package file(s) removes unused data from package file(s)" << std::endl
+              << "  inspect-package file [hash | dump directory] lists resources of package file, with their SHA-256 or decompressed into directory" << std::endl
+              << "  add-names file(s)   adds names in file(s), one per line, which are shown instead of hashes of resources" << std::endl
+              << "  hash-names name(s)  shows hashes of name(s)" << std::endl
+              << "  load-order          lists dll(s) in modlibs in the order they're loaded" << std::endl
+              << "  loader-report [file] shows where SporeModLoader spent time starting the game, slowest dll(s) first" << std::endl
               << std::endl
               << "  version             display version and exit"   << std::endl
               << "  help                display this help and exit" << std::endl
@@ -78,10 +193,18 @@ static void show_usage()
               << "  -n, --needed        only install mod when mod isn't installed" << std::endl
               << "  -u, --update-needed updates mod when mod is already installed" << std::endl
               << "  -s, --save-paths    saves paths to the configuration file" << std::endl
+              << "  -r, --rehash        compares file contents instead of size and time with check" << std::endl
+              << "  -c, --compact       compacts packages while installing them" << std::endl
+              << "  -p, --patch         only writes changed resources of installed packages when updating" << std::endl
               << "      --corelibs-path sets corelibs path" << std::endl
               << "      --modlibs-path  sets modlibs path"  << std::endl
               << "      --data-path     sets data path"     << std::endl
               << "      --ep1-path      sets ep1 data path" << std::endl
+              << "      --store-path    sets content store path, installed files are shared through it" << std::endl
+              << "      --link-mode     sets how files are installed (auto, reflink, hardlink or copy)" << std::endl
+              << "      --cache-path    sets extracted file cache path, cached files aren't extracted again" << std::endl
+              << "      --cache-size    sets maximum size of the extracted file cache in MiB (default: 1024)" << std::endl
+              << "      --targets       installs to every configuration file in the comma separated list" << std::endl
               << std::endl;
 }
 
@@ -103,10 +226,18 @@ int main(int argc, char** argv)
     bool hasNeededOption    = false;
     bool hasUpdateOption    = false;
     bool hasSavePathsOption = false;
+    bool hasRehashOption    = false;
+    bool hasCompactOption   = false;
+    bool hasPatchOption     = false;
     std::filesystem::path coreLibsPath;
     std::filesystem::path modLibsPath;
     std::filesystem::path dataPath;
     std::filesystem::path ep1Path;
+    std::filesystem::path storePath;
+    std::filesystem::path cachePath;
+    arg_str_type linkModeValue;
+    arg_str_type targetsValue;
+    arg_str_type cacheSizeValue;
 
     const struct option_argument optionArgs[] =
     {
@@ -115,6 +246,9 @@ int main(int argc, char** argv)
         { arg_str("n"), arg_str("needed"),        hasNeededOption  },
         { arg_str("u"), arg_str("update-needed"), hasUpdateOption },
         { arg_str("s"), arg_str("save-paths"),    hasSavePathsOption },
+        { arg_str("r"), arg_str("rehash"),        hasRehashOption },
+        { arg_str("c"), arg_str("compact"),       hasCompactOption },
+        { arg_str("p"), arg_str("patch"),         hasPatchOption },
     };
 
     const struct path_argument pathArgs[] =
@@ -123,6 +257,23 @@ int main(int argc, char** argv)
         { arg_str("modlibs-path"),  modLibsPath },
         { arg_str("data-path"),     dataPath },
         { arg_str("ep1-path"),      ep1Path },
+        { arg_str("store-path"),    storePath },
+        { arg_str("cache-path"),    cachePath },
+    };
+
+    const struct value_argument valueArgs[] =
+    {
+        { arg_str("link-mode"),  linkModeValue },
+        { arg_str("targets"),    targetsValue },
+        { arg_str("cache-size"), cacheSizeValue },
+    };
+
+    const struct link_mode_value linkModeValues[] =
+    {
+        { arg_str("auto"),     FileLink::LinkMode::Auto },
+        { arg_str("reflink"),  FileLink::LinkMode::Reflink },
+        { arg_str("hardlink"), FileLink::LinkMode::Hardlink },
+        { arg_str("copy"),     FileLink::LinkMode::Copy },
     };
 
     for (size_t i = 0; i < args.size(); i++)
@@ -173,27 +324,14 @@ int main(int argc, char** argv)
                 {
                     if (arg.rfind(pathArg.argument, 0) == 0)
                     {
+                        arg_str_type value;
                         arg.erase(0, pathArg.argument.size());
-                        if (!arg.empty() && arg[0] == arg_char('='))
-                        { // use path after =
-                            arg.erase(0, 1);
-                            pathArg.path = arg;
-                        }
-                        else
-                        { // use next argument as path
-                            if (i == (args.size() - 1))
-                            {
-                                show_usage();
-                                return 1;
-                            }
-                            pathArg.path = args[i + 1];
-                            args.erase(args.begin() + i + 1);
-                        }
-                        if (pathArg.path.empty())
+                        if (!get_argument_value(args, i, arg, value))
                         {
                             show_usage();
                             return 1;
                         }
+                        pathArg.path = value;
                         if (!std::filesystem::is_directory(pathArg.path))
                         {
                             std::arg_cerr << arg_str("Errror: ") << pathArg.path << arg_str(" isn't a valid path!") << std::endl;
@@ -202,6 +340,19 @@ int main(int argc, char** argv)
                         arg.clear();
                     }
                 }
+                for (const auto& valueArg : valueArgs)
+                {
+                    if (arg.rfind(valueArg.argument, 0) == 0)
+                    {
+                        arg.erase(0, valueArg.argument.size());
+                        if (!get_argument_value(args, i, arg, valueArg.value))
+                        {
+                            show_usage();
+                            return 1;
+                        }
+                        arg.clear();
+                    }
+                }
                 if (!arg.empty())
                 {
                     std::arg_cerr << arg_str("Error: unrecognized option: --") << arg << std::endl;
@@ -226,8 +377,63 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    std::vector<std::filesystem::path> targets;
+    if (!targetsValue.empty())
+    {
+        for (const auto& target : String::Split(targetsValue, arg_char(',')))
+        {
+            if (!target.empty())
+            {
+                targets.push_back(target);
+            }
+        }
+
+        // the directories are retrieved from
+        // the configuration file of every target
+        if (!coreLibsPath.empty() || !modLibsPath.empty() || !dataPath.empty() || !ep1Path.empty() || hasSavePathsOption)
+        {
+            std::cerr << "Error: --targets cannot be combined with paths!" << std::endl;
+            return 1;
+        }
+    }
+
+    FileLink::LinkMode linkMode = FileLink::LinkMode::Auto;
+    if (!linkModeValue.empty())
+    {
+        bool foundLinkMode = false;
+        for (const auto& linkModeValueIter : linkModeValues)
+        {
+            if (linkModeValue == linkModeValueIter.value)
+            {
+                linkMode      = linkModeValueIter.linkMode;
+                foundLinkMode = true;
+            }
+        }
+        if (!foundLinkMode)
+        {
+            std::arg_cerr << arg_str("Error: unrecognized link mode: ") << linkModeValue << std::endl;
+            return 1;
+        }
+    }
+
+    int cacheSize = 0;
+    if (!cacheSizeValue.empty() && (!String::ToInt(cacheSizeValue, cacheSize) || cacheSize <= 0))
+    {
+        std::cerr << "Error: --cache-size must be a positive number!" << std::endl;
+        return 1;
+    }
+
     // apply options
     UI::SetVerboseMode(hasVerboseOption);
+    FileLink::SetLinkMode(linkMode);
+    SporeMod::SetCompactPackages(hasCompactOption);
+    SporeMod::SetPatchPackages(hasPatchOption);
+    Store::SetStorePath(storePath);
+    Cache::SetCachePath(cachePath);
+    if (cacheSize > 0)
+    {
+        Cache::SetCacheSize(static_cast<uint64_t>(cacheSize) * 1048576);
+    }
     UI::SetNoInputMode(hasNoInputOption);
     Path::SetDirectories(coreLibsPath, modLibsPath, ep1Path, dataPath);
     if (hasSavePathsOption)
@@ -248,6 +454,12 @@ int main(int argc, char** argv)
 
     // parse commands
     arg_str_type command = args[1];
+    if (!targets.empty() && command != arg_str("install"))
+    {
+        std::cerr << "Error: --targets can only be used with install!" << std::endl;
+        return 1;
+    }
+
     if (command == arg_str("help"))
     {
         show_usage();
@@ -266,13 +478,32 @@ int main(int argc, char** argv)
 
         SporeModManager::ListInstalledMods();
     }
-    else if (command == arg_str("install"))
+    else if (command == arg_str("check"))
     {
         if (!Path::CheckIfPathsExist())
         {
             return 1;
         }
 
+        if (args.size() != 2)
+        {
+            show_usage();
+            return 1;
+        }
+
+        bool hasChanges = false;
+        if (!SporeModManager::CheckInstalledMods(hasRehashOption, hasChanges) || hasChanges)
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("install"))
+    {
+        if (targets.empty() && !Path::CheckIfPathsExist())
+        {
+            return 1;
+        }
+
         if (args.size() < 3)
         {
             show_usage();
@@ -281,7 +512,14 @@ int main(int argc, char** argv)
 
         std::vector<std::filesystem::path> paths(args.begin() + 2, args.end());
 
-        if (hasUpdateOption)
+        if (!targets.empty())
+        {
+            if (!SporeModManager::InstallModsToTargets(paths, targets, hasUpdateOption, hasNeededOption))
+            {
+                return 1;
+            }
+        }
+        else if (hasUpdateOption)
         {
             if (!SporeModManager::UpdateMods(paths, false))
             {
@@ -330,66 +568,285 @@ int main(int argc, char** argv)
         }
 
         std::vector<int> ids;
+        if (!parse_ids(args, ids))
+        {
+            return 1;
+        }
+
+        if (!SporeModManager::UninstallMods(ids))
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("disable") || command == arg_str("enable"))
+    {
+        if (!Path::CheckIfPathsExist())
+        {
+            return 1;
+        }
+
+        if (args.size() < 3)
+        {
+            show_usage();
+            return 1;
+        }
+
+        std::vector<int> ids;
+        if (!parse_ids(args, ids))
+        {
+            return 1;
+        }
 
-        // we support 2 types to parse the IDs,
-        // either a range (i.e '0-3') or the IDs specified (i.e '0 1 2 3')
-        if (args.size() == 3 && args[2].find(arg_char('-')) != arg_str_type::npos)
+        if (!SporeModManager::SetModsEnabled(ids, command == arg_str("enable")))
         {
-            int startIndex = 0;
-            int endIndex   = 0;
-            std::vector<arg_str_type> splitString = String::Split(args[2], arg_char('-'));
-            if (splitString.size() != 2)
+            return 1;
+        }
+    }
+    else if (command == arg_str("profile"))
+    {
+        if (!Path::CheckIfPathsExist())
+        {
+            return 1;
+        }
+
+        if (args.size() == 3 && args[2] == arg_str("list"))
+        {
+            if (!SporeModManager::ListProfiles())
             {
-                std::cerr << "Error: range can only contain 2 positive numbers!" << std::endl;
                 return 1;
             }
+        }
+        else if (args.size() == 4 && !args[3].empty())
+        {
+            // profile names are stored in the configuration file,
+            // so convert them the same way as paths
+            const std::string name = std::filesystem::path(args[3]).string();
+            bool ret;
 
-            // attempt to parse the strings into numbers
-            if (!String::ToInt(splitString[0], startIndex) ||
-                !String::ToInt(splitString[1], endIndex))
+            if (args[2] == arg_str("save"))
             {
-                std::cerr << "Error: range can only contain numbers!" << std::endl;
-                return 1;
+                ret = SporeModManager::SaveProfile(name);
             }
-
-            // validate start and end index
-            if (startIndex == endIndex)
+            else if (args[2] == arg_str("switch"))
             {
-                std::cerr << "Error: start number cannot be equal to the end number!" << std::endl;
-                return 1;
+                ret = SporeModManager::SwitchProfile(name);
             }
-            else if (startIndex > endIndex)
+            else if (args[2] == arg_str("delete"))
             {
-                std::cerr << "Error: start number must be less than the end number!" << std::endl;
-                return 1;
+                ret = SporeModManager::DeleteProfile(name);
             }
-            else if (endIndex > 256)
+            else
             {
-                std::cerr << "Error: end number cannot be bigger than 256!" << std::endl;
+                show_usage();
                 return 1;
             }
 
-            ids.reserve(endIndex - startIndex);
-            for (int i = startIndex; i <= endIndex; i++)
+            if (!ret)
             {
-                ids.push_back(i);
+                return 1;
             }
         }
         else
         {
-            int number = 0;
-            for (size_t i = 2; i < args.size(); i++)
+            show_usage();
+            return 1;
+        }
+    }
+    else if (command == arg_str("cache-stats"))
+    {
+        if (args.size() != 2)
+        {
+            show_usage();
+            return 1;
+        }
+
+        if (!SporeModManager::ShowCacheStatistics())
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("conflicts"))
+    {
+        if (!Path::CheckIfPathsExist())
+        {
+            return 1;
+        }
+
+        if (args.size() != 2)
+        {
+            show_usage();
+            return 1;
+        }
+
+        if (!SporeModManager::ShowConflicts())
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("merge-packages"))
+    {
+        if (!Path::CheckIfPathsExist())
+        {
+            return 1;
+        }
+
+        if (args.size() < 3)
+        {
+            show_usage();
+            return 1;
+        }
+
+        std::vector<int> ids;
+        if (!parse_ids(args, ids))
+        {
+            return 1;
+        }
+
+        if (!SporeModManager::MergePackages(ids))
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("unmerge-packages"))
+    {
+        if (!Path::CheckIfPathsExist())
+        {
+            return 1;
+        }
+
+        if (args.size() != 2)
+        {
+            show_usage();
+            return 1;
+        }
+
+        if (!SporeModManager::UnmergePackages())
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("compact-package"))
+    {
+        if (args.size() < 3)
+        {
+            show_usage();
+            return 1;
+        }
+
+        std::vector<std::filesystem::path> paths(args.begin() + 2, args.end());
+
+        if (!SporeModManager::CompactPackages(paths))
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("inspect-package"))
+    {
+        bool hashResources = false;
+        std::filesystem::path dumpPath;
+
+        if (args.size() == 4 && args[3] == arg_str("hash"))
+        {
+            hashResources = true;
+        }
+        else if (args.size() == 5 && args[3] == arg_str("dump") && !args[4].empty())
+        {
+            dumpPath = args[4];
+        }
+        else if (args.size() != 3)
+        {
+            show_usage();
+            return 1;
+        }
+
+        if (!SporeModManager::InspectPackage(args[2], hashResources, dumpPath))
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("add-names"))
+    {
+        if (args.size() < 3)
+        {
+            show_usage();
+            return 1;
+        }
+
+        std::vector<std::filesystem::path> paths(args.begin() + 2, args.end());
+
+        if (!SporeModManager::AddNames(paths))
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("hash-names"))
+    {
+        if (args.size() < 3)
+        {
+            show_usage();
+            return 1;
+        }
+
+        std::vector<std::string> names;
+        for (auto iter = args.begin() + 2; iter != args.end(); iter++)
+        {
+            names.push_back(std::filesystem::path(*iter).string());
+        }
+
+        if (!SporeModManager::HashNames(names))
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("load-order"))
+    {
+        if (!Path::CheckIfPathsExist())
+        {
+            return 1;
+        }
+
+        if (args.size() != 2)
+        {
+            show_usage();
+            return 1;
+        }
+
+        if (!SporeModManager::ShowLoadOrder())
+        {
+            return 1;
+        }
+    }
+    else if (command == arg_str("loader-report"))
+    {
+        std::filesystem::path profilePath;
+
+        if (args.size() == 3)
+        {
+            profilePath = args[2];
+        }
+        else if (args.size() == 2)
+        {
+            if (!Path::CheckIfPathsExist())
             {
-                if (!String::ToInt(args[i], number))
-                {
-                    std::cerr << "Error: ID must be a number!" << std::endl;
-                    return 1;
-                }
-                ids.push_back(number);
+                return 1;
             }
+
+            // SporeModLoader writes its profile next to its log,
+            // which is in the directory containing CoreLibs
+            profilePath = Path::GetCoreLibsPath();
+            if (!profilePath.has_filename())
+            {
+                profilePath = profilePath.parent_path();
+            }
+            profilePath = Path::Combine({ profilePath.parent_path(), "SporeModLoader.profile" });
+        }
+        else
+        {
+            show_usage();
+            return 1;
         }
 
-        if (!SporeModManager::UninstallMods(ids))
+        if (!SporeModManager::ShowLoaderReport(profilePath))
         {
             return 1;
         }
@@ -0,0 +1,6 @@
+#ifndef REVISION_H
+#define REVISION_H
+
+#define REVISION_STR "63545ac"
+
+#endif // REVISION_H
@@ -3,6 +3,7 @@
 # SporeModManager test.py
 #
 import os
+import sys
 import shutil
 import zipfile
 import argparse
@@ -10,6 +11,12 @@ import subprocess
 import tempfile
 import atexit
 import uuid
+import hashlib
+import zlib
+import struct
+import threading
+import http.server
+import time
 
 #
 # Global Variables
@@ -36,17 +43,93 @@ config_file      = os.path.join(tests_path, 'configfile.xml')
 modlibs_path     = os.path.join(tests_path, 'ModLibs')
 data_path        = os.path.join(tests_path, 'Data')
 ep1_path         = os.path.join(tests_path, 'DataEP1')
+downloads_path   = os.path.join(tests_path, 'SporeModManager')
 
 os_environment  = os.environ.copy()
 
 # global for write_sporemod
 write_mod_num   = 0
 
+# globals for the local http server,
+# the range request with the number in
+# http_change_request reports the file as changed
+http_server         = None
+http_url            = ''
+http_bytes_served   = 0
+http_range_requests = 0
+http_change_request = 0
+
+#
+# Helper Classes
+#
+
+# http request handler which supports range requests
+# with If-Range and keeps track of the amount of bytes served
+class RangeRequestHandler(http.server.SimpleHTTPRequestHandler):
+	protocol_version = 'HTTP/1.1'
+
+	def __init__(self, *args, **kwargs):
+		super().__init__(*args, directory=mods_path, **kwargs)
+
+	def log_message(self, format, *args):
+		pass
+
+	def do_HEAD(self):
+		self.send_file(False)
+
+	def do_GET(self):
+		self.send_file(True)
+
+	def send_file(self, send_body):
+		global http_bytes_served, http_range_requests
+		path = self.translate_path(self.path)
+		if not os.path.isfile(path):
+			self.send_error(404)
+			return
+		size = os.path.getsize(path)
+		start = 0
+		end = size - 1
+		etag = get_http_etag(path)
+		range_header = self.headers.get('Range')
+		if_range_header = self.headers.get('If-Range')
+		if range_header is not None and send_body:
+			http_range_requests += 1
+			if http_range_requests == http_change_request:
+				etag = '"changed"'
+		if range_header is not None and if_range_header is not None and if_range_header != etag:
+			range_header = None
+		if range_header is not None:
+			range_start, range_end = range_header.replace('bytes=', '').split('-')
+			start = int(range_start)
+			if range_end != '':
+				end = min(int(range_end), size - 1)
+			self.send_response(206)
+			self.send_header('Content-Range', f'bytes {start}-{end}/{size}')
+		else:
+			self.send_response(200)
+		self.send_header('Accept-Ranges', 'bytes')
+		self.send_header('ETag', etag)
+		self.send_header('Content-Length', str(end - start + 1))
+		self.end_headers()
+		if send_body:
+			with open(path, 'rb') as file:
+				file.seek(start)
+				try:
+					self.wfile.write(file.read(end - start + 1))
+				except ConnectionError:
+					# the client aborts when it receives
+					# more data than it has requested
+					self.close_connection = True
+					return
+			http_bytes_served += end - start + 1
+
 #
 # Helper Functions
 #
 
 def cleanup_smm():
+	if http_server is not None:
+		http_server.shutdown()
 	if cleanup:
 		shutil.rmtree(tests_path)
 
@@ -57,10 +140,13 @@ def reset_smm():
 	global write_mod_num
 	write_mod_num = 0
 
-def run_smm(args):
+def run_smm(args, paths = True):
 	os_environment["SPOREMODMANAGER_CONFIGFILE"] = str(config_file)
+	os_environment["TMPDIR"] = str(tests_path)
 	valgrind_cmd = [ 'valgrind', '--quiet', '--leak-check=full', '--show-leak-kinds=all', '--track-origins=yes', '--error-exitcode=2' ]
-	smm_cmd = [ sporemodmanager, '--verbose', '--no-input', f'--corelibs-path={corelibs_path}', f'--modlibs-path={modlibs_path}', f'--data-path={data_path}', f'--ep1-path={ep1_path}' ]
+	smm_cmd = [ sporemodmanager, '--verbose', '--no-input' ]
+	if paths:
+		smm_cmd += [ f'--corelibs-path={corelibs_path}', f'--modlibs-path={modlibs_path}', f'--data-path={data_path}', f'--ep1-path={ep1_path}' ]
 	cmd = [ ]
 	if valgrind:
 		cmd += valgrind_cmd
@@ -96,10 +182,98 @@ def write_sporemod(xml = None, extra = None, createNew = False, invalidZip = Fal
 					archive.writestr(list_str[0], list_str[1])
 	return file
 
+def start_http_server():
+	global http_server, http_url
+	http_server = http.server.ThreadingHTTPServer(('127.0.0.1', 0), RangeRequestHandler)
+	http_url = f'http://127.0.0.1:{http_server.server_address[1]}/'
+	thread = threading.Thread(target=http_server.serve_forever, daemon=True)
+	thread.start()
+
+def get_http_etag(path):
+	stat = os.stat(path)
+	return f'"{stat.st_mtime_ns}-{stat.st_size}"'
+
 def write_package(path):
 	with open(path, 'wb') as file:
 		file.write(b'package')
 
+def get_dbpf_package(keys, padding = 0):
+	# keys are (group, instance, type) tuples,
+	# every resource contains its instance id,
+	# padding is the unused space before every resource
+	data = b''
+	index = struct.pack('<I', 0)
+	for (group, instance, type) in keys:
+		data += b'\xff' * padding
+		resource = struct.pack('<I', instance)
+		index += struct.pack('<IIIIIIIHH', type, group, 0, instance, 96 + len(data), len(resource) | 0x80000000, len(resource), 0, 1)
+		data += resource
+	header = struct.pack('<4sII20xII4xI12xII28x', b'DBPF', 2, 0, 7, len(keys), len(index), 3, 96 + len(data))
+	return header + data + index
+
+def write_dbpf_package(path, keys):
+	with open(path, 'wb') as file:
+		file.write(get_dbpf_package(keys))
+
+def refpack_compress(data):
+	# greedy RefPack compressor, which uses
+	# every type of command the format has
+	output = bytearray(b'\x10\xfb' + struct.pack('>I', len(data))[1:])
+	positions = { }
+	literal_start = 0
+	def write_literals(end, keep):
+		nonlocal literal_start
+		while end - literal_start > keep:
+			size = min((end - literal_start) & ~3, 112)
+			output.append(0xe0 | ((size - 4) >> 2))
+			output.extend(data[literal_start:literal_start + size])
+			literal_start += size
+	i = 0
+	while i + 3 <= len(data):
+		key = data[i:i + 3]
+		candidate = positions.get(key)
+		positions[key] = i
+		length = 0
+		if candidate is not None:
+			offset = i - candidate
+			while length < 1028 and i + length < len(data) and data[candidate + length] == data[i + length]:
+				length += 1
+			if offset > 131072 or (offset > 16384 and length < 5) or (offset > 1024 and length < 4):
+				length = 0
+		if length < 3:
+			i += 1
+			continue
+		write_literals(i, 3)
+		literal = i - literal_start
+		offset -= 1
+		if length <= 10 and offset < 1024:
+			output += bytes([ ((offset >> 3) & 0x60) | ((length - 3) << 2) | literal, offset & 0xff ])
+		elif length <= 67 and offset < 16384:
+			output += bytes([ 0x80 | (length - 4), (literal << 6) | (offset >> 8), offset & 0xff ])
+		else:
+			length -= 5
+			output += bytes([ 0xc0 | ((offset >> 12) & 0x10) | ((length >> 6) & 0x0c) | literal, (offset >> 8) & 0xff, offset & 0xff, length & 0xff ])
+			length += 5
+		output.extend(data[literal_start:i])
+		i += length
+		literal_start = i
+	write_literals(len(data), 3)
+	output.append(0xfc | (len(data) - literal_start))
+	output.extend(data[literal_start:])
+	return bytes(output)
+
+def get_compressed_dbpf_package(resources):
+	# resources are (group, instance, type, data) tuples,
+	# the resources are stored compressed
+	data = b''
+	index = struct.pack('<I', 0)
+	for (group, instance, type, resource) in resources:
+		compressed_resource = refpack_compress(resource)
+		index += struct.pack('<IIIIIIIHH', type, group, 0, instance, 96 + len(data), len(compressed_resource) | 0x80000000, len(resource), 0xffff, 1)
+		data += compressed_resource
+	header = struct.pack('<4sII20xII4xI12xII28x', b'DBPF', 2, 0, 7, len(resources), len(index), 3, 96 + len(data))
+	return header + data + index
+
 def write_invalid(path):
 	with open(path, 'wb') as file:
 		file.write(b'invalid')
@@ -110,6 +284,43 @@ def write_sporemodapi_dll(path):
 		bytes = b'F\0i\0l\0e\0V\0e\0r\0s\0i\0o\0n\0\0\0\0\0002\0.\0005\0.\000300\0'
 		file.write(bytes)
 
+def get_pe_dll(name, imports = {}, exports = []):
+	# everything is stored in one section, which
+	# starts at 0x1000 in memory and 0x200 in the file
+	data = bytearray()
+	def add(blob):
+		rva = 0x1000 + len(data)
+		data.extend(blob)
+		return rva
+	def add_string(string):
+		return add(string.encode() + b'\0')
+	export_rva = 0
+	if exports:
+		exports = sorted(exports)
+		name_rvas = [ add_string(export) for export in exports ]
+		functions_rva = add(b''.join(struct.pack('<I', 0x2000 + i) for i in range(len(exports))))
+		names_rva = add(b''.join(struct.pack('<I', name_rva) for name_rva in name_rvas))
+		ordinals_rva = add(b''.join(struct.pack('<H', i) for i in range(len(exports))))
+		export_rva = add(struct.pack('<12xIIIIIII', add_string(name), 1, len(exports), len(exports), functions_rva, names_rva, ordinals_rva))
+	import_rva = 0
+	if imports:
+		descriptors = b''
+		for dll_name, functions in imports.items():
+			# ordinals are imported by number, names with a hint
+			thunks = [ (0x80000000 | function) if isinstance(function, int) else add(b'\0\0' + function.encode() + b'\0') for function in functions ]
+			thunks_rva = add(b''.join(struct.pack('<I', thunk) for thunk in thunks + [ 0 ]))
+			descriptors += struct.pack('<I8xII', thunks_rva, add_string(dll_name), thunks_rva)
+		import_rva = add(descriptors + bytes(20))
+	header = struct.pack('<2s58xI', b'MZ', 0x40)
+	header += struct.pack('<4sHHIIIHH', b'PE\0\0', 0x14c, 1, 0, 0, 0, 224, 0x2102)
+	header += struct.pack('<H90xIIIII112x', 0x10b, 16, export_rva, 40 if exports else 0, import_rva, (len(imports) + 1) * 20 if imports else 0)
+	header += struct.pack('<8sIIII16x', b'.rdata', len(data), 0x1000, len(data), 0x200)
+	return header + bytes(0x200 - len(header)) + bytes(data)
+
+def check_file_bytes(path, content):
+	with open(path, 'rb') as file:
+		return file.read() == content
+
 def check_file_contents(path, content):
 	with open(path, 'r') as file:
 		file_content = file.read()
@@ -676,6 +887,42 @@ def test_uninstall():
 	assert result.stdout == ''
 	assert result.stderr != ''
 
+	# uninstalling mods with files in every install location
+	# and giving the same id twice should work
+	reset_smm()
+	for num in range(3):
+		xml = f"""<mod displayName="test_uninstall_3_{num}" 
+					unique="test_uninstall_3_{num}" 
+					description="test_uninstall_3_{num}" 
+					installerSystemVersion="1.0.1.1" 
+					dllsBuild="2.5.20">
+					<prerequisite>test_uninstall_3_{num}.dll</prerequisite>
+					<prerequisite game="GalacticAdventures">test_uninstall_3_{num}_ep1.package</prerequisite>
+					<prerequisite game="Spore">test_uninstall_3_{num}_data.package</prerequisite>
+				</mod>"""
+		files = [
+			[ f'test_uninstall_3_{num}.dll', 'test' ],
+			[ f'test_uninstall_3_{num}_ep1.package', 'test' ],
+			[ f'test_uninstall_3_{num}_data.package', 'test' ],
+		]
+		result = run_smm([ 'install', write_sporemod(xml, files, True) ])
+		assert result.returncode == 0
+		assert result.stderr == ''
+	result = run_smm([ 'uninstall', '2', '0', '2' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	for num in [ 0, 2 ]:
+		assert not os.path.isfile(os.path.join(modlibs_path, f'test_uninstall_3_{num}.dll'))
+		assert not os.path.isfile(os.path.join(ep1_path, f'test_uninstall_3_{num}_ep1.package'))
+		assert not os.path.isfile(os.path.join(data_path, f'test_uninstall_3_{num}_data.package'))
+	assert os.path.isfile(os.path.join(modlibs_path, 'test_uninstall_3_1.dll'))
+	assert os.path.isfile(os.path.join(ep1_path, 'test_uninstall_3_1_ep1.package'))
+	assert os.path.isfile(os.path.join(data_path, 'test_uninstall_3_1_data.package'))
+	result = run_smm([ 'list-installed' ])
+	assert result.returncode == 0
+	assert result.stdout == '[0] test_uninstall_3_1\n  test_uninstall_3_1\n'
+	assert result.stderr == ''
+
 
 # Tests whether update works correctly
 def test_update():
@@ -805,6 +1052,94 @@ def test_update():
 	assert result.stdout != ''
 	assert result.stderr == ''
 
+	# updating should only install changed files,
+	# remove files which were removed and leave
+	# unchanged files alone
+	reset_smm()
+	xml = """<mod displayName="test_update_2" 
+				unique="test_update_2" 
+				description="test_update_2" 
+				installerSystemVersion="1.0.1.1" 
+				dllsBuild="2.5.20">
+				<prerequisite>test_update_2_0.dll</prerequisite>
+				<prerequisite>test_update_2_1.dll</prerequisite>
+				<prerequisite>test_update_2_2.dll</prerequisite>
+			  </mod>"""
+	files = [
+		[ 'test_update_2_0.dll', 'test_update_2_0.dll' ],
+		[ 'test_update_2_1.dll', 'test_update_2_1.dll' ],
+		[ 'test_update_2_2.dll', 'test_update_2_2.dll' ],
+	]
+	write_sporemod(xml, files)
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	unchanged_stat = os.stat(os.path.join(modlibs_path, files[0][0]))
+	xml = """<mod displayName="test_update_2" 
+				unique="test_update_2" 
+				description="test_update_2" 
+				installerSystemVersion="1.0.1.1" 
+				dllsBuild="2.5.20">
+				<prerequisite>test_update_2_0.dll</prerequisite>
+				<prerequisite>test_update_2_1.dll</prerequisite>
+				<prerequisite>test_update_2_3.dll</prerequisite>
+			  </mod>"""
+	files = [
+		[ 'test_update_2_0.dll', 'test_update_2_0.dll' ],
+		[ 'test_update_2_1.dll', 'test_update_2_1_changed.dll' ],
+		[ 'test_update_2_3.dll', 'test_update_2_3.dll' ],
+	]
+	write_sporemod(xml, files)
+	result = run_smm([ 'update', sporemod_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert 'Skipping unchanged "test_update_2_0.dll"' in result.stdout
+	assert 'Installing "test_update_2_1.dll"' in result.stdout
+	assert os.stat(os.path.join(modlibs_path, files[0][0])).st_mtime_ns == unchanged_stat.st_mtime_ns
+	assert check_file_contents(os.path.join(modlibs_path, files[1][0]), files[1][1])
+	assert not os.path.isfile(os.path.join(modlibs_path, 'test_update_2_2.dll'))
+	assert check_file_contents(os.path.join(modlibs_path, files[2][0]), files[2][1])
+	result = run_smm([ '--rehash', 'check' ])
+	assert result.returncode == 0
+	assert '0 modified, 0 missing' in result.stdout
+	assert result.stderr == ''
+
+	# a modified file should be installed again
+	with open(os.path.join(modlibs_path, files[0][0]), 'a') as file:
+		file.write('test_update_2')
+	result = run_smm([ 'update', sporemod_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert 'Installing "test_update_2_0.dll"' in result.stdout
+	assert check_file_contents(os.path.join(modlibs_path, files[0][0]), files[0][1])
+
+	# a failing update should leave the
+	# previously installed version intact
+	xml = """<mod displayName="test_update_2" 
+				unique="test_update_2" 
+				description="test_update_2" 
+				installerSystemVersion="1.0.1.1" 
+				dllsBuild="2.5.20">
+				<prerequisite>test_update_2_0.dll</prerequisite>
+				<prerequisite>test_update_2_4.dll</prerequisite>
+			  </mod>"""
+	write_sporemod(xml, [ [ 'test_update_2_0.dll', 'test_update_2_0_broken.dll' ] ])
+	result = run_smm([ 'update', sporemod_file ])
+	assert result.returncode == 1
+	assert result.stderr != ''
+	assert check_file_contents(os.path.join(modlibs_path, files[0][0]), files[0][1])
+	assert check_file_contents(os.path.join(modlibs_path, files[1][0]), files[1][1])
+	assert check_file_contents(os.path.join(modlibs_path, files[2][0]), files[2][1])
+	assert os.listdir(modlibs_path).count('.SporeModManager-staging') == 0
+	assert os.listdir(modlibs_path).count('.SporeModManager-backup') == 0
+	result = run_smm([ 'list-installed' ])
+	assert result.returncode == 0
+	assert 'test_update_2' in result.stdout
+	result = run_smm([ '--rehash', 'check' ])
+	assert result.returncode == 0
+	assert '0 modified, 0 missing' in result.stdout
+	assert result.stderr == ''
+
 # Tests whether list-installed works correctly
 def test_list_installed():
 	print(f'Running {test_list_installed.__name__}...')
@@ -928,88 +1263,1758 @@ def test_list_installed():
 	assert 'test_list_installed_0' not in result.stdout
 	assert result.stderr == ''
 
-# Tests whether update-modapi works correctly
-def test_update_modapi():
-	print(f'Running {test_update_modapi.__name__}...')
+# Tests whether an interrupted install is recovered correctly
+def test_install_recovery():
+	print(f'Running {test_install_recovery.__name__}...')
 	reset_smm()
 
-	# ensure mod with higher dll build required doesn't work
-	xml = """<mod displayName="test_update_modapi_0" 
-				unique="test_update_modapi_0" 
-				description="test_update_modapi_0" 
-				installerSystemVersion="1.0.1.1" 
-				dllsBuild="2.5.400">
+	journal_file = config_file + '.journal'
+	mod_files = [ ]
+	for num in range(3):
+		xml = f"""<mod displayName="test_install_recovery_{num}"
+					unique="test_install_recovery_{num}"
+					description="test_install_recovery_{num}&#10;line 2"
+					installerSystemVersion="1.0.1.1"
+					dllsBuild="2.5.20">
+					<prerequisite>test_install_recovery_{num}.dll</prerequisite>
+				</mod>"""
+		mod_files.append(write_sporemod(xml, [ [ f'test_install_recovery_{num}.dll', f'test_install_recovery_{num}.dll' ] ], True))
+
+	# the journal should be removed after a successful run
+	result = run_smm([ 'install', mod_files[0], mod_files[1] ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert not os.path.isfile(journal_file)
+
+	# simulate a run which got interrupted after installing
+	# the first 2 mods, while writing the next journal entry
+	journal = ''
+	with open(config_file, 'r') as file:
+		config = file.read()
+		for num in range(2):
+			start = config.rindex('<InstalledSporeMod>', 0, config.index(f'test_install_recovery_{num}</UniqueName>'))
+			end = config.index('</InstalledSporeMod>', start) + len('</InstalledSporeMod>')
+			journal += config[start:end].replace('\t', '').replace('\n', '&#10;') + '\n'
+	reset_smm()
+	with open(journal_file, 'w') as file:
+		file.write(journal)
+		file.write(journal[:50])
+
+	# a rerun should skip the mods which have been installed
+	result = run_smm([ 'install', mod_files[0], mod_files[1], mod_files[2] ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert 'Recovering 2 mod(s)' in result.stdout
+	assert result.stdout.count('as it was installed by an interrupted run') == 2
+	assert check_file_contents(os.path.join(modlibs_path, 'test_install_recovery_2.dll'), 'test_install_recovery_2.dll')
+	assert not os.path.isfile(journal_file)
+	result = run_smm([ 'list-installed' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	for num in range(3):
+		assert f'test_install_recovery_{num}' in result.stdout
+	assert '\n  line 2' in result.stdout
+	result = run_smm([ '--rehash', 'check' ])
+	assert result.returncode == 0
+	assert 'Checked 3 file(s) of 3 mod(s), 0 modified, 0 missing' in result.stdout
+	assert result.stderr == ''
+
+	# simulate a run which got killed while updating the first mod, after
+	# moving the installed file into the backup directory but before moving
+	# the staged file into place, which leaves the file only in the backup
+	staging_path = os.path.join(modlibs_path, '.SporeModManager-staging')
+	backup_path = os.path.join(modlibs_path, '.SporeModManager-backup')
+	os.mkdir(staging_path)
+	os.mkdir(backup_path)
+	with open(os.path.join(backup_path, 'journal'), 'w') as file:
+		file.write('S 0 0 test_install_recovery_0.dll\nS 1 0 test_install_recovery_1.dll\n')
+	os.rename(os.path.join(modlibs_path, 'test_install_recovery_0.dll'), os.path.join(backup_path, '0'))
+	for num in range(2):
+		with open(os.path.join(staging_path, str(num)), 'w') as file:
+			file.write('test_install_recovery_update')
+
+	# a rerun should roll back the interrupted update
+	result = run_smm([ 'list-installed' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert 'Rolling back interrupted changes' in result.stdout
+	assert not os.path.exists(staging_path)
+	assert not os.path.exists(backup_path)
+	for num in range(2):
+		assert check_file_contents(os.path.join(modlibs_path, f'test_install_recovery_{num}.dll'), f'test_install_recovery_{num}.dll')
+	result = run_smm([ '--rehash', 'check' ])
+	assert result.returncode == 0
+	assert 'Checked 3 file(s) of 3 mod(s), 0 modified, 0 missing' in result.stdout
+
+	# the backup is kept when it can't be rolled back
+	os.mkdir(backup_path)
+	with open(os.path.join(backup_path, 'journal'), 'w') as file:
+		file.write('S ../0 0 test_install_recovery_0.dll\n')
+	result = run_smm([ 'check' ])
+	assert result.returncode == 1
+	assert 'failed to recover' in result.stderr
+	assert os.path.exists(os.path.join(backup_path, 'journal'))
+	shutil.rmtree(backup_path)
+
+# Tests whether --link-mode works correctly
+def test_install_link_mode():
+	print(f'Running {test_install_link_mode.__name__}...')
+	reset_smm()
+
+	link_package_file = os.path.join(mods_path, 'test_install_link_mode.package')
+	installed_file = os.path.join(ep1_path, 'test_install_link_mode.package')
+	write_package(link_package_file)
+
+	# invalid link modes should fail
+	result = run_smm([ '--link-mode=invalid', 'install', link_package_file ])
+	assert result.returncode == 1
+	assert result.stderr != ''
+	assert not os.path.isfile(installed_file)
+
+	# copy and auto shouldn't share a writable file
+	for args in [ [ '--link-mode', 'copy' ], [ '--link-mode=auto' ], [ ] ]:
+		result = run_smm(args + [ 'install', link_package_file ])
+		assert result.returncode == 0
+		assert result.stderr == ''
+		assert check_file_bytes(installed_file, b'package')
+		assert not os.path.samefile(link_package_file, installed_file)
+		result = run_smm([ 'uninstall', '0' ])
+		assert result.returncode == 0
+		assert not os.path.isfile(installed_file)
+
+	# hardlink should share the file
+	result = run_smm([ '--link-mode=hardlink', 'install', link_package_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert os.path.samefile(link_package_file, installed_file)
+	result = run_smm([ '--rehash', 'check' ])
+	assert result.returncode == 0
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert os.path.isfile(link_package_file)
+
+	# auto can hardlink read-only files
+	os.chmod(link_package_file, 0o444)
+	result = run_smm([ 'install', link_package_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert check_file_bytes(installed_file, b'package')
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	os.chmod(link_package_file, 0o644)
+
+	# reflink either succeeds or fails without leaving files behind
+	result = run_smm([ '--link-mode=reflink', 'install', link_package_file ])
+	if result.returncode == 0:
+		assert check_file_bytes(installed_file, b'package')
+		assert not os.path.samefile(link_package_file, installed_file)
+	else:
+		assert result.stderr != ''
+		assert not os.path.isfile(installed_file)
+
+# Tests whether disabling and enabling mods works correctly
+def test_disable():
+	print(f'Running {test_disable.__name__}...')
+	reset_smm()
+
+	content = str(uuid.uuid4())
+	xml = """<mod displayName="test_disable"
+				unique="test_disable"
+				description="test_disable"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				<prerequisite>test_disable.dll</prerequisite>
 			</mod>"""
-	write_sporemod(xml)
-	result = run_smm([ 'install', sporemod_file ])
+	mod_file = write_sporemod(xml, [ [ 'test_disable.dll', content ] ], True)
+	installed_file = os.path.join(modlibs_path, 'test_disable.dll')
+	disabled_file = os.path.join(modlibs_path, 'SporeModManagerDisabled', 'test_disable', 'test_disable.dll')
+
+	result = run_smm([ 'install', mod_file, package_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+
+	# invalid ids should fail
+	for args in [ [ 'disable' ], [ 'disable', '2' ], [ 'enable', 'a' ] ]:
+		result = run_smm(args)
+		assert result.returncode == 1
+
+	# disabling should move the files out of the install location
+	inode = os.stat(installed_file).st_ino
+	result = run_smm([ 'disable', '0', '1' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert not os.path.isfile(installed_file)
+	assert not os.path.isfile(os.path.join(ep1_path, 'test_package.package'))
+	assert check_file_contents(disabled_file, content)
+	assert os.stat(disabled_file).st_ino == inode
+	result = run_smm([ 'list-installed' ])
+	assert result.returncode == 0
+	assert 'test_disable (disabled)' in result.stdout
+	result = run_smm([ '--rehash', 'check' ])
+	assert result.returncode == 0
+	result = run_smm([ 'disable', '0' ])
+	assert result.returncode == 0
+	assert 'already disabled' in result.stdout
+
+	# disabled mods cannot be updated
+	result = run_smm([ 'update', mod_file ])
 	assert result.returncode == 1
-	assert result.stdout == ''
 	assert result.stderr != ''
 
-	# attempt to update modapi dll
-	result = run_smm([ 'update-modapi' ])
+	# enabling shouldn't overwrite other files
+	write_package(installed_file)
+	result = run_smm([ 'enable', '0' ])
+	assert result.returncode == 1
+	assert result.stderr != ''
+	assert check_file_contents(disabled_file, content)
+	os.remove(installed_file)
+
+	# enabling should move the files back
+	result = run_smm([ 'enable', '0-1' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert check_file_contents(installed_file, content)
+	assert check_file_bytes(os.path.join(ep1_path, 'test_package.package'), b'package')
+	assert not os.path.exists(os.path.join(modlibs_path, 'SporeModManagerDisabled'))
+	assert not os.path.exists(os.path.join(ep1_path, 'SporeModManagerDisabled'))
+	result = run_smm([ 'list-installed' ])
+	assert result.returncode == 0
+	assert '(disabled)' not in result.stdout
+
+	# uninstalling a disabled mod should remove its files
+	result = run_smm([ 'disable', '0' ])
+	assert result.returncode == 0
+	result = run_smm([ 'uninstall', '0', '1' ])
 	assert result.returncode == 0
-	assert result.stdout != ''
 	assert result.stderr == ''
+	assert not os.path.exists(disabled_file)
+	assert not os.path.exists(os.path.join(modlibs_path, 'SporeModManagerDisabled'))
 
-	# ensure updating when we dont have a modapi dll works
-	os.remove(sporemodapi_file)
-	result = run_smm([ 'update-modapi' ])
+# Tests whether profiles work correctly
+def test_profile():
+	print(f'Running {test_profile.__name__}...')
+	reset_smm()
+
+	package_files = [ ]
+	installed_files = [ ]
+	for name in [ 'a', 'b', 'c' ]:
+		profile_package_file = os.path.join(mods_path, f'test_profile_{name}.package')
+		write_package(profile_package_file)
+		package_files.append(profile_package_file)
+		installed_files.append(os.path.join(ep1_path, f'test_profile_{name}.package'))
+
+	result = run_smm([ 'install' ] + package_files)
 	assert result.returncode == 0
-	assert result.stdout != ''
+
+	# invalid usage should fail
+	for args in [ [ 'profile' ], [ 'profile', 'invalid', 'a' ], [ 'profile', 'switch', 'a' ], [ 'profile', 'delete', 'a' ] ]:
+		result = run_smm(args)
+		assert result.returncode == 1
+
+	# profile a contains mod a and b, profile b contains mod b and c
+	result = run_smm([ 'disable', '2' ])
+	assert result.returncode == 0
+	result = run_smm([ 'profile', 'save', 'a' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	result = run_smm([ 'enable', '2' ])
+	assert result.returncode == 0
+	result = run_smm([ 'disable', '0' ])
+	assert result.returncode == 0
+	result = run_smm([ 'profile', 'save', 'b' ])
+	assert result.returncode == 0
+	result = run_smm([ 'profile', 'list' ])
+	assert result.returncode == 0
+	assert result.stdout == '  a (2 mod(s))\n* b (2 mod(s))\n'
+
+	# switching should only move the mods which differ
+	result = run_smm([ 'profile', 'switch', 'a' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert 'enabling 1 and disabling 1 mod(s)' in result.stdout
+	assert 'test_profile_b' not in result.stdout
+	assert os.path.isfile(installed_files[0])
+	assert os.path.isfile(installed_files[1])
+	assert not os.path.isfile(installed_files[2])
+	result = run_smm([ 'profile', 'list' ])
+	assert result.stdout == '* a (2 mod(s))\n  b (2 mod(s))\n'
+	result = run_smm([ 'profile', 'switch', 'a' ])
+	assert result.returncode == 0
+	assert 'enabling 0 and disabling 0 mod(s)' in result.stdout
+
+	# profiles with mods which aren't installed cannot be switched to
+	result = run_smm([ 'uninstall', '2' ])
+	assert result.returncode == 0
+	result = run_smm([ 'profile', 'switch', 'b' ])
+	assert result.returncode == 1
 	assert result.stderr != ''
+	assert os.path.isfile(installed_files[0])
 
-	# ensure updating when already up-to-date doesn't touch the file
-	before_update_mtime = os.path.getmtime(sporemodapi_file)
-	result = run_smm([ 'update-modapi' ])
+	result = run_smm([ 'profile', 'delete', 'a' ])
+	assert result.returncode == 0
+	result = run_smm([ 'profile', 'list' ])
+	assert result.stdout == '  b (2 mod(s))\n'
+
+	result = run_smm([ 'uninstall', '0-1' ])
+	assert result.returncode == 0
+
+# Tests whether identical files can be shared by mods
+def test_install_shared():
+	print(f'Running {test_install_shared.__name__}...')
+	reset_smm()
+
+	content = str(uuid.uuid4())
+	mod_files = [ ]
+	for name in [ 'a', 'b', 'c' ]:
+		xml = f"""<mod displayName="test_install_shared_{name}"
+					unique="test_install_shared_{name}"
+					description="test_install_shared_{name}"
+					installerSystemVersion="1.0.1.1"
+					dllsBuild="2.5.20">
+					<prerequisite>test_install_shared.dll</prerequisite>
+				</mod>"""
+		mod_files.append(write_sporemod(xml, [ [ 'test_install_shared.dll', content if name != 'c' else str(uuid.uuid4()) ] ], True))
+	installed_file = os.path.join(modlibs_path, 'test_install_shared.dll')
+	disabled_file = os.path.join(modlibs_path, 'SporeModManagerDisabled', 'test_install_shared_b', 'test_install_shared.dll')
+
+	# identical files should be shared
+	result = run_smm([ 'install', mod_files[0] ])
+	assert result.returncode == 0
+	result = run_smm([ 'install', mod_files[1] ])
 	assert result.returncode == 0
-	assert result.stdout != ''
 	assert result.stderr == ''
-	assert before_update_mtime == os.path.getmtime(sporemodapi_file)
+	assert 'Skipping shared' in result.stdout
+	assert check_file_contents(installed_file, content)
 
-	# ensure mod with higher dll build required works
-	result = run_smm([ 'install', sporemod_file ])
+	# different files should still collide
+	result = run_smm([ 'install', mod_files[2] ])
+	assert result.returncode == 1
+	assert result.stderr != ''
+	assert check_file_contents(installed_file, content)
+
+	# a shared file which differs on disk shouldn't be replaced
+	result = run_smm([ 'uninstall', '1' ])
+	assert result.returncode == 0
+	with open(installed_file, 'w') as file:
+		file.write('test_install_shared')
+	result = run_smm([ 'install', mod_files[1] ])
+	assert result.returncode == 1
+	assert 'is shared with test_install_shared_a but differs on disk' in result.stderr
+	assert check_file_contents(installed_file, 'test_install_shared')
+	with open(installed_file, 'w') as file:
+		file.write(content)
+	result = run_smm([ 'install', mod_files[1] ])
+	assert result.returncode == 0
+	assert check_file_contents(installed_file, content)
+
+	# disabling a mod shouldn't move a file which is still used
+	result = run_smm([ 'disable', '1' ])
 	assert result.returncode == 0
-	assert result.stdout != ''
 	assert result.stderr == ''
+	assert check_file_contents(installed_file, content)
 
-#
-# main
-#
+	# uninstalling should keep the file for the disabled mod
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert not os.path.exists(installed_file)
+	assert check_file_contents(disabled_file, content)
 
-if __name__ == "__main__":
-	# register exit handler for cleanup
-	atexit.register(cleanup_smm)
+	result = run_smm([ 'enable', '0' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert check_file_contents(installed_file, content)
 
-	# add argument parser
-	parser = argparse.ArgumentParser(description='Runs SporeModManager tests.')
-	parser.add_argument('--nocleanup', action='store_false', help="skips cleanup of temporary directory")
-	parser.add_argument('--verbose', action='store_true', help='prints command output for each test')
-	parser.add_argument('--network', action='store_true', help='runs tests which require network access')
-	parser.add_argument('--valgrind', action='store_true', help='runs tests with valgrind')
-	parser.add_argument('executable', help='executable to run tests with.')
-	args = parser.parse_args()
+	# uninstalling the last mod should remove the file
+	result = run_smm([ 'install', mod_files[0] ])
+	assert result.returncode == 0
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert check_file_contents(installed_file, content)
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert not os.path.exists(installed_file)
 
-	# set global variables
-	sporemodmanager = args.executable
-	verbose 		= args.verbose
-	cleanup         = args.nocleanup
-	network         = args.network
-	valgrind        = args.valgrind
+# Tests whether resource conflicts between packages are detected
+def test_conflicts():
+	print(f'Running {test_conflicts.__name__}...')
+	reset_smm()
 
-	# create test directories
-	os.mkdir(mods_path)
-	os.mkdir(mods2_path)
-	os.mkdir(corelibs_path)
-	os.mkdir(modlibs_path)
-	os.mkdir(data_path)
-	os.mkdir(ep1_path)
+	package_files = [ ]
+	for name, keys in [ ('a', [ (1, 1, 1), (1, 2, 1), (2, 3, 1) ]), ('b', [ (1, 2, 1), (2, 3, 1) ]), ('c', [ (1, 2, 2) ]) ]:
+		conflicts_package_file = os.path.join(mods_path, f'test_conflicts_{name}.package')
+		write_dbpf_package(conflicts_package_file, keys)
+		package_files.append(conflicts_package_file)
 
-	# write spore mod api dll and package file
-	write_sporemodapi_dll(sporemodapi_file)
-	write_package(package_file)
-	write_package(package_file_2)
-	write_invalid(invalid_file)
+	result = run_smm([ 'install', package_files[0], package_files[2] ])
+	assert result.returncode == 0
+	result = run_smm([ 'conflicts' ])
+	assert result.returncode == 0
+	assert result.stdout == 'No conflicting resources found\n'
+
+	# the index should be updated when installing
+	result = run_smm([ 'install', package_files[1], package_file ])
+	assert result.returncode == 0
+	assert 'Warning: "test_conflicts_b.package" contains 2 resource(s)' in result.stderr
+	assert os.path.isfile(f'{config_file}.resources')
+	result = run_smm([ 'conflicts' ])
+	assert result.returncode == 0
+	assert '-> 2 resource(s) are in "test_conflicts_a.package" (test_conflicts_a) and "test_conflicts_b.package" (test_conflicts_b)' in result.stdout
+	assert '--> 0x00000001!0x00000002.0x00000001' in result.stdout
+	assert '--> 0x00000002!0x00000003.0x00000001' in result.stdout
+	assert 'Indexing' not in result.stdout
+
+	# disabled mods shouldn't conflict
+	result = run_smm([ 'disable', '1' ])
+	assert result.returncode == 0
+	result = run_smm([ 'conflicts' ])
+	assert result.returncode == 0
+	assert result.stdout == 'No conflicting resources found\n'
+	result = run_smm([ 'enable', '1' ])
+	assert result.returncode == 0
+
+	# changed packages should be indexed again
+	write_dbpf_package(os.path.join(ep1_path, 'test_conflicts_b.package'), [ (3, 3, 3) ])
+	result = run_smm([ 'conflicts' ])
+	assert result.returncode == 0
+	assert 'Indexing' in result.stdout
+	assert 'No conflicting resources found' in result.stdout
+
+	# the index should be updated when uninstalling
+	result = run_smm([ 'uninstall', '0-3' ])
+	assert result.returncode == 0
+	result = run_smm([ 'conflicts' ])
+	assert result.returncode == 0
+	assert result.stdout == 'No conflicting resources found\n'
+
+# Tests whether resource conflicts are reported before installing
+def test_install_conflicts():
+	print(f'Running {test_install_conflicts.__name__}...')
+	reset_smm()
+
+	conflicts_package_file = os.path.join(mods_path, 'test_install_conflicts.package')
+	write_dbpf_package(conflicts_package_file, [ (1, 1, 1), (1, 2, 1) ])
+	result = run_smm([ 'install', conflicts_package_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+
+	# both stored and compressed packages should be scanned
+	for compress_type in [ zipfile.ZIP_STORED, zipfile.ZIP_DEFLATED ]:
+		xml = """<mod displayName="test_install_conflicts_mod"
+					unique="test_install_conflicts_mod"
+					description="test_install_conflicts_mod"
+					installerSystemVersion="1.0.1.1"
+					dllsBuild="2.5.20">
+					<prerequisite game="galacticadventures">test_install_conflicts_mod.package</prerequisite>
+				</mod>"""
+		mod_file = write_sporemod(xml, None, True)
+		with zipfile.ZipFile(mod_file, mode='a') as archive:
+			archive.writestr('test_install_conflicts_mod.package', get_dbpf_package([ (1, 2, 1), (1, 3, 1) ]), compress_type)
+		result = run_smm([ 'install', mod_file ])
+		assert result.returncode == 0
+		assert 'Warning: "test_install_conflicts_mod.package" contains 1 resource(s) which are also in "test_install_conflicts.package" (test_install_conflicts)!' in result.stderr
+		assert '--> 0x00000001!0x00000002.0x00000001 is also in "test_install_conflicts.package"' in result.stdout
+		result = run_smm([ 'uninstall', '1' ])
+		assert result.returncode == 0
+
+	# packages without conflicts shouldn't warn
+	mod_file = write_sporemod(xml, [ [ 'test_install_conflicts_mod.package', get_dbpf_package([ (2, 2, 2) ]) ] ], True)
+	result = run_smm([ 'install', mod_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+
+	result = run_smm([ 'uninstall', '0-1' ])
+	assert result.returncode == 0
+
+# Tests whether merging packages works correctly
+def test_merge_packages():
+	print(f'Running {test_merge_packages.__name__}...')
+	reset_smm()
+
+	package_files = [ ]
+	for name, keys in [ ('a', [ (1, 1, 1), (1, 2, 1) ]), ('b', [ (1, 2, 1), (2, 3, 1) ]), ('c', [ (3, 3, 3) ]) ]:
+		merge_package_file = os.path.join(mods_path, f'test_merge_packages_{name}.package')
+		write_dbpf_package(merge_package_file, keys)
+		package_files.append(merge_package_file)
+
+	merged_package_file = os.path.join(ep1_path, 'SporeModManagerMerged.package')
+	merged_path = os.path.join(ep1_path, 'SporeModManagerMerged')
+
+	result = run_smm([ 'install' ] + package_files)
+	assert result.returncode == 0
+
+	# disabled mods can't be merged
+	result = run_smm([ 'disable', '2' ])
+	assert result.returncode == 0
+	result = run_smm([ 'merge-packages', '2' ])
+	assert result.returncode == 1
+	assert not os.path.isfile(merged_package_file)
+	result = run_smm([ 'enable', '2' ])
+	assert result.returncode == 0
+
+	# resources of later ids should override earlier ones
+	result = run_smm([ 'merge-packages', '0', '1' ])
+	assert result.returncode == 0
+	assert check_file_bytes(merged_package_file, get_dbpf_package([ (1, 1, 1), (1, 2, 1), (2, 3, 1) ]))
+	assert not os.path.isfile(os.path.join(ep1_path, 'test_merge_packages_a.package'))
+	assert os.path.isfile(os.path.join(merged_path, 'test_merge_packages_a.package'))
+	assert os.path.isfile(os.path.join(ep1_path, 'test_merge_packages_c.package'))
+	result = run_smm([ 'check' ])
+	assert result.returncode == 0
+	assert '0 modified, 0 missing' in result.stdout
+	result = run_smm([ 'merge-packages', '1', '0' ])
+	assert result.returncode == 0
+	assert check_file_bytes(merged_package_file, get_dbpf_package([ (2, 3, 1), (1, 1, 1), (1, 2, 1) ]))
+
+	# updating shouldn't restore merged packages
+	# when configuring one of the mods fails
+	xml = """<mod displayName="test_merge_packages_d"
+				unique="test_merge_packages_d"
+				description="test_merge_packages_d"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				<prerequisite game="GalacticAdventures">test_merge_packages_{}.package</prerequisite>
+			</mod>"""
+	result = run_smm([ 'install', write_sporemod(xml.format('d'), [ [ 'test_merge_packages_d.package', 'test_merge_packages_d' ] ]) ])
+	assert result.returncode == 0
+	result = run_smm([ 'update', package_files[0], write_sporemod(xml.format('c'), [ [ 'test_merge_packages_c.package', 'test_merge_packages_d' ] ]) ])
+	assert result.returncode == 1
+	assert check_file_bytes(merged_package_file, get_dbpf_package([ (2, 3, 1), (1, 1, 1), (1, 2, 1) ]))
+	assert not os.path.isfile(os.path.join(ep1_path, 'test_merge_packages_a.package'))
+	assert os.path.isfile(os.path.join(merged_path, 'test_merge_packages_a.package'))
+	result = run_smm([ 'check' ])
+	assert result.returncode == 0
+	assert '0 modified, 0 missing' in result.stdout
+	result = run_smm([ 'uninstall', '3' ])
+	assert result.returncode == 0
+
+	# merging replaces the previous merge
+	result = run_smm([ 'merge-packages', '0', '2' ])
+	assert result.returncode == 0
+	assert check_file_bytes(merged_package_file, get_dbpf_package([ (1, 1, 1), (1, 2, 1), (3, 3, 3) ]))
+	assert os.path.isfile(os.path.join(ep1_path, 'test_merge_packages_b.package'))
+
+	# uninstalling should rebuild the merged package
+	result = run_smm([ 'uninstall', '2' ])
+	assert result.returncode == 0
+	assert check_file_bytes(merged_package_file, get_dbpf_package([ (1, 1, 1), (1, 2, 1) ]))
+
+	# disabling should restore the packages
+	result = run_smm([ 'disable', '0' ])
+	assert result.returncode == 0
+	assert not os.path.isfile(merged_package_file)
+	assert not os.path.exists(merged_path)
+	result = run_smm([ 'enable', '0' ])
+	assert result.returncode == 0
+	assert os.path.isfile(os.path.join(ep1_path, 'test_merge_packages_a.package'))
+
+	result = run_smm([ 'merge-packages', '0-1' ])
+	assert result.returncode == 0
+	result = run_smm([ 'unmerge-packages' ])
+	assert result.returncode == 0
+	assert not os.path.isfile(merged_package_file)
+	assert not os.path.exists(merged_path)
+	assert check_file_bytes(os.path.join(ep1_path, 'test_merge_packages_a.package'), get_dbpf_package([ (1, 1, 1), (1, 2, 1) ]))
+	assert check_file_bytes(os.path.join(ep1_path, 'test_merge_packages_b.package'), get_dbpf_package([ (1, 2, 1), (2, 3, 1) ]))
+
+	result = run_smm([ 'uninstall', '0-1' ])
+	assert result.returncode == 0
+
+# Tests whether compacting packages works correctly
+def test_compact_package():
+	print(f'Running {test_compact_package.__name__}...')
+	reset_smm()
+
+	keys = [ (1, 1, 1), (1, 2, 1), (2, 3, 1) ]
+	compact_package_file = os.path.join(mods_path, 'test_compact_package.package')
+	with open(compact_package_file, 'wb') as file:
+		file.write(get_dbpf_package(keys, 8))
+
+	result = run_smm([ 'compact-package', compact_package_file ])
+	assert result.returncode == 0
+	assert 'Compacted' in result.stdout
+	assert check_file_bytes(compact_package_file, get_dbpf_package(keys))
+	result = run_smm([ 'compact-package', compact_package_file ])
+	assert result.returncode == 0
+	assert 'is already compact' in result.stdout
+	assert check_file_bytes(compact_package_file, get_dbpf_package(keys))
+
+	# invalid packages shouldn't be changed
+	invalid_package_file = os.path.join(mods_path, 'test_compact_package_invalid.package')
+	write_package(invalid_package_file)
+	result = run_smm([ 'compact-package', invalid_package_file ])
+	assert result.returncode == 1
+	assert check_file_contents(invalid_package_file, 'package')
+
+	# packages should be compacted while installing with --compact
+	with open(compact_package_file, 'wb') as file:
+		file.write(get_dbpf_package(keys, 8))
+	result = run_smm([ '--compact', 'install', compact_package_file, invalid_package_file ])
+	assert result.returncode == 0
+	assert check_file_bytes(os.path.join(ep1_path, 'test_compact_package.package'), get_dbpf_package(keys))
+	assert check_file_bytes(compact_package_file, get_dbpf_package(keys, 8))
+	assert check_file_contents(os.path.join(ep1_path, 'test_compact_package_invalid.package'), 'package')
+	result = run_smm([ 'check', '--rehash' ])
+	assert result.returncode == 0
+	assert '0 modified, 0 missing' in result.stdout
+
+	result = run_smm([ 'uninstall', '0-1' ])
+	assert result.returncode == 0
+
+# Tests whether inspect-package decompresses resources correctly
+def test_inspect_package():
+	print(f'Running {test_inspect_package.__name__}...')
+	reset_smm()
+
+	chunk = os.urandom(64)
+	resources = [
+		(1, 1, 1, b''),
+		(1, 2, 1, b'a'),
+		(1, 3, 1, b'abcabcabcabcabcabc' * 100),
+		(2, 4, 1, uuid.uuid4().bytes * 64 + bytes(range(256)) * 512 + b'abc'),
+		(2, 5, 1, chunk + os.urandom(2000) + chunk + os.urandom(200000) + chunk + bytes(range(256)) * 8)
+	]
+	inspect_package_file = os.path.join(mods_path, 'test_inspect_package.package')
+	with open(inspect_package_file, 'wb') as file:
+		file.write(get_compressed_dbpf_package(resources))
+
+	result = run_smm([ 'inspect-package', inspect_package_file ])
+	assert result.returncode == 0
+	assert f'0x00000001!0x00000003.0x00000001 {len(refpack_compress(resources[2][3]))} / 1800 bytes' in result.stdout
+	assert 'Resources: 5' in result.stdout
+
+	result = run_smm([ 'inspect-package', inspect_package_file, 'hash' ])
+	assert result.returncode == 0
+	assert 'Decoded 5 resource(s)' in result.stdout
+	for (group, instance, type, resource) in resources:
+		assert hashlib.sha256(resource).hexdigest() in result.stdout
+
+	dump_path = os.path.join(tests_path, 'dump')
+	result = run_smm([ 'inspect-package', inspect_package_file, 'dump', dump_path ])
+	assert result.returncode == 0
+	for (group, instance, type, resource) in resources:
+		assert check_file_bytes(os.path.join(dump_path, f'0x{group:08x}!0x{instance:08x}.0x{type:08x}'), resource)
+
+	# corrupt resources should fail
+	package = bytearray(get_compressed_dbpf_package(resources[2:3]))
+	package[96 + 5] = 0x7f
+	with open(inspect_package_file, 'wb') as file:
+		file.write(package)
+	result = run_smm([ 'inspect-package', inspect_package_file, 'hash' ])
+	assert result.returncode == 1
+	assert 'failed to read 0x00000001!0x00000003.0x00000001' in result.stderr
+
+	write_package(inspect_package_file)
+	result = run_smm([ 'inspect-package', inspect_package_file ])
+	assert result.returncode == 1
+
+# Tests whether packages are patched in place when updating with --patch
+def test_update_patch():
+	print(f'Running {test_update_patch.__name__}...')
+	reset_smm()
+
+	resources = [ (1, i, 1, os.urandom(4096)) for i in range(16) ]
+	updated_resources = resources[:3] + [ (1, 3, 1, os.urandom(4096)) ] + resources[4:] + [ (2, 1, 1, b'test_update_patch') ]
+	patch_package_file = os.path.join(mods_path, 'test_update_patch.package')
+	installed_package_file = os.path.join(ep1_path, 'test_update_patch.package')
+	dump_path = os.path.join(tests_path, 'dump_update_patch')
+
+	def check_resources(path, resources):
+		shutil.rmtree(dump_path, ignore_errors=True)
+		result = run_smm([ 'inspect-package', path, 'dump', dump_path ])
+		assert result.returncode == 0
+		assert len(os.listdir(dump_path)) == len(resources)
+		for (group, instance, type, resource) in resources:
+			assert check_file_bytes(os.path.join(dump_path, f'0x{group:08x}!0x{instance:08x}.0x{type:08x}'), resource)
+
+	with open(patch_package_file, 'wb') as file:
+		file.write(get_compressed_dbpf_package(resources))
+	result = run_smm([ 'install', patch_package_file ])
+	assert result.returncode == 0
+	installed_size = os.path.getsize(installed_package_file)
+
+	# only the changed resources and the index should be written
+	with open(patch_package_file, 'wb') as file:
+		file.write(get_compressed_dbpf_package(updated_resources))
+	result = run_smm([ '--patch', 'update', patch_package_file ])
+	assert result.returncode == 0
+	assert 'Patching "test_update_patch.package"' in result.stdout
+	assert os.path.getsize(installed_package_file) < installed_size + os.path.getsize(patch_package_file) // 4
+	check_resources(installed_package_file, updated_resources)
+	result = run_smm([ 'check', '--rehash' ])
+	assert result.returncode == 0
+	assert '0 modified, 0 missing' in result.stdout
+
+	# packages in sporemods should be patched as well
+	xml = """<mod displayName="test_update_patch_sporemod"
+				unique="test_update_patch_sporemod"
+				description="test_update_patch_sporemod"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				<prerequisite>test_update_patch_sporemod.package</prerequisite>
+			</mod>"""
+	# use other groups, so the resources don't conflict
+	resources = [ (group + 2, instance, type, resource) for (group, instance, type, resource) in resources ]
+	updated_resources = [ (group + 2, instance, type, resource) for (group, instance, type, resource) in updated_resources ]
+	mod_file = write_sporemod(xml, [ [ 'test_update_patch_sporemod.package', get_compressed_dbpf_package(resources) ] ], True)
+	result = run_smm([ 'install', mod_file ])
+	assert result.returncode == 0
+	mod_file = write_sporemod(xml, [ [ 'test_update_patch_sporemod.package', get_compressed_dbpf_package(updated_resources) ] ], True)
+	result = run_smm([ '--patch', 'update', mod_file ])
+	assert result.returncode == 0
+	assert 'Patching "test_update_patch_sporemod.package"' in result.stdout
+	check_resources(os.path.join(modlibs_path, 'test_update_patch_sporemod.package'), updated_resources)
+
+	# packages which have changed too much should be installed completely
+	updated_resources = [ (1, i, 1, os.urandom(4096)) for i in range(16) ]
+	with open(patch_package_file, 'wb') as file:
+		file.write(get_compressed_dbpf_package(updated_resources))
+	result = run_smm([ '--patch', 'update', patch_package_file ])
+	assert result.returncode == 0
+	assert 'Unable to patch "test_update_patch.package"' in result.stdout
+	assert check_file_bytes(installed_package_file, get_compressed_dbpf_package(updated_resources))
+
+	# modified packages shouldn't be patched
+	with open(installed_package_file, 'ab') as file:
+		file.write(b'modified')
+	result = run_smm([ '--patch', 'update', patch_package_file ])
+	assert result.returncode == 0
+	assert 'Patching' not in result.stdout
+	assert check_file_bytes(installed_package_file, get_compressed_dbpf_package(updated_resources))
+
+	result = run_smm([ 'uninstall', '0-1' ])
+	assert result.returncode == 0
+
+# Tests whether names are hashed like Spore does and shown for resources
+def test_resource_names():
+	print(f'Running {test_resource_names.__name__}...')
+	reset_smm()
+
+	names_file = os.path.join(tests_path, 'names.txt')
+	dictionary_file = config_file + '.names'
+	if os.path.isfile(dictionary_file):
+		os.remove(dictionary_file)
+
+	# Spore's id() is FNV-1 of the lowercase name with signed characters
+	def spore_id(name):
+		hash = 0x811C9DC5
+		for c in name.encode():
+			if c >= 0x80:
+				c |= 0xFFFFFF00
+			elif c >= ord('A') and c <= ord('Z'):
+				c += 32
+			hash = ((hash * 0x01000193) & 0xFFFFFFFF) ^ c
+		return hash
+
+	names = [ 'a', 'Z', 'CreatureEditor', 'creature_editor~', 'TestResourceNames', 'prop', 'png', 'rw4', 'édition',
+			  'editor_setup_' * 5, 'x' * 200 ] + [ f'test_resource_names_{i}' for i in range(20) ]
+	result = run_smm([ 'hash-names' ] + names)
+	assert result.returncode == 0
+	for name in names:
+		assert f'0x{spore_id(name):08x} {name}\n' in result.stdout
+	assert '0x050c5d7e a\n' in result.stdout
+
+	resources = [
+		(spore_id('TestResourceNames'), spore_id('CreatureEditor'), spore_id('prop'), b'a'),
+		(spore_id('TestResourceNames'), 0x12345678, spore_id('rw4'), b'b')
+	]
+	inspect_package_file = os.path.join(mods_path, 'test_resource_names.package')
+	with open(inspect_package_file, 'wb') as file:
+		file.write(get_compressed_dbpf_package(resources))
+
+	result = run_smm([ 'inspect-package', inspect_package_file ])
+	assert result.returncode == 0
+	assert f'0x{spore_id("TestResourceNames"):08x}!0x{spore_id("CreatureEditor"):08x}.0x{spore_id("prop"):08x} ' in result.stdout
+
+	with open(names_file, 'w', newline='') as file:
+		file.write('\r\n'.join(names[:6]) + '\r\n\n')
+	result = run_smm([ 'add-names', names_file ])
+	assert result.returncode == 0
+	assert os.path.isfile(dictionary_file)
+
+	# names are added to the existing ones
+	with open(names_file, 'w') as file:
+		file.write('\n'.join(names[5:]))
+	result = run_smm([ 'add-names', names_file ])
+	assert result.returncode == 0
+
+	result = run_smm([ 'inspect-package', inspect_package_file ])
+	assert result.returncode == 0
+	assert 'TestResourceNames!CreatureEditor.prop ' in result.stdout
+	assert 'TestResourceNames!0x12345678.rw4 ' in result.stdout
+
+	# the dump keeps using hashes
+	dump_path = os.path.join(tests_path, 'dump_resource_names')
+	result = run_smm([ 'inspect-package', inspect_package_file, 'dump', dump_path ])
+	assert result.returncode == 0
+	assert check_file_bytes(os.path.join(dump_path, f'0x{spore_id("TestResourceNames"):08x}!0x12345678.0x{spore_id("rw4"):08x}'), b'b')
+
+	# an invalid dictionary is ignored
+	with open(dictionary_file, 'r+b') as file:
+		file.truncate(20)
+	result = run_smm([ 'inspect-package', inspect_package_file ])
+	assert result.returncode == 0
+	assert f'0x{spore_id("TestResourceNames"):08x}!0x12345678.0x{spore_id("rw4"):08x} ' in result.stdout
+
+	result = run_smm([ 'add-names', os.path.join(tests_path, 'test_resource_names_missing.txt') ])
+	assert result.returncode == 1
+
+	os.remove(dictionary_file)
+
+# Tests whether the load manifest is written and only used while it's current
+def test_load_manifest():
+	print(f'Running {test_load_manifest.__name__}...')
+	reset_smm()
+
+	manifest_file = os.path.join(tests_path, 'ModLibs.manifest')
+
+	def read_manifest():
+		with open(manifest_file, 'rb') as file:
+			data = file.read()
+		(magic, version, count, reserved, modified_time) = struct.unpack_from('<4sIIIq', data, 0)
+		assert magic == b'SMLM' and version == 2
+		offset = 24
+		names = [ ]
+		for i in range(count):
+			(size, modified_time, name_size, reserved) = struct.unpack_from('<QqII', data, offset)
+			offset += 24
+			names.append(data[offset:offset + name_size].decode())
+			offset += name_size
+		assert offset == len(data)
+		return names
+
+	def get_load_order():
+		names = [ name for name in os.listdir(modlibs_path) if name.lower().endswith('.dll') and os.path.isfile(os.path.join(modlibs_path, name)) ]
+		return sorted(names, key=lambda name: name.lower())
+
+	def check_load_order(current):
+		result = run_smm([ 'load-order' ])
+		assert result.returncode == 0
+		assert ('Using load manifest' in result.stdout) == current
+		assert ('is outdated' in result.stdout) != current
+		assert [ line for line in result.stdout.splitlines() if not line.startswith('-') ] == get_load_order()
+
+	xml = """<mod displayName="test_load_manifest"
+				unique="test_load_manifest"
+				description="test_load_manifest"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				<prerequisite>Test_Load_Manifest_B.DLL</prerequisite>
+				<prerequisite>test_load_manifest_a.dll</prerequisite>
+				<prerequisite>test_load_manifest_c-steam.dll</prerequisite>
+				<prerequisite>test_load_manifest.package</prerequisite>
+			</mod>"""
+	files = [
+		[ 'Test_Load_Manifest_B.DLL', str(uuid.uuid4()) ],
+		[ 'test_load_manifest_a.dll', str(uuid.uuid4()) ],
+		[ 'test_load_manifest_c-steam.dll', str(uuid.uuid4()) ],
+		[ 'test_load_manifest.package', str(uuid.uuid4()) ]
+	]
+	write_sporemod(xml, files)
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 0
+
+	# the manifest lists every dll case insensitively sorted,
+	# the extension is compared case insensitively as well
+	names = read_manifest()
+	assert names == get_load_order()
+	assert names.index('test_load_manifest_a.dll') + 1 == names.index('Test_Load_Manifest_B.DLL')
+	assert 'test_load_manifest_c-steam.dll' in names
+	assert 'test_load_manifest.package' not in names
+	check_load_order(True)
+
+	# the times are microseconds since the unix epoch, so a manifest
+	# written by a build with another compiler is current as well
+	def write_manifest(modified_time):
+		data = b''
+		for name in names:
+			path = os.path.join(modlibs_path, name)
+			os.utime(path, ns=(modified_time * 1000, modified_time * 1000))
+			data += struct.pack('<QqII', os.path.getsize(path), modified_time, len(name.encode()), 0) + name.encode()
+		os.utime(modlibs_path, ns=(modified_time * 1000, modified_time * 1000))
+		with open(manifest_file, 'wb') as file:
+			file.write(struct.pack('<4sIIIq', b'SMLM', 2, len(names), 0, modified_time) + data)
+	write_manifest(1600000000123456)
+	check_load_order(True)
+	os.utime(modlibs_path, ns=(1600000000123457000, 1600000000123457000))
+	check_load_order(False)
+	os.utime(modlibs_path, ns=(1600000000123456000, 1600000000123456000))
+	check_load_order(True)
+
+	# names outside of modlibs are rejected, even when they'd match
+	installed_dll_file = os.path.join(modlibs_path, 'test_load_manifest_a.dll')
+	outside_dll_file = os.path.join(tests_path, 't_load_manifest_a.dll')
+	shutil.copyfile(installed_dll_file, outside_dll_file)
+	stat = os.stat(installed_dll_file)
+	os.utime(outside_dll_file, ns=(stat.st_atime_ns, stat.st_mtime_ns))
+	with open(manifest_file, 'rb') as file:
+		manifest = file.read()
+	with open(manifest_file, 'wb') as file:
+		file.write(manifest.replace(b'test_load_manifest_a.dll', b'../t_load_manifest_a.dll'))
+	check_load_order(False)
+	os.remove(outside_dll_file)
+
+	# truncated manifests are rejected
+	with open(manifest_file, 'wb') as file:
+		file.write(manifest[:-1])
+	check_load_order(False)
+	with open(manifest_file, 'wb') as file:
+		file.write(manifest)
+	check_load_order(True)
+
+	# changing a dll makes the manifest outdated
+	with open(installed_dll_file, 'a') as file:
+		file.write('test_load_manifest')
+	check_load_order(False)
+
+	# disabling or enabling a mod writes the manifest again
+	result = run_smm([ 'disable', '0' ])
+	assert result.returncode == 0
+	assert 'test_load_manifest_a.dll' not in read_manifest()
+	check_load_order(True)
+	result = run_smm([ 'enable', '0' ])
+	assert result.returncode == 0
+	assert 'test_load_manifest_a.dll' in read_manifest()
+	check_load_order(True)
+
+	# adding a dll makes the manifest outdated
+	with open(os.path.join(modlibs_path, 'test_load_manifest_d.dll'), 'w') as file:
+		file.write('test_load_manifest')
+	check_load_order(False)
+	os.remove(os.path.join(modlibs_path, 'test_load_manifest_d.dll'))
+
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert not any(name.lower().startswith('test_load_manifest') for name in read_manifest())
+	check_load_order(True)
+
+# Tests whether the loader profile is reported with the slowest dlls first
+def test_loader_report():
+	print(f'Running {test_loader_report.__name__}...')
+	reset_smm()
+
+	profile_file = os.path.join(tests_path, 'SporeModLoader.profile')
+
+	# events are (type, result, start, duration, file name) with times in milliseconds
+	def write_profile(path, events):
+		data = struct.pack('<4sIII', b'SMLP', 1, len(events), 0)
+		for (type, result, start, duration, name) in events:
+			data += struct.pack('<IIqqII', type, result, start * 1000000, duration * 1000000, len(name.encode()), 0)
+			data += name.encode()
+		with open(path, 'wb') as file:
+			file.write(data)
+		return data
+
+	xml = """<mod displayName="test_loader_report"
+				unique="test_loader_report"
+				description="test_loader_report"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				<prerequisite>test_loader_report_a.dll</prerequisite>
+				<prerequisite>test_loader_report_b.dll</prerequisite>
+			</mod>"""
+	files = [
+		[ 'test_loader_report_a.dll', str(uuid.uuid4()) ],
+		[ 'test_loader_report_b.dll', str(uuid.uuid4()) ]
+	]
+	write_sporemod(xml, files)
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 0
+
+	data = write_profile(profile_file, [
+		(0, 1, 1000, 2, ''),
+		(1, 1, 1002, 1, ''),
+		(2, 1, 1500, 3, ''),
+		(5, 1, 1503, 5, 'SporeModAPI.dll'),
+		(3, 1, 1503, 5, ''),
+		(5, 1, 1508, 1, 'test_loader_report_a.dll'),
+		(5, 1, 1509, 900, 'test_loader_report_b.dll'),
+		(5, 0, 2409, 3, 'test_loader_report_c.dll'),
+		(4, 1, 1508, 904, ''),
+		(5, 1, 5000, 1, 'test_loader_report_b.dll'),
+		(8, 1, 6000, 2, 'test_loader_report_b.dll'),
+		(6, 1, 6000, 2, '')
+	])
+
+	# the profile is next to the directory containing corelibs by default
+	result = run_smm([ 'loader-report' ])
+	assert result.returncode == 0
+	assert 'Read 12 event(s)' in result.stdout
+	assert 'Initialize:             2.000 ms' in result.stdout
+	assert 'LoadModLibs:            904.000 ms' in result.stdout
+	assert 'UnloadCoreLibs:' not in result.stdout
+	assert 'Startup:                1412.000 ms' in result.stdout
+	lines = [ line for line in result.stdout.splitlines() if line[0].isdigit() ]
+	assert lines == [
+		'1. "test_loader_report_b.dll" (test_loader_report): load 901.000 ms, unload 2.000 ms',
+		'2. "SporeModAPI.dll": load 5.000 ms, unload 0.000 ms',
+		'3. "test_loader_report_c.dll": load 3.000 ms, unload 0.000 ms (failed)',
+		'4. "test_loader_report_a.dll" (test_loader_report): load 1.000 ms, unload 0.000 ms'
+	]
+
+	custom_profile_file = os.path.join(tests_path, 'test_loader_report.profile')
+	shutil.move(profile_file, custom_profile_file)
+	result = run_smm([ 'loader-report', custom_profile_file ])
+	assert result.returncode == 0
+	assert '1. "test_loader_report_b.dll"' in result.stdout
+
+	# invalid profiles should fail
+	result = run_smm([ 'loader-report' ])
+	assert result.returncode == 1
+	with open(custom_profile_file, 'wb') as file:
+		file.write(data[:-1])
+	result = run_smm([ 'loader-report', custom_profile_file ])
+	assert result.returncode == 1
+	write_profile(custom_profile_file, [ (9, 1, 0, 1, '') ])
+	result = run_smm([ 'loader-report', custom_profile_file ])
+	assert result.returncode == 1
+	assert 'failed to read loader profile' in result.stderr
+	os.remove(custom_profile_file)
+
+# Tests whether dlls with unresolved imports are rejected and whether dlls are loaded after the dlls they import from
+def test_pe_imports():
+	print(f'Running {test_pe_imports.__name__}...')
+	reset_smm()
+
+	def get_load_order():
+		result = run_smm([ 'load-order' ])
+		assert result.returncode == 0
+		return [ line for line in result.stdout.splitlines() if not line.startswith('-') ]
+
+	def get_xml(name, dll_names):
+		prerequisites = ''.join(f'<prerequisite>{dll_name}</prerequisite>' for dll_name in dll_names)
+		return f"""<mod displayName="{name}"
+				unique="{name}"
+				description="{name}"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				{prerequisites}
+			</mod>"""
+
+	# the dll which is imported from sorts last
+	xml = get_xml('test_pe_imports_0', [ 'Test_Pe_Imports_Z.dll' ])
+	files = [
+		[ 'Test_Pe_Imports_Z.dll', get_pe_dll('Test_Pe_Imports_Z.dll', exports=[ 'Foo', 'Bar' ]) ]
+	]
+	write_sporemod(xml, files)
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 0
+
+	# names are resolved case insensitively, unknown dlls are system dlls
+	xml = get_xml('test_pe_imports_1', [ 'test_pe_imports_a.dll' ])
+	files = [
+		[ 'test_pe_imports_a.dll', get_pe_dll('test_pe_imports_a.dll', imports={ 'test_pe_imports_z.dll': [ 'Foo', 2 ], 'KERNEL32.dll': [ 'LoadLibraryW' ] }) ]
+	]
+	write_sporemod(xml, files)
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 0
+	load_order = get_load_order()
+	assert load_order.index('Test_Pe_Imports_Z.dll') < load_order.index('test_pe_imports_a.dll')
+
+	# missing names and ordinals are rejected
+	xml = get_xml('test_pe_imports_2', [ 'test_pe_imports_b.dll' ])
+	files = [
+		[ 'test_pe_imports_b.dll', get_pe_dll('test_pe_imports_b.dll', imports={ 'Test_Pe_Imports_Z.dll': [ 'Baz', 3 ] }) ]
+	]
+	write_sporemod(xml, files)
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 1
+	assert '"test_pe_imports_b.dll" imports "Baz" from "Test_Pe_Imports_Z.dll", which doesn\'t export it!' in result.stderr
+	assert '"test_pe_imports_b.dll" imports ordinal 3 from "Test_Pe_Imports_Z.dll", which doesn\'t export it!' in result.stderr
+	assert not os.path.exists(os.path.join(modlibs_path, 'test_pe_imports_b.dll'))
+
+	# dlls of the mod itself resolve its imports before they're installed
+	files = [
+		[ 'test_pe_imports_b.dll', get_pe_dll('test_pe_imports_b.dll', imports={ 'test_pe_imports_c.dll': [ 'Baz' ] }) ],
+		[ 'test_pe_imports_c.dll', get_pe_dll('test_pe_imports_c.dll', imports={ 'Test_Pe_Imports_Z.dll': [ 'Bar' ] }, exports=[ 'Baz' ]) ]
+	]
+	write_sporemod(get_xml('test_pe_imports_2', [ 'test_pe_imports_b.dll', 'test_pe_imports_c.dll' ]), files)
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 0
+	load_order = get_load_order()
+	assert load_order.index('Test_Pe_Imports_Z.dll') < load_order.index('test_pe_imports_c.dll') < load_order.index('test_pe_imports_b.dll')
+
+	result = run_smm([ 'check' ])
+	assert result.returncode == 0
+	assert 'unresolved' not in result.stdout
+
+	# check reports the imports which a changed dll breaks
+	with open(os.path.join(modlibs_path, 'Test_Pe_Imports_Z.dll'), 'wb') as file:
+		file.write(get_pe_dll('Test_Pe_Imports_Z.dll', exports=[ 'Foo' ]))
+	result = run_smm([ 'check' ])
+	assert result.returncode == 1
+	assert '2 unresolved import(s)' in result.stdout
+
+	result = run_smm([ 'uninstall', '0', '1', '2' ])
+	assert result.returncode == 0
+	assert not any(name.lower().startswith('test_pe_imports') for name in get_load_order())
+
+# Tests whether the extracted file cache works correctly
+def test_install_cache():
+	print(f'Running {test_install_cache.__name__}...')
+	reset_smm()
+
+	cache_path = os.path.join(tests_path, 'cache')
+	os.mkdir(cache_path)
+
+	content = str(uuid.uuid4())
+	large_content = 'a' * (2 * 1024 * 1024)
+	xml = """<mod displayName="test_install_cache"
+				unique="test_install_cache"
+				description="test_install_cache"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				<prerequisite>test_install_cache.dll</prerequisite>
+				<prerequisite>test_install_cache_large.dll</prerequisite>
+			</mod>"""
+	mod_file = write_sporemod(xml, [ [ 'test_install_cache.dll', content ], [ 'test_install_cache_large.dll', large_content ] ], True)
+
+	# cache-stats requires a cache
+	result = run_smm([ 'cache-stats' ])
+	assert result.returncode == 1
+	assert result.stderr != ''
+
+	# files larger than the cache shouldn't be cached
+	for num in range(2):
+		result = run_smm([ f'--cache-path={cache_path}', '--cache-size=1', 'install', mod_file ])
+		assert result.returncode == 0
+		assert result.stderr == ''
+		assert result.stdout.count('Using cached') == num
+		assert check_file_contents(os.path.join(modlibs_path, 'test_install_cache.dll'), content)
+		assert check_file_contents(os.path.join(modlibs_path, 'test_install_cache_large.dll'), large_content)
+		result = run_smm([ 'uninstall', '0' ])
+		assert result.returncode == 0
+
+	result = run_smm([ '--cache-path', cache_path, 'cache-stats' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert 'Entries: 1\n' in result.stdout
+	assert 'Hits:    1\n' in result.stdout
+	assert 'Misses:  3\n' in result.stdout
+
+	# invalid cache sizes should fail
+	result = run_smm([ '--cache-size=abc', 'install', mod_file ])
+	assert result.returncode == 1
+	assert result.stderr != ''
+
+# Tests whether installing to multiple targets works correctly
+def test_install_targets():
+	print(f'Running {test_install_targets.__name__}...')
+	reset_smm()
+
+	# every target has its own directories and configuration file
+	target_files = [ ]
+	target_paths = [ ]
+	for num in range(2):
+		target_path = os.path.join(tests_path, f'target_{num}')
+		for directory in [ 'CoreLibs', 'ModLibs', 'Data', 'DataEP1' ]:
+			os.makedirs(os.path.join(target_path, directory))
+		write_sporemodapi_dll(os.path.join(target_path, 'CoreLibs', 'SporeModAPI.dll'))
+		target_file = os.path.join(target_path, 'SporeModManager.xml')
+		with open(target_file, 'w') as file:
+			file.write(f"""<SporeModManager>
+							<Directories>
+								<CoreLibsDirectory>{os.path.join(target_path, 'CoreLibs')}</CoreLibsDirectory>
+								<ModLibsDirectory>{os.path.join(target_path, 'ModLibs')}</ModLibsDirectory>
+								<GalacticAdventuresDataDirectory>{os.path.join(target_path, 'DataEP1')}</GalacticAdventuresDataDirectory>
+								<CoreSporeDataDirectory>{os.path.join(target_path, 'Data')}</CoreSporeDataDirectory>
+							</Directories>
+						</SporeModManager>""")
+		target_files.append(target_file)
+		target_paths.append(target_path)
+
+	content = str(uuid.uuid4())
+	xml = """<mod displayName="test_install_targets"
+				unique="test_install_targets"
+				description="test_install_targets"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				<prerequisite>test_install_targets.dll</prerequisite>
+			</mod>"""
+	mod_file = write_sporemod(xml, [ [ 'test_install_targets.dll', content ] ], True)
+	targets = ','.join(target_files)
+
+	# targets cannot be combined with paths or other commands
+	result = run_smm([ f'--targets={targets}', 'install', mod_file ])
+	assert result.returncode == 1
+	assert result.stderr != ''
+	result = run_smm([ f'--targets={targets}', 'list-installed' ], False)
+	assert result.returncode == 1
+	assert result.stderr != ''
+
+	# the file should only be extracted for the first target
+	result = run_smm([ f'--targets={targets}', 'install', mod_file, package_file ], False)
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert result.stdout.count('Copying "test_install_targets.dll"') == 1
+	for num in range(2):
+		assert check_file_contents(os.path.join(target_paths[num], 'ModLibs', 'test_install_targets.dll'), content)
+		assert check_file_bytes(os.path.join(target_paths[num], 'DataEP1', 'test_package.package'), b'package')
+		with open(target_files[num], 'r') as file:
+			assert 'test_install_targets' in file.read()
+	assert not os.path.isfile(os.path.join(modlibs_path, 'test_install_targets.dll'))
+
+	# installing again should fail, unless it's only needed or updated
+	result = run_smm([ f'--targets={targets}', 'install', mod_file ], False)
+	assert result.returncode == 1
+	result = run_smm([ f'--targets={targets}', '-n', 'install', mod_file ], False)
+	assert result.returncode == 0
+	assert result.stderr == ''
+	result = run_smm([ f'--targets={targets}', '-u', 'install', mod_file ], False)
+	assert result.returncode == 0
+	assert result.stderr == ''
+
+# Tests whether the content store works correctly
+def test_install_store():
+	print(f'Running {test_install_store.__name__}...')
+	reset_smm()
+
+	store_path = os.path.join(tests_path, 'store')
+	index_file = os.path.join(store_path, 'index')
+	os.mkdir(store_path)
+
+	content = str(uuid.uuid4())
+	content_hash = hashlib.sha256(content.encode()).hexdigest()
+	object_file = os.path.join(store_path, 'objects', content_hash[:2], content_hash)
+
+	# both mods contain the same file contents
+	mod_files = [ ]
+	for num in range(2):
+		xml = f"""<mod displayName="test_install_store_{num}"
+					unique="test_install_store_{num}"
+					description="test_install_store_{num}"
+					installerSystemVersion="1.0.1.1"
+					dllsBuild="2.5.20">
+					<prerequisite>test_install_store_{num}.dll</prerequisite>
+				</mod>"""
+		mod_files.append(write_sporemod(xml, [ [ f'test_install_store_{num}.dll', content ] ], True))
+
+	result = run_smm([ f'--store-path={store_path}', 'install', mod_files[0], mod_files[1] ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	for num in range(2):
+		assert check_file_contents(os.path.join(modlibs_path, f'test_install_store_{num}.dll'), content)
+	assert check_file_contents(object_file, content)
+	assert check_file_contents(index_file, f'{content_hash} 2\n')
+	result = run_smm([ '--rehash', 'check' ])
+	assert result.returncode == 0
+
+	# the stored file should only be removed with the last reference
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert os.path.isfile(object_file)
+	assert check_file_contents(index_file, f'{content_hash} 1\n')
+	assert check_file_contents(os.path.join(modlibs_path, 'test_install_store_1.dll'), content)
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert not os.path.isfile(object_file)
+	assert check_file_contents(index_file, '')
+
+	# updating should keep the reference of an unchanged file
+	result = run_smm([ f'--store-path={store_path}', 'install', mod_files[0] ])
+	assert result.returncode == 0
+	result = run_smm([ f'--store-path={store_path}', 'update', mod_files[0] ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert check_file_contents(index_file, f'{content_hash} 1\n')
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert check_file_contents(index_file, '')
+
+	# a failed install should release the references it has taken
+	xml = """<mod displayName="test_install_store_2"
+				unique="test_install_store_2"
+				description="test_install_store_2"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				<prerequisite>test_install_store_2.dll</prerequisite>
+				<prerequisite>test_install_store_3.dll</prerequisite>
+			</mod>"""
+	files = [
+		[ 'test_install_store_2.dll', get_pe_dll('test_install_store_2.dll', imports={ 'test_install_store_3.dll': [ 'Bar' ] }) ],
+		[ 'test_install_store_3.dll', get_pe_dll('test_install_store_3.dll', exports=[ 'Foo' ]) ]
+	]
+	result = run_smm([ f'--store-path={store_path}', 'install', write_sporemod(xml, files, True) ])
+	assert result.returncode == 1
+	for file in files:
+		file_hash = hashlib.sha256(file[1]).hexdigest()
+		assert not os.path.exists(os.path.join(modlibs_path, file[0]))
+		assert not os.path.isfile(os.path.join(store_path, 'objects', file_hash[:2], file_hash))
+	assert check_file_contents(index_file, '')
+
+	# packages should be copied into the store
+	package_hash = hashlib.sha256(b'package').hexdigest()
+	package_object_file = os.path.join(store_path, 'objects', package_hash[:2], package_hash)
+	result = run_smm([ '--store-path', store_path, 'install', package_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert check_file_bytes(package_object_file, b'package')
+	assert check_file_bytes(package_file, b'package')
+
+	# updating without the store should release the stored file
+	result = run_smm([ 'update', package_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert not os.path.isfile(package_object_file)
+	assert check_file_bytes(os.path.join(ep1_path, 'test_package.package'), b'package')
+
+# Tests whether check works correctly
+def test_check():
+	print(f'Running {test_check.__name__}...')
+	reset_smm()
+
+	# checking without any mods installed should work
+	result = run_smm([ 'check' ])
+	assert result.returncode == 0
+	assert '0 modified, 0 missing' in result.stdout
+	assert result.stderr == ''
+
+	xml = """<mod displayName="test_check_0"
+				unique="test_check_0"
+				description="test_check_0"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				<prerequisite>test_check_0.dll</prerequisite>
+				<prerequisite game="GalacticAdventures">test_check_0_0.package</prerequisite>
+				<prerequisite game="GalacticAdventures">test_check_0_1.package</prerequisite>
+			</mod>"""
+	files = [
+		[ 'test_check_0.dll', 'test_check_0.dll' ],
+		[ 'test_check_0_0.package', 'test_check_0_0.package' ],
+		[ 'test_check_0_1.package', 'test_check_0_1.package' ],
+	]
+	write_sporemod(xml, files)
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	result = run_smm([ 'install', package_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+
+	# freshly installed mods should be unchanged
+	for args in [ [ 'check' ], [ '--rehash', 'check' ] ]:
+		result = run_smm(args)
+		assert result.returncode == 0
+		assert 'Checked 4 file(s) of 2 mod(s), 0 modified, 0 missing' in result.stdout
+		assert result.stderr == ''
+
+	# the config file should contain the fingerprints
+	with open(config_file, 'r') as file:
+		config = file.read()
+		assert f'<Crc32>{zlib.crc32(files[0][1].encode()):08x}</Crc32>' in config
+		assert f'<Size>{len(files[0][1])}</Size>' in config
+
+	# replacing a file with the same size and modification time
+	# should only be detected when rehashing
+	dll_path = os.path.join(modlibs_path, files[0][0])
+	dll_stat = os.stat(dll_path)
+	with open(dll_path, 'w') as file:
+		file.write('x' * len(files[0][1]))
+	os.utime(dll_path, ns=(dll_stat.st_atime_ns, dll_stat.st_mtime_ns))
+	result = run_smm([ 'check' ])
+	assert result.returncode == 0
+	assert '0 modified, 0 missing' in result.stdout
+	assert result.stderr == ''
+	result = run_smm([ '--rehash', 'check' ])
+	assert result.returncode == 1
+	assert '1 modified, 0 missing' in result.stdout
+	assert dll_path in result.stdout
+	assert result.stderr == ''
+
+	# changing the size or removing a file
+	# should be detected in both modes
+	with open(os.path.join(ep1_path, files[1][0]), 'a') as file:
+		file.write('test_check')
+	os.remove(os.path.join(ep1_path, files[2][0]))
+	result = run_smm([ 'check' ])
+	assert result.returncode == 1
+	assert '1 modified, 1 missing' in result.stdout
+	assert 'test_check_0' in result.stdout
+	assert 'test_package' not in result.stdout
+	assert result.stderr == ''
+	result = run_smm([ '-r', 'check' ])
+	assert result.returncode == 1
+	assert '2 modified, 1 missing' in result.stdout
+	assert result.stderr == ''
+
+	# updating should restore the files which don't
+	# match their size and modification time
+	result = run_smm([ 'update', sporemod_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	result = run_smm([ 'check' ])
+	assert result.returncode == 0
+	assert '0 modified, 0 missing' in result.stdout
+	assert result.stderr == ''
+	result = run_smm([ '--rehash', 'check' ])
+	assert result.returncode == 1
+	assert '1 modified, 0 missing' in result.stdout
+	assert result.stderr == ''
+
+	# reinstalling should restore all files
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	result = run_smm([ '--rehash', 'check' ])
+	assert result.returncode == 0
+	assert '0 modified, 0 missing' in result.stdout
+	assert result.stderr == ''
+
+# Tests whether installing from an url works correctly
+def test_install_remote():
+	print(f'Running {test_install_remote.__name__}...')
+	reset_smm()
+
+	global http_bytes_served
+
+	# installing a package file from an url should fail
+	result = run_smm([ 'install', http_url + 'test_package.package' ])
+	assert result.returncode == 1
+	assert result.stdout == ''
+	assert result.stderr != ''
+
+	# installing a non-existent url should fail
+	result = run_smm([ 'install', http_url + 'test_remote_nonexistent.sporemod' ])
+	assert result.returncode == 1
+	assert result.stderr != ''
+
+	# only the central directory, modinfo.xml and the
+	# selected component should be downloaded
+	xml = """<mod displayName="test_install_remote_0"
+				unique="test_install_remote_0"
+				description="test_install_remote_0"
+				installerSystemVersion="1.0.1.1"
+				hasCustomInstaller="true"
+				dllsBuild="2.5.20">
+				<componentGroup unique="test_install_remote_0_group" displayName="test_install_remote_0_group">
+					<component unique="test_install_remote_0_1" displayName="test_install_remote_0_1" description="" game="GalacticAdventures">test_install_remote_0_1.package</component>
+					<component unique="test_install_remote_0_2" displayName="test_install_remote_0_2" description="" game="GalacticAdventures" defaultChecked="true">test_install_remote_0_2.package</component>
+					<component unique="test_install_remote_0_3" displayName="test_install_remote_0_3" description="" game="GalacticAdventures">test_install_remote_0_3.package</component>
+				</componentGroup>
+				<prerequisite>test_install_remote_0.dll</prerequisite>
+			</mod>"""
+	files = [
+		[ 'test_install_remote_0_1.package', os.urandom(4 * 1024 * 1024) ],
+		[ 'test_install_remote_0_2.package', os.urandom(4 * 1024 * 1024) ],
+		[ 'test_install_remote_0_3.package', os.urandom(4 * 1024 * 1024) ],
+		[ 'test_install_remote_0.dll', os.urandom(1024) ],
+	]
+	file = write_sporemod(xml, files, True)
+	http_bytes_served = 0
+	result = run_smm([ 'install', http_url + os.path.basename(file) ])
+	assert result.returncode == 0
+	assert result.stdout != ''
+	assert result.stderr == ''
+	assert not os.path.isfile(os.path.join(ep1_path, files[0][0]))
+	assert os.path.isfile(os.path.join(ep1_path, files[1][0]))
+	assert not os.path.isfile(os.path.join(ep1_path, files[2][0]))
+	assert os.path.isfile(os.path.join(modlibs_path, files[3][0]))
+	assert check_file_bytes(os.path.join(ep1_path, files[1][0]), files[1][1])
+	assert check_file_bytes(os.path.join(modlibs_path, files[3][0]), files[3][1])
+	assert http_bytes_served < (os.path.getsize(file) / 2)
+
+	# updating from an url should work as well
+	http_bytes_served = 0
+	result = run_smm([ 'update', http_url + os.path.basename(file) ])
+	assert result.returncode == 0
+	assert result.stdout != ''
+	assert result.stderr == ''
+	assert check_file_bytes(os.path.join(ep1_path, files[1][0]), files[1][1])
+	assert http_bytes_served < (os.path.getsize(file) / 2)
+
+# Tests whether downloading with a checksum and resuming works correctly
+def test_install_remote_checksum():
+	print(f'Running {test_install_remote_checksum.__name__}...')
+	reset_smm()
+
+	global http_bytes_served, http_range_requests, http_change_request
+
+	chunk_size = 4 * 1024 * 1024
+	files = [
+		[ 'test_install_remote_checksum_0.package', os.urandom(10 * 1024 * 1024) ],
+	]
+	file = write_sporemod(None, files, True)
+	file_name = os.path.basename(file)
+	file_size = os.path.getsize(file)
+	with open(file, 'rb') as sporemod:
+		file_content = sporemod.read()
+	checksum = hashlib.sha256(file_content).hexdigest()
+	url = http_url + file_name + '#sha256=' + checksum
+	download_file = os.path.join(downloads_path, hashlib.sha256(url.encode()).hexdigest()[:16] + '-' + file_name)
+	state_file = download_file + '.state'
+
+	# installing with a wrong checksum should fail
+	# and remove the downloaded file
+	result = run_smm([ 'install', http_url + file_name + '#sha256=' + ('0' * 64) ])
+	assert result.returncode == 1
+	assert result.stderr != ''
+	assert os.listdir(downloads_path) == [ ]
+	assert not os.path.isfile(os.path.join(ep1_path, files[0][0]))
+
+	# installing with the correct checksum should work
+	http_bytes_served = 0
+	result = run_smm([ 'install', http_url + file_name + '#sha256=' + checksum.upper() ])
+	assert result.returncode == 0
+	assert result.stdout != ''
+	assert result.stderr == ''
+	assert check_file_bytes(os.path.join(ep1_path, files[0][0]), files[0][1])
+	assert os.listdir(downloads_path) == [ ]
+	assert http_bytes_served == file_size + 1
+
+	# the downloaded file is removed after installing, so
+	# installing a different file with the same name from
+	# another url shouldn't use the earlier download
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	other_files = [
+		[ 'test_install_remote_checksum_0.package', os.urandom(1024) ],
+	]
+	other_file = write_sporemod(None, other_files, True)
+	with open(other_file, 'rb') as sporemod:
+		other_checksum = hashlib.sha256(sporemod.read()).hexdigest()
+	os.makedirs(os.path.join(mods_path, 'other'), exist_ok = True)
+	os.replace(other_file, os.path.join(mods_path, 'other', file_name))
+	result = run_smm([ 'install', http_url + 'other/' + file_name + '#sha256=' + other_checksum ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert check_file_bytes(os.path.join(ep1_path, other_files[0][0]), other_files[0][1])
+	assert os.listdir(downloads_path) == [ ]
+
+	# an interrupted download should only download
+	# the missing chunks, and re-download chunks
+	# which don't match their stored checksum
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	def write_partial_download(validator):
+		with open(download_file, 'wb') as partial_file:
+			partial_file.write(file_content[:chunk_size])
+			partial_file.write(b'\0' * (file_size - chunk_size))
+		with open(state_file, 'w') as state:
+			chunks = [ ]
+			for offset in range(0, file_size, chunk_size):
+				chunks.append([ offset, min(chunk_size, file_size - offset), 0, 0 ])
+			chunks[0][2] = chunks[0][1]
+			chunks[0][3] = zlib.crc32(file_content[:chunk_size])
+			chunks[1][2] = 1024 * 1024
+			chunks[1][3] = 1234
+			state.write('SporeModManagerDownload 2\n')
+			state.write(http_url + file_name + '\n')
+			state.write(validator + '\n')
+			state.write(f'{file_size} {len(chunks)}\n')
+			for chunk in chunks:
+				state.write(f'{chunk[0]} {chunk[1]} {chunk[2]} {chunk[3]}\n')
+	write_partial_download(get_http_etag(file))
+	http_bytes_served = 0
+	result = run_smm([ 'install', url ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert check_file_bytes(os.path.join(ep1_path, files[0][0]), files[0][1])
+	assert not os.path.isfile(download_file)
+	assert not os.path.isfile(state_file)
+	assert http_bytes_served == (file_size - chunk_size) + 1
+
+	# an interrupted download of a file which
+	# has changed on the server should start over
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	write_partial_download('"changed"')
+	http_bytes_served = 0
+	result = run_smm([ 'install', url ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	assert check_file_bytes(os.path.join(ep1_path, files[0][0]), files[0][1])
+	assert not os.path.isfile(download_file)
+	assert not os.path.isfile(state_file)
+	assert http_bytes_served == file_size + 1
+
+	# a file which changes on the server during
+	# the download should restart the download
+	result = run_smm([ 'uninstall', '0' ])
+	assert result.returncode == 0
+	assert result.stderr == ''
+	http_range_requests = 0
+	http_change_request = 2
+	result = run_smm([ 'install', url ])
+	http_change_request = 0
+	assert result.returncode == 0
+	assert 'has changed on the server, restarting the download' in result.stdout
+	assert result.stderr == ''
+	assert check_file_bytes(os.path.join(ep1_path, files[0][0]), files[0][1])
+	assert not os.path.isfile(download_file)
+	assert not os.path.isfile(state_file)
+
+# Tests whether update-modapi works correctly
+def test_update_modapi():
+	print(f'Running {test_update_modapi.__name__}...')
+	reset_smm()
+
+	# ensure mod with higher dll build required doesn't work
+	xml = """<mod displayName="test_update_modapi_0" 
+				unique="test_update_modapi_0" 
+				description="test_update_modapi_0" 
+				installerSystemVersion="1.0.1.1" 
+				dllsBuild="2.5.400">
+			</mod>"""
+	write_sporemod(xml)
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 1
+	assert result.stdout == ''
+	assert result.stderr != ''
+
+	# attempt to update modapi dll
+	result = run_smm([ 'update-modapi' ])
+	assert result.returncode == 0
+	assert result.stdout != ''
+	assert result.stderr == ''
+
+	# ensure updating when we dont have a modapi dll works
+	os.remove(sporemodapi_file)
+	result = run_smm([ 'update-modapi' ])
+	assert result.returncode == 0
+	assert result.stdout != ''
+	assert result.stderr != ''
+
+	# ensure updating when already up-to-date doesn't touch the file
+	before_update_mtime = os.path.getmtime(sporemodapi_file)
+	result = run_smm([ 'update-modapi' ])
+	assert result.returncode == 0
+	assert result.stdout != ''
+	assert result.stderr == ''
+	assert before_update_mtime == os.path.getmtime(sporemodapi_file)
+
+	# ensure mod with higher dll build required works
+	result = run_smm([ 'install', sporemod_file ])
+	assert result.returncode == 0
+	assert result.stdout != ''
+	assert result.stderr == ''
+
+#
+# Benchmark Functions
+#
+
+# Measures how fast inspect-package decompresses resources
+def benchmark_inspect_package():
+	print(f'Running {benchmark_inspect_package.__name__}...')
+	reset_smm()
+
+	# every record contains the same compressed resource,
+	# which consists of words and binary data, like most
+	# resources, compressing it only once keeps this fast
+	words = [ uuid.uuid4().hex[:length] for length in range(2, 12) for i in range(32) ]
+	resource = bytearray()
+	while len(resource) < 256 * 1024:
+		resource += words[len(resource) % len(words)].encode() + b' '
+		resource += struct.pack('<I', len(resource) * 2654435761 % 4294967296) if len(resource) % 7 == 0 else b''
+	resource = bytes(resource)
+	compressed_resource = refpack_compress(resource)
+
+	data = b''
+	index = struct.pack('<I', 0)
+	for instance in range(256):
+		index += struct.pack('<IIIIIIIHH', 1, 1, 0, instance, 96 + len(data), len(compressed_resource) | 0x80000000, len(resource), 0xffff, 1)
+		data += compressed_resource
+	header = struct.pack('<4sII20xII4xI12xII28x', b'DBPF', 2, 0, 7, 256, len(index), 3, 96 + len(data))
+
+	benchmark_package_file = os.path.join(mods_path, 'benchmark_inspect_package.package')
+	with open(benchmark_package_file, 'wb') as file:
+		file.write(header + data + index)
+
+	result = run_smm([ 'inspect-package', benchmark_package_file, 'hash' ])
+	assert result.returncode == 0
+	for line in result.stdout.splitlines():
+		if 'Decoded' in line:
+			size         = int(line.split(', ')[1].split(' ')[0])
+			milliseconds = max(int(line.split(' in ')[1].split(' ')[0]), 1)
+			print(f'{line.lstrip("-> ")} ({size / 1048576 / (milliseconds / 1000):.1f} MiB/s, ratio {len(compressed_resource) * 100 // len(resource)}%)')
+
+# Measures how fast installing extracts many small files
+def benchmark_install_small_files():
+	print(f'Running {benchmark_install_small_files.__name__}...')
+	reset_smm()
+
+	# small files make opening, writing and closing
+	# every file, instead of inflating, the bottleneck
+	file_count = 5000
+	prerequisites = ''
+	files = [ ]
+	for i in range(file_count):
+		file_name = f'benchmark_install_small_files_{i}.package'
+		prerequisites += f'<prerequisite game="GalacticAdventures">{file_name}</prerequisite>\n'
+		files.append([ file_name, os.urandom(256) * 8 ])
+	xml = f"""<mod displayName="benchmark_install_small_files"
+				unique="benchmark_install_small_files"
+				description="benchmark_install_small_files"
+				installerSystemVersion="1.0.1.1"
+				dllsBuild="2.5.20">
+				{prerequisites}
+			</mod>"""
+	file = write_sporemod(xml, files, True)
+
+	start_time = time.perf_counter()
+	result = run_smm([ 'install', file ])
+	milliseconds = max(int((time.perf_counter() - start_time) * 1000), 1)
+	assert result.returncode == 0
+	assert result.stderr == ''
+	size = sum(len(data) for name, data in files)
+	print(f'Installed {file_count} files, {size} bytes in {milliseconds} ms ({file_count / (milliseconds / 1000):.0f} files/s)')
+
+#
+# main
+#
+
+if __name__ == "__main__":
+	# register exit handler for cleanup
+	atexit.register(cleanup_smm)
+
+	# add argument parser
+	parser = argparse.ArgumentParser(description='Runs SporeModManager tests.')
+	parser.add_argument('--nocleanup', action='store_false', help="skips cleanup of temporary directory")
+	parser.add_argument('--verbose', action='store_true', help='prints command output for each test')
+	parser.add_argument('--network', action='store_true', help='runs tests which require network access')
+	parser.add_argument('--valgrind', action='store_true', help='runs tests with valgrind')
+	parser.add_argument('--benchmark', action='store_true', help='runs benchmarks instead of tests')
+	parser.add_argument('executable', help='executable to run tests with.')
+	args = parser.parse_args()
+
+	# set global variables
+	sporemodmanager = args.executable
+	verbose 		= args.verbose
+	cleanup         = args.nocleanup
+	network         = args.network
+	valgrind        = args.valgrind
+	benchmark       = args.benchmark
+
+	# create test directories
+	os.mkdir(mods_path)
+	os.mkdir(mods2_path)
+	os.mkdir(corelibs_path)
+	os.mkdir(modlibs_path)
+	os.mkdir(data_path)
+	os.mkdir(ep1_path)
+
+	# write spore mod api dll and package file
+	write_sporemodapi_dll(sporemodapi_file)
+	write_package(package_file)
+	write_package(package_file_2)
+	write_invalid(invalid_file)
+
+	# run benchmarks instead of tests
+	if benchmark:
+		benchmark_inspect_package()
+		benchmark_install_small_files()
+		sys.exit(0)
+
+	# start local http server
+	if not valgrind:
+		start_http_server()
 
 	# call tests
 	test_help()
@@ -1018,5 +3023,29 @@ if __name__ == "__main__":
 	test_uninstall()
 	test_update()
 	test_list_installed()
+	test_check()
+	test_install_recovery()
+	test_install_link_mode()
+	test_install_store()
+	test_install_targets()
+	test_install_cache()
+	test_disable()
+	test_profile()
+	test_install_shared()
+	test_conflicts()
+	test_install_conflicts()
+	test_merge_packages()
+	test_compact_package()
+	test_inspect_package()
+	test_update_patch()
+	test_resource_names()
+	test_load_manifest()
+	test_loader_report()
+	test_pe_imports()
+	# we cannot test installing from urls with valgrind
+	# because it gives false-positives when using dlopen/dlclose
+	if not valgrind:
+		test_install_remote()
+		test_install_remote_checksum()
 	if network:
 		test_update_modapi()